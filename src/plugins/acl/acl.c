@@ -2865,6 +2865,16 @@ acl_set_aclplugin_fn (vlib_main_t * vm,
       am->use_hash_acl_matching = (val != 0);
       goto done;
     }
+  if (unformat (input, "use-tuple-merge %u", &val))
+    {
+      am->use_tuple_merge = (val != 0);
+      goto done;
+    }
+  if (unformat (input, "tuple-merge-split-threshold %u", &val))
+    {
+      am->tuple_merge_split_threshold = val;
+      goto done;
+    }
   if (unformat (input, "l4-match-nonfirst-fragment %u", &val))
     {
       am->l4_match_nonfirst_fragment = (val != 0);
@@ -3541,13 +3551,30 @@ static void
 acl_plugin_print_pae (vlib_main_t * vm, int j, applied_hash_ace_entry_t * pae)
 {
   vlib_cli_output (vm,
-		   "    %4d: acl %d rule %d action %d bitmask-ready rule %d next %d prev %d tail %d hitcount %lld",
+		   "    %4d: acl %d rule %d action %d bitmask-ready rule %d mask type %d next %d prev %d tail %d hitcount %lld",
 		   j, pae->acl_index, pae->ace_index, pae->action,
-		   pae->hash_ace_info_index, pae->next_applied_entry_index,
+		   pae->hash_ace_info_index, pae->mask_type_index,
+		   pae->next_applied_entry_index,
 		   pae->prev_applied_entry_index,
 		   pae->tail_applied_entry_index, pae->hitcount);
 }
 
+static void
+acl_plugin_print_mask_info (vlib_main_t * vm, char *dir,
+			    applied_hash_acl_info_t * pal)
+{
+  hash_applied_mask_info_t *minfo;
+
+  vlib_cli_output (vm, "  %s lookup mask types:", dir);
+  vec_foreach (minfo, pal->mask_info_vec)
+  {
+    vlib_cli_output (vm,
+		     "    mask type %d: first applied entry %d, %d entries",
+		     minfo->mask_type_index, minfo->first_rule_index,
+		     minfo->num_entries);
+  }
+}
+
 static void
 acl_plugin_show_tables_applied_info (acl_main_t * am, u32 sw_if_index)
 {
@@ -3570,8 +3597,7 @@ acl_plugin_show_tables_applied_info (acl_main_t * am, u32 sw_if_index)
 	{
 	  applied_hash_acl_info_t *pal =
 	    &am->input_applied_hash_acl_info_by_sw_if_index[swi];
-	  vlib_cli_output (vm, "  input lookup mask_type_index_bitmap: %U",
-			   format_bitmap_hex, pal->mask_type_index_bitmap);
+	  acl_plugin_print_mask_info (vm, "input", pal);
 	  vlib_cli_output (vm, "  input applied acls: %U", format_vec32,
 			   pal->applied_acls, "%d");
 	}
@@ -3592,8 +3618,7 @@ acl_plugin_show_tables_applied_info (acl_main_t * am, u32 sw_if_index)
 	{
 	  applied_hash_acl_info_t *pal =
 	    &am->output_applied_hash_acl_info_by_sw_if_index[swi];
-	  vlib_cli_output (vm, "  output lookup mask_type_index_bitmap: %U",
-			   format_bitmap_hex, pal->mask_type_index_bitmap);
+	  acl_plugin_print_mask_info (vm, "output", pal);
 	  vlib_cli_output (vm, "  output applied acls: %U", format_vec32,
 			   pal->applied_acls, "%d");
 	}
@@ -3679,6 +3704,42 @@ acl_show_aclplugin_tables_fn (vlib_main_t * vm,
   return error;
 }
 
+static clib_error_t *
+acl_test_aclplugin_lookup_fn (vlib_main_t * vm,
+			      unformat_input_t * input,
+			      vlib_cli_command_t * cmd)
+{
+  acl_main_t *am = &acl_main;
+  u32 sw_if_index = ~0;
+  u32 count = 100000;
+  u32 seed = 0xdeadbeef;
+  u8 is_input = 1;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "sw_if_index %u", &sw_if_index))
+	;
+      else if (unformat (input, "input"))
+	is_input = 1;
+      else if (unformat (input, "output"))
+	is_input = 0;
+      else if (unformat (input, "count %u", &count))
+	;
+      else if (unformat (input, "seed %u", &seed))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+  if (sw_if_index == ~0)
+    return clib_error_return (0, "sw_if_index required");
+  if (count == 0)
+    return clib_error_return (0, "count must be non-zero");
+
+  hash_acl_lookup_benchmark (vm, am, sw_if_index, is_input, count, seed);
+  return 0;
+}
+
 static clib_error_t *
 acl_clear_aclplugin_fn (vlib_main_t * vm,
 			unformat_input_t * input, vlib_cli_command_t * cmd)
@@ -3693,7 +3754,7 @@ acl_clear_aclplugin_fn (vlib_main_t * vm,
  /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (aclplugin_set_command, static) = {
     .path = "set acl-plugin",
-    .short_help = "set acl-plugin session timeout {{udp idle}|tcp {idle|transient}} <seconds>",
+    .short_help = "set acl-plugin {session timeout {{udp idle}|tcp {idle|transient}} <seconds>|use-tuple-merge <0|1>|tuple-merge-split-threshold <n>}",
     .function = acl_set_aclplugin_fn,
 };
 
@@ -3750,6 +3811,13 @@ VLIB_CLI_COMMAND (aclplugin_clear_command, static) = {
     .short_help = "clear acl-plugin sessions",
     .function = acl_clear_aclplugin_fn,
 };
+
+/* hash vs. linear lookup rates, and the lookup tables build time */
+VLIB_CLI_COMMAND (aclplugin_test_lookup_command, static) = {
+    .path = "test acl-plugin lookup",
+    .short_help = "test acl-plugin lookup sw_if_index <n> [input|output] [count <n>] [seed <n>]",
+    .function = acl_test_aclplugin_lookup_fn,
+};
 /* *INDENT-ON* */
 
 static clib_error_t *
@@ -3875,6 +3943,9 @@ acl_init (vlib_main_t * vm)
 
   /* use the new fancy hash-based matching */
   am->use_hash_acl_matching = 1;
+  /* with the mask types merged, so as to do fewer lookups */
+  am->use_tuple_merge = 1;
+  am->tuple_merge_split_threshold = ACL_PLUGIN_TUPLE_MERGE_SPLIT_THRESHOLD;
 
   return error;
 }
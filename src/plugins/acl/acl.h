@@ -42,6 +42,7 @@
 #define ACL_PLUGIN_HASH_LOOKUP_HEAP_SIZE (2 << 25)
 #define ACL_PLUGIN_HASH_LOOKUP_HASH_BUCKETS 65536
 #define ACL_PLUGIN_HASH_LOOKUP_HASH_MEMORY (2 << 25)
+#define ACL_PLUGIN_TUPLE_MERGE_SPLIT_THRESHOLD 39
 
 extern vlib_node_registration_t acl_in_node;
 extern vlib_node_registration_t acl_out_node;
@@ -171,6 +172,11 @@ typedef struct {
   /* Do we use hash-based ACL matching or linear */
   int use_hash_acl_matching;
 
+  /* Do we merge the mask types of the hash-based matching (TupleMerge) */
+  int use_tuple_merge;
+  /* Max entries sharing a key in a merged mask type, before splitting */
+  u32 tuple_merge_split_threshold;
+
   /* a pool of all mask types present in all ACEs */
   ace_mask_type_entry_t *ace_mask_type_pool;
 
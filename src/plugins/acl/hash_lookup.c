@@ -28,6 +28,7 @@
 #include <vnet/plugin/plugin.h>
 #include <acl/acl.h>
 #include <vppinfra/bihash_48_8.h>
+#include <vppinfra/random.h>
 
 #include "hash_lookup.h"
 #include "hash_lookup_private.h"
@@ -40,6 +41,40 @@ static inline applied_hash_ace_entry_t **get_applied_hash_aces(acl_main_t *am, i
   return applied_hash_aces;
 }
 
+static u32 assign_mask_type_index(acl_main_t *am, fa_5tuple_t *mask);
+static void release_mask_type_index(acl_main_t *am, u32 mask_type_index);
+static u32 tm_assign_mask_type_index(acl_main_t *am, applied_hash_acl_info_t *pal,
+                                     applied_hash_ace_entry_t **applied_hash_aces,
+                                     u32 sw_if_index, u8 is_input, hash_ace_info_t *hi);
+
+static inline hash_ace_info_t *
+get_hash_ace_info(acl_main_t *am, applied_hash_ace_entry_t *pae)
+{
+  hash_acl_info_t *ha = vec_elt_at_index(am->hash_acl_infos, pae->acl_index);
+  return vec_elt_at_index(ha->rules, pae->hash_ace_info_index);
+}
+
+/*
+ * Make the hash key of an ACE applied with a given mask type: the ACE's own
+ * match, masked with that mask type, on this sw_if_index and direction.
+ */
+static void
+make_applied_hash_ace_key(acl_main_t *am, hash_ace_info_t *hi, u32 mask_type_index,
+                          u32 sw_if_index, u8 is_input, fa_5tuple_t *kv_key)
+{
+  u64 *pmatch = (u64 *)&hi->match;
+  u64 *pmask = (u64 *)&pool_elt_at_index(am->ace_mask_type_pool, mask_type_index)->mask;
+  u64 *pkey = (u64 *)kv_key;
+  int j;
+
+  for(j=0; j<6; j++) {
+    pkey[j] = pmatch[j] & pmask[j];
+  }
+  kv_key->pkt.mask_type_index_lsb = mask_type_index;
+  kv_key->pkt.sw_if_index = sw_if_index;
+  kv_key->pkt.is_input = is_input;
+}
+
 
 
 /*
@@ -63,6 +98,53 @@ match_portranges(acl_main_t *am, fa_5tuple_t *match, u32 index)
            ((r->dst_port_or_code_first <= match->l4.port[1]) && r->dst_port_or_code_last >= match->l4.port[1]) );
 }
 
+/*
+ * An applied entry that the hash key does not match exactly: either it is
+ * hashed with a less specific mask type than its own (tuple merge), or it
+ * has a port range which no mask can express.
+ */
+static int
+applied_hash_ace_need_full_check(acl_main_t *am, applied_hash_ace_entry_t *pae)
+{
+  hash_ace_info_t *hi = get_hash_ace_info(am, pae);
+  return (pae->mask_type_index != hi->mask_type_index) ||
+         hi->src_portrange_not_powerof2 || hi->dst_portrange_not_powerof2;
+}
+
+/*
+ * This returns true if the 5-tuple matches the applied entry at this index,
+ * using the ACE's own mask rather than the one it is hashed with.
+ */
+static int
+single_rule_match_5tuple(acl_main_t *am, fa_5tuple_t *match, u32 index)
+{
+  applied_hash_ace_entry_t **applied_hash_aces = get_applied_hash_aces(am, match->pkt.is_input, match->pkt.sw_if_index);
+  applied_hash_ace_entry_t *pae = vec_elt_at_index((*applied_hash_aces), index);
+  hash_ace_info_t *hi = get_hash_ace_info(am, pae);
+  fa_5tuple_t *mask = &pool_elt_at_index(am->ace_mask_type_pool, hi->mask_type_index)->mask;
+  u64 *pmatch = (u64 *)match;
+  u64 *pmask = (u64 *)mask;
+  u64 *prule = (u64 *)&hi->match;
+  fa_packet_info_t pkt_mask;
+  int j;
+
+  for(j=0; j<5; j++) {
+    if ((pmatch[j] & pmask[j]) != prule[j])
+      return 0;
+  }
+  /* the sw_if_index and direction have been matched by the hash lookup */
+  pkt_mask.as_u64 = mask->pkt.as_u64;
+  pkt_mask.sw_if_index = 0;
+  pkt_mask.is_input = 0;
+  pkt_mask.mask_type_index_lsb = 0;
+  if ((match->pkt.as_u64 ^ hi->match.pkt.as_u64) & pkt_mask.as_u64)
+    return 0;
+
+  if (hi->src_portrange_not_powerof2 || hi->dst_portrange_not_powerof2)
+    return match_portranges(am, match, index);
+  return 1;
+}
+
 static u32
 multi_acl_match_get_applied_ace_index(acl_main_t *am, fa_5tuple_t *match)
 {
@@ -73,7 +155,8 @@ multi_acl_match_get_applied_ace_index(acl_main_t *am, fa_5tuple_t *match)
   u64 *pmatch = (u64 *)match;
   u64 *pmask;
   u64 *pkey;
-  int mask_type_index;
+  hash_applied_mask_info_t *minfo;
+  u32 mask_type_index;
   u32 curr_match_index = ~0;
 
   u32 sw_if_index = match->pkt.sw_if_index;
@@ -85,11 +168,15 @@ multi_acl_match_get_applied_ace_index(acl_main_t *am, fa_5tuple_t *match)
   DBG("TRYING TO MATCH: %016llx %016llx %016llx %016llx %016llx %016llx",
 	       pmatch[0], pmatch[1], pmatch[2], pmatch[3], pmatch[4], pmatch[5]);
 
-  for(mask_type_index=0; mask_type_index < pool_len(am->ace_mask_type_pool); mask_type_index++) {
-    if (!clib_bitmap_get(vec_elt_at_index((*applied_hash_acls), sw_if_index)->mask_type_index_bitmap, mask_type_index)) {
-      /* This bit is not set. Avoid trying to match */
-      continue;
+  /*
+   * The mask types are ordered by the first applied entry using them,
+   * so once that is past the current candidate there is nothing to find.
+   */
+  vec_foreach(minfo, vec_elt_at_index((*applied_hash_acls), sw_if_index)->mask_info_vec) {
+    if (minfo->first_rule_index >= curr_match_index) {
+      break;
     }
+    mask_type_index = minfo->mask_type_index;
     ace_mask_type_entry_t *mte = vec_elt_at_index(am->ace_mask_type_pool, mask_type_index);
     pmatch = (u64 *)match;
     pmask = (u64 *)&mte->mask;
@@ -116,35 +203,31 @@ multi_acl_match_get_applied_ace_index(acl_main_t *am, fa_5tuple_t *match)
     if (res == 0) {
       DBG("ACL-MATCH! result_val: %016llx", result_val->as_u64);
       if (result_val->applied_entry_index < curr_match_index) {
-	if (PREDICT_FALSE(result_val->need_portrange_check)) {
+	if (PREDICT_FALSE(result_val->need_full_check)) {
           /*
-           * This is going to be slow, since we can have multiple superset
-           * entries for narrow-ish portranges, e.g.:
-           * 0..42 100..400, 230..60000,
-           * so we need to walk linearly and check if they match.
+           * Some of the entries sharing this key are a superset of the
+           * packets they match: a wider mask type, or a portrange,
+           * e.g. 0..42 100..400, 230..60000, so we need to walk
+           * linearly and check if they match.
            */
 
           u32 curr_index = result_val->applied_entry_index;
-          while ((curr_index != ~0) && !match_portranges(am, match, curr_index)) {
+          while ((curr_index < curr_match_index) && !single_rule_match_5tuple(am, match, curr_index)) {
             /* while no match and there are more entries, walk... */
             applied_hash_ace_entry_t *pae = vec_elt_at_index((*applied_hash_aces),curr_index);
-            DBG("entry %d did not portmatch, advancing to %d", curr_index, pae->next_applied_entry_index);
+            DBG("entry %d did not match, advancing to %d", curr_index, pae->next_applied_entry_index);
             curr_index = pae->next_applied_entry_index;
           }
           if (curr_index < curr_match_index) {
-            DBG("The index %d is the new candidate in portrange matches.", curr_index);
+            DBG("The index %d is the new candidate in full check matches.", curr_index);
             curr_match_index = curr_index;
           } else {
-            DBG("Curr portmatch index %d is too big vs. current matched one %d", curr_index, curr_match_index);
+            DBG("Curr full check index %d is too big vs. current matched one %d", curr_index, curr_match_index);
           }
         } else {
           /* The usual path is here. Found an entry in front of the current candiate - so it's a new one */
           DBG("This match is the new candidate");
           curr_match_index = result_val->applied_entry_index;
-	  if (!result_val->shadowed) {
-          /* new result is known to not be shadowed, so no point to look up further */
-            break;
-	  }
         }
       }
     }
@@ -171,16 +254,19 @@ fill_applied_hash_ace_kv(acl_main_t *am,
   fa_5tuple_t *kv_key = (fa_5tuple_t *)kv->key;
   hash_acl_lookup_value_t *kv_val = (hash_acl_lookup_value_t *)&kv->value;
   applied_hash_ace_entry_t *pae = vec_elt_at_index((*applied_hash_aces), new_index);
-  hash_acl_info_t *ha = vec_elt_at_index(am->hash_acl_infos, pae->acl_index);
+  u32 index;
 
-  memcpy(kv_key, &(vec_elt_at_index(ha->rules, pae->hash_ace_info_index)->match), sizeof(*kv_key));
-  /* initialize the sw_if_index and direction */
-  kv_key->pkt.sw_if_index = sw_if_index;
-  kv_key->pkt.is_input = is_input;
+  make_applied_hash_ace_key(am, get_hash_ace_info(am, pae), pae->mask_type_index,
+                            sw_if_index, is_input, kv_key);
   kv_val->as_u64 = 0;
   kv_val->applied_entry_index = new_index;
-  kv_val->need_portrange_check = vec_elt_at_index(ha->rules, pae->hash_ace_info_index)->src_portrange_not_powerof2 ||
-				   vec_elt_at_index(ha->rules, pae->hash_ace_info_index)->dst_portrange_not_powerof2;
+  /* the lookup has to check the entries one by one if any of the chain needs it */
+  for(index = new_index; index != ~0; index = vec_elt_at_index((*applied_hash_aces), index)->next_applied_entry_index) {
+    if (applied_hash_ace_need_full_check(am, vec_elt_at_index((*applied_hash_aces), index))) {
+      kv_val->need_full_check = 1;
+      break;
+    }
+  }
   /* by default assume all values are shadowed -> check all mask types */
   kv_val->shadowed = 1;
 }
@@ -236,6 +322,10 @@ activate_applied_ace_hash_entry(acl_main_t *am,
     pae->prev_applied_entry_index = last_index;
     /* adjust the pointer to the new tail */
     first_pae->tail_applied_entry_index = new_index;
+    if (!result_val->need_full_check && applied_hash_ace_need_full_check(am, pae)) {
+      /* the head's hash entry needs to say the chain is not an exact match anymore */
+      add_del_hashtable_entry(am, sw_if_index, is_input, applied_hash_aces, first_index, 1);
+    }
   } else {
     /* It's the very first entry */
     hashtable_add_del(am, &kv, 1);
@@ -298,6 +388,27 @@ acl_plugin_hash_acl_set_trace_heap(acl_main_t *am, int on)
   }
 }
 
+/*
+ * The applied entries are only ever appended, so adding a mask type
+ * at the end keeps the vector ordered by the first entry using it.
+ */
+static void
+applied_mask_info_add(applied_hash_acl_info_t *pal, u32 mask_type_index, u32 applied_index)
+{
+  hash_applied_mask_info_t *minfo;
+
+  vec_foreach(minfo, pal->mask_info_vec) {
+    if (minfo->mask_type_index == mask_type_index) {
+      minfo->num_entries++;
+      return;
+    }
+  }
+  vec_add2(pal->mask_info_vec, minfo, 1);
+  minfo->mask_type_index = mask_type_index;
+  minfo->first_rule_index = applied_index;
+  minfo->num_entries = 1;
+}
+
 void
 hash_acl_apply(acl_main_t *am, u32 sw_if_index, u8 is_input, int acl_index)
 {
@@ -325,7 +436,7 @@ hash_acl_apply(acl_main_t *am, u32 sw_if_index, u8 is_input, int acl_index)
 
   int base_offset = vec_len(*applied_hash_aces);
 
-  /* Update the bitmap of the mask types with which the lookup
+  /* Update the mask types with which the lookup
      needs to happen for the ACLs applied to this sw_if_index */
   applied_hash_acl_info_t **applied_hash_acls = is_input ? &am->input_applied_hash_acl_info_by_sw_if_index :
                                                     &am->output_applied_hash_acl_info_by_sw_if_index;
@@ -348,8 +459,6 @@ hash_acl_apply(acl_main_t *am, u32 sw_if_index, u8 is_input, int acl_index)
   }
   vec_add1((*hash_acl_applied_sw_if_index), sw_if_index);
 
-  pal->mask_type_index_bitmap = clib_bitmap_or(pal->mask_type_index_bitmap,
-                                     ha->mask_type_index_bitmap);
   /*
    * if the applied ACL is empty, the current code will cause a
    * different behavior compared to current linear search: an empty ACL will
@@ -376,6 +485,15 @@ hash_acl_apply(acl_main_t *am, u32 sw_if_index, u8 is_input, int acl_index)
     pae->next_applied_entry_index = ~0;
     pae->prev_applied_entry_index = ~0;
     pae->tail_applied_entry_index = ~0;
+    if (am->use_tuple_merge) {
+      pae->mask_type_index = tm_assign_mask_type_index(am, pal, applied_hash_aces,
+                                                       sw_if_index, is_input, &ha->rules[i]);
+    } else {
+      /* a reference on the ACE's own mask type, for as long as it is applied */
+      fa_5tuple_t mask = pool_elt_at_index(am->ace_mask_type_pool, ha->rules[i].mask_type_index)->mask;
+      pae->mask_type_index = assign_mask_type_index(am, &mask);
+    }
+    applied_mask_info_add(pal, pae->mask_type_index, new_index);
     activate_applied_ace_hash_entry(am, sw_if_index, is_input, applied_hash_aces, new_index);
   }
   applied_hash_entries_analyze(am, applied_hash_aces);
@@ -495,28 +613,24 @@ deactivate_applied_ace_hash_entry(acl_main_t *am,
   pae->prev_applied_entry_index = ~0;
   pae->next_applied_entry_index = ~0;
   pae->tail_applied_entry_index = ~0;
+  /* the hash entry is gone, so is the need for its mask type */
+  release_mask_type_index(am, pae->mask_type_index);
 }
 
 
 static void
-hash_acl_build_applied_lookup_bitmap(acl_main_t *am, u32 sw_if_index, u8 is_input)
+hash_acl_build_applied_mask_info(acl_main_t *am, u32 sw_if_index, u8 is_input)
 {
   int i;
-  uword *new_lookup_bitmap = 0;
   applied_hash_acl_info_t **applied_hash_acls = is_input ? &am->input_applied_hash_acl_info_by_sw_if_index
                                                          : &am->output_applied_hash_acl_info_by_sw_if_index;
   applied_hash_acl_info_t *pal = vec_elt_at_index((*applied_hash_acls), sw_if_index);
-  for(i=0; i < vec_len(pal->applied_acls); i++) {
-    u32 a_acl_index = *vec_elt_at_index((pal->applied_acls), i);
-    hash_acl_info_t *ha = vec_elt_at_index(am->hash_acl_infos, a_acl_index);
-    DBG("Update bitmask = %U or %U (acl_index %d)\n", format_bitmap_hex, new_lookup_bitmap,
-          format_bitmap_hex, ha->mask_type_index_bitmap, a_acl_index);
-    new_lookup_bitmap = clib_bitmap_or(new_lookup_bitmap,
-                                       ha->mask_type_index_bitmap);
+  applied_hash_ace_entry_t **applied_hash_aces = get_applied_hash_aces(am, is_input, sw_if_index);
+
+  vec_reset_length(pal->mask_info_vec);
+  for(i=0; i < vec_len((*applied_hash_aces)); i++) {
+    applied_mask_info_add(pal, vec_elt_at_index((*applied_hash_aces), i)->mask_type_index, i);
   }
-  uword *old_lookup_bitmap = pal->mask_type_index_bitmap;
-  pal->mask_type_index_bitmap = new_lookup_bitmap;
-  clib_bitmap_free(old_lookup_bitmap);
 }
 
 void
@@ -586,7 +700,7 @@ hash_acl_unapply(acl_main_t *am, u32 sw_if_index, u8 is_input, int acl_index)
   applied_hash_entries_analyze(am, applied_hash_aces);
 
   /* After deletion we might not need some of the mask-types anymore... */
-  hash_acl_build_applied_lookup_bitmap(am, sw_if_index, is_input);
+  hash_acl_build_applied_mask_info(am, sw_if_index, is_input);
   clib_mem_set_heap (oldheap);
 }
 
@@ -766,6 +880,117 @@ release_mask_type_index(acl_main_t *am, u32 mask_type_index)
   }
 }
 
+static int
+mask_is_subset(fa_5tuple_t *mask, fa_5tuple_t *of_mask)
+{
+  u64 *pmask = (u64 *)mask;
+  u64 *pof = (u64 *)of_mask;
+  int j;
+  for(j=0; j<6; j++) {
+    if (pmask[j] & ~pof[j])
+      return 0;
+  }
+  return 1;
+}
+
+static int
+mask_count_bits(fa_5tuple_t *mask)
+{
+  u64 *pmask = (u64 *)mask;
+  int j, bits = 0;
+  for(j=0; j<6; j++) {
+    bits += count_set_bits(pmask[j]);
+  }
+  return bits;
+}
+
+static u32
+count_colliding_applied_entries(acl_main_t *am, applied_hash_ace_entry_t **applied_hash_aces,
+                                u32 sw_if_index, u8 is_input, hash_ace_info_t *hi,
+                                u32 mask_type_index)
+{
+  clib_bihash_kv_48_8_t kv;
+  clib_bihash_kv_48_8_t result;
+  hash_acl_lookup_value_t *result_val = (hash_acl_lookup_value_t *)&result.value;
+  u32 index, count = 0;
+
+  make_applied_hash_ace_key(am, hi, mask_type_index, sw_if_index, is_input, (fa_5tuple_t *)kv.key);
+  if (BV (clib_bihash_search) (&am->acl_lookup_hash, &kv, &result))
+    return 0;
+  for(index = result_val->applied_entry_index; index != ~0;
+      index = vec_elt_at_index((*applied_hash_aces), index)->next_applied_entry_index) {
+    count++;
+  }
+  return count;
+}
+
+/*
+ * Shorten the address prefixes of the mask to the byte (IPv4)
+ * or the 16 bits (IPv6) boundary below, so that the ACEs with
+ * prefixes of similar lengths can share the mask type.
+ */
+static void
+tm_relax_mask(fa_5tuple_t *mask, u8 is_ipv6)
+{
+  int i;
+  for(i=0; i<2; i++) {
+    int prefix_len = count_set_bits(mask->addr[i].as_u64[0]) + count_set_bits(mask->addr[i].as_u64[1]);
+    prefix_len = prefix_len ? (prefix_len - 1) & ~(is_ipv6 ? 15 : 7) : 0;
+    make_address_mask(&mask->addr[i], is_ipv6, prefix_len);
+  }
+}
+
+/*
+ * TupleMerge: rather than with its own mask type, hash an applied ACE with
+ * the most specific of the mask types already used on the sw_if_index that
+ * is no more specific than its own, so there are fewer mask types to look
+ * up. The lookup then has to check the ACEs sharing a key one by one, so
+ * a key already shared by tuple_merge_split_threshold entries is not joined.
+ * If there is no mask type to join, start a relaxed one for the next ACEs,
+ * unless that one is there already and full, then use the ACE's own one.
+ */
+static u32
+tm_assign_mask_type_index(acl_main_t *am, applied_hash_acl_info_t *pal,
+                          applied_hash_ace_entry_t **applied_hash_aces,
+                          u32 sw_if_index, u8 is_input, hash_ace_info_t *hi)
+{
+  hash_applied_mask_info_t *minfo;
+  fa_5tuple_t own_mask, mask;
+  u32 best_index = ~0;
+  int best_bits = -1;
+
+  own_mask = pool_elt_at_index(am->ace_mask_type_pool, hi->mask_type_index)->mask;
+
+  vec_foreach(minfo, pal->mask_info_vec) {
+    fa_5tuple_t *a_mask = &pool_elt_at_index(am->ace_mask_type_pool, minfo->mask_type_index)->mask;
+    int bits = mask_count_bits(a_mask);
+    if ((bits <= best_bits) || !mask_is_subset(a_mask, &own_mask))
+      continue;
+    if (count_colliding_applied_entries(am, applied_hash_aces, sw_if_index, is_input, hi,
+                                        minfo->mask_type_index) >= am->tuple_merge_split_threshold)
+      continue;
+    best_index = minfo->mask_type_index;
+    best_bits = bits;
+  }
+
+  if (best_index != ~0) {
+    /* a copy, since taking the reference might move the pool */
+    mask = pool_elt_at_index(am->ace_mask_type_pool, best_index)->mask;
+  } else {
+    mask = own_mask;
+    tm_relax_mask(&mask, hi->match.pkt.is_ip6);
+    u32 relaxed_index = find_mask_type_index(am, &mask);
+    vec_foreach(minfo, pal->mask_info_vec) {
+      if (minfo->mask_type_index == relaxed_index) {
+        DBG("Relaxed mask type %d is full, splitting", relaxed_index);
+        mask = own_mask;
+        break;
+      }
+    }
+  }
+  return assign_mask_type_index(am, &mask);
+}
+
 void hash_acl_add(acl_main_t *am, int acl_index)
 {
   void *oldheap = hash_acl_set_heap(am);
@@ -884,6 +1109,159 @@ hash_multi_acl_match_5tuple (u32 sw_if_index, fa_5tuple_t * pkt_5tuple, int is_l
   return 0;
 }
 
+static void
+random_address_in_prefix(ip46_address_t *addr, ip46_address_t *prefix,
+                         u8 prefix_len, u8 is_ipv6, u32 *seed)
+{
+  ip46_address_t mask;
+  int i;
+  make_address_mask(&mask, is_ipv6, prefix_len);
+  for(i=0; i<4; i++) {
+    addr->ip6.as_u32[i] = (prefix->ip6.as_u32[i] & mask.ip6.as_u32[i]) | (random_u32(seed) & ~mask.ip6.as_u32[i]);
+  }
+  if (!is_ipv6) {
+    ip46_address_mask_ip4(addr);
+  }
+}
+
+static u16
+random_port_in_range(u16 port_first, u16 port_last, u32 *seed)
+{
+  return port_first + random_u32(seed) % ((u32)port_last - port_first + 1);
+}
+
+/*
+ * Make the 5-tuples for the lookup benchmark the way ClassBench makes
+ * its traces: mostly packets falling within a randomly picked applied
+ * rule, plus one in ten entirely random ones.
+ */
+static void
+make_benchmark_5tuple(acl_main_t *am, applied_hash_ace_entry_t **applied_hash_aces,
+                      u32 sw_if_index, u8 is_input, fa_5tuple_t *t, u32 *seed)
+{
+  memset(t, 0, sizeof(*t));
+  if ((vec_len((*applied_hash_aces)) == 0) || (random_u32(seed) % 10 == 0)) {
+    int i;
+    t->pkt.is_ip6 = random_u32(seed) % 4 == 0;
+    for(i=0; i<4; i++) {
+      t->addr[0].ip6.as_u32[i] = random_u32(seed);
+      t->addr[1].ip6.as_u32[i] = random_u32(seed);
+    }
+    if (!t->pkt.is_ip6) {
+      ip46_address_mask_ip4(&t->addr[0]);
+      ip46_address_mask_ip4(&t->addr[1]);
+    }
+    t->l4.proto = (random_u32(seed) & 1) ? IPPROTO_TCP : IPPROTO_UDP;
+    t->l4.port[0] = random_u32(seed);
+    t->l4.port[1] = random_u32(seed);
+  } else {
+    applied_hash_ace_entry_t *pae = vec_elt_at_index((*applied_hash_aces),
+                                      random_u32(seed) % vec_len((*applied_hash_aces)));
+    acl_rule_t *r = &am->acls[pae->acl_index].rules[pae->ace_index];
+    t->pkt.is_ip6 = r->is_ipv6;
+    random_address_in_prefix(&t->addr[0], &r->src, r->src_prefixlen, r->is_ipv6, seed);
+    random_address_in_prefix(&t->addr[1], &r->dst, r->dst_prefixlen, r->is_ipv6, seed);
+    t->l4.proto = r->proto ? r->proto : ((random_u32(seed) & 1) ? IPPROTO_TCP : IPPROTO_UDP);
+    t->l4.port[0] = random_port_in_range(r->src_port_or_type_first, r->src_port_or_type_last, seed);
+    t->l4.port[1] = random_port_in_range(r->dst_port_or_code_first, r->dst_port_or_code_last, seed);
+  }
+  t->pkt.l4_valid = 1;
+  if (t->l4.proto == IPPROTO_TCP) {
+    t->pkt.tcp_flags = random_u32(seed);
+    t->pkt.tcp_flags_valid = 1;
+  }
+  t->pkt.sw_if_index = sw_if_index;
+  t->pkt.is_input = is_input;
+}
+
+/*
+ * Time the hash based lookups on a sw_if_index against the linear ones,
+ * checking that both find the same rule, and the time it takes to build
+ * the lookup structures of the ACLs applied there.
+ */
+void
+hash_acl_lookup_benchmark(vlib_main_t *vm, acl_main_t *am, u32 sw_if_index,
+                          u8 is_input, u32 n_lookups, u32 seed)
+{
+  applied_hash_ace_entry_t **applied_hash_aces;
+  applied_hash_acl_info_t **applied_hash_acls = is_input ? &am->input_applied_hash_acl_info_by_sw_if_index
+                                                         : &am->output_applied_hash_acl_info_by_sw_if_index;
+  applied_hash_acl_info_t *pal;
+  fa_5tuple_t *tuples = 0;
+  u32 *hash_matches = 0;
+  u32 *acl_matches = 0;
+  u32 *rule_matches = 0;
+  u32 *acl_indices;
+  u32 i, n_mismatches = 0;
+  f64 t_hash, t_linear, t_build;
+
+  if ((sw_if_index >= vec_len((*applied_hash_acls))) ||
+      (vec_len(vec_elt_at_index((*applied_hash_acls), sw_if_index)->applied_acls) == 0)) {
+    vlib_cli_output(vm, "No ACLs applied on sw_if_index %d %s", sw_if_index, is_input ? "input" : "output");
+    return;
+  }
+  applied_hash_aces = get_applied_hash_aces(am, is_input, sw_if_index);
+  pal = vec_elt_at_index((*applied_hash_acls), sw_if_index);
+
+  vec_validate(tuples, n_lookups - 1);
+  vec_validate(hash_matches, n_lookups - 1);
+  vec_validate(acl_matches, n_lookups - 1);
+  vec_validate(rule_matches, n_lookups - 1);
+  for(i=0; i < n_lookups; i++) {
+    make_benchmark_5tuple(am, applied_hash_aces, sw_if_index, is_input, &tuples[i], &seed);
+  }
+
+  t_hash = vlib_time_now(vm);
+  for(i=0; i < n_lookups; i++) {
+    hash_matches[i] = multi_acl_match_get_applied_ace_index(am, &tuples[i]);
+  }
+  t_hash = vlib_time_now(vm) - t_hash;
+
+  t_linear = vlib_time_now(vm);
+  for(i=0; i < n_lookups; i++) {
+    u32 trace_bitmap = 0;
+    acl_matches[i] = rule_matches[i] = ~0;
+    linear_multi_acl_match_5tuple(sw_if_index, &tuples[i], 0, tuples[i].pkt.is_ip6, is_input,
+                                  &acl_matches[i], &rule_matches[i], &trace_bitmap);
+  }
+  t_linear = vlib_time_now(vm) - t_linear;
+
+  for(i=0; i < n_lookups; i++) {
+    u32 acl_match = ~0, rule_match = ~0;
+    if (hash_matches[i] < vec_len((*applied_hash_aces))) {
+      applied_hash_ace_entry_t *pae = vec_elt_at_index((*applied_hash_aces), hash_matches[i]);
+      acl_match = pae->acl_index;
+      rule_match = pae->ace_index;
+    }
+    if ((acl_match != acl_matches[i]) || (rule_match != rule_matches[i])) {
+      n_mismatches++;
+    }
+  }
+
+  vlib_cli_output(vm, "sw_if_index %d %s: %d applied entries, %d mask types (tuple merge %s)",
+                  sw_if_index, is_input ? "input" : "output", vec_len((*applied_hash_aces)),
+                  vec_len(pal->mask_info_vec), am->use_tuple_merge ? "on" : "off");
+  vlib_cli_output(vm, "  %d lookups: hash %.0f lookups/s, linear %.0f lookups/s, %d mismatches",
+                  n_lookups, n_lookups / t_hash, n_lookups / t_linear, n_mismatches);
+
+  /* rebuild the lookup structures of the sw_if_index from scratch */
+  acl_indices = vec_dup(pal->applied_acls);
+  t_build = vlib_time_now(vm);
+  for(i = vec_len(acl_indices); i > 0; i--) {
+    hash_acl_unapply(am, sw_if_index, is_input, acl_indices[i-1]);
+  }
+  for(i=0; i < vec_len(acl_indices); i++) {
+    hash_acl_apply(am, sw_if_index, is_input, acl_indices[i]);
+  }
+  t_build = vlib_time_now(vm) - t_build;
+  vlib_cli_output(vm, "  build: %.3f ms", t_build * 1e3);
+
+  vec_free(acl_indices);
+  vec_free(hash_matches);
+  vec_free(acl_matches);
+  vec_free(rule_matches);
+  vec_free(tuples);
+}
 
 void
 show_hash_acl_hash (vlib_main_t * vm, acl_main_t *am, u32 verbose)
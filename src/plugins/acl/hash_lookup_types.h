@@ -68,18 +68,35 @@ typedef struct {
    * number of hits on this entry
    */
   u64 hitcount;
+  /*
+   * The mask type this entry is hashed with. With tuple merge it may be
+   * less specific than the mask type of the ACE, shared with other ACEs.
+   */
+  u32 mask_type_index;
   /*
    * Action of this applied ACE
    */
   u8 action;
 } applied_hash_ace_entry_t;
 
+/*
+ * A mask type used for the lookups on an interface,
+ * i.e. one of the tuples of the tuple space search.
+ */
+typedef struct {
+  u32 mask_type_index;
+  /* the first applied entry hashed with this mask type */
+  u32 first_rule_index;
+  /* the number of applied entries hashed with this mask type */
+  u32 num_entries;
+} hash_applied_mask_info_t;
+
 typedef struct {
    /*
-    * A logical OR of all the applied_ace_hash_entry_t=>
-    *                            hash_ace_info_t=>mask_type_index bits set
+    * The mask types the lookup is done with, in the order of
+    * the first applied entry each of them finds.
     */
-   uword *mask_type_index_bitmap;
+   hash_applied_mask_info_t *mask_info_vec;
    /* applied ACLs so we can track them independently from main ACL module */
    u32 *applied_acls;
 } applied_hash_acl_info_t;
@@ -93,7 +110,11 @@ typedef union {
     u8 reserved_u8;
     /* means there is some other entry in front intersecting with this one */
     u8 shadowed:1;
-    u8 need_portrange_check:1;
+    /*
+     * the entries with this key need to be checked one by one:
+     * a port range, or a mask type relaxed by tuple merge.
+     */
+    u8 need_full_check:1;
     u8 reserved_flags:6;
   };
 } hash_acl_lookup_value_t;
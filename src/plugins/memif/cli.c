@@ -203,6 +203,8 @@ memif_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
 	args.is_master = 1;
       else if (unformat (line_input, "slave"))
 	args.is_master = 0;
+      else if (unformat (line_input, "zero-copy"))
+	args.is_zero_copy = 1;
       else if (unformat (line_input, "mode ip"))
 	args.mode = MEMIF_INTERFACE_MODE_IP;
       else if (unformat (line_input, "hw-addr %U",
@@ -227,6 +229,9 @@ memif_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
   if (tx_queues > 255 || tx_queues < 1)
     return clib_error_return (0, "tx queue must be between 1 - 255");
 
+  if (args.is_zero_copy && args.is_master)
+    return clib_error_return (0, "zero-copy is for slave interfaces only");
+
   args.rx_queues = rx_queues;
   args.tx_queues = tx_queues;
 
@@ -257,7 +262,7 @@ VLIB_CLI_COMMAND (memif_create_command, static) = {
                 "[ring-size <size>] [buffer-size <size>] "
 		"[hw-addr <mac-address>] "
 		"<master|slave> [rx-queues <number>] [tx-queues <number>] "
-		"[mode ip] [secret <string>]",
+		"[mode ip] [secret <string>] [zero-copy]",
   .function = memif_create_command_fn,
 };
 /* *INDENT-ON* */
@@ -256,6 +256,121 @@ retry:
   return frame->n_vectors;
 }
 
+/*
+ * Zero-copy transmit, slave only: descriptors point at the data of the
+ * vlib buffers themselves, one per buffer of the chain. The buffers are
+ * kept, by slot, until the master has consumed them and moved tail.
+ */
+static_always_inline uword
+memif_interface_tx_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
+			      vlib_frame_t * frame, memif_if_t * mif)
+{
+  memif_ring_t *ring;
+  u32 *buffers = vlib_frame_args (frame);
+  u32 n_left = frame->n_vectors;
+  u32 thread_index = vlib_get_thread_index ();
+  u8 tx_queues = vec_len (mif->tx_queues);
+  memif_queue_t *mq;
+  u16 ring_size, mask, head, tail, free_slots;
+  u8 qid;
+  int n_retries = 5;
+
+  if (tx_queues < vec_len (vlib_mains))
+    {
+      ASSERT (tx_queues > 0);
+      qid = thread_index % tx_queues;
+      clib_spinlock_lock_if_init (&mif->lockp);
+    }
+  else
+    qid = thread_index;
+
+  mq = vec_elt_at_index (mif->tx_queues, qid);
+  ring = mq->ring;
+  ring_size = 1 << mq->log2_ring_size;
+  mask = ring_size - 1;
+  head = mq->last_head;
+
+retry:
+
+  /* free consumed buffers */
+  tail = ring->tail;
+  while (mq->last_tail != tail)
+    {
+      u16 slot = mq->last_tail & mask;
+      u16 n = clib_min ((u16) (tail - mq->last_tail), ring_size - slot);
+      vlib_buffer_free_no_next (vm, mq->buffers + slot, n);
+      mq->last_tail += n;
+    }
+
+  free_slots = ring_size - head + mq->last_tail;
+
+  while (n_left && free_slots)
+    {
+      vlib_buffer_t *b0 = vlib_get_buffer (vm, buffers[0]);
+      vlib_buffer_t *b = b0;
+      u32 bi = buffers[0];
+      u16 n_seg = 1;
+
+      while (b->flags & VLIB_BUFFER_NEXT_PRESENT)
+	{
+	  b = vlib_get_buffer (vm, b->next_buffer);
+	  n_seg++;
+	}
+      if (PREDICT_FALSE (n_seg > free_slots))
+	break;
+
+      if (n_left > 2)
+	memif_prefetch_buffer_and_data (vm, buffers[2]);
+
+      b = b0;
+      while (1)
+	{
+	  u16 slot = head++ & mask;
+	  memif_desc_t *d = &ring->desc[slot];
+
+	  mq->buffers[slot] = bi;
+	  memif_desc_set_vlib_buffer (vm, d, b);
+	  d->buffer_length = d->length = b->current_length;
+	  if ((b->flags & VLIB_BUFFER_NEXT_PRESENT) == 0)
+	    {
+	      d->flags = 0;
+	      break;
+	    }
+	  d->flags = MEMIF_DESC_FLAG_NEXT;
+	  bi = b->next_buffer;
+	  b = vlib_get_buffer (vm, bi);
+	}
+
+      buffers++;
+      n_left--;
+      free_slots -= n_seg;
+    }
+
+  CLIB_MEMORY_STORE_BARRIER ();
+  ring->head = mq->last_head = head;
+
+  if (n_left && n_retries--)
+    goto retry;
+
+  clib_spinlock_unlock_if_init (&mif->lockp);
+
+  if (n_left)
+    {
+      vlib_error_count (vm, node->node_index, MEMIF_TX_ERROR_NO_FREE_SLOTS,
+			n_left);
+      vlib_buffer_free (vm, buffers, n_left);
+    }
+
+  if ((ring->flags & MEMIF_RING_FLAG_MASK_INT) == 0 && mq->int_fd > -1)
+    {
+      u64 b = 1;
+      CLIB_UNUSED (int r) = write (mq->int_fd, &b, sizeof (b));
+      mq->int_count++;
+    }
+
+  return frame->n_vectors;
+}
+
 uword
 CLIB_MULTIARCH_FN (memif_interface_tx) (vlib_main_t * vm,
 					vlib_node_runtime_t * node,
@@ -265,7 +380,9 @@ CLIB_MULTIARCH_FN (memif_interface_tx) (vlib_main_t * vm,
   vnet_interface_output_runtime_t *rund = (void *) node->runtime_data;
   memif_if_t *mif = pool_elt_at_index (nm->interfaces, rund->dev_instance);
 
-  if (mif->flags & MEMIF_IF_FLAG_IS_SLAVE)
+  if (mif->flags & MEMIF_IF_FLAG_ZERO_COPY)
+    return memif_interface_tx_zc_inline (vm, node, frame, mif);
+  else if (mif->flags & MEMIF_IF_FLAG_IS_SLAVE)
     return memif_interface_tx_inline (vm, node, frame, mif, MEMIF_RING_S2M);
   else
     return memif_interface_tx_inline (vm, node, frame, mif, MEMIF_RING_M2S);
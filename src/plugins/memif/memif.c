@@ -65,6 +65,29 @@ memif_queue_intfd_close (memif_queue_t * mq)
     }
 }
 
+/*
+ * In zero-copy mode the rx ring slots all hold buffers posted to the
+ * peer, and the tx ring slots from last_tail to last_head hold buffers
+ * the peer has not consumed yet; they are ours again once disconnected.
+ */
+static void
+memif_queue_free_buffers (memif_queue_t * mq)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  u16 mask = (1 << mq->log2_ring_size) - 1;
+
+  if (mq->buffers == 0)
+    return;
+
+  if (mq->type == MEMIF_RING_M2S)
+    vlib_buffer_free_no_next (vm, mq->buffers, vec_len (mq->buffers));
+  else
+    while (mq->last_tail != mq->last_head)
+      vlib_buffer_free_no_next (vm, mq->buffers + (mq->last_tail++ & mask),
+				1);
+  vec_free (mq->buffers);
+}
+
 void
 memif_disconnect (memif_if_t * mif, clib_error_t * err)
 {
@@ -125,16 +148,26 @@ memif_disconnect (memif_if_t * mif, clib_error_t * err)
   }
 
   /* free tx and rx queues */
-  vec_foreach (mq, mif->rx_queues) memif_queue_intfd_close (mq);
+  vec_foreach (mq, mif->rx_queues)
+  {
+    memif_queue_intfd_close (mq);
+    memif_queue_free_buffers (mq);
+  }
   vec_free (mif->rx_queues);
 
-  vec_foreach (mq, mif->tx_queues) memif_queue_intfd_close (mq);
+  vec_foreach (mq, mif->tx_queues)
+  {
+    memif_queue_intfd_close (mq);
+    memif_queue_free_buffers (mq);
+  }
   vec_free (mif->tx_queues);
 
   /* free memory regions */
   vec_foreach (mr, mif->regions)
   {
     int rv;
+    if (mr->is_external)
+      continue;
     if ((rv = munmap (mr->shm, mr->region_size)))
       clib_warning ("munmap failed, rv = %d", rv);
     if (mr->fd > -1)
@@ -268,12 +301,15 @@ memif_get_ring (memif_if_t * mif, memif_ring_type_t type, u16 ring_num)
 clib_error_t *
 memif_init_regions_and_queues (memif_if_t * mif)
 {
+  vlib_main_t *vm = vlib_get_main ();
   memif_ring_t *ring = NULL;
   int i, j;
   u64 buffer_offset;
+  u32 n_buffer_slots;
   memif_region_t *r;
   clib_mem_vm_alloc_t alloc = { 0 };
   clib_error_t *err;
+  int zero_copy = (mif->flags & MEMIF_IF_FLAG_ZERO_COPY) != 0;
 
   vec_validate_aligned (mif->regions, 0, CLIB_CACHE_LINE_BYTES);
   r = vec_elt_at_index (mif->regions, 0);
@@ -282,10 +318,13 @@ memif_init_regions_and_queues (memif_if_t * mif)
     (sizeof (memif_ring_t) +
      sizeof (memif_desc_t) * (1 << mif->run.log2_ring_size));
 
-  r->region_size = buffer_offset +
-    mif->run.buffer_size * (1 << mif->run.log2_ring_size) *
+  /* in zero-copy mode the region holds the rings only, descriptors point
+     into the vlib buffer memory regions which follow it */
+  n_buffer_slots = zero_copy ? 0 : (1 << mif->run.log2_ring_size) *
     (mif->run.num_s2m_rings + mif->run.num_m2s_rings);
 
+  r->region_size = buffer_offset + mif->run.buffer_size * n_buffer_slots;
+
   alloc.name = "memif region";
   alloc.size = r->region_size;
   alloc.flags = CLIB_MEM_VM_F_SHARED;
@@ -297,6 +336,24 @@ memif_init_regions_and_queues (memif_if_t * mif)
   r->fd = alloc.fd;
   r->shm = alloc.addr;
 
+  if (zero_copy)
+    {
+      vlib_buffer_pool_t *bp;
+      vec_foreach (bp, vm->buffer_main->buffer_pools)
+      {
+	vlib_physmem_region_t *pr;
+	pr = vlib_physmem_get_region (vm, bp->physmem_region);
+	if (pr->fd < 0)
+	  return clib_error_return (0, "buffer memory '%s' is not shared",
+				    pr->name);
+	vec_add2_aligned (mif->regions, r, 1, CLIB_CACHE_LINE_BYTES);
+	r->fd = pr->fd;
+	r->shm = pr->mem;
+	r->region_size = pr->size;
+	r->is_external = 1;
+      }
+    }
+
   for (i = 0; i < mif->run.num_s2m_rings; i++)
     {
       ring = memif_get_ring (mif, MEMIF_RING_S2M, i);
@@ -342,6 +399,10 @@ memif_init_regions_and_queues (memif_if_t * mif)
     mq->offset = (void *) mq->ring - (void *) mif->regions[mq->region].shm;
     mq->last_head = 0;
     mq->type = MEMIF_RING_S2M;
+
+    if (zero_copy)
+      vec_validate_aligned (mq->buffers, (1 << mq->log2_ring_size) - 1,
+			    CLIB_CACHE_LINE_BYTES);
   }
 
   ASSERT (mif->rx_queues == 0);
@@ -359,6 +420,23 @@ memif_init_regions_and_queues (memif_if_t * mif)
     mq->offset = (void *) mq->ring - (void *) mif->regions[mq->region].shm;
     mq->last_head = 0;
     mq->type = MEMIF_RING_M2S;
+
+    if (zero_copy)
+      {
+	u16 ring_size = 1 << mq->log2_ring_size;
+	vec_validate_aligned (mq->buffers, ring_size - 1,
+			      CLIB_CACHE_LINE_BYTES);
+	if ((j = vlib_buffer_alloc (vm, mq->buffers, ring_size)) != ring_size)
+	  {
+	    vlib_buffer_free (vm, mq->buffers, j);
+	    vec_free (mq->buffers);
+	    return clib_error_return (0, "no buffers to post on rx queue %u",
+				      i);
+	  }
+	for (j = 0; j < ring_size; j++)
+	  memif_desc_post_buffer (vm, &mq->ring->desc[j],
+				  vlib_get_buffer (vm, mq->buffers[j]));
+      }
   }
 
   return 0;
@@ -672,6 +750,13 @@ memif_create_if (vlib_main_t * vm, memif_create_if_args_t * args)
       goto done;
     }
 
+  /* only the slave, which owns the rings, can post its own buffers */
+  if (args->is_zero_copy && args->is_master)
+    {
+      rv = VNET_API_ERROR_INVALID_ARGUMENT;
+      goto done;
+    }
+
   msf = vec_elt_at_index (mm->socket_files, p[0]);
 
   /* existing socket file can be either master or slave but cannot be both */
@@ -825,6 +910,9 @@ memif_create_if (vlib_main_t * vm, memif_create_if_args_t * args)
   if (args->is_master == 0)
     mif->flags |= MEMIF_IF_FLAG_IS_SLAVE;
 
+  if (args->is_zero_copy)
+    mif->flags |= MEMIF_IF_FLAG_ZERO_COPY;
+
   hw = vnet_get_hw_interface (vnm, mif->hw_if_index);
   hw->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_INT_MODE;
   vnet_hw_interface_set_input_node (vnm, mif->hw_if_index,
@@ -206,6 +206,7 @@ api_memif_create (vat_main_t * vam)
   u32 tx_queues = MEMIF_DEFAULT_TX_QUEUES;
   int ret;
   u8 mode = MEMIF_INTERFACE_MODE_ETHERNET;
+  u8 zero_copy = 0;
 
   while (unformat_check_input (i) != UNFORMAT_END_OF_INPUT)
     {
@@ -228,6 +229,8 @@ api_memif_create (vat_main_t * vam)
 	mode = MEMIF_INTERFACE_MODE_IP;
       else if (unformat (i, "hw_addr %U", unformat_ethernet_address, hw_addr))
 	;
+      else if (unformat (i, "zero-copy"))
+	zero_copy = 1;
       else
 	{
 	  clib_warning ("unknown input '%U'", format_unformat_error, i);
@@ -275,6 +278,7 @@ api_memif_create (vat_main_t * vam)
   memcpy (mp->hw_addr, hw_addr, 6);
   mp->rx_queues = rx_queues;
   mp->tx_queues = tx_queues;
+  mp->zero_copy = zero_copy;
 
   S (mp);
   W (ret);
@@ -376,14 +380,15 @@ vl_api_memif_details_t_handler (vl_api_memif_details_t * mp)
   fformat (vam->ofp, "%s: sw_if_index %u mac %U\n"
 	   "   id %u socket-id %u role %s\n"
 	   "   ring_size %u buffer_size %u\n"
-	   "   state %s link %s\n",
+	   "   state %s link %s%s\n",
 	   mp->if_name, ntohl (mp->sw_if_index), format_ethernet_address,
 	   mp->hw_addr, clib_net_to_host_u32 (mp->id),
 	   clib_net_to_host_u32 (mp->socket_id),
 	   mp->role ? "slave" : "master",
 	   ntohl (mp->ring_size), ntohs (mp->buffer_size),
 	   mp->admin_up_down ? "up" : "down",
-	   mp->link_up_down ? "up" : "down");
+	   mp->link_up_down ? "up" : "down",
+	   mp->zero_copy ? " zero-copy" : "");
 }
 
 /* memif_socket_filename_dump API */
@@ -437,7 +442,8 @@ static void vl_api_memif_socket_filename_details_t_handler
 #define foreach_vpe_api_msg					  \
 _(memif_create, "[id <id>] [socket-id <id>] [ring_size <size>] " \
 		"[buffer_size <size>] [hw_addr <mac_address>] "   \
-		"[secret <string>] [mode ip] <master|slave>")	  \
+		"[secret <string>] [mode ip] <master|slave> "	  \
+		"[zero-copy]")						  \
 _(memif_delete, "<sw_if_index>")                                  \
 _(memif_dump, "")						  \
 _(memif_socket_filename_dump, "")				\
@@ -525,6 +525,160 @@ memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   return n_rx_packets;
 }
 
+/*
+ * Zero-copy receive, slave only: every slot of the M2S ring holds one of
+ * our vlib buffers, posted to the master which writes the packet straight
+ * into it. Filled buffers go up the graph as they are, and a fresh buffer
+ * is posted in each slot before the slot is given back by moving tail.
+ */
+static_always_inline uword
+memif_device_input_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
+			      memif_if_t * mif, u16 qid,
+			      memif_interface_mode_t mode)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  memif_main_t *nm = &memif_main;
+  memif_queue_t *mq = vec_elt_at_index (mif->rx_queues, qid);
+  memif_ring_t *ring = mq->ring;
+  u32 thread_index = vlib_get_thread_index ();
+  u16 ring_size = 1 << mq->log2_ring_size;
+  u16 mask = ring_size - 1;
+  uword n_trace = vlib_get_trace_count (vm, node);
+  u32 n_rx_packets = 0, n_rx_bytes = 0;
+  u32 next_index, n_left_to_next, *to_next;
+  u32 n_free_bufs;
+  u16 head, tail, n_slots;
+
+  head = ring->head;
+  tail = ring->tail;
+  if (head == tail)
+    return 0;
+
+  /* buffers to post in place of the ones handed over */
+  n_free_bufs = vec_len (nm->rx_buffers[thread_index]);
+  if (PREDICT_FALSE (n_free_bufs < ring_size))
+    {
+      vec_validate (nm->rx_buffers[thread_index],
+		    ring_size + n_free_bufs - 1);
+      n_free_bufs +=
+	vlib_buffer_alloc (vm, &nm->rx_buffers[thread_index][n_free_bufs],
+			   ring_size);
+      _vec_len (nm->rx_buffers[thread_index]) = n_free_bufs;
+    }
+
+  /* a slot is only taken when another buffer can replace it */
+  n_slots = clib_min ((u16) (head - tail), n_free_bufs);
+
+  if (mode == MEMIF_INTERFACE_MODE_IP)
+    next_index = VNET_DEVICE_INPUT_NEXT_IP6_INPUT;
+  else
+    next_index = VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
+
+  while (n_slots)
+    {
+      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
+
+      while (n_slots && n_left_to_next)
+	{
+	  vlib_buffer_t *b0, *b, *prev;
+	  u32 bi0, next0 = next_index;
+	  u16 n_seg = 1, i, slot;
+
+	  while (ring->desc[(tail + n_seg - 1) & mask].flags &
+		 MEMIF_DESC_FLAG_NEXT)
+	    if (++n_seg > n_slots)
+	      break;
+
+	  /* the rest of the chain is not there, or cannot be replaced */
+	  if (PREDICT_FALSE (n_seg > n_slots))
+	    {
+	      n_slots = 0;
+	      break;
+	    }
+
+	  if (n_slots > n_seg + 2)
+	    memif_prefetch (vm, mq->buffers[(tail + n_seg) & mask]);
+
+	  slot = tail & mask;
+	  bi0 = mq->buffers[slot];
+	  b0 = prev = vlib_get_buffer (vm, bi0);
+	  b0->current_length = ring->desc[slot].length;
+	  b0->total_length_not_including_first_buffer = 0;
+	  b0->flags = VLIB_BUFFER_TOTAL_LENGTH_VALID;
+	  b0->error = 0;
+	  vnet_buffer (b0)->sw_if_index[VLIB_RX] = mif->sw_if_index;
+	  vnet_buffer (b0)->sw_if_index[VLIB_TX] = (u32) ~ 0;
+
+	  for (i = 1; i < n_seg; i++)
+	    {
+	      slot = (tail + i) & mask;
+	      b = vlib_get_buffer (vm, mq->buffers[slot]);
+	      b->current_length = ring->desc[slot].length;
+	      b->flags = 0;
+	      prev->next_buffer = mq->buffers[slot];
+	      prev->flags |= VLIB_BUFFER_NEXT_PRESENT;
+	      b0->total_length_not_including_first_buffer +=
+		b->current_length;
+	      prev = b;
+	    }
+
+	  /* post fresh buffers in the slots handed over */
+	  for (i = 0; i < n_seg; i++)
+	    {
+	      slot = (tail + i) & mask;
+	      mq->buffers[slot] = nm->rx_buffers[thread_index][--n_free_bufs];
+	      memif_desc_post_buffer (vm, &ring->desc[slot],
+				      vlib_get_buffer (vm,
+						       mq->buffers[slot]));
+	    }
+	  _vec_len (nm->rx_buffers[thread_index]) = n_free_bufs;
+	  tail += n_seg;
+	  n_slots -= n_seg;
+
+	  if (mode == MEMIF_INTERFACE_MODE_IP)
+	    next0 = memif_next_from_ip_hdr (node, b0);
+	  else if (PREDICT_FALSE (mif->per_interface_next_index != ~0))
+	    next0 = mif->per_interface_next_index;
+	  else
+	    vnet_feature_start_device_input_x1 (mif->sw_if_index, &next0, b0);
+
+	  VLIB_BUFFER_TRACE_TRAJECTORY_INIT (b0);
+
+	  if (PREDICT_FALSE (n_trace > 0))
+	    {
+	      memif_input_trace_t *tr;
+	      vlib_trace_buffer (vm, node, next0, b0, /* follow_chain */ 0);
+	      vlib_set_trace_count (vm, node, --n_trace);
+	      tr = vlib_add_trace (vm, node, b0, sizeof (*tr));
+	      tr->next_index = next0;
+	      tr->hw_if_index = mif->hw_if_index;
+	      tr->ring = qid;
+	    }
+
+	  to_next[0] = bi0;
+	  to_next += 1;
+	  n_left_to_next--;
+	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index, to_next,
+					   n_left_to_next, bi0, next0);
+
+	  n_rx_packets++;
+	  n_rx_bytes += b0->current_length +
+	    b0->total_length_not_including_first_buffer;
+	}
+      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+    }
+
+  CLIB_MEMORY_STORE_BARRIER ();
+  ring->tail = tail;
+
+  vlib_increment_combined_counter (vnm->interface_main.combined_sw_if_counters
+				   + VNET_INTERFACE_COUNTER_RX, thread_index,
+				   mif->hw_if_index, n_rx_packets,
+				   n_rx_bytes);
+
+  return n_rx_packets;
+}
+
 uword
 CLIB_MULTIARCH_FN (memif_input_fn) (vlib_main_t * vm,
 				    vlib_node_runtime_t * node,
@@ -542,7 +696,18 @@ CLIB_MULTIARCH_FN (memif_input_fn) (vlib_main_t * vm,
     if ((mif->flags & MEMIF_IF_FLAG_ADMIN_UP) &&
 	(mif->flags & MEMIF_IF_FLAG_CONNECTED))
       {
-	if (mif->flags & MEMIF_IF_FLAG_IS_SLAVE)
+	if (mif->flags & MEMIF_IF_FLAG_ZERO_COPY)
+	  {
+	    if (mif->mode == MEMIF_INTERFACE_MODE_IP)
+	      n_rx += memif_device_input_zc_inline (vm, node, mif,
+						    dq->queue_id,
+						    MEMIF_INTERFACE_MODE_IP);
+	    else
+	      n_rx += memif_device_input_zc_inline (vm, node, mif,
+						    dq->queue_id,
+						    MEMIF_INTERFACE_MODE_ETHERNET);
+	  }
+	else if (mif->flags & MEMIF_IF_FLAG_IS_SLAVE)
 	  {
 	    if (mif->mode == MEMIF_INTERFACE_MODE_IP)
 	      n_rx += memif_device_input_inline (vm, node, frame, mif,
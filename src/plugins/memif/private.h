@@ -83,6 +83,9 @@ typedef struct
   void *shm;
   memif_region_size_t region_size;
   int fd;
+
+  /* vlib buffer memory exposed to the peer, not ours to unmap or close */
+  u8 is_external;
 } memif_region_t;
 
 typedef struct
@@ -107,6 +110,9 @@ typedef struct
   uword int_clib_file_index;
   u64 int_count;
 
+  /* zero-copy: vlib buffer index posted in each ring slot */
+  u32 *buffers;
+
   /* queue type */
   memif_ring_type_t type;
 } memif_queue_t;
@@ -116,7 +122,8 @@ typedef struct
   _(1, IS_SLAVE, "slave")		\
   _(2, CONNECTING, "connecting")	\
   _(3, CONNECTED, "connected")		\
-  _(4, DELETING, "deleting")
+  _(4, DELETING, "deleting")		\
+  _(5, ZERO_COPY, "zero-copy")
 
 typedef enum
 {
@@ -216,6 +223,7 @@ typedef struct
   u8 hw_addr[6];
   u8 rx_queues;
   u8 tx_queues;
+  u8 is_zero_copy;
 
   /* return */
   u32 sw_if_index;
@@ -234,6 +242,33 @@ memif_get_buffer (memif_if_t * mif, memif_ring_t * ring, u16 slot)
   return mif->regions[region].shm + ring->desc[slot].offset;
 }
 
+/*
+ * Zero-copy: point a descriptor at the current data of a vlib buffer.
+ * The buffer pools are exposed to the peer in order, as the regions
+ * following region 0.
+ */
+static_always_inline void
+memif_desc_set_vlib_buffer (vlib_main_t * vm, memif_desc_t * d,
+			    vlib_buffer_t * b)
+{
+  vlib_buffer_pool_t *bp = vec_elt_at_index (vm->buffer_main->buffer_pools,
+					     b->buffer_pool_index);
+  d->region = 1 + b->buffer_pool_index;
+  d->offset = pointer_to_uword (vlib_buffer_get_current (b)) - bp->start;
+}
+
+/* Zero-copy: hand an empty buffer to the peer, to be filled on rx */
+static_always_inline void
+memif_desc_post_buffer (vlib_main_t * vm, memif_desc_t * d,
+			vlib_buffer_t * b)
+{
+  b->current_data = 0;
+  memif_desc_set_vlib_buffer (vm, d, b);
+  d->buffer_length = VLIB_BUFFER_DATA_SIZE;
+  d->length = 0;
+  d->flags = 0;
+}
+
 /* memif.c */
 clib_error_t *memif_init_regions_and_queues (memif_if_t * mif);
 clib_error_t *memif_connect (memif_if_t * mif);
@@ -0,0 +1,44 @@
+from trex_stl_lib.api import *
+
+class STLS1(object):
+
+    def __init__ (self):
+        self.ip_range = {'local': {'start': "10.0.0.3", 'end': "10.1.255.255"},
+                         'remote': {'start': "2.2.0.1", 'end': "2.2.255.254"}}
+
+    def create_stream (self, vm):
+        # GRE is not translated by port: every session is endpoint dependent
+        base_pkt = Ether()/IP(proto=47)
+
+        if len(base_pkt) < 64:
+            pad_len = 64 - len(base_pkt)
+            pad = Padding()
+            pad.load = '\x00' * pad_len
+            base_pkt = base_pkt/pad
+
+        pkt = STLPktBuilder(pkt=base_pkt, vm=vm)
+        return STLStream(packet=pkt, mode=STLTXCont())
+
+    def get_streams (self, direction = 0, **kwargs):
+        ip_src = self.ip_range['local']
+        ip_dst = self.ip_range['remote']
+
+        vm = STLVM()
+
+        vm.var(name="ip_src", min_value=ip_src['start'], max_value=ip_src['end'], size=4, op="random")
+        vm.var(name="ip_dst", min_value=ip_dst['start'], max_value=ip_dst['end'], size=4, op="random")
+
+        vm.write(fv_name="ip_src", pkt_offset="IP.src")
+        vm.write(fv_name="ip_dst", pkt_offset="IP.dst")
+
+        vm.fix_chksum()
+
+        return [ self.create_stream(vm) ]
+
+
+# dynamic load - used for trex console or simulator
+def register():
+    return STLS1()
+
+
+
@@ -290,6 +290,7 @@ static u32 slow_path (snat_main_t *sm, vlib_buffer_t *b0,
   u32 outside_fib_index;
   uword * p;
   udp_header_t * udp0 = ip4_next_header (ip0);
+  u8 is_port_block = 0;
 
   if (PREDICT_FALSE (maximum_sessions_exceeded(sm, thread_index)))
     {
@@ -320,11 +321,21 @@ static u32 slow_path (snat_main_t *sm, vlib_buffer_t *b0,
   if (snat_static_mapping_match (sm, *key0, &key1, 0, 0, 0))
     {
       /* Try to create dynamic translation */
-      if (snat_alloc_outside_address_and_port (sm->addresses, rx_fib_index0,
-                                               thread_index, &key1,
-                                               &address_index,
-                                               sm->port_per_thread,
-                                               sm->per_thread_data[thread_index].snat_thread_index))
+      if (sm->port_block_size)
+        {
+          if (nat44_port_block_alloc_port (sm, u, rx_fib_index0, thread_index,
+                                           &key1, &address_index))
+            {
+              b0->error = node->errors[SNAT_IN2OUT_ERROR_OUT_OF_PORTS];
+              return SNAT_IN2OUT_NEXT_DROP;
+            }
+          is_port_block = 1;
+        }
+      else if (snat_alloc_outside_address_and_port (sm->addresses, rx_fib_index0,
+                                                    thread_index, &key1,
+                                                    &address_index,
+                                                    sm->port_per_thread,
+                                                    sm->per_thread_data[thread_index].snat_thread_index))
         {
           b0->error = node->errors[SNAT_IN2OUT_ERROR_OUT_OF_PORTS];
           return SNAT_IN2OUT_NEXT_DROP;
@@ -345,6 +356,8 @@ static u32 slow_path (snat_main_t *sm, vlib_buffer_t *b0,
 
   if (address_index == ~0)
     s->flags |= SNAT_SESSION_FLAG_STATIC_MAPPING;
+  if (is_port_block)
+    s->flags |= SNAT_SESSION_FLAG_PORT_BLOCK;
   s->outside_address_index = address_index;
   s->in2out = *key0;
   s->out2in = key1;
@@ -368,13 +381,14 @@ static u32 slow_path (snat_main_t *sm, vlib_buffer_t *b0,
                                1 /* is_add */))
       clib_warning ("out2in key add failed");
 
-  /* log NAT event */
-  snat_ipfix_logging_nat44_ses_create(s->in2out.addr.as_u32,
-                                      s->out2in.addr.as_u32,
-                                      s->in2out.protocol,
-                                      s->in2out.port,
-                                      s->out2in.port,
-                                      s->in2out.fib_index);
+  /* log NAT event, the allocation of the port's block was logged instead */
+  if (!is_port_block)
+    snat_ipfix_logging_nat44_ses_create(s->in2out.addr.as_u32,
+                                        s->out2in.addr.as_u32,
+                                        s->in2out.protocol,
+                                        s->in2out.port,
+                                        s->out2in.port,
+                                        s->in2out.fib_index);
   return next0;
 }
 
@@ -471,8 +485,10 @@ icmp_get_ed_key(ip4_header_t *ip0, nat_ed_ses_key_t *p_key0)
 }
 
 static inline int
-nat_not_translate_output_feature_fwd (snat_main_t * sm, ip4_header_t * ip)
+nat_not_translate_output_feature_fwd (snat_main_t * sm, ip4_header_t * ip,
+                                      u32 thread_index)
 {
+  snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
   nat_ed_ses_key_t key;
   clib_bihash_kv_16_8_t kv, value;
   udp_header_t *udp;
@@ -505,7 +521,7 @@ nat_not_translate_output_feature_fwd (snat_main_t * sm, ip4_header_t * ip)
   kv.key[0] = key.as_u64[0];
   kv.key[1] = key.as_u64[1];
 
-  if (!clib_bihash_search_16_8 (&sm->in2out_ed, &kv, &value))
+  if (!clib_bihash_search_16_8 (&tsm->in2out_ed, &kv, &value))
     return value.value == ~0ULL;
 
   return 0;
@@ -618,7 +634,8 @@ u32 icmp_match_in2out_slow(snat_main_t *sm, vlib_node_runtime_t *node,
           key.fib_index = rx_fib_index0;
           s_kv.key[0] = key.as_u64[0];
           s_kv.key[1] = key.as_u64[1];
-          if (!clib_bihash_search_16_8 (&sm->in2out_ed, &s_kv, &s_value))
+          if (!clib_bihash_search_16_8 (&sm->per_thread_data[thread_index].in2out_ed,
+                                        &s_kv, &s_value))
             s0 = pool_elt_at_index (sm->per_thread_data[thread_index].sessions,
                                     s_value.value);
           else
@@ -1053,7 +1070,7 @@ snat_hairpinning_unknown_proto (snat_main_t *sm,
                                 vlib_buffer_t * b,
                                 ip4_header_t * ip)
 {
-  u32 old_addr, new_addr = 0, ti = 0;
+  u32 old_addr, new_addr = 0, ti;
   clib_bihash_kv_8_8_t kv, value;
   clib_bihash_kv_16_8_t s_kv, s_value;
   nat_ed_ses_key_t key;
@@ -1071,7 +1088,8 @@ snat_hairpinning_unknown_proto (snat_main_t *sm,
   key.l_port = 0;
   s_kv.key[0] = key.as_u64[0];
   s_kv.key[1] = key.as_u64[1];
-  if (clib_bihash_search_16_8 (&sm->out2in_ed, &s_kv, &s_value))
+  ti = nat_ed_out2in_owner (sm, &s_kv, &s_value);
+  if (ti == ~0)
     {
       m_key.addr = ip->dst_address;
       m_key.fib_index = sm->outside_fib_index;
@@ -1088,11 +1106,6 @@ snat_hairpinning_unknown_proto (snat_main_t *sm,
     }
   else
     {
-      if (sm->num_workers > 1)
-        ti = sm->worker_out2in_cb (ip, sm->outside_fib_index);
-      else
-        ti = sm->num_workers;
-
       s = pool_elt_at_index (sm->per_thread_data[ti].sessions, s_value.value);
       if (vnet_buffer(b)->sw_if_index[VLIB_TX] == ~0)
         vnet_buffer(b)->sw_if_index[VLIB_TX] = s->in2out.fib_index;
@@ -1140,7 +1153,7 @@ snat_in2out_unknown_proto (snat_main_t *sm,
   s_kv.key[0] = key.as_u64[0];
   s_kv.key[1] = key.as_u64[1];
 
-  if (!clib_bihash_search_16_8 (&sm->in2out_ed, &s_kv, &s_value))
+  if (!clib_bihash_search_16_8 (&tsm->in2out_ed, &s_kv, &s_value))
     {
       s = pool_elt_at_index (tsm->sessions, s_value.value);
       new_addr = ip->src_address.as_u32 = s->out2in.addr.as_u32;
@@ -1203,7 +1216,7 @@ snat_in2out_unknown_proto (snat_main_t *sm,
                       key.l_addr.as_u32 = new_addr;
                       s_kv.key[0] = key.as_u64[0];
                       s_kv.key[1] = key.as_u64[1];
-                      if (clib_bihash_search_16_8 (&sm->out2in_ed, &s_kv, &s_value))
+                      if (nat_ed_out2in_owner (sm, &s_kv, &s_value) == ~0)
                         break;
 
                       goto create_ses;
@@ -1216,7 +1229,8 @@ snat_in2out_unknown_proto (snat_main_t *sm,
               key.l_addr.as_u32 = sm->addresses[i].addr.as_u32;
               s_kv.key[0] = key.as_u64[0];
               s_kv.key[1] = key.as_u64[1];
-              if (clib_bihash_search_16_8 (&sm->out2in_ed, &s_kv, &s_value))
+              /* the address must be free for this remote on any thread */
+              if (nat_ed_out2in_owner (sm, &s_kv, &s_value) == ~0)
                 {
                   new_addr = ip->src_address.as_u32 = key.l_addr.as_u32;
                   address_index = i;
@@ -1260,14 +1274,14 @@ create_ses:
       s_kv.key[0] = key.as_u64[0];
       s_kv.key[1] = key.as_u64[1];
       s_kv.value = s - tsm->sessions;
-      if (clib_bihash_add_del_16_8 (&sm->in2out_ed, &s_kv, 1))
+      if (clib_bihash_add_del_16_8 (&tsm->in2out_ed, &s_kv, 1))
         clib_warning ("in2out key add failed");
 
       key.l_addr.as_u32 = new_addr;
       key.fib_index = sm->outside_fib_index;
       s_kv.key[0] = key.as_u64[0];
       s_kv.key[1] = key.as_u64[1];
-      if (clib_bihash_add_del_16_8 (&sm->out2in_ed, &s_kv, 1))
+      if (clib_bihash_add_del_16_8 (&tsm->out2in_ed, &s_kv, 1))
         clib_warning ("out2in key add failed");
   }
 
@@ -1329,7 +1343,7 @@ snat_in2out_lb (snat_main_t *sm,
   s_kv.key[0] = key.as_u64[0];
   s_kv.key[1] = key.as_u64[1];
 
-  if (!clib_bihash_search_16_8 (&sm->in2out_ed, &s_kv, &s_value))
+  if (!clib_bihash_search_16_8 (&tsm->in2out_ed, &s_kv, &s_value))
     {
       if (s_value.value == ~0ULL)
         return 0;
@@ -1377,7 +1391,7 @@ snat_in2out_lb (snat_main_t *sm,
 
       /* Add to lookup tables */
       s_kv.value = s - tsm->sessions;
-      if (clib_bihash_add_del_16_8 (&sm->in2out_ed, &s_kv, 1))
+      if (clib_bihash_add_del_16_8 (&tsm->in2out_ed, &s_kv, 1))
         clib_warning ("in2out-ed key add failed");
 
       key.l_addr = e_key.addr;
@@ -1385,7 +1399,7 @@ snat_in2out_lb (snat_main_t *sm,
       key.l_port = e_key.port;
       s_kv.key[0] = key.as_u64[0];
       s_kv.key[1] = key.as_u64[1];
-      if (clib_bihash_add_del_16_8 (&sm->out2in_ed, &s_kv, 1))
+      if (clib_bihash_add_del_16_8 (&tsm->out2in_ed, &s_kv, 1))
         clib_warning ("out2in-ed key add failed");
     }
 
@@ -1419,6 +1433,7 @@ snat_in2out_lb (snat_main_t *sm,
           ip->dst_address.as_u32 = s->ext_host_addr.as_u32;
         }
       tcp->checksum = ip_csum_fold(sum);
+      nat44_session_update_tcp (sm, s, tcp, thread_index, 1);
     }
   else
     {
@@ -1570,7 +1585,7 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
             {
               if (is_output_feature)
                 {
-                  if (PREDICT_FALSE(nat_not_translate_output_feature_fwd(sm, ip0)))
+                  if (PREDICT_FALSE(nat_not_translate_output_feature_fwd(sm, ip0, thread_index)))
                     goto trace00;
                 }
 
@@ -1677,6 +1692,7 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
                                      ip4_header_t /* cheat */,
                                      length /* changed member */);
               tcp0->checksum = ip_csum_fold(sum0);
+              nat44_session_update_tcp (sm, s0, tcp0, thread_index, 1);
             }
           else
             {
@@ -1762,7 +1778,7 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
             {
               if (is_output_feature)
                 {
-                  if (PREDICT_FALSE(nat_not_translate_output_feature_fwd(sm, ip1)))
+                  if (PREDICT_FALSE(nat_not_translate_output_feature_fwd(sm, ip1, thread_index)))
                     goto trace01;
                 }
 
@@ -1869,6 +1885,7 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
                                      ip4_header_t /* cheat */,
                                      length /* changed member */);
               tcp1->checksum = ip_csum_fold(sum1);
+              nat44_session_update_tcp (sm, s1, tcp1, thread_index, 1);
             }
           else
             {
@@ -1990,7 +2007,7 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
             {
                if (is_output_feature)
                 {
-                  if (PREDICT_FALSE(nat_not_translate_output_feature_fwd(sm, ip0)))
+                  if (PREDICT_FALSE(nat_not_translate_output_feature_fwd(sm, ip0, thread_index)))
                     goto trace0;
                 }
 
@@ -2098,6 +2115,7 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
                                      ip4_header_t /* cheat */,
                                      length /* changed member */);
               tcp0->checksum = ip_csum_fold(sum0);
+              nat44_session_update_tcp (sm, s0, tcp0, thread_index, 1);
             }
           else
             {
@@ -2630,6 +2648,7 @@ nat44_in2out_reass_node_fn (vlib_main_t * vm,
                                          ip4_header_t /* cheat */,
                                          length /* changed member */);
                   tcp0->checksum = ip_csum_fold(sum0);
+                  nat44_session_update_tcp (sm, s0, tcp0, thread_index, 1);
                 }
               else
                 {
@@ -140,6 +140,9 @@ typedef enum {
   NAT44_CLASSIFY_N_NEXT,
 } nat44_classify_next_t;
 
+static void nat44_port_block_del_address (snat_main_t * sm,
+                                          u32 address_index);
+
 void
 nat_free_session_data (snat_main_t * sm, snat_session_t * s, u32 thread_index)
 {
@@ -152,6 +155,13 @@ nat_free_session_data (snat_main_t * sm, snat_session_t * s, u32 thread_index)
   snat_main_per_thread_data_t *tsm =
     vec_elt_at_index (sm->per_thread_data, thread_index);
 
+  if (s->expire_timer_handle != ~0)
+    {
+      tw_timer_stop_1t_3w_1024sl_ov (&tsm->session_timers,
+                                     s->expire_timer_handle);
+      s->expire_timer_handle = ~0;
+    }
+
   /* Endpoint dependent session lookup tables */
   if (is_ed_session (s))
     {
@@ -172,7 +182,7 @@ nat_free_session_data (snat_main_t * sm, snat_session_t * s, u32 thread_index)
         }
       ed_kv.key[0] = ed_key.as_u64[0];
       ed_kv.key[1] = ed_key.as_u64[1];
-      if (clib_bihash_add_del_16_8 (&sm->out2in_ed, &ed_kv, 0))
+      if (clib_bihash_add_del_16_8 (&tsm->out2in_ed, &ed_kv, 0))
         clib_warning ("out2in_ed key del failed");
 
       ed_key.l_addr = s->in2out.addr;
@@ -186,20 +196,21 @@ nat_free_session_data (snat_main_t * sm, snat_session_t * s, u32 thread_index)
         }
       ed_kv.key[0] = ed_key.as_u64[0];
       ed_kv.key[1] = ed_key.as_u64[1];
-      if (clib_bihash_add_del_16_8 (&sm->in2out_ed, &ed_kv, 0))
+      if (clib_bihash_add_del_16_8 (&tsm->in2out_ed, &ed_kv, 0))
         clib_warning ("in2out_ed key del failed");
     }
 
   if (snat_is_unk_proto_session (s))
     return;
 
-  /* log NAT event */
-  snat_ipfix_logging_nat44_ses_delete(s->in2out.addr.as_u32,
-                                      s->out2in.addr.as_u32,
-                                      s->in2out.protocol,
-                                      s->in2out.port,
-                                      s->out2in.port,
-                                      s->in2out.fib_index);
+  /* log NAT event, for a port of a block its release is logged instead */
+  if (!(s->flags & SNAT_SESSION_FLAG_PORT_BLOCK))
+    snat_ipfix_logging_nat44_ses_delete(s->in2out.addr.as_u32,
+                                        s->out2in.addr.as_u32,
+                                        s->in2out.protocol,
+                                        s->in2out.port,
+                                        s->out2in.port,
+                                        s->in2out.fib_index);
 
   /* Twice NAT address and port for external host */
   if (is_twice_nat_session (s))
@@ -232,7 +243,12 @@ nat_free_session_data (snat_main_t * sm, snat_session_t * s, u32 thread_index)
   if (snat_is_session_static (s))
     return;
 
-  if (s->outside_address_index != ~0)
+  if (s->outside_address_index == ~0)
+    return;
+
+  if (s->flags & SNAT_SESSION_FLAG_PORT_BLOCK)
+    nat44_port_block_free_port (sm, s, thread_index);
+  else
     snat_free_outside_address_and_port (sm->addresses, thread_index,
                                         &s->out2in, s->outside_address_index);
 }
@@ -318,12 +334,14 @@ nat_session_alloc_or_recycle (snat_main_t *sm, snat_user_t *u, u32 thread_index)
       s->flags = 0;
       s->total_bytes = 0;
       s->total_pkts = 0;
+      tsm->sessions_recycled++;
     }
   else
     {
       pool_get (tsm->sessions, s);
       memset (s, 0, sizeof (*s));
       s->outside_address_index = ~0;
+      s->expire_timer_handle = ~0;
 
       /* Create list elts */
       pool_get (tsm->list_pool, per_user_translation_list_elt);
@@ -339,9 +357,45 @@ nat_session_alloc_or_recycle (snat_main_t *sm, snat_user_t *u, u32 thread_index)
                           per_user_translation_list_elt - tsm->list_pool);
     }
 
+  /* Protocol not known yet, the first expiry extends the timer if need be */
+  nat44_session_set_expiry (sm, s, thread_index,
+                            clib_min (clib_min (sm->udp_timeout,
+                                                sm->icmp_timeout),
+                                      sm->tcp_transitory_timeout));
+
   return s;
 }
 
+void
+nat44_delete_session (snat_main_t * sm, snat_session_t * s, u32 thread_index)
+{
+  snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
+  snat_user_key_t u_key;
+  clib_bihash_kv_8_8_t kv, value;
+  snat_user_t *u;
+
+  nat_free_session_data (sm, s, thread_index);
+
+  u_key.addr = s->in2out.addr;
+  u_key.fib_index = s->in2out.fib_index;
+  kv.key = u_key.as_u64;
+  if (!clib_bihash_search_8_8 (&tsm->user_hash, &kv, &value))
+    {
+      u = pool_elt_at_index (tsm->users, value.value);
+      if (snat_is_session_static (s))
+        {
+          if (u->nstaticsessions)
+            u->nstaticsessions--;
+        }
+      else if (u->nsessions)
+        u->nsessions--;
+    }
+
+  clib_dlist_remove (tsm->list_pool, s->per_user_index);
+  pool_put_index (tsm->list_pool, s->per_user_index);
+  pool_put (tsm->sessions, s);
+}
+
 static inline uword
 nat44_classify_node_fn_inline (vlib_main_t * vm,
                                vlib_node_runtime_t * node,
@@ -997,6 +1051,8 @@ int snat_add_static_mapping(ip4_address_t l_addr, ip4_address_t e_addr,
                     }
                   if (addr_only)
                     {
+                      nat44_port_block_release_all (sm, u,
+                                                    tsm - sm->per_thread_data);
                       pool_put (tsm->users, u);
                       clib_bihash_add_del_8_8 (&tsm->user_hash, &kv, 0);
                     }
@@ -1392,8 +1448,9 @@ snat_del_address (snat_main_t *sm, ip4_address_t addr, u8 delete_sm,
       vec_del1 (sm->twice_nat_addresses, i);
       return 0;
     }
-  else
-    vec_del1 (sm->addresses, i);
+
+  nat44_port_block_del_address (sm, i);
+  vec_del1 (sm->addresses, i);
 
   /* Delete external address from FIB */
   pool_foreach (interface, sm->interfaces,
@@ -2166,9 +2223,6 @@ snat_get_worker_out2in_cb (ip4_header_t * ip0, u32 rx_fib_index0)
   snat_static_mapping_t *m;
   nat_ed_ses_key_t key;
   clib_bihash_kv_16_8_t s_kv, s_value;
-  snat_main_per_thread_data_t *tsm;
-  snat_session_t *s;
-  int i;
   u32 proto;
   u32 next_worker_index = 0;
 
@@ -2222,21 +2276,10 @@ snat_get_worker_out2in_cb (ip4_header_t * ip0, u32 rx_fib_index0)
       s_kv.key[0] = key.as_u64[0];
       s_kv.key[1] = key.as_u64[1];
 
-      if (!clib_bihash_search_16_8 (&sm->out2in_ed, &s_kv, &s_value))
-        {
-          for (i = 0; i < _vec_len (sm->per_thread_data); i++)
-            {
-              tsm = vec_elt_at_index (sm->per_thread_data, i);
-              if (!pool_is_free_index(tsm->sessions, s_value.value))
-                {
-                  s = pool_elt_at_index (tsm->sessions, s_value.value);
-                  if (s->out2in.addr.as_u32 == ip0->dst_address.as_u32 &&
-                      s->out2in.port == ip0->protocol &&
-                      snat_is_unk_proto_session (s))
-                    return i;
-                }
-            }
-         }
+      /* the thread which created the session */
+      next_worker_index = nat_ed_out2in_owner (sm, &s_kv, &s_value);
+      if (next_worker_index != ~0)
+        return next_worker_index;
 
       /* if no session use current thread */
       return vlib_get_thread_index ();
@@ -2292,6 +2335,115 @@ snat_get_worker_out2in_cb (ip4_header_t * ip0, u32 rx_fib_index0)
   return next_worker_index;
 }
 
+/**
+ * @brief Per worker walk deleting the NAT44 sessions whose timer expired.
+ */
+static uword
+nat44_session_expire_worker_walk_fn (vlib_main_t * vm,
+                                     vlib_node_runtime_t * rt,
+                                     vlib_frame_t * f)
+{
+  snat_main_t *sm = &snat_main;
+  u32 thread_index = vlib_get_thread_index ();
+  snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
+  f64 now = vlib_time_now (vm);
+  snat_session_t *s;
+  u32 *si, timeout;
+  f64 idle;
+
+  vec_reset_length (tsm->expired_sessions);
+  tsm->expired_sessions =
+    tw_timer_expire_timers_vec_1t_3w_1024sl_ov (&tsm->session_timers, now,
+                                                tsm->expired_sessions);
+
+  vec_foreach (si, tsm->expired_sessions)
+    {
+      s = pool_elt_at_index (tsm->sessions, si[0]);
+      s->expire_timer_handle = ~0;
+
+      /* Heard from since the timer was started? */
+      timeout = nat44_session_get_timeout (sm, s);
+      idle = now - s->last_heard;
+      if (idle < timeout)
+        {
+          nat44_session_set_expiry (sm, s, thread_index,
+                                    (u32) (timeout - idle) + 1);
+          continue;
+        }
+
+      nat44_delete_session (sm, s, thread_index);
+      tsm->sessions_expired++;
+    }
+
+  /* A full batch, the wheel may have more: come back next loop */
+  if (vec_len (tsm->expired_sessions) >= NAT44_SESSION_EXPIRE_BATCH)
+    vlib_node_set_interrupt_pending (vm, rt->node_index);
+
+  return 0;
+}
+
+static vlib_node_registration_t nat44_session_expire_worker_walk_node;
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (nat44_session_expire_worker_walk_node, static) = {
+    .function = nat44_session_expire_worker_walk_fn,
+    .type = VLIB_NODE_TYPE_INPUT,
+    .state = VLIB_NODE_STATE_INTERRUPT,
+    .name = "nat44-session-expire-worker-walk",
+};
+/* *INDENT-ON* */
+
+/**
+ * @brief Centralized process to drive per worker session expiry.
+ */
+static uword
+nat44_session_expire_walk_fn (vlib_main_t * vm, vlib_node_runtime_t * rt,
+                              vlib_frame_t * f)
+{
+  snat_main_t *sm = &snat_main;
+  vlib_main_t **worker_vms = 0, *worker_vm;
+  u32 node_index = nat44_session_expire_worker_walk_node.index;
+  int i;
+
+  /* No sessions to expire with deterministic or static mapping only NAT */
+  if (sm->deterministic ||
+      (sm->static_mapping_only && !sm->static_mapping_connection_tracking))
+    return 0;
+
+  if (vec_len (vlib_mains) == 0)
+    vec_add1 (worker_vms, vm);
+  else
+    {
+      for (i = 0; i < vec_len (vlib_mains); i++)
+        {
+          worker_vm = vlib_mains[i];
+          if (worker_vm)
+            vec_add1 (worker_vms, worker_vm);
+        }
+    }
+
+  while (1)
+    {
+      vlib_process_suspend (vm, 1.0);
+
+      for (i = 0; i < vec_len (worker_vms); i++)
+        {
+          worker_vm = worker_vms[i];
+          vlib_node_set_interrupt_pending (worker_vm, node_index);
+        }
+    }
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (nat44_session_expire_walk_node, static) = {
+    .function = nat44_session_expire_walk_fn,
+    .type = VLIB_NODE_TYPE_PROCESS,
+    .name = "nat44-session-expire-walk",
+};
+/* *INDENT-ON* */
+
 static clib_error_t *
 snat_config (vlib_main_t * vm, unformat_input_t * input)
 {
@@ -2418,13 +2570,20 @@ snat_config (vlib_main_t * vm, unformat_input_t * input)
 
               clib_bihash_init_8_8 (&tsm->user_hash, "users", user_buckets,
                                     user_memory_size);
-            }
 
-          clib_bihash_init_16_8 (&sm->in2out_ed, "in2out-ed",
-                                 translation_buckets, translation_memory_size);
+              clib_bihash_init_16_8 (&tsm->in2out_ed, "in2out-ed",
+                                     translation_buckets,
+                                     translation_memory_size);
+
+              clib_bihash_init_16_8 (&tsm->out2in_ed, "out2in-ed",
+                                     translation_buckets,
+                                     translation_memory_size);
 
-          clib_bihash_init_16_8 (&sm->out2in_ed, "out2in-ed",
-                                 translation_buckets, translation_memory_size);
+              tw_timer_wheel_init_1t_3w_1024sl_ov (&tsm->session_timers, 0,
+                                                   1.0 /* seconds */,
+                                                   NAT44_SESSION_EXPIRE_BATCH);
+              tsm->session_timers.last_run_time = vlib_time_now (vm);
+            }
         }
       else
         {
@@ -2532,6 +2691,8 @@ u8 * format_snat_user (u8 * s, va_list * args)
   u32 elt_index, head_index;
   u32 session_index;
   snat_session_t * sess;
+  nat44_port_block_t * b;
+  snat_address_t * a;
 
   s = format (s, "%U: %d dynamic translations, %d static translations\n",
               format_ip4_address, &u->addr, u->nsessions, u->nstaticsessions);
@@ -2539,6 +2700,14 @@ u8 * format_snat_user (u8 * s, va_list * args)
   if (verbose == 0)
     return s;
 
+  vec_foreach (b, u->port_blocks)
+    {
+      a = vec_elt_at_index (snat_main.addresses, b->address_index);
+      s = format (s, "  port block %U:%d-%d, %d ports in use\n",
+                  format_ip4_address, &a->addr, b->start,
+                  b->start + b->size - 1, b->n_busy);
+    }
+
   if (u->nsessions || u->nstaticsessions)
     {
       head_index = u->sessions_per_user_list_head_index;
@@ -2816,8 +2985,6 @@ nat44_del_session (snat_main_t *sm, ip4_address_t *addr, u16 port,
   snat_session_key_t key;
   snat_session_t *s;
   clib_bihash_8_8_t *t;
-  snat_user_key_t u_key;
-  snat_user_t *u;
 
   ip.dst_address.as_u32 = ip.src_address.as_u32 = addr->as_u32;
   if (sm->num_workers)
@@ -2836,20 +3003,7 @@ nat44_del_session (snat_main_t *sm, ip4_address_t *addr, u16 port,
   if (!clib_bihash_search_8_8 (t, &kv, &value))
     {
       s = pool_elt_at_index (tsm->sessions, value.value);
-      kv.key = s->in2out.as_u64;
-      clib_bihash_add_del_8_8 (&tsm->in2out, &kv, 0);
-      kv.key = s->out2in.as_u64;
-      clib_bihash_add_del_8_8 (&tsm->out2in, &kv, 0);
-      u_key.addr = s->in2out.addr;
-      u_key.fib_index = s->in2out.fib_index;
-      kv.key = u_key.as_u64;
-      if (!clib_bihash_search_8_8 (&tsm->user_hash, &kv, &value))
-        {
-          u = pool_elt_at_index (tsm->users, value.value);
-          u->nsessions--;
-        }
-      clib_dlist_remove (tsm->list_pool, s->per_user_index);
-      pool_put (tsm->sessions, s);
+      nat44_delete_session (sm, s, tsm - sm->per_thread_data);
       return 0;
     }
 
@@ -2865,6 +3019,7 @@ nat_set_alloc_addr_and_port_mape (u16 psid, u16 psid_offset, u16 psid_length)
   sm->psid = psid;
   sm->psid_offset = psid_offset;
   sm->psid_length = psid_length;
+  sm->port_block_size = 0;
 }
 
 void
@@ -2873,5 +3028,294 @@ nat_set_alloc_addr_and_port_default (void)
   snat_main_t *sm = &snat_main;
 
   sm->alloc_addr_and_port = nat_alloc_addr_and_port_default;
+  sm->port_block_size = 0;
+}
+
+/**
+ * @brief Set port block allocation mode.
+ *
+ * Each user gets blocks of block_size ports of an outside address, in the
+ * port range of its thread, and its dynamic sessions take their ports
+ * from them. Only the allocation and release of blocks are logged.
+ * Blocks already assigned keep their size.
+ */
+int
+nat_set_alloc_addr_and_port_port_block (u16 block_size)
+{
+  snat_main_t *sm = &snat_main;
+
+  if (block_size == 0 || block_size > sm->port_per_thread)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  /* NAT64, DS-Lite and twice NAT still take single ports */
+  sm->alloc_addr_and_port = nat_alloc_addr_and_port_default;
+  sm->port_block_size = block_size;
+
+  return 0;
+}
+
+static_always_inline int
+nat44_port_block_get_port (nat44_port_block_t * b, snat_protocol_t proto,
+                           u16 * offset)
+{
+  switch (proto)
+    {
+#define _(N, i, n, s) \
+    case SNAT_PROTOCOL_##N: \
+      if (vec_len (b->n##_free_ports)) \
+        { \
+          *offset = vec_pop (b->n##_free_ports); \
+          return 0; \
+        } \
+      if (b->n##_next_port < b->size) \
+        { \
+          *offset = b->n##_next_port++; \
+          return 0; \
+        } \
+      return 1;
+      foreach_snat_protocol
+#undef _
+    default:
+      return 1;
+    }
+}
+
+/* Find a block of free ports, of all protocols, in the range of a thread */
+static int
+nat44_port_block_find (snat_address_t * a, u16 size, u16 port_per_thread,
+                       u32 snat_thread_index, u16 * startp)
+{
+  uword base = port_per_thread * snat_thread_index + 1025;
+  uword start, next;
+
+  for (start = base; start + size <= base + port_per_thread; start += size)
+    {
+      next = start + size;
+#define _(N, i, n, s) \
+      next = clib_min (next, clib_bitmap_next_set (a->busy_##n##_port_bitmap, \
+                                                   start));
+      foreach_snat_protocol
+#undef _
+      if (next == start + size)
+        {
+          *startp = start;
+          return 0;
+        }
+    }
+
+  return 1;
+}
+
+static void
+nat44_port_block_reserve (snat_address_t * a, u32 thread_index, u16 start,
+                          u16 size, int is_add)
+{
+  u32 port;
+
+#define _(N, i, n, s) \
+  for (port = start; port < start + size; port++) \
+    clib_bitmap_set_no_check (a->busy_##n##_port_bitmap, port, is_add); \
+  if (is_add) \
+    { \
+      a->busy_##n##_ports += size; \
+      a->busy_##n##_ports_per_thread[thread_index] += size; \
+    } \
+  else \
+    { \
+      a->busy_##n##_ports -= size; \
+      a->busy_##n##_ports_per_thread[thread_index] -= size; \
+    }
+  foreach_snat_protocol
+#undef _
+}
+
+static void
+nat44_port_block_free (snat_main_t * sm, snat_user_t * u, u32 block_index)
+{
+  nat44_port_block_t *b = vec_elt_at_index (u->port_blocks, block_index);
+
+  nat_ipfix_logging_port_block (u->addr.as_u32,
+                                sm->addresses[b->address_index].addr.as_u32,
+                                b->start, b->start + b->size - 1,
+                                u->fib_index, 0);
+#define _(N, i, n, s) \
+  vec_free (b->n##_free_ports);
+  foreach_snat_protocol
+#undef _
+  vec_del1 (u->port_blocks, block_index);
+}
+
+/**
+ * @brief Allocate an outside address and port from the blocks of a user.
+ *
+ * The port comes from one of the user's blocks, else from a new block,
+ * on an address of the user's VRF first, else of any VRF.
+ *
+ * @returns 0 on success, 1 if out of ports
+ */
+int
+nat44_port_block_alloc_port (snat_main_t * sm, snat_user_t * u,
+                             u32 fib_index, u32 thread_index,
+                             snat_session_key_t * k, u32 * address_indexp)
+{
+  snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
+  nat44_port_block_t *b;
+  snat_address_t *a;
+  u32 i, gi = ~0;
+  u16 start, gstart = 0, offset;
+
+  vec_foreach (b, u->port_blocks)
+    {
+      if (!nat44_port_block_get_port (b, k->protocol, &offset))
+        goto done;
+    }
+
+  for (i = 0; i < vec_len (sm->addresses); i++)
+    {
+      a = sm->addresses + i;
+      if (a->fib_index != fib_index && a->fib_index != ~0)
+        continue;
+      if (nat44_port_block_find (a, sm->port_block_size, sm->port_per_thread,
+                                 tsm->snat_thread_index, &start))
+        continue;
+      if (a->fib_index == fib_index)
+        goto new_block;
+      if (gi == ~0)
+        {
+          gi = i;
+          gstart = start;
+        }
+    }
+
+  if (gi == ~0)
+    {
+      /* Totally out of translations to use... */
+      snat_ipfix_logging_addresses_exhausted (0);
+      return 1;
+    }
+  i = gi;
+  start = gstart;
+
+new_block:
+  a = sm->addresses + i;
+  nat44_port_block_reserve (a, thread_index, start, sm->port_block_size, 1);
+  vec_add2 (u->port_blocks, b, 1);
+  memset (b, 0, sizeof (*b));
+  b->address_index = i;
+  b->start = start;
+  b->size = sm->port_block_size;
+  nat_ipfix_logging_port_block (u->addr.as_u32, a->addr.as_u32, b->start,
+                                b->start + b->size - 1, u->fib_index, 1);
+  if (nat44_port_block_get_port (b, k->protocol, &offset))
+    {
+      /* not a protocol the blocks have ports of */
+      nat44_port_block_reserve (a, thread_index, b->start, b->size, 0);
+      nat44_port_block_free (sm, u, b - u->port_blocks);
+      return 1;
+    }
+
+done:
+  b->n_busy++;
+  k->addr = sm->addresses[b->address_index].addr;
+  k->port = clib_host_to_net_u16 (b->start + offset);
+  *address_indexp = b->address_index;
+  return 0;
+}
+
+/**
+ * @brief Give the port of a session back to its block.
+ *
+ * The block is released once none of its ports is in use.
+ */
+void
+nat44_port_block_free_port (snat_main_t * sm, snat_session_t * s,
+                            u32 thread_index)
+{
+  snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
+  clib_bihash_kv_8_8_t kv, value;
+  snat_user_key_t u_key;
+  nat44_port_block_t *b;
+  snat_user_t *u;
+  u16 port = clib_net_to_host_u16 (s->out2in.port);
+
+  u_key.addr = s->in2out.addr;
+  u_key.fib_index = s->in2out.fib_index;
+  kv.key = u_key.as_u64;
+  if (clib_bihash_search_8_8 (&tsm->user_hash, &kv, &value))
+    return;
+  u = pool_elt_at_index (tsm->users, value.value);
+
+  vec_foreach (b, u->port_blocks)
+    {
+      /* by address, as address indices move down when one is deleted */
+      if (sm->addresses[b->address_index].addr.as_u32 !=
+          s->out2in.addr.as_u32 ||
+          port < b->start || port >= b->start + b->size)
+        continue;
+
+      switch (s->out2in.protocol)
+        {
+#define _(N, i, n, s) \
+        case SNAT_PROTOCOL_##N: \
+          vec_add1 (b->n##_free_ports, port - b->start); \
+          break;
+          foreach_snat_protocol
+#undef _
+        default:
+          break;
+        }
+
+      if (--b->n_busy == 0)
+        {
+          nat44_port_block_reserve (sm->addresses + b->address_index,
+                                    thread_index, b->start, b->size, 0);
+          nat44_port_block_free (sm, u, b - u->port_blocks);
+        }
+      return;
+    }
+}
+
+/**
+ * @brief Release all the port blocks of a user.
+ */
+void
+nat44_port_block_release_all (snat_main_t * sm, snat_user_t * u,
+                              u32 thread_index)
+{
+  nat44_port_block_t *b;
+
+  while (vec_len (u->port_blocks))
+    {
+      b = vec_end (u->port_blocks) - 1;
+      nat44_port_block_reserve (sm->addresses + b->address_index,
+                                thread_index, b->start, b->size, 0);
+      nat44_port_block_free (sm, u, b - u->port_blocks);
+    }
+  vec_free (u->port_blocks);
+}
+
+/* Forget the blocks of an outside address about to be deleted */
+static void
+nat44_port_block_del_address (snat_main_t * sm, u32 address_index)
+{
+  snat_main_per_thread_data_t *tsm;
+  snat_user_t *u;
+  int j;
+
+  vec_foreach (tsm, sm->per_thread_data)
+    {
+      /* *INDENT-OFF* */
+      pool_foreach (u, tsm->users,
+      ({
+        for (j = vec_len (u->port_blocks) - 1; j >= 0; j--)
+          {
+            if (u->port_blocks[j].address_index == address_index)
+              nat44_port_block_free (sm, u, j);
+            else if (u->port_blocks[j].address_index > address_index)
+              u->port_blocks[j].address_index--;
+          }
+      }));
+      /* *INDENT-ON* */
+    }
 }
 
@@ -26,6 +26,7 @@
 #include <vppinfra/bihash_8_8.h>
 #include <vppinfra/bihash_16_8.h>
 #include <vppinfra/dlist.h>
+#include <vppinfra/tw_timer_1t_3w_1024sl_ov.h>
 #include <vppinfra/error.h>
 #include <vlibapi/api.h>
 
@@ -37,6 +38,9 @@
 #define SNAT_TCP_INCOMING_SYN 6
 #define SNAT_ICMP_TIMEOUT 60
 
+/* Max sessions deleted per dispatch of a worker's expiry walk */
+#define NAT44_SESSION_EXPIRE_BATCH 1024
+
 #define SNAT_FLAG_HAIRPINNING (1 << 0)
 
 /* Key */
@@ -129,6 +133,10 @@ typedef enum {
 #define SNAT_SESSION_FLAG_UNKNOWN_PROTO  2
 #define SNAT_SESSION_FLAG_LOAD_BALANCING 4
 #define SNAT_SESSION_FLAG_TWICE_NAT      8
+#define SNAT_SESSION_FLAG_FIN_IN2OUT     16
+#define SNAT_SESSION_FLAG_FIN_OUT2IN     32
+#define SNAT_SESSION_FLAG_TCP_CLOSED     64
+#define SNAT_SESSION_FLAG_PORT_BLOCK     128
 
 #define NAT_INTERFACE_FLAG_IS_INSIDE 1
 #define NAT_INTERFACE_FLAG_IS_OUTSIDE 2
@@ -162,15 +170,36 @@ typedef CLIB_PACKED(struct {
   /* External hos address and port after translation */
   ip4_address_t ext_host_nat_addr; /* 74-77 */
   u16 ext_host_nat_port;           /* 78-79 */
+
+  /* Expiry timer, ~0 if none */
+  u32 expire_timer_handle;         /* 80-83 */
 }) snat_session_t;
 
 
+/* Block of ports of an outside address, assigned to one user */
+typedef struct {
+  u32 address_index;
+  u16 start;
+  u16 size;
+  /* Ports in use, of all protocols */
+  u32 n_busy;
+  /* Per protocol, ports from next_port on were never used, those freed
+     since are on free_ports */
+#define _(N, i, n, s) \
+  u16 n##_next_port; \
+  u16 * n##_free_ports;
+  foreach_snat_protocol
+#undef _
+} nat44_port_block_t;
+
 typedef struct {
   ip4_address_t addr;
   u32 fib_index;
   u32 sessions_per_user_list_head_index;
   u32 nsessions;
   u32 nstaticsessions;
+  /* Port blocks, in port block allocation mode */
+  nat44_port_block_t * port_blocks;
 } snat_user_t;
 
 typedef struct {
@@ -249,6 +278,10 @@ typedef struct {
   clib_bihash_8_8_t out2in;
   clib_bihash_8_8_t in2out;
 
+  /* Endpoint address dependent sessions lookup tables */
+  clib_bihash_16_8_t out2in_ed;
+  clib_bihash_16_8_t in2out_ed;
+
   /* Find-a-user => src address lookup */
   clib_bihash_8_8_t user_hash;
 
@@ -261,6 +294,14 @@ typedef struct {
   /* Pool of doubly-linked list elements */
   dlist_elt_t * list_pool;
 
+  /* Session expiry timers, one per session */
+  tw_timer_wheel_1t_3w_1024sl_ov_t session_timers;
+  u32 * expired_sessions;
+
+  /* Sessions deleted on expiry, and recycled over the per-user limit */
+  u64 sessions_expired;
+  u64 sessions_recycled;
+
   u32 snat_thread_index;
 } snat_main_per_thread_data_t;
 
@@ -288,10 +329,6 @@ typedef int nat_alloc_out_addr_and_port_function_t (snat_address_t * addresses,
                                                     u32 snat_thread_index);
 
 typedef struct snat_main_s {
-  /* Endpoint address dependent sessions lookup tables */
-  clib_bihash_16_8_t out2in_ed;
-  clib_bihash_16_8_t in2out_ed;
-
   snat_icmp_match_function_t * icmp_match_in2out_cb;
   snat_icmp_match_function_t * icmp_match_out2in_cb;
 
@@ -326,6 +363,8 @@ typedef struct snat_main_s {
   u8 psid_offset;
   u8 psid_length;
   u16 psid;
+  /* Ports per block in port block allocation mode, 0 if off */
+  u16 port_block_size;
 
   /* Vector of twice NAT addresses for extenal hosts */
   snat_address_t * twice_nat_addresses;
@@ -572,9 +611,19 @@ snat_user_t * nat_user_get_or_create (snat_main_t *sm, ip4_address_t *addr,
                                       u32 fib_index, u32 thread_index);
 snat_session_t * nat_session_alloc_or_recycle (snat_main_t *sm, snat_user_t *u,
                                                u32 thread_index);
+void nat44_delete_session (snat_main_t * sm, snat_session_t * s,
+                           u32 thread_index);
 void nat_set_alloc_addr_and_port_mape (u16 psid, u16 psid_offset,
                                        u16 psid_length);
 void nat_set_alloc_addr_and_port_default (void);
+int nat_set_alloc_addr_and_port_port_block (u16 block_size);
+int nat44_port_block_alloc_port (snat_main_t * sm, snat_user_t * u,
+                                 u32 fib_index, u32 thread_index,
+                                 snat_session_key_t * k, u32 * address_indexp);
+void nat44_port_block_free_port (snat_main_t * sm, snat_session_t * s,
+                                 u32 thread_index);
+void nat44_port_block_release_all (snat_main_t * sm, snat_user_t * u,
+                                   u32 thread_index);
 
 static_always_inline u8
 icmp_is_error_message (icmp46_header_t * icmp)
@@ -626,6 +675,118 @@ maximum_sessions_exceeded (snat_main_t *sm, u32 thread_index)
   return 0;
 }
 
+/** \brief Find the thread owning an endpoint dependent session.
+    Sessions, and their out2in-ed entries, are per thread: a key used
+    by any thread must be looked for in all of them.
+    @param sm NAT main
+    @param kv out2in-ed key
+    @param value out2in-ed value found
+    @return index of the thread whose table has the key, ~0 if none
+*/
+always_inline u32
+nat_ed_out2in_owner (snat_main_t *sm, clib_bihash_kv_16_8_t *kv,
+                     clib_bihash_kv_16_8_t *value)
+{
+  snat_main_per_thread_data_t *tsm;
+
+  vec_foreach (tsm, sm->per_thread_data)
+    {
+      if (!clib_bihash_search_16_8 (&tsm->out2in_ed, kv, value))
+        return tsm - sm->per_thread_data;
+    }
+
+  return ~0;
+}
+
+/** \brief Get the idle timeout of a NAT44 session.
+    @param sm NAT main
+    @param s NAT session
+    @return timeout in seconds
+*/
+always_inline u32
+nat44_session_get_timeout (snat_main_t *sm, snat_session_t *s)
+{
+  switch (s->in2out.protocol)
+    {
+    case SNAT_PROTOCOL_ICMP:
+      return sm->icmp_timeout;
+    case SNAT_PROTOCOL_TCP:
+      if (s->flags & SNAT_SESSION_FLAG_TCP_CLOSED)
+        return sm->tcp_transitory_timeout;
+      return sm->tcp_established_timeout;
+    default:
+      return sm->udp_timeout;
+    }
+}
+
+/** \brief (Re)start the expiry timer of a NAT44 session.
+    The timer is not moved on each packet: when it fires, the session is
+    deleted only if idle for its whole timeout, else the timer is
+    restarted for the time left.
+    @param sm NAT main
+    @param s NAT session
+    @param thread_index thread owning the session
+    @param timeout seconds from now
+*/
+always_inline void
+nat44_session_set_expiry (snat_main_t *sm, snat_session_t *s,
+                          u32 thread_index, u32 timeout)
+{
+  snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
+
+  if (s->expire_timer_handle != ~0)
+    tw_timer_stop_1t_3w_1024sl_ov (&tsm->session_timers,
+                                   s->expire_timer_handle);
+  s->expire_timer_handle =
+    tw_timer_start_1t_3w_1024sl_ov (&tsm->session_timers, s - tsm->sessions,
+                                    0, clib_max (timeout, 1));
+}
+
+/** \brief Track TCP connection close of a NAT44 session.
+    Once both sides sent FIN, or either sent RST, the session is aged out
+    after the TCP transitory timeout rather than the established one.
+    A SYN on the same 5-tuple reopens it.
+    @param sm NAT main
+    @param s NAT session
+    @param tcp TCP header of the packet
+    @param thread_index thread owning the session
+    @param is_in2out 1 if the packet is in2out
+*/
+always_inline void
+nat44_session_update_tcp (snat_main_t *sm, snat_session_t *s,
+                          tcp_header_t *tcp, u32 thread_index, u8 is_in2out)
+{
+  u32 flags = s->flags;
+
+  if (PREDICT_TRUE (!(tcp->flags & (TCP_FLAG_SYN | TCP_FLAG_FIN |
+                                    TCP_FLAG_RST))))
+    return;
+
+  if (tcp->flags & TCP_FLAG_SYN)
+    {
+      s->flags &= ~(SNAT_SESSION_FLAG_FIN_IN2OUT |
+                    SNAT_SESSION_FLAG_FIN_OUT2IN |
+                    SNAT_SESSION_FLAG_TCP_CLOSED);
+      return;
+    }
+
+  if (tcp->flags & TCP_FLAG_RST)
+    s->flags |= SNAT_SESSION_FLAG_TCP_CLOSED;
+  else
+    s->flags |= is_in2out ? SNAT_SESSION_FLAG_FIN_IN2OUT :
+      SNAT_SESSION_FLAG_FIN_OUT2IN;
+
+  if ((s->flags & SNAT_SESSION_FLAG_FIN_IN2OUT) &&
+      (s->flags & SNAT_SESSION_FLAG_FIN_OUT2IN))
+    s->flags |= SNAT_SESSION_FLAG_TCP_CLOSED;
+
+  /* Just closed, age out fast */
+  if (!(flags & SNAT_SESSION_FLAG_TCP_CLOSED) &&
+      (s->flags & SNAT_SESSION_FLAG_TCP_CLOSED))
+    nat44_session_set_expiry (sm, s, thread_index,
+                              sm->tcp_transitory_timeout);
+}
+
 static_always_inline void
 nat_send_all_to_node(vlib_main_t *vm, u32 *bi_vector,
                      vlib_node_runtime_t *node, vlib_error_t *error, u32 next)
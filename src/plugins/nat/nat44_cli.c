@@ -152,7 +152,7 @@ nat44_set_alloc_addr_and_port_alg_command_fn (vlib_main_t * vm,
 {
   unformat_input_t _line_input, *line_input = &_line_input;
   clib_error_t *error = 0;
-  u32 psid, psid_offset, psid_length;
+  u32 psid, psid_offset, psid_length, block_size;
 
   /* Get a line of input. */
   if (!unformat_user (input, unformat_line_input, line_input))
@@ -168,6 +168,16 @@ nat44_set_alloc_addr_and_port_alg_command_fn (vlib_main_t * vm,
 	     &psid_offset, &psid_length))
 	nat_set_alloc_addr_and_port_mape ((u16) psid, (u16) psid_offset,
 					  (u16) psid_length);
+      else if (unformat (line_input, "port-block size %u", &block_size))
+	{
+	  if (block_size > 0xffff ||
+	      nat_set_alloc_addr_and_port_port_block ((u16) block_size))
+	    {
+	      error = clib_error_return (0, "invalid port block size %u",
+					 block_size);
+	      goto done;
+	    }
+	}
       else
 	{
 	  error = clib_error_return (0, "unknown input '%U'",
@@ -860,6 +870,10 @@ nat44_show_sessions_command_fn (vlib_main_t * vm, unformat_input_t * input,
     {
       tsm = vec_elt_at_index (sm->per_thread_data, i);
 
+      vlib_cli_output (vm, " thread %d: %d sessions, %llu expired, "
+                       "%llu recycled", i, pool_elts (tsm->sessions),
+                       tsm->sessions_expired, tsm->sessions_recycled);
+
       pool_foreach (u, tsm->users,
       ({
         vlib_cli_output (vm, "  %U", format_snat_user, tsm, u, verbose);
@@ -1395,6 +1409,9 @@ VLIB_CLI_COMMAND (snat_ipfix_logging_enable_disable_command, static) = {
  * Set address and port assignment algorithm
  * For the MAP-E CE limit port choice based on PSID use:
  *  vpp# nat addr-port-assignment-alg map-e psid 10 psid-offset 6 psid-len 6
+ * To give each inside address blocks of 256 ports, logging only their
+ * allocation and release rather than each session, use:
+ *  vpp# nat addr-port-assignment-alg port-block size 256
  * To set standard (default) address and port assignment algorithm use:
  *  vpp# nat addr-port-assignment-alg default
  * @cliexend
@@ -1602,7 +1619,8 @@ VLIB_CLI_COMMAND (nat44_show_interface_address_command, static) = {
 /*?
  * @cliexpar
  * @cliexstart{show nat44 sessions}
- * Show NAT44 sessions.
+ * Show NAT44 sessions, and per thread how many were deleted on expiry
+ * and recycled over the per-user limit.
  * @cliexend
 ?*/
 VLIB_CLI_COMMAND (nat44_show_sessions_command, static) = {
@@ -1462,6 +1462,34 @@ static void *vl_api_nat44_forwarding_is_enabled_t_print
   FINISH;
 }
 
+static void
+  vl_api_nat44_set_port_block_size_t_handler
+  (vl_api_nat44_set_port_block_size_t * mp)
+{
+  snat_main_t *sm = &snat_main;
+  vl_api_nat44_set_port_block_size_reply_t *rmp;
+  u16 block_size = ntohs (mp->block_size);
+  int rv = 0;
+
+  if (block_size)
+    rv = nat_set_alloc_addr_and_port_port_block (block_size);
+  else
+    nat_set_alloc_addr_and_port_default ();
+
+  REPLY_MACRO (VL_API_NAT44_SET_PORT_BLOCK_SIZE_REPLY);
+}
+
+static void *vl_api_nat44_set_port_block_size_t_print
+  (vl_api_nat44_set_port_block_size_t * mp, void *handle)
+{
+  u8 *s;
+
+  s = format (0, "SCRIPT: nat44_set_port_block_size ");
+  s = format (s, "block_size %d", ntohs (mp->block_size));
+
+  FINISH;
+}
+
 /*******************************/
 /*** Deterministic NAT (CGN) ***/
 /*******************************/
@@ -2812,6 +2840,7 @@ _(NAT44_LB_STATIC_MAPPING_DUMP, nat44_lb_static_mapping_dump)           \
 _(NAT44_DEL_SESSION, nat44_del_session)                                 \
 _(NAT44_FORWARDING_ENABLE_DISABLE, nat44_forwarding_enable_disable)     \
 _(NAT44_FORWARDING_IS_ENABLED, nat44_forwarding_is_enabled)             \
+_(NAT44_SET_PORT_BLOCK_SIZE, nat44_set_port_block_size)                 \
 _(NAT_DET_ADD_DEL_MAP, nat_det_add_del_map)                             \
 _(NAT_DET_FORWARD, nat_det_forward)                                     \
 _(NAT_DET_REVERSE, nat_det_reverse)                                     \
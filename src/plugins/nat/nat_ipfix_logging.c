@@ -16,7 +16,6 @@
  */
 
 #include <vnet/flow/flow_report.h>
-#include <vlibmemory/api.h>
 #include <nat/nat_ipfix_logging.h>
 
 snat_ipfix_logging_main_t snat_ipfix_logging_main;
@@ -30,6 +29,7 @@ snat_ipfix_logging_main_t snat_ipfix_logging_main;
 #define MAX_FRAGMENTS_IP6_LEN 33
 #define NAT64_BIB_LEN 38
 #define NAT64_SES_LEN 62
+#define NAT_PORT_BLOCK_LEN 25
 
 #define NAT44_SESSION_CREATE_FIELD_COUNT 8
 #define NAT_ADDRESSES_EXHAUTED_FIELD_COUNT 3
@@ -39,76 +39,7 @@ snat_ipfix_logging_main_t snat_ipfix_logging_main;
 #define MAX_FRAGMENTS_FIELD_COUNT 5
 #define NAT64_BIB_FIELD_COUNT 8
 #define NAT64_SES_FIELD_COUNT 12
-
-typedef struct
-{
-  u8 nat_event;
-  u32 src_ip;
-  u32 nat_src_ip;
-  snat_protocol_t snat_proto;
-  u16 src_port;
-  u16 nat_src_port;
-  u32 vrf_id;
-} snat_ipfix_logging_nat44_ses_args_t;
-
-typedef struct
-{
-  u32 pool_id;
-} snat_ipfix_logging_addr_exhausted_args_t;
-
-typedef struct
-{
-  u32 limit;
-  u32 src_ip;
-} snat_ipfix_logging_max_entries_per_user_args_t;
-
-typedef struct
-{
-  u32 limit;
-} nat_ipfix_logging_max_sessions_args_t;
-
-typedef struct
-{
-  u32 limit;
-} nat_ipfix_logging_max_bibs_args_t;
-
-typedef struct
-{
-  u32 limit;
-  u32 src;
-} nat_ipfix_logging_max_frags_ip4_args_t;
-
-typedef struct
-{
-  u32 limit;
-  u64 src[2];
-} nat_ipfix_logging_max_frags_ip6_args_t;
-
-typedef struct
-{
-  u8 nat_event;
-  u64 src_ip[2];
-  u32 nat_src_ip;
-  u8 proto;
-  u16 src_port;
-  u16 nat_src_port;
-  u64 dst_ip[2];
-  u32 nat_dst_ip;
-  u32 vrf_id;
-  u16 dst_port;
-  u16 nat_dst_port;
-} nat_ipfix_logging_nat64_ses_args_t;
-
-typedef struct
-{
-  u8 nat_event;
-  u64 src_ip[2];
-  u32 nat_src_ip;
-  u8 proto;
-  u16 src_port;
-  u16 nat_src_port;
-  u32 vrf_id;
-} nat_ipfix_logging_nat64_bib_args_t;
+#define NAT_PORT_BLOCK_FIELD_COUNT 7
 
 #define skip_if_disabled()                                    \
 do {                                                          \
@@ -174,6 +105,11 @@ snat_template_rewrite (flow_report_main_t * frm,
       field_count = NAT64_SES_FIELD_COUNT;
       silm->nat64_ses_template_id = fr->template_id;
     }
+  else if (event == NAT_PORT_BLOCK_ALLOC)
+    {
+      field_count = NAT_PORT_BLOCK_FIELD_COUNT;
+      silm->port_block_template_id = fr->template_id;
+    }
   else if (event == QUOTA_EXCEEDED)
     {
       if (quota_event == MAX_ENTRIES_PER_USER)
@@ -305,6 +241,23 @@ snat_template_rewrite (flow_report_main_t * frm,
       f->e_id_length = ipfix_e_id_length (0, ingressVRFID, 4);
       f++;
     }
+  else if (event == NAT_PORT_BLOCK_ALLOC)
+    {
+      f->e_id_length = ipfix_e_id_length (0, observationTimeMilliseconds, 8);
+      f++;
+      f->e_id_length = ipfix_e_id_length (0, natEvent, 1);
+      f++;
+      f->e_id_length = ipfix_e_id_length (0, sourceIPv4Address, 4);
+      f++;
+      f->e_id_length = ipfix_e_id_length (0, postNATSourceIPv4Address, 4);
+      f++;
+      f->e_id_length = ipfix_e_id_length (0, portRangeStart, 2);
+      f++;
+      f->e_id_length = ipfix_e_id_length (0, portRangeEnd, 2);
+      f++;
+      f->e_id_length = ipfix_e_id_length (0, ingressVRFID, 4);
+      f++;
+    }
   else if (event == QUOTA_EXCEEDED)
     {
       if (quota_event == MAX_ENTRIES_PER_USER)
@@ -502,11 +455,44 @@ nat_template_rewrite_nat64_session (flow_report_main_t * frm,
 				collector_port, NAT64_SESSION_CREATE, 0);
 }
 
+u8 *
+nat_template_rewrite_port_block (flow_report_main_t * frm,
+				 flow_report_t * fr,
+				 ip4_address_t * collector_address,
+				 ip4_address_t * src_address,
+				 u16 collector_port)
+{
+  return snat_template_rewrite (frm, fr, collector_address, src_address,
+				collector_port, NAT_PORT_BLOCK_ALLOC, 0);
+}
+
+/**
+ * @brief Get the time in milliseconds since the epoch
+ *
+ * Each thread has its own time reference pair, the clock of a worker
+ * starts when the worker does.
+ */
+static inline u64
+nat_ipfix_time_now_ms (vlib_main_t * vm, snat_ipfix_per_thread_data_t * sitd)
+{
+  f64 now = vlib_time_now (vm);
+
+  if (PREDICT_FALSE (sitd->vlib_time_0 == 0))
+    {
+      sitd->vlib_time_0 = now;
+      sitd->milisecond_time_0 = unix_time_now_nsec () * 1e-6;
+    }
+
+  return (u64) ((now - sitd->vlib_time_0) * 1e3) + sitd->milisecond_time_0;
+}
+
 static inline void
-snat_ipfix_header_create (flow_report_main_t * frm,
+snat_ipfix_header_create (flow_report_main_t * frm, vlib_main_t * vm,
 			  vlib_buffer_t * b0, u32 * offset)
 {
   snat_ipfix_logging_main_t *silm = &snat_ipfix_logging_main;
+  snat_ipfix_per_thread_data_t *sitd =
+    vec_elt_at_index (silm->per_thread_data, vm->thread_index);
   flow_report_stream_t *stream;
   ip4_ipfix_template_packet_t *tp;
   ipfix_message_header_t *h = 0;
@@ -539,17 +525,18 @@ snat_ipfix_header_create (flow_report_main_t * frm,
   udp->checksum = 0;
 
   h->export_time = clib_host_to_net_u32 ((u32)
-					 (((f64) frm->unix_time_0) +
-					  (vlib_time_now (frm->vlib_main) -
-					   frm->vlib_time_0)));
-  h->sequence_number = clib_host_to_net_u32 (stream->sequence_number++);
+					 (nat_ipfix_time_now_ms (vm, sitd) /
+					  1000));
+  /* Workers number their messages in the same stream */
+  h->sequence_number =
+    clib_host_to_net_u32 (clib_smp_atomic_add (&stream->sequence_number, 1));
   h->domain_id = clib_host_to_net_u32 (stream->domain_id);
 
   *offset = (u32) (((u8 *) (s + 1)) - (u8 *) tp);
 }
 
 static inline void
-snat_ipfix_send (flow_report_main_t * frm,
+snat_ipfix_send (flow_report_main_t * frm, vlib_main_t * vm,
 		 vlib_frame_t * f, vlib_buffer_t * b0, u16 template_id)
 {
   ip4_ipfix_template_packet_t *tp;
@@ -557,7 +544,6 @@ snat_ipfix_send (flow_report_main_t * frm,
   ipfix_set_header_t *s = 0;
   ip4_header_t *ip;
   udp_header_t *udp;
-  vlib_main_t *vm = frm->vlib_main;
 
   tp = vlib_buffer_get_current (b0);
   ip = (ip4_header_t *) & tp->ip4;
@@ -599,7 +585,9 @@ snat_ipfix_logging_nat44_ses (u8 nat_event, u32 src_ip, u32 nat_src_ip,
   vlib_buffer_t *b0 = 0;
   u32 bi0 = ~0;
   u32 offset;
-  vlib_main_t *vm = frm->vlib_main;
+  vlib_main_t *vm = vlib_get_main ();
+  snat_ipfix_per_thread_data_t *sitd =
+    vec_elt_at_index (silm->per_thread_data, vm->thread_index);
   u64 now;
   vlib_buffer_free_list_t *fl;
   u8 proto = ~0;
@@ -609,10 +597,9 @@ snat_ipfix_logging_nat44_ses (u8 nat_event, u32 src_ip, u32 nat_src_ip,
 
   proto = snat_proto_to_ip_proto (snat_proto);
 
-  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
-  now += silm->milisecond_time_0;
+  now = nat_ipfix_time_now_ms (vm, sitd);
 
-  b0 = silm->nat44_session_buffer;
+  b0 = sitd->nat44_session_buffer;
 
   if (PREDICT_FALSE (b0 == 0))
     {
@@ -625,7 +612,7 @@ snat_ipfix_logging_nat44_ses (u8 nat_event, u32 src_ip, u32 nat_src_ip,
 	  return;
 	}
 
-      b0 = silm->nat44_session_buffer = vlib_get_buffer (vm, bi0);
+      b0 = sitd->nat44_session_buffer = vlib_get_buffer (vm, bi0);
       fl =
 	vlib_buffer_get_free_list (vm, VLIB_BUFFER_DEFAULT_FREE_LIST_INDEX);
       vlib_buffer_init_for_free_list (b0, fl);
@@ -635,22 +622,22 @@ snat_ipfix_logging_nat44_ses (u8 nat_event, u32 src_ip, u32 nat_src_ip,
   else
     {
       bi0 = vlib_get_buffer_index (vm, b0);
-      offset = silm->nat44_session_next_record_offset;
+      offset = sitd->nat44_session_next_record_offset;
     }
 
-  f = silm->nat44_session_frame;
+  f = sitd->nat44_session_frame;
   if (PREDICT_FALSE (f == 0))
     {
       u32 *to_next;
       f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      silm->nat44_session_frame = f;
+      sitd->nat44_session_frame = f;
       to_next = vlib_frame_vector_args (f);
       to_next[0] = bi0;
       f->n_vectors = 1;
     }
 
   if (PREDICT_FALSE (offset == 0))
-    snat_ipfix_header_create (frm, b0, &offset);
+    snat_ipfix_header_create (frm, vm, b0, &offset);
 
   if (PREDICT_TRUE (do_flush == 0))
     {
@@ -685,12 +672,12 @@ snat_ipfix_logging_nat44_ses (u8 nat_event, u32 src_ip, u32 nat_src_ip,
   if (PREDICT_FALSE
       (do_flush || (offset + NAT44_SESSION_CREATE_LEN) > frm->path_mtu))
     {
-      snat_ipfix_send (frm, f, b0, silm->nat44_session_template_id);
-      silm->nat44_session_frame = 0;
-      silm->nat44_session_buffer = 0;
+      snat_ipfix_send (frm, vm, f, b0, silm->nat44_session_template_id);
+      sitd->nat44_session_frame = 0;
+      sitd->nat44_session_buffer = 0;
       offset = 0;
     }
-  silm->nat44_session_next_record_offset = offset;
+  sitd->nat44_session_next_record_offset = offset;
 }
 
 static void
@@ -702,7 +689,9 @@ snat_ipfix_logging_addr_exhausted (u32 pool_id, int do_flush)
   vlib_buffer_t *b0 = 0;
   u32 bi0 = ~0;
   u32 offset;
-  vlib_main_t *vm = frm->vlib_main;
+  vlib_main_t *vm = vlib_get_main ();
+  snat_ipfix_per_thread_data_t *sitd =
+    vec_elt_at_index (silm->per_thread_data, vm->thread_index);
   u64 now;
   vlib_buffer_free_list_t *fl;
   u8 nat_event = NAT_ADDRESSES_EXHAUTED;
@@ -710,10 +699,9 @@ snat_ipfix_logging_addr_exhausted (u32 pool_id, int do_flush)
   if (!silm->enabled)
     return;
 
-  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
-  now += silm->milisecond_time_0;
+  now = nat_ipfix_time_now_ms (vm, sitd);
 
-  b0 = silm->addr_exhausted_buffer;
+  b0 = sitd->addr_exhausted_buffer;
 
   if (PREDICT_FALSE (b0 == 0))
     {
@@ -726,7 +714,7 @@ snat_ipfix_logging_addr_exhausted (u32 pool_id, int do_flush)
 	  return;
 	}
 
-      b0 = silm->addr_exhausted_buffer = vlib_get_buffer (vm, bi0);
+      b0 = sitd->addr_exhausted_buffer = vlib_get_buffer (vm, bi0);
       fl =
 	vlib_buffer_get_free_list (vm, VLIB_BUFFER_DEFAULT_FREE_LIST_INDEX);
       vlib_buffer_init_for_free_list (b0, fl);
@@ -736,22 +724,22 @@ snat_ipfix_logging_addr_exhausted (u32 pool_id, int do_flush)
   else
     {
       bi0 = vlib_get_buffer_index (vm, b0);
-      offset = silm->addr_exhausted_next_record_offset;
+      offset = sitd->addr_exhausted_next_record_offset;
     }
 
-  f = silm->addr_exhausted_frame;
+  f = sitd->addr_exhausted_frame;
   if (PREDICT_FALSE (f == 0))
     {
       u32 *to_next;
       f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      silm->addr_exhausted_frame = f;
+      sitd->addr_exhausted_frame = f;
       to_next = vlib_frame_vector_args (f);
       to_next[0] = bi0;
       f->n_vectors = 1;
     }
 
   if (PREDICT_FALSE (offset == 0))
-    snat_ipfix_header_create (frm, b0, &offset);
+    snat_ipfix_header_create (frm, vm, b0, &offset);
 
   if (PREDICT_TRUE (do_flush == 0))
     {
@@ -771,12 +759,12 @@ snat_ipfix_logging_addr_exhausted (u32 pool_id, int do_flush)
   if (PREDICT_FALSE
       (do_flush || (offset + NAT_ADDRESSES_EXHAUTED_LEN) > frm->path_mtu))
     {
-      snat_ipfix_send (frm, f, b0, silm->addr_exhausted_template_id);
-      silm->addr_exhausted_frame = 0;
-      silm->addr_exhausted_buffer = 0;
+      snat_ipfix_send (frm, vm, f, b0, silm->addr_exhausted_template_id);
+      sitd->addr_exhausted_frame = 0;
+      sitd->addr_exhausted_buffer = 0;
       offset = 0;
     }
-  silm->addr_exhausted_next_record_offset = offset;
+  sitd->addr_exhausted_next_record_offset = offset;
 }
 
 static void
@@ -788,7 +776,9 @@ snat_ipfix_logging_max_entries_per_usr (u32 limit, u32 src_ip, int do_flush)
   vlib_buffer_t *b0 = 0;
   u32 bi0 = ~0;
   u32 offset;
-  vlib_main_t *vm = frm->vlib_main;
+  vlib_main_t *vm = vlib_get_main ();
+  snat_ipfix_per_thread_data_t *sitd =
+    vec_elt_at_index (silm->per_thread_data, vm->thread_index);
   u64 now;
   vlib_buffer_free_list_t *fl;
   u8 nat_event = QUOTA_EXCEEDED;
@@ -797,10 +787,9 @@ snat_ipfix_logging_max_entries_per_usr (u32 limit, u32 src_ip, int do_flush)
   if (!silm->enabled)
     return;
 
-  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
-  now += silm->milisecond_time_0;
+  now = nat_ipfix_time_now_ms (vm, sitd);
 
-  b0 = silm->max_entries_per_user_buffer;
+  b0 = sitd->max_entries_per_user_buffer;
 
   if (PREDICT_FALSE (b0 == 0))
     {
@@ -813,7 +802,7 @@ snat_ipfix_logging_max_entries_per_usr (u32 limit, u32 src_ip, int do_flush)
 	  return;
 	}
 
-      b0 = silm->max_entries_per_user_buffer = vlib_get_buffer (vm, bi0);
+      b0 = sitd->max_entries_per_user_buffer = vlib_get_buffer (vm, bi0);
       fl =
 	vlib_buffer_get_free_list (vm, VLIB_BUFFER_DEFAULT_FREE_LIST_INDEX);
       vlib_buffer_init_for_free_list (b0, fl);
@@ -823,22 +812,22 @@ snat_ipfix_logging_max_entries_per_usr (u32 limit, u32 src_ip, int do_flush)
   else
     {
       bi0 = vlib_get_buffer_index (vm, b0);
-      offset = silm->max_entries_per_user_next_record_offset;
+      offset = sitd->max_entries_per_user_next_record_offset;
     }
 
-  f = silm->max_entries_per_user_frame;
+  f = sitd->max_entries_per_user_frame;
   if (PREDICT_FALSE (f == 0))
     {
       u32 *to_next;
       f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      silm->max_entries_per_user_frame = f;
+      sitd->max_entries_per_user_frame = f;
       to_next = vlib_frame_vector_args (f);
       to_next[0] = bi0;
       f->n_vectors = 1;
     }
 
   if (PREDICT_FALSE (offset == 0))
-    snat_ipfix_header_create (frm, b0, &offset);
+    snat_ipfix_header_create (frm, vm, b0, &offset);
 
   if (PREDICT_TRUE (do_flush == 0))
     {
@@ -864,12 +853,12 @@ snat_ipfix_logging_max_entries_per_usr (u32 limit, u32 src_ip, int do_flush)
   if (PREDICT_FALSE
       (do_flush || (offset + MAX_ENTRIES_PER_USER_LEN) > frm->path_mtu))
     {
-      snat_ipfix_send (frm, f, b0, silm->max_entries_per_user_template_id);
-      silm->max_entries_per_user_frame = 0;
-      silm->max_entries_per_user_buffer = 0;
+      snat_ipfix_send (frm, vm, f, b0, silm->max_entries_per_user_template_id);
+      sitd->max_entries_per_user_frame = 0;
+      sitd->max_entries_per_user_buffer = 0;
       offset = 0;
     }
-  silm->max_entries_per_user_next_record_offset = offset;
+  sitd->max_entries_per_user_next_record_offset = offset;
 }
 
 static void
@@ -881,7 +870,9 @@ nat_ipfix_logging_max_ses (u32 limit, int do_flush)
   vlib_buffer_t *b0 = 0;
   u32 bi0 = ~0;
   u32 offset;
-  vlib_main_t *vm = frm->vlib_main;
+  vlib_main_t *vm = vlib_get_main ();
+  snat_ipfix_per_thread_data_t *sitd =
+    vec_elt_at_index (silm->per_thread_data, vm->thread_index);
   u64 now;
   vlib_buffer_free_list_t *fl;
   u8 nat_event = QUOTA_EXCEEDED;
@@ -890,10 +881,9 @@ nat_ipfix_logging_max_ses (u32 limit, int do_flush)
   if (!silm->enabled)
     return;
 
-  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
-  now += silm->milisecond_time_0;
+  now = nat_ipfix_time_now_ms (vm, sitd);
 
-  b0 = silm->max_sessions_buffer;
+  b0 = sitd->max_sessions_buffer;
 
   if (PREDICT_FALSE (b0 == 0))
     {
@@ -906,7 +896,7 @@ nat_ipfix_logging_max_ses (u32 limit, int do_flush)
 	  return;
 	}
 
-      b0 = silm->max_sessions_buffer = vlib_get_buffer (vm, bi0);
+      b0 = sitd->max_sessions_buffer = vlib_get_buffer (vm, bi0);
       fl =
 	vlib_buffer_get_free_list (vm, VLIB_BUFFER_DEFAULT_FREE_LIST_INDEX);
       vlib_buffer_init_for_free_list (b0, fl);
@@ -916,22 +906,22 @@ nat_ipfix_logging_max_ses (u32 limit, int do_flush)
   else
     {
       bi0 = vlib_get_buffer_index (vm, b0);
-      offset = silm->max_sessions_next_record_offset;
+      offset = sitd->max_sessions_next_record_offset;
     }
 
-  f = silm->max_sessions_frame;
+  f = sitd->max_sessions_frame;
   if (PREDICT_FALSE (f == 0))
     {
       u32 *to_next;
       f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      silm->max_sessions_frame = f;
+      sitd->max_sessions_frame = f;
       to_next = vlib_frame_vector_args (f);
       to_next[0] = bi0;
       f->n_vectors = 1;
     }
 
   if (PREDICT_FALSE (offset == 0))
-    snat_ipfix_header_create (frm, b0, &offset);
+    snat_ipfix_header_create (frm, vm, b0, &offset);
 
   if (PREDICT_TRUE (do_flush == 0))
     {
@@ -954,12 +944,12 @@ nat_ipfix_logging_max_ses (u32 limit, int do_flush)
   if (PREDICT_FALSE
       (do_flush || (offset + MAX_SESSIONS_LEN) > frm->path_mtu))
     {
-      snat_ipfix_send (frm, f, b0, silm->max_sessions_template_id);
-      silm->max_sessions_frame = 0;
-      silm->max_sessions_buffer = 0;
+      snat_ipfix_send (frm, vm, f, b0, silm->max_sessions_template_id);
+      sitd->max_sessions_frame = 0;
+      sitd->max_sessions_buffer = 0;
       offset = 0;
     }
-  silm->max_sessions_next_record_offset = offset;
+  sitd->max_sessions_next_record_offset = offset;
 }
 
 static void
@@ -971,7 +961,9 @@ nat_ipfix_logging_max_bib (u32 limit, int do_flush)
   vlib_buffer_t *b0 = 0;
   u32 bi0 = ~0;
   u32 offset;
-  vlib_main_t *vm = frm->vlib_main;
+  vlib_main_t *vm = vlib_get_main ();
+  snat_ipfix_per_thread_data_t *sitd =
+    vec_elt_at_index (silm->per_thread_data, vm->thread_index);
   u64 now;
   vlib_buffer_free_list_t *fl;
   u8 nat_event = QUOTA_EXCEEDED;
@@ -980,10 +972,9 @@ nat_ipfix_logging_max_bib (u32 limit, int do_flush)
   if (!silm->enabled)
     return;
 
-  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
-  now += silm->milisecond_time_0;
+  now = nat_ipfix_time_now_ms (vm, sitd);
 
-  b0 = silm->max_bibs_buffer;
+  b0 = sitd->max_bibs_buffer;
 
   if (PREDICT_FALSE (b0 == 0))
     {
@@ -996,7 +987,7 @@ nat_ipfix_logging_max_bib (u32 limit, int do_flush)
 	  return;
 	}
 
-      b0 = silm->max_bibs_buffer = vlib_get_buffer (vm, bi0);
+      b0 = sitd->max_bibs_buffer = vlib_get_buffer (vm, bi0);
       fl =
 	vlib_buffer_get_free_list (vm, VLIB_BUFFER_DEFAULT_FREE_LIST_INDEX);
       vlib_buffer_init_for_free_list (b0, fl);
@@ -1006,22 +997,22 @@ nat_ipfix_logging_max_bib (u32 limit, int do_flush)
   else
     {
       bi0 = vlib_get_buffer_index (vm, b0);
-      offset = silm->max_bibs_next_record_offset;
+      offset = sitd->max_bibs_next_record_offset;
     }
 
-  f = silm->max_bibs_frame;
+  f = sitd->max_bibs_frame;
   if (PREDICT_FALSE (f == 0))
     {
       u32 *to_next;
       f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      silm->max_bibs_frame = f;
+      sitd->max_bibs_frame = f;
       to_next = vlib_frame_vector_args (f);
       to_next[0] = bi0;
       f->n_vectors = 1;
     }
 
   if (PREDICT_FALSE (offset == 0))
-    snat_ipfix_header_create (frm, b0, &offset);
+    snat_ipfix_header_create (frm, vm, b0, &offset);
 
   if (PREDICT_TRUE (do_flush == 0))
     {
@@ -1044,12 +1035,12 @@ nat_ipfix_logging_max_bib (u32 limit, int do_flush)
   if (PREDICT_FALSE
       (do_flush || (offset + MAX_BIBS_LEN) > frm->path_mtu))
     {
-      snat_ipfix_send (frm, f, b0, silm->max_bibs_template_id);
-      silm->max_bibs_frame = 0;
-      silm->max_bibs_buffer = 0;
+      snat_ipfix_send (frm, vm, f, b0, silm->max_bibs_template_id);
+      sitd->max_bibs_frame = 0;
+      sitd->max_bibs_buffer = 0;
       offset = 0;
     }
-  silm->max_bibs_next_record_offset = offset;
+  sitd->max_bibs_next_record_offset = offset;
 }
 
 static void
@@ -1061,7 +1052,9 @@ nat_ipfix_logging_max_frag_ip4 (u32 limit, u32 src, int do_flush)
   vlib_buffer_t *b0 = 0;
   u32 bi0 = ~0;
   u32 offset;
-  vlib_main_t *vm = frm->vlib_main;
+  vlib_main_t *vm = vlib_get_main ();
+  snat_ipfix_per_thread_data_t *sitd =
+    vec_elt_at_index (silm->per_thread_data, vm->thread_index);
   u64 now;
   vlib_buffer_free_list_t *fl;
   u8 nat_event = QUOTA_EXCEEDED;
@@ -1070,10 +1063,9 @@ nat_ipfix_logging_max_frag_ip4 (u32 limit, u32 src, int do_flush)
   if (!silm->enabled)
     return;
 
-  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
-  now += silm->milisecond_time_0;
+  now = nat_ipfix_time_now_ms (vm, sitd);
 
-  b0 = silm->max_frags_ip4_buffer;
+  b0 = sitd->max_frags_ip4_buffer;
 
   if (PREDICT_FALSE (b0 == 0))
     {
@@ -1086,7 +1078,7 @@ nat_ipfix_logging_max_frag_ip4 (u32 limit, u32 src, int do_flush)
 	  return;
 	}
 
-      b0 = silm->max_frags_ip4_buffer = vlib_get_buffer (vm, bi0);
+      b0 = sitd->max_frags_ip4_buffer = vlib_get_buffer (vm, bi0);
       fl =
 	vlib_buffer_get_free_list (vm, VLIB_BUFFER_DEFAULT_FREE_LIST_INDEX);
       vlib_buffer_init_for_free_list (b0, fl);
@@ -1096,22 +1088,22 @@ nat_ipfix_logging_max_frag_ip4 (u32 limit, u32 src, int do_flush)
   else
     {
       bi0 = vlib_get_buffer_index (vm, b0);
-      offset = silm->max_frags_ip4_next_record_offset;
+      offset = sitd->max_frags_ip4_next_record_offset;
     }
 
-  f = silm->max_frags_ip4_frame;
+  f = sitd->max_frags_ip4_frame;
   if (PREDICT_FALSE (f == 0))
     {
       u32 *to_next;
       f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      silm->max_frags_ip4_frame = f;
+      sitd->max_frags_ip4_frame = f;
       to_next = vlib_frame_vector_args (f);
       to_next[0] = bi0;
       f->n_vectors = 1;
     }
 
   if (PREDICT_FALSE (offset == 0))
-    snat_ipfix_header_create (frm, b0, &offset);
+    snat_ipfix_header_create (frm, vm, b0, &offset);
 
   if (PREDICT_TRUE (do_flush == 0))
     {
@@ -1137,12 +1129,12 @@ nat_ipfix_logging_max_frag_ip4 (u32 limit, u32 src, int do_flush)
   if (PREDICT_FALSE
       (do_flush || (offset + MAX_BIBS_LEN) > frm->path_mtu))
     {
-      snat_ipfix_send (frm, f, b0, silm->max_frags_ip4_template_id);
-      silm->max_frags_ip4_frame = 0;
-      silm->max_frags_ip4_buffer = 0;
+      snat_ipfix_send (frm, vm, f, b0, silm->max_frags_ip4_template_id);
+      sitd->max_frags_ip4_frame = 0;
+      sitd->max_frags_ip4_buffer = 0;
       offset = 0;
     }
-  silm->max_frags_ip4_next_record_offset = offset;
+  sitd->max_frags_ip4_next_record_offset = offset;
 }
 
 static void
@@ -1154,7 +1146,9 @@ nat_ipfix_logging_max_frag_ip6 (u32 limit, ip6_address_t * src, int do_flush)
   vlib_buffer_t *b0 = 0;
   u32 bi0 = ~0;
   u32 offset;
-  vlib_main_t *vm = frm->vlib_main;
+  vlib_main_t *vm = vlib_get_main ();
+  snat_ipfix_per_thread_data_t *sitd =
+    vec_elt_at_index (silm->per_thread_data, vm->thread_index);
   u64 now;
   vlib_buffer_free_list_t *fl;
   u8 nat_event = QUOTA_EXCEEDED;
@@ -1163,10 +1157,9 @@ nat_ipfix_logging_max_frag_ip6 (u32 limit, ip6_address_t * src, int do_flush)
   if (!silm->enabled)
     return;
 
-  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
-  now += silm->milisecond_time_0;
+  now = nat_ipfix_time_now_ms (vm, sitd);
 
-  b0 = silm->max_frags_ip6_buffer;
+  b0 = sitd->max_frags_ip6_buffer;
 
   if (PREDICT_FALSE (b0 == 0))
     {
@@ -1179,7 +1172,7 @@ nat_ipfix_logging_max_frag_ip6 (u32 limit, ip6_address_t * src, int do_flush)
 	  return;
 	}
 
-      b0 = silm->max_frags_ip6_buffer = vlib_get_buffer (vm, bi0);
+      b0 = sitd->max_frags_ip6_buffer = vlib_get_buffer (vm, bi0);
       fl =
 	vlib_buffer_get_free_list (vm, VLIB_BUFFER_DEFAULT_FREE_LIST_INDEX);
       vlib_buffer_init_for_free_list (b0, fl);
@@ -1189,22 +1182,22 @@ nat_ipfix_logging_max_frag_ip6 (u32 limit, ip6_address_t * src, int do_flush)
   else
     {
       bi0 = vlib_get_buffer_index (vm, b0);
-      offset = silm->max_frags_ip6_next_record_offset;
+      offset = sitd->max_frags_ip6_next_record_offset;
     }
 
-  f = silm->max_frags_ip6_frame;
+  f = sitd->max_frags_ip6_frame;
   if (PREDICT_FALSE (f == 0))
     {
       u32 *to_next;
       f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      silm->max_frags_ip6_frame = f;
+      sitd->max_frags_ip6_frame = f;
       to_next = vlib_frame_vector_args (f);
       to_next[0] = bi0;
       f->n_vectors = 1;
     }
 
   if (PREDICT_FALSE (offset == 0))
-    snat_ipfix_header_create (frm, b0, &offset);
+    snat_ipfix_header_create (frm, vm, b0, &offset);
 
   if (PREDICT_TRUE (do_flush == 0))
     {
@@ -1230,12 +1223,12 @@ nat_ipfix_logging_max_frag_ip6 (u32 limit, ip6_address_t * src, int do_flush)
   if (PREDICT_FALSE
       (do_flush || (offset + MAX_BIBS_LEN) > frm->path_mtu))
     {
-      snat_ipfix_send (frm, f, b0, silm->max_frags_ip6_template_id);
-      silm->max_frags_ip6_frame = 0;
-      silm->max_frags_ip6_buffer = 0;
+      snat_ipfix_send (frm, vm, f, b0, silm->max_frags_ip6_template_id);
+      sitd->max_frags_ip6_frame = 0;
+      sitd->max_frags_ip6_buffer = 0;
       offset = 0;
     }
-  silm->max_frags_ip6_next_record_offset = offset;
+  sitd->max_frags_ip6_next_record_offset = offset;
 }
 
 static void
@@ -1249,17 +1242,18 @@ nat_ipfix_logging_nat64_bibe (u8 nat_event, ip6_address_t * src_ip,
   vlib_buffer_t *b0 = 0;
   u32 bi0 = ~0;
   u32 offset;
-  vlib_main_t *vm = frm->vlib_main;
+  vlib_main_t *vm = vlib_get_main ();
+  snat_ipfix_per_thread_data_t *sitd =
+    vec_elt_at_index (silm->per_thread_data, vm->thread_index);
   u64 now;
   vlib_buffer_free_list_t *fl;
 
   if (!silm->enabled)
     return;
 
-  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
-  now += silm->milisecond_time_0;
+  now = nat_ipfix_time_now_ms (vm, sitd);
 
-  b0 = silm->nat64_bib_buffer;
+  b0 = sitd->nat64_bib_buffer;
 
   if (PREDICT_FALSE (b0 == 0))
     {
@@ -1272,7 +1266,7 @@ nat_ipfix_logging_nat64_bibe (u8 nat_event, ip6_address_t * src_ip,
 	  return;
 	}
 
-      b0 = silm->nat64_bib_buffer = vlib_get_buffer (vm, bi0);
+      b0 = sitd->nat64_bib_buffer = vlib_get_buffer (vm, bi0);
       fl =
 	vlib_buffer_get_free_list (vm, VLIB_BUFFER_DEFAULT_FREE_LIST_INDEX);
       vlib_buffer_init_for_free_list (b0, fl);
@@ -1282,22 +1276,22 @@ nat_ipfix_logging_nat64_bibe (u8 nat_event, ip6_address_t * src_ip,
   else
     {
       bi0 = vlib_get_buffer_index (vm, b0);
-      offset = silm->nat64_bib_next_record_offset;
+      offset = sitd->nat64_bib_next_record_offset;
     }
 
-  f = silm->nat64_bib_frame;
+  f = sitd->nat64_bib_frame;
   if (PREDICT_FALSE (f == 0))
     {
       u32 *to_next;
       f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      silm->nat64_bib_frame = f;
+      sitd->nat64_bib_frame = f;
       to_next = vlib_frame_vector_args (f);
       to_next[0] = bi0;
       f->n_vectors = 1;
     }
 
   if (PREDICT_FALSE (offset == 0))
-    snat_ipfix_header_create (frm, b0, &offset);
+    snat_ipfix_header_create (frm, vm, b0, &offset);
 
   if (PREDICT_TRUE (do_flush == 0))
     {
@@ -1332,12 +1326,12 @@ nat_ipfix_logging_nat64_bibe (u8 nat_event, ip6_address_t * src_ip,
   if (PREDICT_FALSE
       (do_flush || (offset + NAT64_BIB_LEN) > frm->path_mtu))
     {
-      snat_ipfix_send (frm, f, b0, silm->nat64_bib_template_id);
-      silm->nat64_bib_frame = 0;
-      silm->nat64_bib_buffer = 0;
+      snat_ipfix_send (frm, vm, f, b0, silm->nat64_bib_template_id);
+      sitd->nat64_bib_frame = 0;
+      sitd->nat64_bib_buffer = 0;
       offset = 0;
     }
-  silm->nat64_bib_next_record_offset = offset;
+  sitd->nat64_bib_next_record_offset = offset;
 }
 
 static void
@@ -1353,17 +1347,18 @@ nat_ipfix_logging_nat64_ses (u8 nat_event, ip6_address_t * src_ip,
   vlib_buffer_t *b0 = 0;
   u32 bi0 = ~0;
   u32 offset;
-  vlib_main_t *vm = frm->vlib_main;
+  vlib_main_t *vm = vlib_get_main ();
+  snat_ipfix_per_thread_data_t *sitd =
+    vec_elt_at_index (silm->per_thread_data, vm->thread_index);
   u64 now;
   vlib_buffer_free_list_t *fl;
 
   if (!silm->enabled)
     return;
 
-  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
-  now += silm->milisecond_time_0;
+  now = nat_ipfix_time_now_ms (vm, sitd);
 
-  b0 = silm->nat64_ses_buffer;
+  b0 = sitd->nat64_ses_buffer;
 
   if (PREDICT_FALSE (b0 == 0))
     {
@@ -1376,7 +1371,7 @@ nat_ipfix_logging_nat64_ses (u8 nat_event, ip6_address_t * src_ip,
 	  return;
 	}
 
-      b0 = silm->nat64_ses_buffer = vlib_get_buffer (vm, bi0);
+      b0 = sitd->nat64_ses_buffer = vlib_get_buffer (vm, bi0);
       fl =
 	vlib_buffer_get_free_list (vm, VLIB_BUFFER_DEFAULT_FREE_LIST_INDEX);
       vlib_buffer_init_for_free_list (b0, fl);
@@ -1386,22 +1381,22 @@ nat_ipfix_logging_nat64_ses (u8 nat_event, ip6_address_t * src_ip,
   else
     {
       bi0 = vlib_get_buffer_index (vm, b0);
-      offset = silm->nat64_ses_next_record_offset;
+      offset = sitd->nat64_ses_next_record_offset;
     }
 
-  f = silm->nat64_ses_frame;
+  f = sitd->nat64_ses_frame;
   if (PREDICT_FALSE (f == 0))
     {
       u32 *to_next;
       f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      silm->nat64_ses_frame = f;
+      sitd->nat64_ses_frame = f;
       to_next = vlib_frame_vector_args (f);
       to_next[0] = bi0;
       f->n_vectors = 1;
     }
 
   if (PREDICT_FALSE (offset == 0))
-    snat_ipfix_header_create (frm, b0, &offset);
+    snat_ipfix_header_create (frm, vm, b0, &offset);
 
   if (PREDICT_TRUE (do_flush == 0))
     {
@@ -1448,20 +1443,112 @@ nat_ipfix_logging_nat64_ses (u8 nat_event, ip6_address_t * src_ip,
   if (PREDICT_FALSE
       (do_flush || (offset + NAT64_SES_LEN) > frm->path_mtu))
     {
-      snat_ipfix_send (frm, f, b0, silm->nat64_ses_template_id);
-      silm->nat64_ses_frame = 0;
-      silm->nat64_ses_buffer = 0;
+      snat_ipfix_send (frm, vm, f, b0, silm->nat64_ses_template_id);
+      sitd->nat64_ses_frame = 0;
+      sitd->nat64_ses_buffer = 0;
       offset = 0;
     }
-  silm->nat64_ses_next_record_offset = offset;
+  sitd->nat64_ses_next_record_offset = offset;
 }
 
 static void
-snat_ipfix_logging_nat44_ses_rpc_cb (snat_ipfix_logging_nat44_ses_args_t * a)
+nat_ipfix_logging_port_blk (u8 nat_event, u32 src_ip, u32 nat_src_ip,
+			    u16 start_port, u16 end_port, u32 vrf_id,
+			    int do_flush)
 {
-  snat_ipfix_logging_nat44_ses (a->nat_event, a->src_ip, a->nat_src_ip,
-				a->snat_proto, a->src_port, a->nat_src_port,
-				a->vrf_id, 0);
+  snat_ipfix_logging_main_t *silm = &snat_ipfix_logging_main;
+  flow_report_main_t *frm = &flow_report_main;
+  vlib_frame_t *f;
+  vlib_buffer_t *b0 = 0;
+  u32 bi0 = ~0;
+  u32 offset;
+  vlib_main_t *vm = vlib_get_main ();
+  snat_ipfix_per_thread_data_t *sitd =
+    vec_elt_at_index (silm->per_thread_data, vm->thread_index);
+  u64 now;
+  vlib_buffer_free_list_t *fl;
+
+  if (!silm->enabled)
+    return;
+
+  now = nat_ipfix_time_now_ms (vm, sitd);
+
+  b0 = sitd->port_block_buffer;
+
+  if (PREDICT_FALSE (b0 == 0))
+    {
+      if (do_flush)
+	return;
+
+      if (vlib_buffer_alloc (vm, &bi0, 1) != 1)
+	{
+	  clib_warning ("can't allocate buffer for NAT IPFIX event");
+	  return;
+	}
+
+      b0 = sitd->port_block_buffer = vlib_get_buffer (vm, bi0);
+      fl =
+	vlib_buffer_get_free_list (vm, VLIB_BUFFER_DEFAULT_FREE_LIST_INDEX);
+      vlib_buffer_init_for_free_list (b0, fl);
+      VLIB_BUFFER_TRACE_TRAJECTORY_INIT (b0);
+      offset = 0;
+    }
+  else
+    {
+      bi0 = vlib_get_buffer_index (vm, b0);
+      offset = sitd->port_block_next_record_offset;
+    }
+
+  f = sitd->port_block_frame;
+  if (PREDICT_FALSE (f == 0))
+    {
+      u32 *to_next;
+      f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
+      sitd->port_block_frame = f;
+      to_next = vlib_frame_vector_args (f);
+      to_next[0] = bi0;
+      f->n_vectors = 1;
+    }
+
+  if (PREDICT_FALSE (offset == 0))
+    snat_ipfix_header_create (frm, vm, b0, &offset);
+
+  if (PREDICT_TRUE (do_flush == 0))
+    {
+      u64 time_stamp = clib_host_to_net_u64 (now);
+      clib_memcpy (b0->data + offset, &time_stamp, sizeof (time_stamp));
+      offset += sizeof (time_stamp);
+
+      clib_memcpy (b0->data + offset, &nat_event, sizeof (nat_event));
+      offset += sizeof (nat_event);
+
+      clib_memcpy (b0->data + offset, &src_ip, sizeof (src_ip));
+      offset += sizeof (src_ip);
+
+      clib_memcpy (b0->data + offset, &nat_src_ip, sizeof (nat_src_ip));
+      offset += sizeof (nat_src_ip);
+
+      clib_memcpy (b0->data + offset, &start_port, sizeof (start_port));
+      offset += sizeof (start_port);
+
+      clib_memcpy (b0->data + offset, &end_port, sizeof (end_port));
+      offset += sizeof (end_port);
+
+      clib_memcpy (b0->data + offset, &vrf_id, sizeof (vrf_id));
+      offset += sizeof (vrf_id);
+
+      b0->current_length += NAT_PORT_BLOCK_LEN;
+    }
+
+  if (PREDICT_FALSE
+      (do_flush || (offset + NAT_PORT_BLOCK_LEN) > frm->path_mtu))
+    {
+      snat_ipfix_send (frm, vm, f, b0, silm->port_block_template_id);
+      sitd->port_block_frame = 0;
+      sitd->port_block_buffer = 0;
+      offset = 0;
+    }
+  sitd->port_block_next_record_offset = offset;
 }
 
 /**
@@ -1481,20 +1568,10 @@ snat_ipfix_logging_nat44_ses_create (u32 src_ip,
 				     u16 src_port,
 				     u16 nat_src_port, u32 vrf_id)
 {
-  snat_ipfix_logging_nat44_ses_args_t a;
-
   skip_if_disabled ();
 
-  a.nat_event = NAT44_SESSION_CREATE;
-  a.src_ip = src_ip;
-  a.nat_src_ip = nat_src_ip;
-  a.snat_proto = snat_proto;
-  a.src_port = src_port;
-  a.nat_src_port = nat_src_port;
-  a.vrf_id = vrf_id;
-
-  vl_api_rpc_call_main_thread (snat_ipfix_logging_nat44_ses_rpc_cb,
-			       (u8 *) & a, sizeof (a));
+  snat_ipfix_logging_nat44_ses (NAT44_SESSION_CREATE, src_ip, nat_src_ip,
+				snat_proto, src_port, nat_src_port, vrf_id, 0);
 }
 
 /**
@@ -1514,37 +1591,10 @@ snat_ipfix_logging_nat44_ses_delete (u32 src_ip,
 				     u16 src_port,
 				     u16 nat_src_port, u32 vrf_id)
 {
-  snat_ipfix_logging_nat44_ses_args_t a;
-
   skip_if_disabled ();
 
-  a.nat_event = NAT44_SESSION_DELETE;
-  a.src_ip = src_ip;
-  a.nat_src_ip = nat_src_ip;
-  a.snat_proto = snat_proto;
-  a.src_port = src_port;
-  a.nat_src_port = nat_src_port;
-  a.vrf_id = vrf_id;
-
-  vl_api_rpc_call_main_thread (snat_ipfix_logging_nat44_ses_rpc_cb,
-			       (u8 *) & a, sizeof (a));
-}
-
-vlib_frame_t *
-snat_data_callback_nat44_session (flow_report_main_t * frm,
-				  flow_report_t * fr,
-				  vlib_frame_t * f,
-				  u32 * to_next, u32 node_index)
-{
-  snat_ipfix_logging_nat44_ses (0, 0, 0, 0, 0, 0, 0, 1);
-  return f;
-}
-
-static void
-  snat_ipfix_logging_addr_exhausted_rpc_cb
-  (snat_ipfix_logging_addr_exhausted_args_t * a)
-{
-  snat_ipfix_logging_addr_exhausted (a->pool_id, 0);
+  snat_ipfix_logging_nat44_ses (NAT44_SESSION_DELETE, src_ip, nat_src_ip,
+				snat_proto, src_port, nat_src_port, vrf_id, 0);
 }
 
 /**
@@ -1556,31 +1606,9 @@ void
 snat_ipfix_logging_addresses_exhausted (u32 pool_id)
 {
   //TODO: This event SHOULD be rate limited
-  snat_ipfix_logging_addr_exhausted_args_t a;
-
   skip_if_disabled ();
 
-  a.pool_id = pool_id;
-
-  vl_api_rpc_call_main_thread (snat_ipfix_logging_addr_exhausted_rpc_cb,
-			       (u8 *) & a, sizeof (a));
-}
-
-vlib_frame_t *
-snat_data_callback_addr_exhausted (flow_report_main_t * frm,
-				   flow_report_t * fr,
-				   vlib_frame_t * f,
-				   u32 * to_next, u32 node_index)
-{
-  snat_ipfix_logging_addr_exhausted (0, 1);
-  return f;
-}
-
-static void
-  snat_ipfix_logging_max_entries_per_usr_rpc_cb
-  (snat_ipfix_logging_max_entries_per_user_args_t * a)
-{
-  snat_ipfix_logging_max_entries_per_usr (a->limit, a->src_ip, 0);
+  snat_ipfix_logging_addr_exhausted (pool_id, 0);
 }
 
 /**
@@ -1593,31 +1621,9 @@ void
 snat_ipfix_logging_max_entries_per_user (u32 limit, u32 src_ip)
 {
   //TODO: This event SHOULD be rate limited
-  snat_ipfix_logging_max_entries_per_user_args_t a;
-
   skip_if_disabled ();
 
-  a.limit = limit;
-  a.src_ip = src_ip;
-
-  vl_api_rpc_call_main_thread (snat_ipfix_logging_max_entries_per_usr_rpc_cb,
-			       (u8 *) & a, sizeof (a));
-}
-
-vlib_frame_t *
-snat_data_callback_max_entries_per_usr (flow_report_main_t * frm,
-					flow_report_t * fr,
-					vlib_frame_t * f,
-					u32 * to_next, u32 node_index)
-{
-  snat_ipfix_logging_max_entries_per_usr (0, 0, 1);
-  return f;
-}
-
-static void
-nat_ipfix_logging_max_ses_rpc_cb (nat_ipfix_logging_max_sessions_args_t * a)
-{
-  nat_ipfix_logging_max_ses (a->limit, 0);
+  snat_ipfix_logging_max_entries_per_usr (limit, src_ip, 0);
 }
 
 /**
@@ -1629,30 +1635,9 @@ void
 nat_ipfix_logging_max_sessions (u32 limit)
 {
   //TODO: This event SHOULD be rate limited
-  nat_ipfix_logging_max_sessions_args_t a;
-
   skip_if_disabled ();
 
-  a.limit = limit;
-
-  vl_api_rpc_call_main_thread (nat_ipfix_logging_max_ses_rpc_cb,
-			       (u8 *) & a, sizeof (a));
-}
-
-vlib_frame_t *
-nat_data_callback_max_sessions (flow_report_main_t * frm,
-				flow_report_t * fr,
-				vlib_frame_t * f,
-				u32 * to_next, u32 node_index)
-{
-  nat_ipfix_logging_max_ses (0, 1);
-  return f;
-}
-
-static void
-nat_ipfix_logging_max_bib_rpc_cb (nat_ipfix_logging_max_bibs_args_t * a)
-{
-  nat_ipfix_logging_max_bib (a->limit, 0);
+  nat_ipfix_logging_max_ses (limit, 0);
 }
 
 /**
@@ -1664,30 +1649,9 @@ void
 nat_ipfix_logging_max_bibs (u32 limit)
 {
   //TODO: This event SHOULD be rate limited
-  nat_ipfix_logging_max_bibs_args_t a;
-
   skip_if_disabled ();
 
-  a.limit = limit;
-
-  vl_api_rpc_call_main_thread (nat_ipfix_logging_max_bib_rpc_cb,
-			       (u8 *) & a, sizeof (a));
-}
-
-vlib_frame_t *
-nat_data_callback_max_bibs (flow_report_main_t * frm,
-			    flow_report_t * fr,
-			    vlib_frame_t * f,
-			    u32 * to_next, u32 node_index)
-{
-  nat_ipfix_logging_max_bib (0, 1);
-  return f;
-}
-
-static void
-nat_ipfix_logging_max_frag_ip4_rpc_cb (nat_ipfix_logging_max_frags_ip4_args_t * a)
-{
-  nat_ipfix_logging_max_frag_ip4 (a->limit, a->src, 0);
+  nat_ipfix_logging_max_bib (limit, 0);
 }
 
 /**
@@ -1700,34 +1664,9 @@ void
 nat_ipfix_logging_max_fragments_ip4 (u32 limit, ip4_address_t * src)
 {
   //TODO: This event SHOULD be rate limited
-  nat_ipfix_logging_max_frags_ip4_args_t a;
-
   skip_if_disabled ();
 
-  a.limit = limit;
-  a.src = src->as_u32;
-
-  vl_api_rpc_call_main_thread (nat_ipfix_logging_max_frag_ip4_rpc_cb,
-			       (u8 *) & a, sizeof (a));
-}
-
-vlib_frame_t *
-nat_data_callback_max_frags_ip4 (flow_report_main_t * frm,
-			         flow_report_t * fr,
-			         vlib_frame_t * f,
-			         u32 * to_next, u32 node_index)
-{
-  nat_ipfix_logging_max_frag_ip4 (0, 0, 1);
-  return f;
-}
-
-static void
-nat_ipfix_logging_max_frag_ip6_rpc_cb (nat_ipfix_logging_max_frags_ip6_args_t * a)
-{
-  ip6_address_t src;
-  src.as_u64[0] = a->src[0];
-  src.as_u64[1] = a->src[1];
-  nat_ipfix_logging_max_frag_ip6 (a->limit, &src, 0);
+  nat_ipfix_logging_max_frag_ip4 (limit, src->as_u32, 0);
 }
 
 /**
@@ -1740,37 +1679,9 @@ void
 nat_ipfix_logging_max_fragments_ip6 (u32 limit, ip6_address_t * src)
 {
   //TODO: This event SHOULD be rate limited
-  nat_ipfix_logging_max_frags_ip6_args_t a;
-
   skip_if_disabled ();
 
-  a.limit = limit;
-  a.src[0] = src->as_u64[0];
-  a.src[1] = src->as_u64[1];
-
-  vl_api_rpc_call_main_thread (nat_ipfix_logging_max_frag_ip6_rpc_cb,
-			       (u8 *) & a, sizeof (a));
-}
-
-vlib_frame_t *
-nat_data_callback_max_frags_ip6 (flow_report_main_t * frm,
-			         flow_report_t * fr,
-			         vlib_frame_t * f,
-			         u32 * to_next, u32 node_index)
-{
-  nat_ipfix_logging_max_frag_ip6 (0, 0, 1);
-  return f;
-}
-
-static void
-nat_ipfix_logging_nat64_bib_rpc_cb (nat_ipfix_logging_nat64_bib_args_t * a)
-{
-  ip6_address_t src_ip;
-  src_ip.as_u64[0] = a->src_ip[0];
-  src_ip.as_u64[1] = a->src_ip[1];
-  nat_ipfix_logging_nat64_bibe (a->nat_event, &src_ip, a->nat_src_ip,
-                                a->proto, a->src_port, a->nat_src_port,
-                                a->vrf_id, 0);
+  nat_ipfix_logging_max_frag_ip6 (limit, src, 0);
 }
 
 /**
@@ -1790,45 +1701,14 @@ nat_ipfix_logging_nat64_bib (ip6_address_t * src_ip,
                              u16 src_port, u16 nat_src_port, u32 vrf_id,
                              u8 is_create)
 {
-  nat_ipfix_logging_nat64_bib_args_t a;
+  u8 nat_event;
 
   skip_if_disabled ();
 
-  a.src_ip[0] = src_ip->as_u64[0];
-  a.src_ip[1] = src_ip->as_u64[1];
-  a.nat_src_ip = nat_src_ip->as_u32;
-  a.proto = proto;
-  a.src_port = src_port;
-  a.nat_src_port = nat_src_port;
-  a.vrf_id = vrf_id;
-  a.nat_event = is_create ? NAT64_BIB_CREATE : NAT64_BIB_DELETE;
-
-  vl_api_rpc_call_main_thread (nat_ipfix_logging_nat64_bib_rpc_cb,
-			       (u8 *) & a, sizeof (a));
-}
+  nat_event = is_create ? NAT64_BIB_CREATE : NAT64_BIB_DELETE;
 
-vlib_frame_t *
-nat_data_callback_nat64_bib (flow_report_main_t * frm,
-			     flow_report_t * fr,
-			     vlib_frame_t * f,
-			     u32 * to_next, u32 node_index)
-{
-  nat_ipfix_logging_nat64_bibe (0, 0, 0, 0, 0, 0, 0, 1);
-  return f;
-}
-
-static void
-nat_ipfix_logging_nat64_ses_rpc_cb (nat_ipfix_logging_nat64_ses_args_t * a)
-{
-  ip6_address_t src_ip, dst_ip;
-  src_ip.as_u64[0] = a->src_ip[0];
-  src_ip.as_u64[1] = a->src_ip[1];
-  dst_ip.as_u64[0] = a->dst_ip[0];
-  dst_ip.as_u64[1] = a->dst_ip[1];
-  nat_ipfix_logging_nat64_ses (a->nat_event, &src_ip, a->nat_src_ip,
-                               a->proto, a->src_port, a->nat_src_port,
-                               &dst_ip, a->nat_dst_ip, a->dst_port,
-                               a->nat_dst_port, a->vrf_id, 0);
+  nat_ipfix_logging_nat64_bibe (nat_event, src_ip, nat_src_ip->as_u32,
+                                proto, src_port, nat_src_port, vrf_id, 0);
 }
 
 /**
@@ -1854,35 +1734,115 @@ nat_ipfix_logging_nat64_session (ip6_address_t * src_ip,
                                  ip4_address_t * nat_dst_ip, u16 dst_port,
                                  u16 nat_dst_port, u32 vrf_id, u8 is_create)
 {
-  nat_ipfix_logging_nat64_ses_args_t a;
+  u8 nat_event;
+
+  skip_if_disabled ();
+
+  nat_event = is_create ? NAT64_SESSION_CREATE : NAT64_SESSION_DELETE;
+
+  nat_ipfix_logging_nat64_ses (nat_event, src_ip, nat_src_ip->as_u32,
+                               proto, src_port, nat_src_port, dst_ip,
+                               nat_dst_ip->as_u32, dst_port, nat_dst_port,
+                               vrf_id, 0);
+}
+
+/**
+ * @brief Generate NAT port block allocation or release event
+ *
+ * @param src_ip     source IPv4 address
+ * @param nat_src_ip translated source IPv4 address
+ * @param start_port first port of the block
+ * @param end_port   last port of the block
+ * @param vrf_id     VRF ID
+ * @param is_alloc   1 if the block is allocated, 0 if released
+ */
+void
+nat_ipfix_logging_port_block (u32 src_ip, u32 nat_src_ip, u16 start_port,
+			      u16 end_port, u32 vrf_id, u8 is_alloc)
+{
+  u8 nat_event;
 
   skip_if_disabled ();
 
-  a.src_ip[0] = src_ip->as_u64[0];
-  a.src_ip[1] = src_ip->as_u64[1];
-  a.nat_src_ip = nat_src_ip->as_u32;
-  a.proto = proto;
-  a.src_port = src_port;
-  a.nat_src_port = nat_src_port;
-  a.dst_ip[0] = dst_ip->as_u64[0];
-  a.dst_ip[1] = dst_ip->as_u64[1];
-  a.nat_dst_ip = nat_dst_ip->as_u32;
-  a.dst_port = dst_port;
-  a.nat_dst_port = nat_dst_port;
-  a.vrf_id = vrf_id;
-  a.nat_event = is_create ? NAT64_SESSION_CREATE : NAT64_SESSION_DELETE;
-
-  vl_api_rpc_call_main_thread (nat_ipfix_logging_nat64_ses_rpc_cb,
-			       (u8 *) & a, sizeof (a));
+  nat_event = is_alloc ? NAT_PORT_BLOCK_ALLOC : NAT_PORT_BLOCK_DEALLOC;
+
+  nat_ipfix_logging_port_blk (nat_event, src_ip, nat_src_ip,
+			      clib_host_to_net_u16 (start_port),
+			      clib_host_to_net_u16 (end_port), vrf_id, 0);
 }
 
-vlib_frame_t *
-nat_data_callback_nat64_session (flow_report_main_t * frm,
-			         flow_report_t * fr,
-			         vlib_frame_t * f,
-			         u32 * to_next, u32 node_index)
+/**
+ * @brief Send the records of the calling thread built so far
+ */
+void
+nat_ipfix_flush (void)
 {
+  snat_ipfix_logging_nat44_ses (0, 0, 0, 0, 0, 0, 0, 1);
+  snat_ipfix_logging_addr_exhausted (0, 1);
+  snat_ipfix_logging_max_entries_per_usr (0, 0, 1);
+  nat_ipfix_logging_max_ses (0, 1);
+  nat_ipfix_logging_max_bib (0, 1);
+  nat_ipfix_logging_max_frag_ip4 (0, 0, 1);
+  nat_ipfix_logging_max_frag_ip6 (0, 0, 1);
+  nat_ipfix_logging_nat64_bibe (0, 0, 0, 0, 0, 0, 0, 1);
   nat_ipfix_logging_nat64_ses (0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1);
+  nat_ipfix_logging_port_blk (0, 0, 0, 0, 0, 0, 1);
+}
+
+static uword
+nat_ipfix_flush_node_fn (vlib_main_t * vm, vlib_node_runtime_t * rt,
+			 vlib_frame_t * f)
+{
+  nat_ipfix_flush ();
+  return 0;
+}
+
+static vlib_node_registration_t nat_ipfix_flush_node;
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (nat_ipfix_flush_node, static) = {
+  .function = nat_ipfix_flush_node_fn,
+  .type = VLIB_NODE_TYPE_INPUT,
+  .state = VLIB_NODE_STATE_INTERRUPT,
+  .name = "nat-ipfix-flush",
+};
+/* *INDENT-ON* */
+
+/**
+ * @brief Send the records of all threads built so far
+ *
+ * The records of the main thread are sent right away, each worker sends
+ * its own when it next polls the nat-ipfix-flush node.
+ */
+void
+nat_ipfix_flush_from_main (void)
+{
+  vlib_main_t *worker_vm;
+  int i;
+
+  skip_if_disabled ();
+
+  nat_ipfix_flush ();
+
+  for (i = 1; i < vec_len (vlib_mains); i++)
+    {
+      worker_vm = vlib_mains[i];
+      if (worker_vm)
+	vlib_node_set_interrupt_pending (worker_vm,
+					 nat_ipfix_flush_node.index);
+    }
+}
+
+/*
+ * The flow report process calls the data callback of each report every
+ * template interval, and on "ipfix flush". All the NAT reports share this
+ * one: a flush with no records pending is cheap.
+ */
+static vlib_frame_t *
+nat_data_callback (flow_report_main_t * frm, flow_report_t * fr,
+		   vlib_frame_t * f, u32 * to_next, u32 node_index)
+{
+  nat_ipfix_flush_from_main ();
   return f;
 }
 
@@ -1918,7 +1878,7 @@ snat_ipfix_logging_enable_disable (int enable, u32 domain_id, u16 src_port)
   if (sm->deterministic)
     {
       a.rewrite_callback = snat_template_rewrite_max_entries_per_usr;
-      a.flow_data_callback = snat_data_callback_max_entries_per_usr;
+      a.flow_data_callback = nat_data_callback;
 
       rv = vnet_flow_report_add_del (frm, &a, NULL);
       if (rv)
@@ -1930,7 +1890,7 @@ snat_ipfix_logging_enable_disable (int enable, u32 domain_id, u16 src_port)
   else
     {
       a.rewrite_callback = snat_template_rewrite_nat44_session;
-      a.flow_data_callback = snat_data_callback_nat44_session;
+      a.flow_data_callback = nat_data_callback;
 
       rv = vnet_flow_report_add_del (frm, &a, NULL);
       if (rv)
@@ -1940,7 +1900,7 @@ snat_ipfix_logging_enable_disable (int enable, u32 domain_id, u16 src_port)
 	}
 
       a.rewrite_callback = snat_template_rewrite_addr_exhausted;
-      a.flow_data_callback = snat_data_callback_addr_exhausted;
+      a.flow_data_callback = nat_data_callback;
 
       rv = vnet_flow_report_add_del (frm, &a, NULL);
       if (rv)
@@ -1950,7 +1910,7 @@ snat_ipfix_logging_enable_disable (int enable, u32 domain_id, u16 src_port)
 	}
 
       a.rewrite_callback = nat_template_rewrite_max_sessions;
-      a.flow_data_callback = nat_data_callback_max_sessions;
+      a.flow_data_callback = nat_data_callback;
 
       rv = vnet_flow_report_add_del (frm, &a, NULL);
       if (rv)
@@ -1960,7 +1920,7 @@ snat_ipfix_logging_enable_disable (int enable, u32 domain_id, u16 src_port)
 	}
 
       a.rewrite_callback = nat_template_rewrite_max_bibs;
-      a.flow_data_callback = nat_data_callback_max_bibs;
+      a.flow_data_callback = nat_data_callback;
 
       rv = vnet_flow_report_add_del (frm, &a, NULL);
       if (rv)
@@ -1970,7 +1930,7 @@ snat_ipfix_logging_enable_disable (int enable, u32 domain_id, u16 src_port)
 	}
 
       a.rewrite_callback = nat_template_rewrite_max_frags_ip4;
-      a.flow_data_callback = nat_data_callback_max_frags_ip4;
+      a.flow_data_callback = nat_data_callback;
 
       rv = vnet_flow_report_add_del (frm, &a, NULL);
       if (rv)
@@ -1980,7 +1940,7 @@ snat_ipfix_logging_enable_disable (int enable, u32 domain_id, u16 src_port)
 	}
 
       a.rewrite_callback = nat_template_rewrite_max_frags_ip6;
-      a.flow_data_callback = nat_data_callback_max_frags_ip6;
+      a.flow_data_callback = nat_data_callback;
 
       rv = vnet_flow_report_add_del (frm, &a, NULL);
       if (rv)
@@ -1990,7 +1950,7 @@ snat_ipfix_logging_enable_disable (int enable, u32 domain_id, u16 src_port)
 	}
 
       a.rewrite_callback = nat_template_rewrite_nat64_bib;
-      a.flow_data_callback = nat_data_callback_nat64_bib;
+      a.flow_data_callback = nat_data_callback;
 
       rv = vnet_flow_report_add_del (frm, &a, NULL);
       if (rv)
@@ -2000,7 +1960,17 @@ snat_ipfix_logging_enable_disable (int enable, u32 domain_id, u16 src_port)
 	}
 
       a.rewrite_callback = nat_template_rewrite_nat64_session;
-      a.flow_data_callback = nat_data_callback_nat64_session;
+      a.flow_data_callback = nat_data_callback;
+
+      rv = vnet_flow_report_add_del (frm, &a, NULL);
+      if (rv)
+	{
+	  clib_warning ("vnet_flow_report_add_del returned %d", rv);
+	  return -1;
+	}
+
+      a.rewrite_callback = nat_template_rewrite_port_block;
+      a.flow_data_callback = nat_data_callback;
 
       rv = vnet_flow_report_add_del (frm, &a, NULL);
       if (rv)
@@ -2025,7 +1995,7 @@ snat_ipfix_logging_init (vlib_main_t * vm)
 
   silm->enabled = 0;
 
-  /* Set up time reference pair */
-  silm->vlib_time_0 = vlib_time_now (vm);
-  silm->milisecond_time_0 = unix_time_now_nsec () * 1e-6;
+  vec_validate_aligned (silm->per_thread_data,
+			vlib_get_thread_main ()->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
 }
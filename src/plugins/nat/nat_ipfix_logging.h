@@ -29,6 +29,8 @@ typedef enum {
   NAT64_BIB_DELETE = 11,
   NAT_PORTS_EXHAUSTED = 12,
   QUOTA_EXCEEDED = 13,
+  NAT_PORT_BLOCK_ALLOC = 16,
+  NAT_PORT_BLOCK_DEALLOC = 17,
 } nat_event_t;
 
 typedef enum {
@@ -40,8 +42,7 @@ typedef enum {
 } quota_exceed_event_t;
 
 typedef struct {
-  /** NAT plugin IPFIX logging enabled */
-  u8 enabled;
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
 
   /** ipfix buffers under construction */
   vlib_buffer_t *nat44_session_buffer;
@@ -53,6 +54,7 @@ typedef struct {
   vlib_buffer_t *max_frags_ip6_buffer;
   vlib_buffer_t *nat64_bib_buffer;
   vlib_buffer_t *nat64_ses_buffer;
+  vlib_buffer_t *port_block_buffer;
 
   /** frames containing ipfix buffers */
   vlib_frame_t *nat44_session_frame;
@@ -64,6 +66,7 @@ typedef struct {
   vlib_frame_t *max_frags_ip6_frame;
   vlib_frame_t *nat64_bib_frame;
   vlib_frame_t *nat64_ses_frame;
+  vlib_frame_t *port_block_frame;
 
   /** next record offset */
   u32 nat44_session_next_record_offset;
@@ -75,10 +78,19 @@ typedef struct {
   u32 max_frags_ip6_next_record_offset;
   u32 nat64_bib_next_record_offset;
   u32 nat64_ses_next_record_offset;
+  u32 port_block_next_record_offset;
 
   /** Time reference pair */
   u64 milisecond_time_0;
   f64 vlib_time_0;
+} snat_ipfix_per_thread_data_t;
+
+typedef struct {
+  /** NAT plugin IPFIX logging enabled */
+  u8 enabled;
+
+  /** per thread data, records are built by the thread logging them */
+  snat_ipfix_per_thread_data_t *per_thread_data;
 
   /** template IDs */
   u16 nat44_session_template_id;
@@ -90,6 +102,7 @@ typedef struct {
   u16 max_frags_ip6_template_id;
   u16 nat64_bib_template_id;
   u16 nat64_ses_template_id;
+  u16 port_block_template_id;
 
   /** stream index */
   u32 stream_index;
@@ -99,6 +112,8 @@ extern snat_ipfix_logging_main_t snat_ipfix_logging_main;
 
 void snat_ipfix_logging_init (vlib_main_t * vm);
 int snat_ipfix_logging_enable_disable (int enable, u32 domain_id, u16 src_port);
+void nat_ipfix_flush (void);
+void nat_ipfix_flush_from_main (void);
 void snat_ipfix_logging_nat44_ses_create (u32 src_ip, u32 nat_src_ip,
                                           snat_protocol_t snat_proto,
                                           u16 src_port, u16 nat_src_port,
@@ -124,5 +139,8 @@ void nat_ipfix_logging_nat64_bib(ip6_address_t * src_ip,
                                  ip4_address_t * nat_src_ip, u8 proto,
                                  u16 src_port, u16 nat_src_port,
                                  u32 vrf_id, u8 is_create);
+void nat_ipfix_logging_port_block (u32 src_ip, u32 nat_src_ip,
+                                   u16 start_port, u16 end_port,
+                                   u32 vrf_id, u8 is_alloc);
 
 #endif /* __included_nat_ipfix_logging_h__ */
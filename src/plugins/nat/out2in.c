@@ -312,11 +312,13 @@ icmp_get_ed_key(ip4_header_t *ip0, nat_ed_ses_key_t *p_key0)
 }
 
 static void
-create_bypass_for_fwd(snat_main_t * sm, ip4_header_t * ip)
+create_bypass_for_fwd(snat_main_t * sm, ip4_header_t * ip, u32 thread_index)
 {
   nat_ed_ses_key_t key;
   clib_bihash_kv_16_8_t kv;
   udp_header_t *udp;
+  snat_main_per_thread_data_t *tsm;
+  ip4_header_t in2out_ip;
 
   if (ip->protocol == IP_PROTOCOL_ICMP)
     {
@@ -344,7 +346,15 @@ create_bypass_for_fwd(snat_main_t * sm, ip4_header_t * ip)
   kv.key[1] = key.as_u64[1];
   kv.value = ~0ULL;
 
-  if (clib_bihash_add_del_16_8 (&sm->in2out_ed, &kv, 1))
+  /* the bypass is looked up by the worker the replies are handed to */
+  if (sm->num_workers > 1)
+    {
+      in2out_ip.src_address = ip->dst_address;
+      thread_index = sm->worker_in2out_cb (&in2out_ip, 0);
+    }
+  tsm = &sm->per_thread_data[thread_index];
+
+  if (clib_bihash_add_del_16_8 (&tsm->in2out_ed, &kv, 1))
     clib_warning ("in2out_ed key add failed");
 }
 
@@ -419,7 +429,7 @@ u32 icmp_match_out2in_slow(snat_main_t *sm, vlib_node_runtime_t *node,
             }
           else
             {
-              create_bypass_for_fwd(sm, ip0);
+              create_bypass_for_fwd(sm, ip0, thread_index);
               dont_translate = 1;
               goto out;
             }
@@ -470,7 +480,8 @@ u32 icmp_match_out2in_slow(snat_main_t *sm, vlib_node_runtime_t *node,
           key.fib_index = rx_fib_index0;
           s_kv.key[0] = key.as_u64[0];
           s_kv.key[1] = key.as_u64[1];
-          if (!clib_bihash_search_16_8 (&sm->out2in_ed, &s_kv, &s_value))
+          if (!clib_bihash_search_16_8 (&sm->per_thread_data[thread_index].out2in_ed,
+                                        &s_kv, &s_value))
             s0 = pool_elt_at_index (sm->per_thread_data[thread_index].sessions,
                                     s_value.value);
           else
@@ -751,7 +762,7 @@ snat_out2in_unknown_proto (snat_main_t *sm,
   s_kv.key[0] = key.as_u64[0];
   s_kv.key[1] = key.as_u64[1];
 
-  if (!clib_bihash_search_16_8 (&sm->out2in_ed, &s_kv, &s_value))
+  if (!clib_bihash_search_16_8 (&tsm->out2in_ed, &s_kv, &s_value))
     {
       s = pool_elt_at_index (tsm->sessions, s_value.value);
       new_addr = ip->dst_address.as_u32 = s->in2out.addr.as_u32;
@@ -808,14 +819,14 @@ snat_out2in_unknown_proto (snat_main_t *sm,
 
       /* Add to lookup tables */
       s_kv.value = s - tsm->sessions;
-      if (clib_bihash_add_del_16_8 (&sm->out2in_ed, &s_kv, 1))
+      if (clib_bihash_add_del_16_8 (&tsm->out2in_ed, &s_kv, 1))
         clib_warning ("out2in key add failed");
 
       key.l_addr = ip->dst_address;
       key.fib_index = m->fib_index;
       s_kv.key[0] = key.as_u64[0];
       s_kv.key[1] = key.as_u64[1];
-      if (clib_bihash_add_del_16_8 (&sm->in2out_ed, &s_kv, 1))
+      if (clib_bihash_add_del_16_8 (&tsm->in2out_ed, &s_kv, 1))
         clib_warning ("in2out key add failed");
    }
 
@@ -875,7 +886,7 @@ snat_out2in_lb (snat_main_t *sm,
   s_kv.key[0] = key.as_u64[0];
   s_kv.key[1] = key.as_u64[1];
 
-  if (!clib_bihash_search_16_8 (&sm->out2in_ed, &s_kv, &s_value))
+  if (!clib_bihash_search_16_8 (&tsm->out2in_ed, &s_kv, &s_value))
     {
       s = pool_elt_at_index (tsm->sessions, s_value.value);
     }
@@ -920,7 +931,7 @@ snat_out2in_lb (snat_main_t *sm,
 
       /* Add to lookup tables */
       s_kv.value = s - tsm->sessions;
-      if (clib_bihash_add_del_16_8 (&sm->out2in_ed, &s_kv, 1))
+      if (clib_bihash_add_del_16_8 (&tsm->out2in_ed, &s_kv, 1))
         clib_warning ("out2in-ed key add failed");
 
       if (twice_nat)
@@ -944,7 +955,7 @@ snat_out2in_lb (snat_main_t *sm,
       key.l_port = l_key.port;
       s_kv.key[0] = key.as_u64[0];
       s_kv.key[1] = key.as_u64[1];
-      if (clib_bihash_add_del_16_8 (&sm->in2out_ed, &s_kv, 1))
+      if (clib_bihash_add_del_16_8 (&tsm->in2out_ed, &s_kv, 1))
         clib_warning ("in2out-ed key add failed");
     }
 
@@ -979,6 +990,7 @@ snat_out2in_lb (snat_main_t *sm,
           ip->src_address.as_u32 = s->ext_host_nat_addr.as_u32;
         }
       tcp->checksum = ip_csum_fold(sum);
+      nat44_session_update_tcp (sm, s, tcp, thread_index, 0);
     }
   else
     {
@@ -1156,7 +1168,7 @@ snat_out2in_node_fn (vlib_main_t * vm,
                     }
                   else
                     {
-                      create_bypass_for_fwd(sm, ip0);
+                      create_bypass_for_fwd(sm, ip0, thread_index);
                       goto trace0;
                     }
                 }
@@ -1214,6 +1226,7 @@ snat_out2in_node_fn (vlib_main_t * vm,
                                      ip4_header_t /* cheat */,
                                      length /* changed member */);
               tcp0->checksum = ip_csum_fold(sum0);
+              nat44_session_update_tcp (sm, s0, tcp0, thread_index, 0);
             }
           else
             {
@@ -1327,7 +1340,7 @@ snat_out2in_node_fn (vlib_main_t * vm,
                     }
                   else
                     {
-                      create_bypass_for_fwd(sm, ip1);
+                      create_bypass_for_fwd(sm, ip1, thread_index);
                       goto trace1;
                     }
                 }
@@ -1385,6 +1398,7 @@ snat_out2in_node_fn (vlib_main_t * vm,
                                      ip4_header_t /* cheat */,
                                      length /* changed member */);
               tcp1->checksum = ip_csum_fold(sum1);
+              nat44_session_update_tcp (sm, s1, tcp1, thread_index, 0);
             }
           else
             {
@@ -1534,7 +1548,7 @@ snat_out2in_node_fn (vlib_main_t * vm,
                     }
                   else
                     {
-                      create_bypass_for_fwd(sm, ip0);
+                      create_bypass_for_fwd(sm, ip0, thread_index);
                       goto trace00;
                     }
                 }
@@ -1592,6 +1606,7 @@ snat_out2in_node_fn (vlib_main_t * vm,
                                      ip4_header_t /* cheat */,
                                      length /* changed member */);
               tcp0->checksum = ip_csum_fold(sum0);
+              nat44_session_update_tcp (sm, s0, tcp0, thread_index, 0);
             }
           else
             {
@@ -1781,7 +1796,7 @@ nat44_out2in_reass_node_fn (vlib_main_t * vm,
                         }
                       else
                         {
-                          create_bypass_for_fwd(sm, ip0);
+                          create_bypass_for_fwd(sm, ip0, thread_index);
                           goto trace0;
                         }
                     }
@@ -1851,6 +1866,7 @@ nat44_out2in_reass_node_fn (vlib_main_t * vm,
                                          ip4_header_t /* cheat */,
                                          length /* changed member */);
                   tcp0->checksum = ip_csum_fold(sum0);
+                  nat44_session_update_tcp (sm, s0, tcp0, thread_index, 0);
                 }
               else
                 {
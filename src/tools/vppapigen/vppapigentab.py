@@ -0,0 +1,94 @@
+
+# vppapigentab.py
+# This file is automatically generated. Do not edit.
+# pylint: disable=W,C,R
+_tabversion = '3.10'
+
+_lr_method = 'LALR'
+
+_lr_signature = "AUTOREPLY BOOL DEFINE DONT_TRACE ENUM EVENTS F64 FALSE I16 I32 I64 I8 ID IMPORT MANUAL_ENDIAN MANUAL_PRINT NULL NUM OPTION RETURNS RPC SERVICE STREAM STRING STRING_LITERAL TRUE TYPEDEF TYPEONLY U16 U32 U64 U8slist : stmt\n                 | slist stmtstmt : define\n                | typedef\n                | option\n                | import\n                | enum\n                | serviceimport : IMPORT STRING_LITERAL ';' service : SERVICE '{' service_statements '}' ';' service_statements : service_statement\n                        | service_statements service_statementservice_statement : RPC ID RETURNS NULL ';'\n                             | RPC ID RETURNS ID ';'\n                             | RPC ID RETURNS STREAM ID ';'\n                             | RPC ID RETURNS ID EVENTS event_list ';' event_list : events\n                      | event_list events events : ID\n                  | ID ',' enum : ENUM ID '{' enum_statements '}' ';'  enum : ENUM ID ':' enum_size '{' enum_statements '}' ';'  enum_size : U8\n                      | U16\n                      | U32 define : DEFINE ID '{' block_statements_opt '}' ';' define : flist DEFINE ID '{' block_statements_opt '}' ';' flist : flag\n                 | flist flagflag : MANUAL_PRINT\n                | MANUAL_ENDIAN\n                | DONT_TRACE\n                | TYPEONLY\n                | AUTOREPLYtypedef : TYPEDEF ID '{' block_statements_opt '}' ';' block_statements_opt : block_statementsblock_statements : block_statement\n                            | block_statements block_statementblock_statement : declaration\n                           | option enum_statements : enum_statement\n                            | enum_statements enum_statementenum_statement : ID '=' NUM ','\n                          | ID ',' declaration : type_specifier ID ';' declaration : type_specifier ID '[' NUM ']' ';'\n                       | type_specifier ID '[' ID ']' ';' option : OPTION ID '=' assignee ';' assignee : NUM\n                    | TRUE\n                    | FALSE\n                    | STRING_LITERAL type_specifier : U8\n                          | U16\n                          | U32\n                          | U64\n                          | I8\n                          | I16\n                          | I32\n                          | I64\n                          | F64\n                          | BOOL\n                          | STRINGtype_specifier : ID "
+    
+_lr_action_items = {'U16':([36,37,39,56,58,59,62,75,76,81,94,119,120,],[57,57,74,-37,57,-40,-39,57,-48,-38,-45,-46,-47,]),'OPTION':([0,1,5,6,11,12,14,17,21,22,35,36,37,56,58,59,62,75,76,77,81,92,94,95,96,108,115,119,120,],[2,2,-4,-8,-7,-5,-1,-6,-3,-2,-9,2,2,-37,2,-40,-39,2,-48,-10,-38,-26,-45,-35,-21,-27,-22,-46,-47,]),'SERVICE':([0,1,5,6,11,12,14,17,21,22,35,76,77,92,95,96,108,115,],[3,3,-4,-8,-7,-5,-1,-6,-3,-2,-9,-48,-10,-26,-35,-21,-27,-22,]),'U32':([36,37,39,56,58,59,62,75,76,81,94,119,120,],[51,51,73,-37,51,-40,-39,51,-48,-38,-45,-46,-47,]),'F64':([36,37,56,58,59,62,75,76,81,94,119,120,],[52,52,-37,52,-40,-39,52,-48,-38,-45,-46,-47,]),'TRUE':([31,],[42,]),'MANUAL_ENDIAN':([0,1,4,5,6,8,11,12,14,15,16,17,18,19,20,21,22,29,35,76,77,92,95,96,108,115,],[4,4,-31,-4,-8,-32,-7,-5,-1,4,-28,-6,-33,-34,-30,-3,-2,-29,-9,-48,-10,-26,-35,-21,-27,-22,]),'U8':([36,37,39,56,58,59,62,75,76,81,94,119,120,],[49,49,71,-37,49,-40,-39,49,-48,-38,-45,-46,-47,]),'I8':([36,37,56,58,59,62,75,76,81,94,119,120,],[53,53,-37,53,-40,-39,53,-48,-38,-45,-46,-47,]),'NULL':([78,],[90,]),'STREAM':([78,],[89,]),',':([70,97,112,],[86,106,118,]),'ID':([2,9,10,13,30,34,36,37,38,49,50,51,52,53,55,56,57,58,59,60,61,62,63,64,65,66,68,69,75,76,78,81,83,86,87,89,93,94,98,103,106,110,111,112,116,118,119,120,],[23,26,27,28,40,48,63,63,70,-53,-63,-55,-61,-57,80,-37,-54,63,-40,-59,-58,-39,-64,-56,-60,-62,-41,70,63,-48,91,-38,-42,-44,70,100,105,-45,70,112,-43,112,-17,-19,-18,-20,-46,-47,]),'RPC':([24,32,33,46,101,102,109,117,],[34,-11,34,-12,-13,-14,-15,-16,]),'NUM':([31,85,93,],[44,97,104,]),'IMPORT':([0,1,5,6,11,12,14,17,21,22,35,76,77,92,95,96,108,115,],[7,7,-4,-8,-7,-5,-1,-6,-3,-2,-9,-48,-10,-26,-35,-21,-27,-22,]),';':([25,41,42,43,44,45,47,79,80,82,84,90,91,99,100,107,110,111,112,113,114,116,118,],[35,-51,-50,76,-49,-52,77,92,94,95,96,101,102,108,109,115,117,-17,-19,119,120,-18,-20,]),':':([28,],[39,]),'=':([23,70,],[31,85,]),'DONT_TRACE':([0,1,4,5,6,8,11,12,14,15,16,17,18,19,20,21,22,29,35,76,77,92,95,96,108,115,],[8,8,-31,-4,-8,-32,-7,-5,-1,8,-28,-6,-33,-34,-30,-3,-2,-29,-9,-48,-10,-26,-35,-21,-27,-22,]),'$end':([1,5,6,11,12,14,17,21,22,35,76,77,92,95,96,108,115,],[0,-4,-8,-7,-5,-1,-6,-3,-2,-9,-48,-10,-26,-35,-21,-27,-22,]),'TYPEDEF':([0,1,5,6,11,12,14,17,21,22,35,76,77,92,95,96,108,115,],[10,10,-4,-8,-7,-5,-1,-6,-3,-2,-9,-48,-10,-26,-35,-21,-27,-22,]),'I16':([36,37,56,58,59,62,75,76,81,94,119,120,],[61,61,-37,61,-40,-39,61,-48,-38,-45,-46,-47,]),'STRING':([36,37,56,58,59,62,75,76,81,94,119,120,],[50,50,-37,50,-40,-39,50,-48,-38,-45,-46,-47,]),'I32':([36,37,56,58,59,62,75,76,81,94,119,120,],[60,60,-37,60,-40,-39,60,-48,-38,-45,-46,-47,]),'ENUM':([0,1,5,6,11,12,14,17,21,22,35,76,77,92,95,96,108,115,],[13,13,-4,-8,-7,-5,-1,-6,-3,-2,-9,-48,-10,-26,-35,-21,-27,-22,]),'AUTOREPLY':([0,1,4,5,6,8,11,12,14,15,16,17,18,19,20,21,22,29,35,76,77,92,95,96,108,115,],[19,19,-31,-4,-8,-32,-7,-5,-1,19,-28,-6,-33,-34,-30,-3,-2,-29,-9,-48,-10,-26,-35,-21,-27,-22,]),'[':([80,],[93,]),']':([104,105,],[113,114,]),'MANUAL_PRINT':([0,1,4,5,6,8,11,12,14,15,16,17,18,19,20,21,22,29,35,76,77,92,95,96,108,115,],[20,20,-31,-4,-8,-32,-7,-5,-1,20,-28,-6,-33,-34,-30,-3,-2,-29,-9,-48,-10,-26,-35,-21,-27,-22,]),'FALSE':([31,],[41,]),'STRING_LITERAL':([7,31,],[25,45,]),'TYPEONLY':([0,1,4,5,6,8,11,12,14,15,16,17,18,19,20,21,22,29,35,76,77,92,95,96,108,115,],[18,18,-31,-4,-8,-32,-7,-5,-1,18,-28,-6,-33,-34,-30,-3,-2,-29,-9,-48,-10,-26,-35,-21,-27,-22,]),'U64':([36,37,56,58,59,62,75,76,81,94,119,120,],[64,64,-37,64,-40,-39,64,-48,-38,-45,-46,-47,]),'RETURNS':([48,],[78,]),'EVENTS':([91,],[103,]),'I64':([36,37,56,58,59,62,75,76,81,94,119,120,],[65,65,-37,65,-40,-39,65,-48,-38,-45,-46,-47,]),'BOOL':([36,37,56,58,59,62,75,76,81,94,119,120,],[66,66,-37,66,-40,-39,66,-48,-38,-45,-46,-47,]),'{':([3,26,27,28,40,71,72,73,74,],[24,36,37,38,75,-23,87,-25,-24,]),'DEFINE':([0,1,4,5,6,8,11,12,14,15,16,17,18,19,20,21,22,29,35,76,77,92,95,96,108,115,],[9,9,-31,-4,-8,-32,-7,-5,-1,30,-28,-6,-33,-34,-30,-3,-2,-29,-9,-48,-10,-26,-35,-21,-27,-22,]),'}':([32,33,46,54,56,58,59,62,67,68,69,76,81,83,86,88,94,98,101,102,106,109,117,119,120,],[-11,47,-12,79,-37,-36,-40,-39,82,-41,84,-48,-38,-42,-44,99,-45,107,-13,-14,-43,-15,-16,-46,-47,]),}
+
+_lr_action = {}
+for _k, _v in _lr_action_items.items():
+   for _x,_y in zip(_v[0],_v[1]):
+      if not _x in _lr_action:  _lr_action[_x] = {}
+      _lr_action[_x][_k] = _y
+del _lr_action_items
+
+_lr_goto_items = {'slist':([0,],[1,]),'enum_statement':([38,69,87,98,],[68,83,68,83,]),'service_statements':([24,],[33,]),'assignee':([31,],[43,]),'enum_size':([39,],[72,]),'typedef':([0,1,],[5,5,]),'type_specifier':([36,37,58,75,],[55,55,55,55,]),'service':([0,1,],[6,6,]),'service_statement':([24,33,],[32,46,]),'block_statement':([36,37,58,75,],[56,56,81,56,]),'enum_statements':([38,87,],[69,98,]),'import':([0,1,],[17,17,]),'events':([103,110,],[111,116,]),'define':([0,1,],[21,21,]),'block_statements':([36,37,75,],[58,58,58,]),'option':([0,1,36,37,58,75,],[12,12,59,59,59,59,]),'enum':([0,1,],[11,11,]),'block_statements_opt':([36,37,75,],[54,67,88,]),'stmt':([0,1,],[14,22,]),'flist':([0,1,],[15,15,]),'flag':([0,1,15,],[16,16,29,]),'declaration':([36,37,58,75,],[62,62,62,62,]),'event_list':([103,],[110,]),}
+
+_lr_goto = {}
+for _k, _v in _lr_goto_items.items():
+   for _x, _y in zip(_v[0], _v[1]):
+       if not _x in _lr_goto: _lr_goto[_x] = {}
+       _lr_goto[_x][_k] = _y
+del _lr_goto_items
+_lr_productions = [
+  ("S' -> slist","S'",1,None,None,None),
+  ('slist -> stmt','slist',1,'p_slist','vppapigen',311),
+  ('slist -> slist stmt','slist',2,'p_slist','vppapigen',312),
+  ('stmt -> define','stmt',1,'p_stmt','vppapigen',319),
+  ('stmt -> typedef','stmt',1,'p_stmt','vppapigen',320),
+  ('stmt -> option','stmt',1,'p_stmt','vppapigen',321),
+  ('stmt -> import','stmt',1,'p_stmt','vppapigen',322),
+  ('stmt -> enum','stmt',1,'p_stmt','vppapigen',323),
+  ('stmt -> service','stmt',1,'p_stmt','vppapigen',324),
+  ('import -> IMPORT STRING_LITERAL ;','import',3,'p_import','vppapigen',328),
+  ('service -> SERVICE { service_statements } ;','service',5,'p_service','vppapigen',332),
+  ('service_statements -> service_statement','service_statements',1,'p_service_statements','vppapigen',336),
+  ('service_statements -> service_statements service_statement','service_statements',2,'p_service_statements','vppapigen',337),
+  ('service_statement -> RPC ID RETURNS NULL ;','service_statement',5,'p_service_statement','vppapigen',344),
+  ('service_statement -> RPC ID RETURNS ID ;','service_statement',5,'p_service_statement','vppapigen',345),
+  ('service_statement -> RPC ID RETURNS STREAM ID ;','service_statement',6,'p_service_statement','vppapigen',346),
+  ('service_statement -> RPC ID RETURNS ID EVENTS event_list ;','service_statement',7,'p_service_statement','vppapigen',347),
+  ('event_list -> events','event_list',1,'p_event_list','vppapigen',360),
+  ('event_list -> event_list events','event_list',2,'p_event_list','vppapigen',361),
+  ('events -> ID','events',1,'p_event','vppapigen',368),
+  ('events -> ID ,','events',2,'p_event','vppapigen',369),
+  ('enum -> ENUM ID { enum_statements } ;','enum',6,'p_enum','vppapigen',373),
+  ('enum -> ENUM ID : enum_size { enum_statements } ;','enum',8,'p_enum_type','vppapigen',377),
+  ('enum_size -> U8','enum_size',1,'p_enum_size','vppapigen',384),
+  ('enum_size -> U16','enum_size',1,'p_enum_size','vppapigen',385),
+  ('enum_size -> U32','enum_size',1,'p_enum_size','vppapigen',386),
+  ('define -> DEFINE ID { block_statements_opt } ;','define',6,'p_define','vppapigen',390),
+  ('define -> flist DEFINE ID { block_statements_opt } ;','define',7,'p_define_flist','vppapigen',395),
+  ('flist -> flag','flist',1,'p_flist','vppapigen',399),
+  ('flist -> flist flag','flist',2,'p_flist','vppapigen',400),
+  ('flag -> MANUAL_PRINT','flag',1,'p_flag','vppapigen',407),
+  ('flag -> MANUAL_ENDIAN','flag',1,'p_flag','vppapigen',408),
+  ('flag -> DONT_TRACE','flag',1,'p_flag','vppapigen',409),
+  ('flag -> TYPEONLY','flag',1,'p_flag','vppapigen',410),
+  ('flag -> AUTOREPLY','flag',1,'p_flag','vppapigen',411),
+  ('typedef -> TYPEDEF ID { block_statements_opt } ;','typedef',6,'p_typedef','vppapigen',417),
+  ('block_statements_opt -> block_statements','block_statements_opt',1,'p_block_statements_opt','vppapigen',421),
+  ('block_statements -> block_statement','block_statements',1,'p_block_statements','vppapigen',425),
+  ('block_statements -> block_statements block_statement','block_statements',2,'p_block_statements','vppapigen',426),
+  ('block_statement -> declaration','block_statement',1,'p_block_statement','vppapigen',433),
+  ('block_statement -> option','block_statement',1,'p_block_statement','vppapigen',434),
+  ('enum_statements -> enum_statement','enum_statements',1,'p_enum_statements','vppapigen',438),
+  ('enum_statements -> enum_statements enum_statement','enum_statements',2,'p_enum_statements','vppapigen',439),
+  ('enum_statement -> ID = NUM ,','enum_statement',4,'p_enum_statement','vppapigen',446),
+  ('enum_statement -> ID ,','enum_statement',2,'p_enum_statement','vppapigen',447),
+  ('declaration -> type_specifier ID ;','declaration',3,'p_declaration','vppapigen',454),
+  ('declaration -> type_specifier ID [ NUM ] ;','declaration',6,'p_declaration_array','vppapigen',461),
+  ('declaration -> type_specifier ID [ ID ] ;','declaration',6,'p_declaration_array','vppapigen',462),
+  ('option -> OPTION ID = assignee ;','option',5,'p_option','vppapigen',483),
+  ('assignee -> NUM','assignee',1,'p_assignee','vppapigen',487),
+  ('assignee -> TRUE','assignee',1,'p_assignee','vppapigen',488),
+  ('assignee -> FALSE','assignee',1,'p_assignee','vppapigen',489),
+  ('assignee -> STRING_LITERAL','assignee',1,'p_assignee','vppapigen',490),
+  ('type_specifier -> U8','type_specifier',1,'p_type_specifier','vppapigen',494),
+  ('type_specifier -> U16','type_specifier',1,'p_type_specifier','vppapigen',495),
+  ('type_specifier -> U32','type_specifier',1,'p_type_specifier','vppapigen',496),
+  ('type_specifier -> U64','type_specifier',1,'p_type_specifier','vppapigen',497),
+  ('type_specifier -> I8','type_specifier',1,'p_type_specifier','vppapigen',498),
+  ('type_specifier -> I16','type_specifier',1,'p_type_specifier','vppapigen',499),
+  ('type_specifier -> I32','type_specifier',1,'p_type_specifier','vppapigen',500),
+  ('type_specifier -> I64','type_specifier',1,'p_type_specifier','vppapigen',501),
+  ('type_specifier -> F64','type_specifier',1,'p_type_specifier','vppapigen',502),
+  ('type_specifier -> BOOL','type_specifier',1,'p_type_specifier','vppapigen',503),
+  ('type_specifier -> STRING','type_specifier',1,'p_type_specifier','vppapigen',504),
+  ('type_specifier -> ID','type_specifier',1,'p_typedef_specifier','vppapigen',509),
+]
@@ -7783,6 +7783,8 @@ api_tap_create_v2 (vat_main_t * vam)
   u32 host_ip6_prefix_len = 0;
   int ret;
   u32 rx_ring_sz = 0, tx_ring_sz = 0;
+  u32 num_rx_queues = 0;
+  u8 enable_gso = 0;
 
   memset (mac_address, 0, sizeof (mac_address));
 
@@ -7820,6 +7822,10 @@ api_tap_create_v2 (vat_main_t * vam)
 	;
       else if (unformat (i, "tx-ring-size %d", &tx_ring_sz))
 	;
+      else if (unformat (i, "num-rx-queues %u", &num_rx_queues))
+	;
+      else if (unformat (i, "gso"))
+	enable_gso = 1;
       else
 	break;
     }
@@ -7882,6 +7888,8 @@ api_tap_create_v2 (vat_main_t * vam)
   mp->host_ip6_addr_set = host_ip6_prefix_len != 0;
   mp->rx_ring_sz = ntohs (rx_ring_sz);
   mp->tx_ring_sz = ntohs (tx_ring_sz);
+  mp->num_rx_queues = ntohs (num_rx_queues);
+  mp->enable_gso = enable_gso;
 
   if (random_mac == 0)
     clib_memcpy (mp->mac_address, mac_address, 6);
@@ -12444,6 +12452,9 @@ static void vl_api_sw_interface_tap_v2_details_t_handler_json
   vat_json_object_add_string_copy (node, "dev_name", mp->dev_name);
   vat_json_object_add_uint (node, "rx_ring_sz", ntohs (mp->rx_ring_sz));
   vat_json_object_add_uint (node, "tx_ring_sz", ntohs (mp->tx_ring_sz));
+  vat_json_object_add_uint (node, "num_rx_queues",
+			    ntohs (mp->num_rx_queues));
+  vat_json_object_add_uint (node, "gso_enabled", mp->gso_enabled);
   vat_json_object_add_string_copy (node, "host_mac_addr",
 				   format (0, "%U", format_ethernet_address,
 					   &mp->host_mac_addr));
@@ -13382,6 +13393,7 @@ api_create_vhost_user_if (vat_main_t * vam)
   u32 custom_dev_instance = ~0;
   u8 hwaddr[6];
   u8 use_custom_mac = 0;
+  u8 enable_gso = 0;
   u8 *tag = 0;
   int ret;
 
@@ -13400,6 +13412,8 @@ api_create_vhost_user_if (vat_main_t * vam)
 	use_custom_mac = 1;
       else if (unformat (i, "server"))
 	is_server = 1;
+      else if (unformat (i, "gso"))
+	enable_gso = 1;
       else if (unformat (i, "tag %s", &tag))
 	;
       else
@@ -13431,6 +13445,7 @@ api_create_vhost_user_if (vat_main_t * vam)
     }
   mp->use_custom_mac = use_custom_mac;
   clib_memcpy (mp->mac_address, hwaddr, 6);
+  mp->enable_gso = enable_gso;
   if (tag)
     strncpy ((char *) mp->tag, (char *) tag, ARRAY_LEN (mp->tag) - 1);
   vec_free (tag);
@@ -13451,6 +13466,7 @@ api_modify_vhost_user_if (vat_main_t * vam)
   u32 custom_dev_instance = ~0;
   u8 sw_if_index_set = 0;
   u32 sw_if_index = (u32) ~ 0;
+  u8 enable_gso = 0;
   int ret;
 
   while (unformat_check_input (i) != UNFORMAT_END_OF_INPUT)
@@ -13467,6 +13483,8 @@ api_modify_vhost_user_if (vat_main_t * vam)
 	;
       else if (unformat (i, "server"))
 	is_server = 1;
+      else if (unformat (i, "gso"))
+	enable_gso = 1;
       else
 	break;
     }
@@ -13501,6 +13519,7 @@ api_modify_vhost_user_if (vat_main_t * vam)
       mp->renumber = 1;
       mp->custom_dev_instance = ntohl (custom_dev_instance);
     }
+  mp->enable_gso = enable_gso;
 
   S (mp);
   W (ret);
@@ -19230,6 +19249,7 @@ api_af_packet_create (vat_main_t * vam)
   u8 *host_if_name = 0;
   u8 hw_addr[6];
   u8 random_hw_addr = 1;
+  u32 num_rx_queues = 1;
   int ret;
 
   memset (hw_addr, 0, sizeof (hw_addr));
@@ -19240,6 +19260,8 @@ api_af_packet_create (vat_main_t * vam)
 	vec_add1 (host_if_name, 0);
       else if (unformat (i, "hw_addr %U", unformat_ethernet_address, hw_addr))
 	random_hw_addr = 0;
+      else if (unformat (i, "num_rx_queues %u", &num_rx_queues))
+	;
       else
 	break;
     }
@@ -19261,6 +19283,7 @@ api_af_packet_create (vat_main_t * vam)
   clib_memcpy (mp->host_if_name, host_if_name, vec_len (host_if_name));
   clib_memcpy (mp->hw_addr, hw_addr, 6);
   mp->use_random_hw_addr = random_hw_addr;
+  mp->num_rx_queues = clib_host_to_net_u16 (num_rx_queues);
   vec_free (host_if_name);
 
   S (mp);
@@ -22776,7 +22799,8 @@ _(tap_delete,                                                           \
   "<vpp-if-name> | sw_if_index <id>")                                   \
 _(sw_interface_tap_dump, "")                                            \
 _(tap_create_v2,                                                        \
-  "id <num> [hw-addr <mac-addr>] [host-ns <name>] [rx-ring-size <num> [tx-ring-size <num>]") \
+  "id <num> [hw-addr <mac-addr>] [host-ns <name>] [rx-ring-size <num> [tx-ring-size <num>]\n" \
+  "[num-rx-queues <num>] [gso]")                                        \
 _(tap_delete_v2,                                                        \
   "<vpp-if-name> | sw_if_index <id>")                                   \
 _(sw_interface_tap_v2_dump, "")                                         \
@@ -22907,10 +22931,10 @@ _(l2_interface_vlan_tag_rewrite,                                        \
   "[translate-2-[1|2]] [push_dot1q 0] tag1 <nn> tag2 <nn>")             \
 _(create_vhost_user_if,                                                 \
         "socket <filename> [server] [renumber <dev_instance>] "         \
-        "[mac <mac_address>]")                                          \
+        "[mac <mac_address>] [gso]")                                    \
 _(modify_vhost_user_if,                                                 \
         "<intfc> | sw_if_index <nn> socket <filename>\n"                \
-        "[server] [renumber <dev_instance>]")                           \
+        "[server] [renumber <dev_instance>] [gso]")                     \
 _(delete_vhost_user_if, "<intfc> | sw_if_index <nn>")                   \
 _(sw_interface_vhost_user_dump, "")                                     \
 _(show_version, "")                                                     \
@@ -23110,7 +23134,8 @@ _(lisp_get_map_request_itr_rlocs, "")                                   \
 _(show_lisp_pitr, "")                                                   \
 _(show_lisp_use_petr, "")                                               \
 _(show_lisp_map_request_mode, "")                                       \
-_(af_packet_create, "name <host interface name> [hw_addr <mac>]")       \
+_(af_packet_create, "name <host interface name> [hw_addr <mac>] "      \
+  "[num_rx_queues <n>]")                                                \
 _(af_packet_delete, "name <host interface name>")                       \
 _(policer_add_del, "name <policer name> <params> [del]")                \
 _(policer_dump, "[name <policer name>]")                                \
@@ -409,7 +409,9 @@ vlib_buffer_create_free_list_helper (vlib_main_t * vm,
 	hash_set (bm->free_list_by_size, f->n_data_bytes, f->index);
     }
 
-  clib_spinlock_init (&f->global_buffers_lock);
+  f->depot.top = (u32) ~ 0;
+  f->magazine_size = clib_min (VLIB_BUFFER_MAGAZINE_SIZE,
+			       f->n_data_bytes / sizeof (u32));
 
   for (i = 1; i < vec_len (vlib_mains); i++)
     {
@@ -521,6 +523,30 @@ vlib_buffer_delete_free_list_internal (vlib_main_t * vm,
     }
 }
 
+/* Pop a magazine off a depot: returns its carrier, ~0 if empty. */
+static u32
+vlib_buffer_depot_pop (vlib_main_t * vm, vlib_buffer_depot_t * d)
+{
+  u64 old, new;
+  u32 carrier;
+
+  do
+    {
+      old = d->top;
+      carrier = (u32) old;
+      if (carrier == ~0)
+	return ~0;
+      /* may read a carrier another thread just popped, and reused: the
+         push count then differs and the swap fails */
+      new = (old & ~(u64) 0xffffffff)
+	| vlib_get_buffer (vm, carrier)->next_buffer;
+    }
+  while (!__sync_bool_compare_and_swap (&d->top, old, new));
+
+  __sync_fetch_and_sub (&d->n_magazines, 1);
+  return carrier;
+}
+
 /* Make sure free list has at least given number of free buffers. */
 static uword
 vlib_buffer_fill_free_list_internal (vlib_main_t * vm,
@@ -538,21 +564,22 @@ vlib_buffer_fill_free_list_internal (vlib_main_t * vm,
   if (n <= 0)
     return min_free_buffers;
 
+  /* Take whole magazines, freed by other threads, from the depot */
   mfl = vlib_buffer_get_free_list (vlib_mains[0], fl->index);
-  if (vec_len (mfl->global_buffers) > 0)
+  while (n > 0)
     {
-      int n_copy, n_left;
-      clib_spinlock_lock (&mfl->global_buffers_lock);
-      n_copy = clib_min (vec_len (mfl->global_buffers), n);
-      n_left = vec_len (mfl->global_buffers) - n_copy;
-      vec_add_aligned (fl->buffers, mfl->global_buffers + n_left, n_copy,
-		       CLIB_CACHE_LINE_BYTES);
-      _vec_len (mfl->global_buffers) = n_left;
-      clib_spinlock_unlock (&mfl->global_buffers_lock);
-      n = min_free_buffers - vec_len (fl->buffers);
-      if (n <= 0)
-	return min_free_buffers;
+      u32 carrier = vlib_buffer_depot_pop (vm, &mfl->depot);
+      if (carrier == ~0)
+	break;
+      vec_add_aligned (fl->buffers, vlib_get_buffer (vm, carrier)->data,
+		       fl->magazine_size, CLIB_CACHE_LINE_BYTES);
+      /* last in, so first out: it was just read */
+      vec_add1_aligned (fl->buffers, carrier, CLIB_CACHE_LINE_BYTES);
+      fl->n_alloc += fl->magazine_size + 1;
+      n -= fl->magazine_size + 1;
     }
+  if (n <= 0)
+    return min_free_buffers;
 
   /* Always allocate round number of buffers. */
   n = round_pow2 (n, CLIB_CACHE_LINE_BYTES / sizeof (u32));
@@ -1006,9 +1033,9 @@ format_vlib_buffer_free_list (u8 * s, va_list * va)
   uword bytes_alloc, bytes_free, n_free, size;
 
   if (!f)
-    return format (s, "%=7s%=30s%=12s%=12s%=12s%=12s%=12s%=12s",
+    return format (s, "%=7s%=30s%=12s%=12s%=12s%=12s%=12s%=12s%=12s",
 		   "Thread", "Name", "Index", "Size", "Alloc", "Free",
-		   "#Alloc", "#Free");
+		   "#Alloc", "#Free", "#Depot");
 
   size = sizeof (vlib_buffer_t) + f->n_data_bytes;
   n_free = vec_len (f->buffers);
@@ -1020,6 +1047,10 @@ format_vlib_buffer_free_list (u8 * s, va_list * va)
 	      format_memory_size, bytes_alloc,
 	      format_memory_size, bytes_free, f->n_alloc, n_free);
 
+  /* the depot is the main thread's, its buffers in magazines */
+  if (threadnum == 0)
+    s = format (s, "%=12d", f->depot.n_magazines * (f->magazine_size + 1));
+
   return s;
 }
 
@@ -1060,6 +1091,89 @@ VLIB_CLI_COMMAND (show_buffers_command, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+test_buffer_alloc_free_command_fn (vlib_main_t * vm,
+				   unformat_input_t * input,
+				   vlib_cli_command_t * cmd)
+{
+  vlib_buffer_free_list_t *mf;
+  vlib_main_t *fvm;
+  u32 n_buffers = VLIB_FRAME_SIZE, n_rounds = 1000, free_thread = 0;
+  u32 *buffers = 0, n_magazines, n, i;
+  u64 t, alloc_clocks = 0, free_clocks = 0, n_done = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "buffers %u", &n_buffers))
+	;
+      else if (unformat (input, "rounds %u", &n_rounds))
+	;
+      else if (unformat (input, "free-thread %u", &free_thread))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (n_buffers == 0 || n_rounds == 0)
+    return clib_error_return (0, "buffers and rounds must be non-zero");
+  if (free_thread >= vec_len (vlib_mains))
+    return clib_error_return (0, "no thread %u", free_thread);
+
+  fvm = vlib_mains[free_thread];
+  mf = vlib_buffer_get_free_list (vm, VLIB_BUFFER_DEFAULT_FREE_LIST_INDEX);
+  vec_validate (buffers, n_buffers - 1);
+
+  /* the freeing thread stopped, its free list is ours to use */
+  vlib_worker_thread_barrier_sync (vm);
+  n_magazines = mf->depot.n_magazines;
+  for (i = 0; i < n_rounds; i++)
+    {
+      t = clib_cpu_time_now ();
+      n = vlib_buffer_alloc (vm, buffers, n_buffers);
+      alloc_clocks += clib_cpu_time_now () - t;
+
+      t = clib_cpu_time_now ();
+      vlib_buffer_free (fvm, buffers, n);
+      free_clocks += clib_cpu_time_now () - t;
+
+      n_done += n;
+      if (n < n_buffers)
+	break;
+    }
+  vlib_worker_thread_barrier_release (vm);
+  vec_free (buffers);
+
+  if (n_done == 0)
+    return clib_error_return (0, "buffer allocation failed");
+
+  vlib_cli_output (vm, "%llu buffers allocated on thread 0, freed on "
+		   "thread %u, in %u rounds", n_done, free_thread, i);
+  vlib_cli_output (vm, "alloc %.2f clocks/buffer, free %.2f clocks/buffer",
+		   (f64) alloc_clocks / n_done, (f64) free_clocks / n_done);
+  vlib_cli_output (vm, "magazines in the depot: %u before, %u after",
+		   n_magazines, mf->depot.n_magazines);
+  return 0;
+}
+
+/*?
+ * Measure the cost of buffer allocation and free, allocating on the
+ * main thread and freeing, as if the buffers had been handed off, on
+ * another thread. Buffers freed on that thread go back, in magazines,
+ * through the depot.
+ *
+ * @cliexpar
+ * @cliexcmd{test buffer alloc-free buffers 256 rounds 10000 free-thread 1}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_buffer_alloc_free_command, static) = {
+  .path = "test buffer alloc-free",
+  .short_help = "test buffer alloc-free [buffers <n>] [rounds <n>] "
+    "[free-thread <n>]",
+  .function = test_buffer_alloc_free_command_fn,
+};
+/* *INDENT-ON* */
+
 clib_error_t *
 vlib_buffer_main_init (struct vlib_main_t * vm)
 {
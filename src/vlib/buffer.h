@@ -350,6 +350,29 @@ vlib_buffer_pull (vlib_buffer_t * b, u8 size)
 /* Forward declaration. */
 struct vlib_main_t;
 
+/*
+ * Free buffers move between threads in magazines: a magazine is up to
+ * VLIB_BUFFER_MAGAZINE_SIZE free buffers, their indices written in the
+ * data of one more free buffer, the carrier. Full magazines are stacked,
+ * lock-free, in a depot all threads share; a thread with too many free
+ * buffers pushes magazines, one with too few pops them.
+ */
+#define VLIB_BUFFER_MAGAZINE_SIZE VLIB_FRAME_SIZE
+
+/* Magazines a thread keeps before it pushes one to the depot */
+#define VLIB_BUFFER_MAGAZINES_PER_THREAD 4
+
+typedef struct
+{
+  /* The carrier of the top magazine in the low 32 bits, ~0 if none, and
+     a count of pushes in the high 32 bits, so that a pop which raced
+     with a pop and a push of the same carrier fails */
+  volatile u64 top;
+
+  /* Magazines in the depot */
+  volatile u32 n_magazines;
+} vlib_buffer_depot_t;
+
 typedef struct vlib_buffer_free_list_t
 {
   /* Template buffer used to initialize first 16 bytes of buffers
@@ -372,11 +395,12 @@ typedef struct vlib_buffer_free_list_t
   /* Vector of free buffers.  Each element is a byte offset into I/O heap. */
   u32 *buffers;
 
-  /* global vector of free buffers, used only on main thread.
-     Bufers are returned to global buffers only in case when number of
-     buffers on free buffers list grows about threshold */
-  u32 *global_buffers;
-  clib_spinlock_t global_buffers_lock;
+  /* Depot of magazines, used only on main thread's free list */
+  vlib_buffer_depot_t depot;
+
+  /* Buffers per magazine: fewer than VLIB_BUFFER_MAGAZINE_SIZE if the
+     data of a buffer cannot hold that many indices */
+  u32 magazine_size;
 
   /* Memory chunks allocated for this free list
      recorded here so they can be freed when free list
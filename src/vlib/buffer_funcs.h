@@ -952,6 +952,31 @@ vlib_buffer_init_for_free_list (vlib_buffer_t * dst,
   ASSERT (dst->n_add_refs == 0);
 }
 
+/** \brief Push a magazine onto a depot
+
+    @param vm - (vlib_main_t *) vlib main data structure pointer
+    @param d - (vlib_buffer_depot_t *) the depot
+    @param carrier - (u32) carrier of the magazine, its data already
+    holding the indices of the buffers in the magazine
+*/
+always_inline void
+vlib_buffer_depot_push (vlib_main_t * vm, vlib_buffer_depot_t * d,
+			u32 carrier)
+{
+  vlib_buffer_t *b = vlib_get_buffer (vm, carrier);
+  u64 old, new;
+
+  /* counted first, so that a racing pop never takes the count below 0 */
+  __sync_fetch_and_add (&d->n_magazines, 1);
+  do
+    {
+      old = d->top;
+      b->next_buffer = (u32) old;
+      new = ((old >> 32) + 1) << 32 | carrier;
+    }
+  while (!__sync_bool_compare_and_swap (&d->top, old, new));
+}
+
 always_inline void
 vlib_buffer_add_to_free_list (vlib_main_t * vm,
 			      vlib_buffer_free_list_t * f,
@@ -963,17 +988,20 @@ vlib_buffer_add_to_free_list (vlib_main_t * vm,
     vlib_buffer_init_for_free_list (b, f);
   vec_add1_aligned (f->buffers, buffer_index, CLIB_CACHE_LINE_BYTES);
 
-  if (vec_len (f->buffers) > 4 * VLIB_FRAME_SIZE)
+  if (vec_len (f->buffers) >
+      VLIB_BUFFER_MAGAZINES_PER_THREAD * f->magazine_size)
     {
       vlib_buffer_free_list_t *mf;
+      u32 n = f->magazine_size, carrier;
+
       mf = vlib_buffer_get_free_list (vlib_mains[0], f->index);
-      clib_spinlock_lock (&mf->global_buffers_lock);
       /* keep last stored buffers, as they are more likely hot in the cache */
-      vec_add_aligned (mf->global_buffers, f->buffers, VLIB_FRAME_SIZE,
-		       CLIB_CACHE_LINE_BYTES);
-      vec_delete (f->buffers, VLIB_FRAME_SIZE, 0);
-      f->n_alloc -= VLIB_FRAME_SIZE;
-      clib_spinlock_unlock (&mf->global_buffers_lock);
+      carrier = f->buffers[n];
+      clib_memcpy (vlib_get_buffer (vm, carrier)->data, f->buffers,
+		   n * sizeof (u32));
+      vlib_buffer_depot_push (vm, &mf->depot, carrier);
+      vec_delete (f->buffers, n + 1, 0);
+      f->n_alloc -= n + 1;
     }
 }
 
@@ -328,6 +328,120 @@ generic_buffer_node_inline (vlib_main_t * vm,
   return frame->n_vectors;
 }
 
+/**
+ * @brief Hand buffers off to the threads that are to process them
+ *
+ * The buffers go, in order, onto frame queue @c frame_queue_index of the
+ * thread given for each, each run of buffers for one thread copied into
+ * its ring slot at once. A thread gets a new slot only once its slot is
+ * full; all slots are shipped, however full, before returning. The
+ * buffers for a queue found congested are, by the queue's policy,
+ * either dropped, i.e. freed, or enqueued anyway, the producer waiting
+ * for a slot, for at most VLIB_FRAME_QUEUE_MAX_WAIT before dropping
+ * them too.
+ *
+ * @param vm - vlib_main_t, the producer's
+ * @param frame_queue_index - from vlib_frame_queue_main_init
+ * @param buffer_indices - the buffers
+ * @param thread_indices - the thread of each buffer
+ * @param n_packets - the number of buffers
+ * @return the number of buffers enqueued, the rest were dropped
+ */
+static_always_inline u32
+vlib_buffer_enqueue_to_thread (vlib_main_t * vm, u32 frame_queue_index,
+			       u32 * buffer_indices, u16 * thread_indices,
+			       u32 n_packets)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_frame_queue_main_t *fqm;
+  vlib_frame_queue_per_thread_data_t *ptd;
+  vlib_frame_queue_elt_t *hf = 0;
+  u32 n_left_to_next_thread = 0, *to_next_thread = 0;
+  u32 current_thread_index = ~0;
+  u32 n_left = n_packets, n_drop;
+  int i;
+
+  fqm = vec_elt_at_index (tm->frame_queue_mains, frame_queue_index);
+  ptd = vec_elt_at_index (fqm->per_thread_data, vm->thread_index);
+
+  while (n_left)
+    {
+      u32 thread_index = thread_indices[0];
+      u32 n_run = 1, max_run;
+
+      if (thread_index != current_thread_index)
+	{
+	  if (hf)
+	    hf->n_vectors = VLIB_FRAME_SIZE - n_left_to_next_thread;
+
+	  hf = vlib_get_thread_handoff_queue_elt (fqm, ptd, frame_queue_index,
+						  thread_index);
+	  if (hf)
+	    {
+	      n_left_to_next_thread = VLIB_FRAME_SIZE - hf->n_vectors;
+	      to_next_thread = &hf->buffer_index[hf->n_vectors];
+	    }
+	  current_thread_index = thread_index;
+	}
+
+      /* The run of buffers for this thread, as many as the slot holds */
+      max_run = hf ? clib_min (n_left, n_left_to_next_thread) : n_left;
+      while (n_run < max_run && thread_indices[n_run] == thread_index)
+	n_run++;
+
+      if (PREDICT_FALSE (hf == 0))
+	{
+	  vec_add (ptd->drop_buffers, buffer_indices, n_run);
+	  ptd->stats[thread_index].congestion_drops += n_run;
+	}
+      else
+	{
+	  clib_memcpy (to_next_thread, buffer_indices, n_run * sizeof (u32));
+	  to_next_thread += n_run;
+	  n_left_to_next_thread -= n_run;
+
+	  if (n_left_to_next_thread == 0)
+	    {
+	      hf->n_vectors = VLIB_FRAME_SIZE;
+	      vlib_put_frame_queue_elt (hf);
+	      ptd->stats[thread_index].enqueue_vectors += VLIB_FRAME_SIZE;
+	      ptd->handoff_queue_elt_by_thread_index[thread_index] = 0;
+	      current_thread_index = ~0;
+	      hf = 0;
+	    }
+	}
+
+      buffer_indices += n_run;
+      thread_indices += n_run;
+      n_left -= n_run;
+    }
+
+  if (hf)
+    hf->n_vectors = VLIB_FRAME_SIZE - n_left_to_next_thread;
+
+  /* Ship the slots to the threads, rather than wait to fill them */
+  for (i = 0; i < vec_len (ptd->handoff_queue_elt_by_thread_index); i++)
+    {
+      if ((hf = ptd->handoff_queue_elt_by_thread_index[i]))
+	{
+	  ptd->stats[i].enqueue_vectors += hf->n_vectors;
+	  vlib_put_frame_queue_elt (hf);
+	  ptd->handoff_queue_elt_by_thread_index[i] = 0;
+	}
+      ptd->congested_handoff_queue_by_thread_index[i] =
+	(vlib_frame_queue_t *) (~0);
+    }
+
+  n_drop = vec_len (ptd->drop_buffers);
+  if (PREDICT_FALSE (n_drop))
+    {
+      vlib_buffer_free (vm, ptd->drop_buffers, n_drop);
+      vec_reset_length (ptd->drop_buffers);
+    }
+
+  return n_packets - n_drop;
+}
+
 #endif /* included_vlib_buffer_node_h */
 
 /*
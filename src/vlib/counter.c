@@ -74,26 +74,90 @@ vlib_clear_combined_counters (vlib_combined_counter_main_t * cm)
     }
 }
 
+/*
+ * Defaults used when the stat segment (vpp/stats/stat_segment.c) is not
+ * linked in: counters stay on the current heap.
+ */
+__clib_weak void *
+vlib_stats_push_heap (char *name)
+{
+  return 0;
+}
+
+__clib_weak void
+vlib_stats_pop_heap (void *cm, void *oldheap, stat_directory_type_t type)
+{
+}
+
+__clib_weak clib_error_t *
+vlib_map_stat_segment_init (void)
+{
+  return 0;
+}
+
 void
 vlib_validate_simple_counter (vlib_simple_counter_main_t * cm, u32 index)
 {
   vlib_thread_main_t *tm = vlib_get_thread_main ();
+  void *oldheap;
   int i;
 
+  oldheap = vlib_stats_push_heap (cm->stat_segment_name);
+
   vec_validate (cm->counters, tm->n_vlib_mains - 1);
   for (i = 0; i < tm->n_vlib_mains; i++)
     vec_validate_aligned (cm->counters[i], index, CLIB_CACHE_LINE_BYTES);
+
+  vlib_stats_pop_heap (cm, oldheap, STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE);
 }
 
 void
 vlib_validate_combined_counter (vlib_combined_counter_main_t * cm, u32 index)
 {
   vlib_thread_main_t *tm = vlib_get_thread_main ();
+  void *oldheap;
   int i;
 
+  oldheap = vlib_stats_push_heap (cm->stat_segment_name);
+
   vec_validate (cm->counters, tm->n_vlib_mains - 1);
   for (i = 0; i < tm->n_vlib_mains; i++)
     vec_validate_aligned (cm->counters[i], index, CLIB_CACHE_LINE_BYTES);
+
+  vlib_stats_pop_heap (cm, oldheap, STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED);
+}
+
+int
+vlib_validate_combined_counter_will_expand
+  (vlib_combined_counter_main_t * cm, u32 index)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  void *oldheap;
+  int i, rv = 0;
+
+  /* Possibly once in recorded history */
+  if (PREDICT_FALSE (vec_len (cm->counters) < tm->n_vlib_mains))
+    return 1;
+
+  oldheap = vlib_stats_push_heap (cm->stat_segment_name);
+
+  for (i = 0; i < tm->n_vlib_mains; i++)
+    {
+      /* Trivially OK, and proves that index >= vec_len(...) */
+      if (index < vec_len (cm->counters[i]))
+	continue;
+      if (_vec_resize_will_expand (cm->counters[i],
+				   index - vec_len (cm->counters[i]) + 1,
+				   (index + 1) * sizeof (vlib_counter_t), 0,
+				   CLIB_CACHE_LINE_BYTES))
+	{
+	  rv = 1;
+	  break;
+	}
+    }
+
+  vlib_stats_pop_heap (cm, oldheap, STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED);
+  return rv;
 }
 
 u32
@@ -63,6 +63,7 @@ typedef struct
                                            serialized incrementally. */
 
   char *name;			/**< The counter collection's name. */
+  char *stat_segment_name;	/**< Name in stat segment directory */
 } vlib_simple_counter_main_t;
 
 /** The number of counters (not the number of per-thread counters) */
@@ -183,6 +184,7 @@ typedef struct
   vlib_counter_t *value_at_last_serialize; /**< Counter values as of last serialize. */
   u32 last_incremental_serialize_index;	/**< Last counter index serialized incrementally. */
   char *name; /**< The counter collection's name. */
+  char *stat_segment_name;	/**< Name in stat segment directory */
 } vlib_combined_counter_main_t;
 
 /** The number of counters (not the number of per-thread counters) */
@@ -304,6 +306,16 @@ void vlib_validate_simple_counter (vlib_simple_counter_main_t * cm,
 void vlib_validate_combined_counter (vlib_combined_counter_main_t * cm,
 				     u32 index);
 
+/** Whether validating a combined counter would move the counter vectors,
+    which workers must not be incrementing at the time.
+    @param cm - (vlib_combined_counter_main_t *) pointer to the counter
+    collection
+    @param index - (u32) index of the counter to validate
+    @returns 1 if it would
+*/
+int vlib_validate_combined_counter_will_expand
+  (vlib_combined_counter_main_t * cm, u32 index);
+
 /** Obtain the number of simple or combined counters allocated.
     A macro which reduces to to vec_len(cm->maxi), the answer in either
     case.
@@ -314,6 +326,38 @@ void vlib_validate_combined_counter (vlib_combined_counter_main_t * cm,
 */
 #define vlib_counter_len(cm) vec_len((cm)->maxi)
 
+/** Types of the entries in the stat segment directory */
+typedef enum
+{
+  STAT_DIR_TYPE_ILLEGAL = 0,
+  STAT_DIR_TYPE_SCALAR_POINTER,
+  STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE,
+  STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED,
+} stat_directory_type_t;
+
+/** Switch to the stat segment heap before (re)allocating the vectors
+    of a counter collection which has a stat_segment_name.
+    Weak no-op unless the stat segment is linked in.
+
+    @param name - (char *) the collection's stat_segment_name, may be 0
+    @returns the previous heap, 0 if the heap was not switched
+*/
+void *vlib_stats_push_heap (char *name);
+
+/** Switch back from the stat segment heap and publish the
+    collection's (possibly moved) vectors in the directory
+
+    @param cm - the counter collection
+    @param oldheap - the value returned by vlib_stats_push_heap
+    @param type - the type of the collection
+*/
+void vlib_stats_pop_heap (void *cm, void *oldheap,
+			  stat_directory_type_t type);
+
+/** Map the stat segment. Called by vlib_main before any counter
+    is allocated; weak no-op unless the stat segment is linked in. */
+clib_error_t *vlib_map_stat_segment_init (void);
+
 serialize_function_t serialize_vlib_simple_counter_main,
   unserialize_vlib_simple_counter_main;
 serialize_function_t serialize_vlib_combined_counter_main,
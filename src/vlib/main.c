@@ -1488,9 +1488,12 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
       if (!is_main)
 	{
 	  vlib_worker_thread_barrier_check ();
+	  vlib_rcu_quiescent_state (vm);
 	  vec_foreach (fqm, tm->frame_queue_mains)
 	    vlib_frame_queue_dequeue (vm, fqm);
 	}
+      else if (PREDICT_FALSE (vec_len (tm->rcu_callbacks) > 0))
+	vlib_rcu_process_callbacks (vm);
 
       /* Process pre-input nodes. */
       vec_foreach (n, nm->nodes_by_type[VLIB_NODE_TYPE_PRE_INPUT])
@@ -1709,6 +1712,13 @@ vlib_main (vlib_main_t * volatile vm, unformat_input_t * input)
       goto done;
     }
 
+  /* Map the stat segment before any counters are allocated */
+  if ((error = vlib_map_stat_segment_init ()))
+    {
+      clib_error_report (error);
+      goto done;
+    }
+
   if ((error = vlib_thread_init (vm)))
     {
       clib_error_report (error);
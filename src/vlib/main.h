@@ -74,6 +74,9 @@ typedef struct vlib_main_t
   u32 main_loop_vectors_processed;
   u32 main_loop_nodes_processed;
 
+  /* Count of vectors processed by all previous main loops, never reset. */
+  u64 vectors_processed_total;
+
   /* Circular buffer of input node vector counts.
      Indexed by low bits of
      (main_loop_count >> VLIB_LOG2_INPUT_VECTORS_PER_MAIN_LOOP). */
@@ -339,6 +342,7 @@ vlib_increment_main_loop_counter (vlib_main_t * vm)
 
   v += vm->main_loop_vectors_processed;
   n += vm->main_loop_nodes_processed;
+  vm->vectors_processed_total += vm->main_loop_vectors_processed;
   vm->main_loop_vectors_processed = 0;
   vm->main_loop_nodes_processed = 0;
   vm->vector_counts_per_main_loop[i] = v;
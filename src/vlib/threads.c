@@ -472,6 +472,7 @@ vlib_frame_queue_t *
 vlib_frame_queue_alloc (int nelts)
 {
   vlib_frame_queue_t *fq;
+  int i;
 
   fq = clib_mem_alloc_aligned (sizeof (*fq), CLIB_CACHE_LINE_BYTES);
   memset (fq, 0, sizeof (*fq));
@@ -479,6 +480,10 @@ vlib_frame_queue_alloc (int nelts)
   fq->vector_threshold = 128;	// packets
   vec_validate_aligned (fq->elts, nelts - 1, CLIB_CACHE_LINE_BYTES);
 
+  /* tails start at 1: slot 0 is first used a lap in */
+  for (i = 0; i < nelts; i++)
+    fq->elts[i].sequence = i ? i : nelts;
+
   if (1)
     {
       if (((uword) & fq->tail) & (CLIB_CACHE_LINE_BYTES - 1))
@@ -766,6 +771,10 @@ start_workers (vlib_main_t * vm)
       vlib_worker_threads->node_reforks_required =
 	clib_mem_alloc_aligned (sizeof (u32), CLIB_CACHE_LINE_BYTES);
 
+      vlib_worker_threads->rcu_epoch =
+	clib_mem_alloc_aligned (sizeof (u64), CLIB_CACHE_LINE_BYTES);
+      *vlib_worker_threads->rcu_epoch = 0;
+
       /* Ask for an initial barrier sync */
       *vlib_worker_threads->workers_at_barrier = 0;
       *vlib_worker_threads->wait_at_barrier = 1;
@@ -1430,6 +1439,20 @@ vlib_worker_thread_fork_fixup (vlib_fork_fixup_t which)
 #define BARRIER_MINIMUM_OPEN_FACTOR 3
 #endif
 
+/* Wake the workers sleeping idle, so they come to the barrier now */
+static void
+vlib_worker_thread_barrier_wake_sleepers (void)
+{
+  vlib_worker_thread_t *w;
+  u64 one = 1;
+
+  vec_foreach (w, vlib_worker_threads)
+  {
+    if (w->sleeping && write (w->wakeup_fd, &one, sizeof (one)) < 0)
+      clib_unix_warning ("write");
+  }
+}
+
 void
 vlib_worker_thread_barrier_sync_int (vlib_main_t * vm)
 {
@@ -1472,6 +1495,9 @@ vlib_worker_thread_barrier_sync_int (vlib_main_t * vm)
   deadline = now + BARRIER_SYNC_TIMEOUT;
 
   *vlib_worker_threads->wait_at_barrier = 1;
+  CLIB_MEMORY_BARRIER ();
+  vlib_worker_thread_barrier_wake_sleepers ();
+
   while (*vlib_worker_threads->workers_at_barrier != count)
     {
       if ((now = vlib_time_now (vm)) > deadline)
@@ -1577,6 +1603,76 @@ vlib_worker_thread_barrier_release (vlib_main_t * vm)
 
 }
 
+/* @returns the oldest epoch any worker may still hold references from */
+static u64
+vlib_rcu_quiescent_epoch (void)
+{
+  vlib_worker_thread_t *w;
+  u64 epoch = ~0ULL;
+  int i;
+
+  for (i = 1; i < vec_len (vlib_mains); i++)
+    {
+      w = vlib_worker_threads + vlib_mains[i]->thread_index;
+      epoch = clib_min (epoch, w->rcu_quiescent_epoch);
+    }
+
+  return epoch;
+}
+
+void
+vlib_rcu_call (void (*function) (void *arg), void *arg)
+{
+  vlib_thread_main_t *tm = &vlib_thread_main;
+  vlib_rcu_callback_t *cb;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  /* No workers, or all of them parked: nobody can be looking */
+  if (vec_len (vlib_mains) < 2 || vlib_worker_threads[0].recursion_level > 0)
+    {
+      function (arg);
+      return;
+    }
+
+  /* The object must be unreachable before the epoch moves on */
+  CLIB_MEMORY_BARRIER ();
+  *vlib_worker_threads->rcu_epoch += 1;
+
+  vec_add2 (tm->rcu_callbacks, cb, 1);
+  cb->function = function;
+  cb->arg = arg;
+  cb->epoch = *vlib_worker_threads->rcu_epoch;
+}
+
+void
+vlib_rcu_process_callbacks (vlib_main_t * vm)
+{
+  vlib_thread_main_t *tm = &vlib_thread_main;
+  vlib_rcu_callback_t *cb, *ready = 0;
+  u32 n_ready;
+  u64 epoch;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  epoch = vlib_rcu_quiescent_epoch ();
+
+  for (n_ready = 0; n_ready < vec_len (tm->rcu_callbacks); n_ready++)
+    if (tm->rcu_callbacks[n_ready].epoch > epoch)
+      break;
+
+  if (0 == n_ready)
+    return;
+
+  /* The callbacks may queue more, so take them off the list first */
+  vec_add (ready, tm->rcu_callbacks, n_ready);
+  vec_delete (tm->rcu_callbacks, n_ready, 0);
+
+  vec_foreach (cb, ready) cb->function (cb->arg);
+
+  vec_free (ready);
+}
+
 /*
  * Check the frame queue to see if any frames are available.
  * If so, pull the packets off the frames and put them to
@@ -1694,6 +1790,7 @@ vlib_frame_queue_dequeue (vlib_main_t * vm, vlib_frame_queue_main_t * fqm)
       elt->n_vectors = 0;
       elt->msg_type = 0xfefefefe;
       CLIB_MEMORY_BARRIER ();
+      elt->sequence = fq->head + 1 + fq->nelts;
       fq->head++;
       processed++;
 
@@ -1749,6 +1846,7 @@ vlib_frame_queue_main_init (u32 node_index, u32 frame_queue_nelts)
 {
   vlib_thread_main_t *tm = vlib_get_thread_main ();
   vlib_frame_queue_main_t *fqm;
+  vlib_frame_queue_per_thread_data_t *ptd;
   vlib_frame_queue_t *fq;
   int i;
 
@@ -1758,6 +1856,19 @@ vlib_frame_queue_main_init (u32 node_index, u32 frame_queue_nelts)
   vec_add2 (tm->frame_queue_mains, fqm, 1);
 
   fqm->node_index = node_index;
+  fqm->queue_hi_thresh = frame_queue_nelts - VLIB_FRAME_QUEUE_HI_THRESH_MARGIN;
+
+  vec_validate_aligned (fqm->per_thread_data, tm->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (ptd, fqm->per_thread_data)
+  {
+    vec_validate (ptd->handoff_queue_elt_by_thread_index,
+		  tm->n_vlib_mains - 1);
+    vec_validate_init_empty (ptd->congested_handoff_queue_by_thread_index,
+			     tm->n_vlib_mains - 1,
+			     (vlib_frame_queue_t *) (~0));
+    vec_validate (ptd->stats, tm->n_vlib_mains - 1);
+  }
 
   vec_validate (fqm->vlib_frame_queues, tm->n_vlib_mains - 1);
   _vec_len (fqm->vlib_frame_queues) = 0;
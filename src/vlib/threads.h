@@ -94,6 +94,13 @@ typedef struct
   u32 n_vectors;
   u32 last_n_vectors;
 
+  /*
+   * The tail for which the slot is free: set a lap ahead by the consumer
+   * once done with it. Producers look here, in the line they are about
+   * to fill anyway, rather than at the consumer's head.
+   */
+  volatile u64 sequence;
+
   /* 256 * 4 = 1024 bytes, even mult of cache line size */
   u32 buffer_index[VLIB_FRAME_SIZE];
 }
@@ -105,6 +112,7 @@ typedef struct
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   volatile u32 *wait_at_barrier;
   volatile u32 *workers_at_barrier;
+  volatile u64 *rcu_epoch;
 
   /* Second Cache Line */
     CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
@@ -127,6 +135,14 @@ typedef struct
   long lwp;
   int lcore_id;
   pthread_t thread_id;
+
+  /* Third cache line, written by its own thread once per main loop */
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline2);
+  volatile u64 rcu_quiescent_epoch;
+
+  /* Set while the thread sleeps idle; a barrier sync writes wakeup_fd */
+  volatile u32 sleeping;
+  int wakeup_fd;
 } vlib_worker_thread_t;
 
 extern vlib_worker_thread_t *vlib_worker_threads;
@@ -161,11 +177,62 @@ typedef struct
 }
 vlib_frame_queue_t;
 
+#define VLIB_FRAME_QUEUE_N_OCCUPANCY_BINS 8
+
+/* Slots short of a full ring at which a queue is, by default, congested */
+#define VLIB_FRAME_QUEUE_HI_THRESH_MARGIN 2
+
+/* How long the wait policy waits for a slot in a full ring, in seconds */
+#define VLIB_FRAME_QUEUE_MAX_WAIT 1e-3
+
+/* Handoff from one producer thread to one consumer thread */
+typedef struct
+{
+  /* ring slots taken, and the buffers put in them */
+  u64 enqueues;
+  u64 enqueue_vectors;
+
+  /* buffers dropped with the queue congested, by the drop policy */
+  u64 congestion_drops;
+
+  /* slots taken with the queue congested, by the wait policy */
+  u64 congestion_waits;
+
+  /* ring occupancy, in eighths, as the producer saw it taking a slot */
+  u64 occupancy[VLIB_FRAME_QUEUE_N_OCCUPANCY_BINS];
+} vlib_frame_queue_stats_t;
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  /* The slot being filled for each consumer thread, if any */
+  vlib_frame_queue_elt_t **handoff_queue_elt_by_thread_index;
+
+  /* The queues found congested, and so dropped to, during this frame */
+  vlib_frame_queue_t **congested_handoff_queue_by_thread_index;
+
+  /* Buffers to drop, at the end of the frame */
+  u32 *drop_buffers;
+
+  /* By consumer thread index */
+  vlib_frame_queue_stats_t *stats;
+} vlib_frame_queue_per_thread_data_t;
+
 typedef struct
 {
   u32 node_index;
   vlib_frame_queue_t **vlib_frame_queues;
 
+  /* Ring slots in use from which a queue is congested */
+  u32 queue_hi_thresh;
+
+  /* Drop what is for a congested queue, rather than wait for a slot */
+  u8 drop_on_congestion;
+
+  /* By producer thread index */
+  vlib_frame_queue_per_thread_data_t *per_thread_data;
+
   /* for frame queue tracing */
   frame_queue_trace_t *frame_queue_traces;
   frame_queue_nelt_counter_t *frame_queue_histogram;
@@ -217,6 +284,22 @@ void vlib_worker_thread_barrier_sync_int (vlib_main_t * vm);
 void vlib_worker_thread_barrier_release (vlib_main_t * vm);
 void vlib_worker_thread_node_refork (void);
 
+/*
+ * Epoch based (RCU style) reclamation.
+ *
+ * Control plane updates which are written to be safe against concurrent
+ * readers on the workers (publish the new object, then unlink the old
+ * one) need not stop the workers. What they cannot do is free the old
+ * object while a worker may still be looking at it. Instead they hand
+ * it to vlib_rcu_call(), which runs the free on the main thread once
+ * every worker has passed through the top of its dispatch loop - where
+ * it holds no references - since the call was made.
+ *
+ * With no workers, or with the barrier held, the call is made at once.
+ */
+void vlib_rcu_call (void (*function) (void *arg), void *arg);
+void vlib_rcu_process_callbacks (vlib_main_t * vm);
+
 static_always_inline uword
 vlib_get_thread_index (void)
 {
@@ -286,6 +369,14 @@ typedef struct
   clib_error_t *(*vlib_thread_set_lcore_cb) (u32 thread, u16 lcore);
 } vlib_thread_callbacks_t;
 
+typedef struct
+{
+  void (*function) (void *arg);
+  void *arg;
+  /* epoch all workers must have passed before the call */
+  u64 epoch;
+} vlib_rcu_callback_t;
+
 typedef struct
 {
   /* Link list of registrations, built by constructors */
@@ -346,6 +437,9 @@ typedef struct
   /* callbacks */
   vlib_thread_callbacks_t cb;
   int extern_thread_mgmt;
+
+  /* rcu callbacks waiting for a grace period, oldest first */
+  vlib_rcu_callback_t *rcu_callbacks;
 } vlib_thread_main_t;
 
 extern vlib_thread_main_t vlib_thread_main;
@@ -417,6 +511,44 @@ vlib_worker_thread_barrier_check (void)
     }
 }
 
+/* Called by a worker where it holds no references to shared objects */
+static inline void
+vlib_rcu_quiescent_state (vlib_main_t * vm)
+{
+  vlib_worker_thread_t *w = vlib_worker_threads + vm->thread_index;
+  u64 epoch = *vlib_worker_threads->rcu_epoch;
+
+  /* don't dirty the cache line unless the epoch moved on */
+  if (PREDICT_FALSE (w->rcu_quiescent_epoch != epoch))
+    {
+      CLIB_MEMORY_BARRIER ();
+      w->rcu_quiescent_epoch = epoch;
+    }
+}
+
+/*
+ * Called by a worker about to sleep: until it is back online it holds no
+ * references, so grace periods need not wait for it.
+ */
+static inline void
+vlib_rcu_thread_offline (vlib_main_t * vm)
+{
+  vlib_worker_thread_t *w = vlib_worker_threads + vm->thread_index;
+
+  CLIB_MEMORY_BARRIER ();
+  w->rcu_quiescent_epoch = ~0ULL;
+}
+
+static inline void
+vlib_rcu_thread_online (vlib_main_t * vm)
+{
+  vlib_worker_thread_t *w = vlib_worker_threads + vm->thread_index;
+
+  w->rcu_quiescent_epoch = *vlib_worker_threads->rcu_epoch;
+  /* published before this thread looks at any shared object */
+  CLIB_MEMORY_BARRIER ();
+}
+
 always_inline vlib_main_t *
 vlib_get_worker_vlib_main (u32 worker_index)
 {
@@ -435,35 +567,73 @@ vlib_put_frame_queue_elt (vlib_frame_queue_elt_t * hf)
   hf->valid = 1;
 }
 
+/*
+ * Take the ring slot of the next tail, 0 if the ring is full. Producers
+ * race for the tail only once they have seen the slot free, so none
+ * holds a tail it cannot use.
+ */
+static inline vlib_frame_queue_elt_t *
+vlib_frame_queue_try_get_elt (vlib_frame_queue_t * fq)
+{
+  vlib_frame_queue_elt_t *elt;
+  u64 tail = fq->tail;
+  i64 lap;
+
+  while (1)
+    {
+      elt = fq->elts + ((tail + 1) & (fq->nelts - 1));
+      lap = elt->sequence - (tail + 1);
+
+      if (lap < 0)
+	/* still holds the frame of a lap before */
+	return 0;
+      if (lap == 0 && __sync_bool_compare_and_swap (&fq->tail, tail,
+						    tail + 1))
+	break;
+      /* another producer took it */
+      tail = fq->tail;
+    }
+
+  elt->msg_type = VLIB_FRAME_QUEUE_ELT_DISPATCH_FRAME;
+  elt->last_n_vectors = elt->n_vectors = 0;
+
+  return elt;
+}
+
+/*
+ * Wait for a ring slot, for at most max_clocks. The slot's line is
+ * written only by the consumer freeing it, so waiting on it leaves the
+ * consumer's lines alone.
+ */
+static inline vlib_frame_queue_elt_t *
+vlib_frame_queue_wait_elt (vlib_frame_queue_t * fq, u64 max_clocks)
+{
+  vlib_frame_queue_elt_t *elt;
+  u64 t_start = clib_cpu_time_now ();
+
+  while (!(elt = vlib_frame_queue_try_get_elt (fq)))
+    {
+      if (clib_cpu_time_now () - t_start > max_clocks)
+	return 0;
+      vlib_worker_thread_barrier_check ();
+      CLIB_PAUSE ();
+    }
+
+  return elt;
+}
+
 static inline vlib_frame_queue_elt_t *
 vlib_get_frame_queue_elt (u32 frame_queue_index, u32 index)
 {
   vlib_frame_queue_t *fq;
-  vlib_frame_queue_elt_t *elt;
   vlib_thread_main_t *tm = &vlib_thread_main;
   vlib_frame_queue_main_t *fqm =
     vec_elt_at_index (tm->frame_queue_mains, frame_queue_index);
-  u64 new_tail;
 
   fq = fqm->vlib_frame_queues[index];
   ASSERT (fq);
 
-  new_tail = __sync_add_and_fetch (&fq->tail, 1);
-
-  /* Wait until a ring slot is available */
-  while (new_tail >= fq->head_hint + fq->nelts)
-    vlib_worker_thread_barrier_check ();
-
-  elt = fq->elts + (new_tail & (fq->nelts - 1));
-
-  /* this would be very bad... */
-  while (elt->valid)
-    ;
-
-  elt->msg_type = VLIB_FRAME_QUEUE_ELT_DISPATCH_FRAME;
-  elt->last_n_vectors = elt->n_vectors = 0;
-
-  return elt;
+  return vlib_frame_queue_wait_elt (fq, ~0ULL);
 }
 
 static inline vlib_frame_queue_t *
@@ -516,6 +686,68 @@ vlib_get_worker_handoff_queue_elt (u32 frame_queue_index,
   return elt;
 }
 
+/*
+ * The slot to fill for a consumer thread: the one held since earlier in
+ * the frame or a new one, 0 if the queue is congested and its policy is
+ * to drop.
+ */
+static inline vlib_frame_queue_elt_t *
+vlib_get_thread_handoff_queue_elt (vlib_frame_queue_main_t * fqm,
+				   vlib_frame_queue_per_thread_data_t * ptd,
+				   u32 frame_queue_index, u32 thread_index)
+{
+  vlib_frame_queue_stats_t *st = vec_elt_at_index (ptd->stats, thread_index);
+  vlib_frame_queue_elt_t *elt;
+  vlib_frame_queue_t *fq;
+  u64 head_hint, n_used;
+
+  if ((elt = ptd->handoff_queue_elt_by_thread_index[thread_index]))
+    return elt;
+
+  if (ptd->congested_handoff_queue_by_thread_index[thread_index] !=
+      (vlib_frame_queue_t *) (~0))
+    return 0;
+
+  fq = fqm->vlib_frame_queues[thread_index];
+  ASSERT (fq);
+
+  /* The hint first: it never passes the tail read after it */
+  head_hint = fq->head_hint;
+  CLIB_MEMORY_BARRIER ();
+  n_used = fq->tail - head_hint;
+
+  st->occupancy[clib_min (n_used * VLIB_FRAME_QUEUE_N_OCCUPANCY_BINS /
+			  fq->nelts,
+			  VLIB_FRAME_QUEUE_N_OCCUPANCY_BINS - 1)]++;
+
+  if (PREDICT_FALSE (n_used >= fqm->queue_hi_thresh))
+    {
+      fq->enqueue_full_events++;
+      if (fqm->drop_on_congestion)
+	goto congested;
+      st->congestion_waits++;
+    }
+
+  if (PREDICT_FALSE (!(elt = vlib_frame_queue_try_get_elt (fq))))
+    {
+      /* two workers handing off to each other must not wait for ever */
+      vlib_main_t *vm = vlib_get_main ();
+      elt = vlib_frame_queue_wait_elt (fq, VLIB_FRAME_QUEUE_MAX_WAIT *
+				       vm->clib_time.clocks_per_second);
+      if (!elt)
+	goto congested;
+    }
+
+  ptd->handoff_queue_elt_by_thread_index[thread_index] = elt;
+  st->enqueues++;
+
+  return elt;
+
+congested:
+  ptd->congested_handoff_queue_by_thread_index[thread_index] = fq;
+  return 0;
+}
+
 u8 *vlib_thread_stack_init (uword thread_index);
 int vlib_thread_cb_register (struct vlib_main_t *vm,
 			     vlib_thread_callbacks_t * cb);
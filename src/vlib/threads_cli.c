@@ -421,6 +421,198 @@ VLIB_CLI_COMMAND (cmd_show_frame_queue_histogram,static) = {
 /* *INDENT-ON* */
 
 
+static u8 *
+format_frame_queue_stats (u8 * s, va_list * args)
+{
+  vlib_frame_queue_stats_t *st = va_arg (*args, vlib_frame_queue_stats_t *);
+  u64 total = 0;
+  int i;
+
+  for (i = 0; i < VLIB_FRAME_QUEUE_N_OCCUPANCY_BINS; i++)
+    total += st->occupancy[i];
+
+  s = format (s, "%10llu %10llu %7.2f %8llu %8llu ",
+	      st->enqueues, st->enqueue_vectors,
+	      st->enqueues ? (f64) st->enqueue_vectors / st->enqueues : 0.0,
+	      st->congestion_waits, st->congestion_drops);
+
+  /* As with the histogram, any non-zero count shows as at least 1% */
+  for (i = 0; i < VLIB_FRAME_QUEUE_N_OCCUPANCY_BINS; i++)
+    s = format (s, " %3d%%", total ?
+		(st->occupancy[i] * 100 + total - 1) / total : 0);
+  return s;
+}
+
+/*
+ * Display the handoff counters, from each producer thread to each
+ * consumer thread, kept by vlib_buffer_enqueue_to_thread.
+ */
+static clib_error_t *
+show_frame_queue_stats (vlib_main_t * vm, unformat_input_t * input,
+			vlib_cli_command_t * cmd)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_frame_queue_main_t *fqm;
+  vlib_frame_queue_per_thread_data_t *ptd;
+  vlib_frame_queue_stats_t *st;
+
+  vec_foreach (fqm, tm->frame_queue_mains)
+  {
+    vlib_cli_output (vm, "Worker handoff queue index %u (next node '%U'):",
+		     fqm - tm->frame_queue_mains,
+		     format_vlib_node_name, vm, fqm->node_index);
+    vlib_cli_output (vm, "  policy %s, congested at %u of %u slots in use",
+		     fqm->drop_on_congestion ? "drop" : "wait",
+		     fqm->queue_hi_thresh, fqm->vlib_frame_queues[0]->nelts);
+    vlib_cli_output (vm, "  %-20s %-20s %10s %10s %7s %8s %8s  "
+		     "occupancy 0/8 .. 7/8", "producer", "consumer",
+		     "enqueues", "vectors", "vec/enq", "waits", "drops");
+
+    vec_foreach (ptd, fqm->per_thread_data)
+    {
+      vec_foreach (st, ptd->stats)
+      {
+	if (st->enqueues == 0 && st->congestion_drops == 0)
+	  continue;
+	vlib_cli_output (vm, "  %-20v %-20v %U",
+			 vlib_worker_threads[ptd - fqm->per_thread_data].name,
+			 vlib_worker_threads[st - ptd->stats].name,
+			 format_frame_queue_stats, st);
+      }
+    }
+  }
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (cmd_show_frame_queue_stats,static) = {
+    .path = "show frame-queue stats",
+    .short_help = "show frame-queue stats",
+    .function = show_frame_queue_stats,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+clear_frame_queue_stats (vlib_main_t * vm, unformat_input_t * input,
+			 vlib_cli_command_t * cmd)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_frame_queue_main_t *fqm;
+  vlib_frame_queue_per_thread_data_t *ptd;
+
+  vlib_worker_thread_barrier_sync (vm);
+  vec_foreach (fqm, tm->frame_queue_mains)
+  {
+    vec_foreach (ptd, fqm->per_thread_data)
+    {
+      memset (ptd->stats, 0, vec_bytes (ptd->stats));
+    }
+  }
+  vlib_worker_thread_barrier_release (vm);
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (cmd_clear_frame_queue_stats,static) = {
+    .path = "clear frame-queue stats",
+    .short_help = "clear frame-queue stats",
+    .function = clear_frame_queue_stats,
+};
+/* *INDENT-ON* */
+
+/*
+ * What to do with the buffers for a congested queue: drop them, or wait
+ * for the consumer to make room. A queue is congested with threshold
+ * slots in use. Either way, those for a full ring still unable to take
+ * them after VLIB_FRAME_QUEUE_MAX_WAIT are dropped.
+ */
+static clib_error_t *
+set_frame_queue_policy (vlib_main_t * vm, unformat_input_t * input,
+			vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_frame_queue_main_t *fqm;
+  clib_error_t *error = NULL;
+  u32 index = ~(u32) 0;
+  u32 threshold = 0;
+  int drop = -1;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "drop"))
+	drop = 1;
+      else if (unformat (line_input, "wait"))
+	drop = 0;
+      else if (unformat (line_input, "threshold %u", &threshold))
+	;
+      else if (unformat (line_input, "index %u", &index))
+	;
+      else
+	{
+	  error = clib_error_return (0, "parse error: '%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (index != ~(u32) 0 && index >= vec_len (tm->frame_queue_mains))
+    {
+      error = clib_error_return (0,
+				 "expecting valid worker handoff queue index");
+      goto done;
+    }
+
+  vec_foreach (fqm, tm->frame_queue_mains)
+  {
+    if (index != ~(u32) 0 && index != fqm - tm->frame_queue_mains)
+      continue;
+
+    if (threshold >= fqm->vlib_frame_queues[0]->nelts)
+      {
+	error = clib_error_return (0, "threshold must be below %u",
+				   fqm->vlib_frame_queues[0]->nelts);
+	goto done;
+      }
+
+    if (drop != -1)
+      fqm->drop_on_congestion = drop;
+    if (threshold)
+      fqm->queue_hi_thresh = threshold;
+  }
+
+done:
+  unformat_free (line_input);
+
+  return error;
+}
+
+/*?
+ * Set what a handoff node does with the packets for a worker whose
+ * frame queue is congested: drop them, or wait for the worker to make
+ * room, the default. Dropping keeps a slow worker from holding up the
+ * others; the packets show as 'congestion drop' errors on the handoff
+ * node. A queue is congested with, by default, all but two of its slots
+ * in use. The wait for a slot in a full queue lasts at most 1ms, after
+ * which the packets are dropped too, so that two workers handing off
+ * to each other cannot wait on one another for ever.
+ *
+ * @cliexpar
+ * @cliexcmd{set frame-queue policy drop index 0 threshold 24}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (cmd_set_frame_queue_policy,static) = {
+    .path = "set frame-queue policy",
+    .short_help = "set frame-queue policy (drop|wait) [index <n>] "
+      "[threshold <slots>]",
+    .function = set_frame_queue_policy,
+};
+/* *INDENT-ON* */
+
+
 /*
  * Modify the number of elements on the frame_queues
  */
@@ -481,6 +673,10 @@ test_frame_queue_nelts (vlib_main_t * vm, unformat_input_t * input,
       fqm->vlib_frame_queues[fqix]->nelts = nelts;
     }
 
+  /* Keep the queues able to reach the congestion threshold */
+  fqm->queue_hi_thresh = clib_min (fqm->queue_hi_thresh,
+				   nelts - VLIB_FRAME_QUEUE_HI_THRESH_MARGIN);
+
 done:
   unformat_free (line_input);
 
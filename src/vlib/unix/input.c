@@ -37,10 +37,13 @@
  *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#define _GNU_SOURCE
 #include <vlib/vlib.h>
 #include <vlib/unix/unix.h>
 #include <signal.h>
 #include <unistd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 #include <vppinfra/tw_timer_1t_3w_1024sl_ov.h>
 
 /* FIXME autoconf */
@@ -50,19 +53,57 @@
 
 #include <sys/epoll.h>
 
+/* Sleeps of idle workers start this short, and double while idle */
+#define LINUX_EPOLL_MIN_SLEEP_US 8
+
+/* and are no longer than the main thread's when it has nothing to do */
+#define LINUX_EPOLL_MAX_SLEEP_US 10000
+
+/* Wakeup latency, in power of 2 microseconds: <1, <2, ... >=256 */
+#define LINUX_EPOLL_N_WAKEUP_LATENCY_BINS 10
+
 typedef struct
 {
   int epoll_fd;
   struct epoll_event *epoll_events;
   int n_epoll_fds;
 
+  /* Worker sleep: main loops idle in a row, the vectors processed as of
+     the last, and the length of the next sleep */
+  u32 idle_loops;
+  u32 sleep_us;
+
+  /* Written by the main thread, to wake the worker for a barrier */
+  int wakeup_fd;
+  u64 last_vectors_processed;
+
   /* Statistics. */
   u64 epoll_files_ready;
   u64 epoll_waits;
+
+  /* Worker sleep statistics */
+  u64 sleeps;
+  u64 sleep_event_wakeups;
+  u64 sleep_clocks;
+  u64 wakeup_latency[LINUX_EPOLL_N_WAKEUP_LATENCY_BINS];
 } linux_epoll_main_t;
 
 static linux_epoll_main_t *linux_epoll_mains = 0;
 
+typedef struct
+{
+  /* Main loops a worker is idle before it sleeps, 0 if workers only
+     sleep with no input node polling */
+  u32 idle_loops;
+
+  /* Longest sleep, the bound on the latency of polled input */
+  u32 max_sleep_us;
+} linux_epoll_worker_sleep_t;
+
+static linux_epoll_worker_sleep_t linux_epoll_worker_sleep = {
+  .max_sleep_us = 1000,
+};
+
 static void
 linux_epoll_file_update (clib_file_t * f, clib_file_update_type_t update_type)
 {
@@ -129,6 +170,59 @@ linux_epoll_file_update (clib_file_t * f, clib_file_update_type_t update_type)
     }
 }
 
+/* @returns 0 if the worker did, or has, anything to do since last asked */
+static_always_inline int
+linux_epoll_worker_is_idle (vlib_main_t * vm, linux_epoll_main_t * em)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_node_main_t *nm = &vm->node_main;
+  vlib_frame_queue_main_t *fqm;
+  u64 v = vm->vectors_processed_total;
+  int is_idle;
+
+  is_idle = v == em->last_vectors_processed
+    && _vec_len (nm->pending_interrupt_node_runtime_indices) == 0;
+  em->last_vectors_processed = v;
+
+  /* frames handed off to us, not yet dequeued */
+  vec_foreach (fqm, tm->frame_queue_mains)
+  {
+    vlib_frame_queue_t *fq = fqm->vlib_frame_queues[vm->thread_index];
+    is_idle &= fq->head == fq->tail;
+  }
+
+  return is_idle;
+}
+
+static_always_inline void
+linux_epoll_worker_sleep_done (vlib_main_t * vm, linux_epoll_main_t * em,
+			       u64 t_sleep, int woken)
+{
+  u64 clocks = clib_cpu_time_now () - t_sleep;
+  f64 late_us;
+  int bin;
+
+  em->sleeps += 1;
+  em->sleep_clocks += clocks;
+
+  if (woken)
+    {
+      /* woken to work: sleep short next time */
+      em->sleep_event_wakeups += 1;
+      em->sleep_us = LINUX_EPOLL_MIN_SLEEP_US;
+      return;
+    }
+
+  /* woken by the timeout: how late */
+  late_us = clocks * vm->clib_time.seconds_per_clock * 1e6 - em->sleep_us;
+  bin = late_us < 1 ? 0 : 1 + min_log2 ((uword) late_us);
+  bin = clib_min (bin, LINUX_EPOLL_N_WAKEUP_LATENCY_BINS - 1);
+  em->wakeup_latency[bin] += 1;
+
+  em->sleep_us = clib_min (2 * em->sleep_us,
+			   linux_epoll_worker_sleep.max_sleep_us);
+}
+
 static_always_inline uword
 linux_epoll_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			  vlib_frame_t * frame, u32 thread_index)
@@ -140,6 +234,96 @@ linux_epoll_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   int n_fds_ready;
   int is_main = (thread_index == 0);
 
+  if (!is_main && linux_epoll_worker_sleep.idle_loops)
+    {
+      static sigset_t unblock_all_signals;
+      vlib_worker_thread_t *w = vlib_worker_threads + thread_index;
+      u64 t_sleep;
+
+      /* come back every loop, to count them */
+      node->input_main_loops_per_call = 0;
+
+      if (!linux_epoll_worker_is_idle (vm, em))
+	{
+	  em->idle_loops = 0;
+	  em->sleep_us = LINUX_EPOLL_MIN_SLEEP_US;
+	}
+      else if (em->idle_loops < linux_epoll_worker_sleep.idle_loops)
+	em->idle_loops++;
+
+      if (em->idle_loops < linux_epoll_worker_sleep.idle_loops)
+	{
+	  /* not idle long enough: look at the files now and then */
+	  if (em->epoll_fd == -1 || (vm->main_loop_count & 1023))
+	    return 0;
+	  n_fds_ready = epoll_pwait (em->epoll_fd, em->epoll_events,
+				     vec_len (em->epoll_events), 0,
+				     &unblock_all_signals);
+	  goto files_ready;
+	}
+
+      /*
+       * Input nodes in adaptive rx-mode have by now switched to interrupt
+       * mode, and will wake us through the files. Those still polling
+       * are looked at again within a sleep.
+       */
+      if (PREDICT_FALSE (em->wakeup_fd == -1))
+	{
+	  em->wakeup_fd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+	  if (em->wakeup_fd < 0)
+	    {
+	      clib_unix_warning ("eventfd");
+	      linux_epoll_worker_sleep.idle_loops = 0;
+	      em->wakeup_fd = -1;
+	      return 0;
+	    }
+	  w->wakeup_fd = em->wakeup_fd;
+	}
+
+      /* a barrier asked for from here on writes to the eventfd */
+      w->sleeping = 1;
+      CLIB_MEMORY_BARRIER ();
+      if (*vlib_worker_threads->wait_at_barrier)
+	{
+	  w->sleeping = 0;
+	  return 0;
+	}
+
+      vlib_rcu_thread_offline (vm);
+      t_sleep = clib_cpu_time_now ();
+      {
+	/* epoll times in ms: wait on the epoll fd itself, to the usec */
+	struct pollfd pfds[2] = {
+	  {.fd = em->wakeup_fd,.events = POLLIN},
+	  {.fd = em->epoll_fd,.events = POLLIN},
+	};
+	struct timespec ts = {
+	  .tv_sec = em->sleep_us / 1000000,
+	  .tv_nsec = (em->sleep_us % 1000000) * 1000,
+	};
+	int n_ready;
+
+	n_ready = ppoll (pfds, em->epoll_fd != -1 ? 2 : 1, &ts,
+			 &unblock_all_signals);
+	w->sleeping = 0;
+
+	n_fds_ready = n_ready < 0 ? n_ready : 0;
+	if (n_ready > 0 && (pfds[0].revents & POLLIN))
+	  {
+	    u64 n_wakeups;
+	    int __clib_unused rv;
+	    rv = read (em->wakeup_fd, &n_wakeups, sizeof (n_wakeups));
+	  }
+	if (n_ready > 0 && em->epoll_fd != -1 && (pfds[1].revents & POLLIN))
+	  n_fds_ready = epoll_pwait (em->epoll_fd, em->epoll_events,
+				     vec_len (em->epoll_events), 0,
+				     &unblock_all_signals);
+	vlib_rcu_thread_online (vm);
+	linux_epoll_worker_sleep_done (vm, em, t_sleep, n_ready > 0);
+      }
+      goto files_ready;
+    }
+
   {
     vlib_node_main_t *nm = &vm->node_main;
     u32 ticks_until_expiration;
@@ -213,6 +397,7 @@ linux_epoll_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
       }
   }
 
+files_ready:
   if (n_fds_ready < 0)
     {
       if (unix_error_is_fatal (errno))
@@ -289,6 +474,149 @@ VLIB_REGISTER_NODE (linux_epoll_input_node,static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+set_worker_sleep_command_fn (vlib_main_t * vm,
+			     unformat_input_t * input,
+			     vlib_cli_command_t * cmd)
+{
+  linux_epoll_worker_sleep_t *ws = &linux_epoll_worker_sleep;
+  u32 idle_loops = 1024, max_sleep_us = ws->max_sleep_us;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "idle-loops %u", &idle_loops))
+	;
+      else if (unformat (input, "max-sleep %u", &max_sleep_us))
+	;
+      else if (unformat (input, "disable"))
+	idle_loops = 0;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  /* a barrier sync waits for the workers' sleeps; keep them short of
+     its timeout */
+  if (max_sleep_us < LINUX_EPOLL_MIN_SLEEP_US ||
+      max_sleep_us > LINUX_EPOLL_MAX_SLEEP_US)
+    return clib_error_return (0, "max-sleep must be %u to %uus",
+			      LINUX_EPOLL_MIN_SLEEP_US,
+			      LINUX_EPOLL_MAX_SLEEP_US);
+
+  ws->max_sleep_us = max_sleep_us;
+  ws->idle_loops = idle_loops;
+  return 0;
+}
+
+/*?
+ * Let worker threads sleep when idle. A worker which has had nothing to
+ * do for the given number of main loops sleeps, first briefly, then for
+ * twice as long each time it finds nothing to do, up to max-sleep
+ * microseconds, at most 10000. Input nodes on queues in adaptive rx-mode
+ * arm their interrupts when idle, and wake the worker at once; those on
+ * polled queues wait at most max-sleep. A barrier sync wakes the workers
+ * at once too. Without this, workers sleep only with
+ * no input node polling.
+ *
+ * @cliexpar
+ * @cliexcmd{set interface rx-mode VirtualEthernet0/0/0 adaptive}
+ * @cliexcmd{set worker sleep idle-loops 1024 max-sleep 500}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_worker_sleep_command, static) = {
+  .path = "set worker sleep",
+  .short_help = "set worker sleep [idle-loops <n>] [max-sleep <usec>] "
+    "| disable",
+  .function = set_worker_sleep_command_fn,
+};
+/* *INDENT-ON* */
+
+static u8 *
+format_linux_epoll_wakeup_latency (u8 * s, va_list * args)
+{
+  linux_epoll_main_t *em = va_arg (*args, linux_epoll_main_t *);
+  int i;
+
+  for (i = 0; i < LINUX_EPOLL_N_WAKEUP_LATENCY_BINS; i++)
+    {
+      if (i == 0)
+	s = format (s, "<1us %llu", em->wakeup_latency[i]);
+      else if (i < LINUX_EPOLL_N_WAKEUP_LATENCY_BINS - 1)
+	s = format (s, " <%uus %llu", 1 << i, em->wakeup_latency[i]);
+      else
+	s = format (s, " >=%uus %llu", 1 << (i - 1), em->wakeup_latency[i]);
+    }
+  return s;
+}
+
+static clib_error_t *
+show_worker_sleep_command_fn (vlib_main_t * vm,
+			      unformat_input_t * input,
+			      vlib_cli_command_t * cmd)
+{
+  linux_epoll_worker_sleep_t *ws = &linux_epoll_worker_sleep;
+  linux_epoll_main_t *em;
+  int i;
+
+  if (ws->idle_loops)
+    vlib_cli_output (vm, "workers sleep after %u idle loops, "
+		     "for at most %uus", ws->idle_loops, ws->max_sleep_us);
+  else
+    vlib_cli_output (vm, "workers sleep only with no input node polling");
+
+  for (i = 1; i < vec_len (vlib_mains); i++)
+    {
+      em = vec_elt_at_index (linux_epoll_mains, i);
+      vlib_cli_output (vm, "%s: %llu sleeps, %llu woken by input, "
+		       "%.6fs asleep", vlib_worker_threads[i].name,
+		       em->sleeps, em->sleep_event_wakeups,
+		       em->sleep_clocks * vm->clib_time.seconds_per_clock);
+      vlib_cli_output (vm, "  wakeup latency: %U",
+		       format_linux_epoll_wakeup_latency, em);
+    }
+  return 0;
+}
+
+/*?
+ * Show how long each worker has slept, how often input woke it, and how
+ * late the timeout woke it, past the sleep asked for.
+ *
+ * @cliexpar
+ * @cliexcmd{show worker sleep}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_worker_sleep_command, static) = {
+  .path = "show worker sleep",
+  .short_help = "show worker sleep",
+  .function = show_worker_sleep_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+clear_worker_sleep_command_fn (vlib_main_t * vm,
+			       unformat_input_t * input,
+			       vlib_cli_command_t * cmd)
+{
+  linux_epoll_main_t *em;
+
+  vlib_worker_thread_barrier_sync (vm);
+  vec_foreach (em, linux_epoll_mains)
+  {
+    em->sleeps = em->sleep_event_wakeups = em->sleep_clocks = 0;
+    memset (em->wakeup_latency, 0, sizeof (em->wakeup_latency));
+  }
+  vlib_worker_thread_barrier_release (vm);
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (clear_worker_sleep_command, static) = {
+  .path = "clear worker sleep",
+  .short_help = "clear worker sleep",
+  .function = clear_worker_sleep_command_fn,
+};
+/* *INDENT-ON* */
+
 clib_error_t *
 linux_epoll_input_init (vlib_main_t * vm)
 {
@@ -313,6 +641,7 @@ linux_epoll_input_init (vlib_main_t * vm)
       }
     else
       em->epoll_fd = -1;
+    em->wakeup_fd = -1;
   }
 
   fm->file_update = linux_epoll_file_update;
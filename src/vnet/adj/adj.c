@@ -47,17 +47,40 @@ adj_poison (ip_adjacency_t * adj)
 ip_adjacency_t *
 adj_alloc (fib_protocol_t proto)
 {
+    vlib_main_t *vm = vlib_get_main();
     ip_adjacency_t *adj;
+    u8 need_barrier_sync;
+
+    /*
+     * the workers read the pool and the counters without locks, so they
+     * must be stopped should either of them move.
+     */
+    pool_get_aligned_will_expand(adj_pool, need_barrier_sync,
+                                 CLIB_CACHE_LINE_BYTES);
+    if (need_barrier_sync)
+        vlib_worker_thread_barrier_sync(vm);
 
     pool_get_aligned(adj_pool, adj, CLIB_CACHE_LINE_BYTES);
 
     adj_poison(adj);
 
+    if (!need_barrier_sync)
+    {
+        need_barrier_sync =
+            vlib_validate_combined_counter_will_expand(&adjacency_counters,
+                                                       adj_get_index(adj));
+        if (need_barrier_sync)
+            vlib_worker_thread_barrier_sync(vm);
+    }
+
     /* Make sure certain fields are always initialized. */
     /* Validate adjacency counters. */
     vlib_validate_combined_counter(&adjacency_counters,
                                    adj_get_index(adj));
 
+    if (need_barrier_sync)
+        vlib_worker_thread_barrier_release(vm);
+
     fib_node_init(&adj->ia_node,
                   FIB_NODE_TYPE_ADJ);
 
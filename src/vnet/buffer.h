@@ -63,7 +63,8 @@
   _(15, L3_HDR_OFFSET_VALID, 0)				\
   _(16, L4_HDR_OFFSET_VALID, 0)				\
   _(17, FLOW_REPORT, "flow-report")			\
-  _(18, IS_DVR, "dvr")
+  _(18, IS_DVR, "dvr")					\
+  _(19, GSO, "gso")
 
 #define VNET_BUFFER_FLAGS_VLAN_BITS \
   (VNET_BUFFER_F_VLAN_1_DEEP | VNET_BUFFER_F_VLAN_2_DEEP)
@@ -360,6 +361,14 @@ STATIC_ASSERT (sizeof (vnet_buffer_opaque_t) <=
 /* Full cache line (64 bytes) of additional space */
 typedef struct
 {
+  /**
+   * With VNET_BUFFER_F_GSO, the packet is to be sent as segments of
+   * gso_size bytes of L4 payload, each with a copy of the headers, of
+   * which the L4 header is gso_l4_hdr_sz bytes.
+   */
+  u16 gso_size;
+  u16 gso_l4_hdr_sz;
+
   union
   {
 #if VLIB_BUFFER_TRACE_TRAJECTORY > 0
@@ -369,7 +378,7 @@ typedef struct
       u16 *trajectory_trace;
     };
 #endif
-    u32 unused[12];
+    u32 unused[11];
   };
 } vnet_buffer_opaque2_t;
 
@@ -383,6 +392,20 @@ STATIC_ASSERT (sizeof (vnet_buffer_opaque2_t) <=
 	       STRUCT_SIZE_OF (vlib_buffer_t, opaque2),
 	       "VNET buffer opaque2 meta-data too large for vlib_buffer");
 
+/**
+ * The length of the packet, from its current data, that is checked
+ * against an MTU. That of a packet yet to be segmented is the length of
+ * its segments.
+ */
+always_inline u32
+vnet_buffer_mtu_check_length (vlib_main_t * vm, vlib_buffer_t * b)
+{
+  if (PREDICT_FALSE (b->flags & VNET_BUFFER_F_GSO))
+    return (vnet_buffer (b)->l4_hdr_offset - b->current_data +
+	    vnet_buffer2 (b)->gso_l4_hdr_sz + vnet_buffer2 (b)->gso_size);
+  return vlib_buffer_length_in_chain (vm, b);
+}
+
 format_function_t format_vnet_buffer;
 
 #endif /* included_vnet_buffer_h */
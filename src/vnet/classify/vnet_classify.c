@@ -145,9 +145,17 @@ vnet_classify_new_table (vnet_classify_main_t * cm,
   vec_validate_aligned (t->buckets, nbuckets - 1, CLIB_CACHE_LINE_BYTES);
   oldheap = clib_mem_set_heap (t->mheap);
 
-  t->writer_lock = clib_mem_alloc_aligned (CLIB_CACHE_LINE_BYTES,
-					   CLIB_CACHE_LINE_BYTES);
-  t->writer_lock[0] = 0;
+  t->alloc_lock = clib_mem_alloc_aligned (CLIB_CACHE_LINE_BYTES,
+					  CLIB_CACHE_LINE_BYTES);
+  t->alloc_lock[0] = 0;
+
+  /*
+   * Writers on any thread may update the table at once, so the per-thread
+   * working copies are sized up front rather than grown under their feet
+   */
+  vec_validate (t->working_copies, vlib_get_thread_main ()->n_vlib_mains - 1);
+  vec_validate_init_empty (t->working_copy_lengths,
+			   vlib_get_thread_main ()->n_vlib_mains - 1, -1);
 
   clib_mem_set_heap (oldheap);
   return (t);
@@ -175,6 +183,20 @@ vnet_classify_delete_table_index (vnet_classify_main_t * cm,
   pool_put (cm->tables, t);
 }
 
+static inline void
+vnet_classify_alloc_lock (vnet_classify_table_t * t)
+{
+  while (__sync_lock_test_and_set (t->alloc_lock, 1))
+    CLIB_PAUSE ();
+}
+
+static inline void
+vnet_classify_alloc_unlock (vnet_classify_table_t * t)
+{
+  CLIB_MEMORY_BARRIER ();
+  t->alloc_lock[0] = 0;
+}
+
 static vnet_classify_entry_t *
 vnet_classify_entry_alloc (vnet_classify_table_t * t, u32 log2_pages)
 {
@@ -182,11 +204,11 @@ vnet_classify_entry_alloc (vnet_classify_table_t * t, u32 log2_pages)
   u32 required_length;
   void *oldheap;
 
-  ASSERT (t->writer_lock[0]);
   required_length =
     (sizeof (vnet_classify_entry_t) + (t->match_n_vectors * sizeof (u32x4)))
     * t->entries_per_page * (1 << log2_pages);
 
+  vnet_classify_alloc_lock (t);
   if (log2_pages >= vec_len (t->freelists) || t->freelists[log2_pages] == 0)
     {
       oldheap = clib_mem_set_heap (t->mheap);
@@ -201,6 +223,7 @@ vnet_classify_entry_alloc (vnet_classify_table_t * t, u32 log2_pages)
   t->freelists[log2_pages] = rv->next_free;
 
 initialize:
+  vnet_classify_alloc_unlock (t);
   ASSERT (rv);
 
   memset (rv, 0xff, required_length);
@@ -211,12 +234,14 @@ static void
 vnet_classify_entry_free (vnet_classify_table_t * t,
 			  vnet_classify_entry_t * v, u32 log2_pages)
 {
-  ASSERT (t->writer_lock[0]);
+  vnet_classify_alloc_lock (t);
 
   ASSERT (vec_len (t->freelists) > log2_pages);
 
   v->next_free = t->freelists[log2_pages];
   t->freelists[log2_pages] = v;
+
+  vnet_classify_alloc_unlock (t);
 }
 
 static inline void make_working_copy
@@ -229,14 +254,7 @@ static inline void make_working_copy
   u32 thread_index = vlib_get_thread_index ();
   int working_copy_length, required_length;
 
-  if (thread_index >= vec_len (t->working_copies))
-    {
-      oldheap = clib_mem_set_heap (t->mheap);
-      vec_validate (t->working_copies, thread_index);
-      vec_validate (t->working_copy_lengths, thread_index);
-      t->working_copy_lengths[thread_index] = -1;
-      clib_mem_set_heap (oldheap);
-    }
+  ASSERT (thread_index < vec_len (t->working_copies));
 
   /*
    * working_copies are per-cpu so that near-simultaneous
@@ -249,20 +267,20 @@ static inline void make_working_copy
     (sizeof (vnet_classify_entry_t) + (t->match_n_vectors * sizeof (u32x4)))
     * t->entries_per_page * (1 << b->log2_pages);
 
-  t->saved_bucket.as_u64 = b->as_u64;
-  oldheap = clib_mem_set_heap (t->mheap);
-
   if (required_length > working_copy_length)
     {
+      vnet_classify_alloc_lock (t);
+      oldheap = clib_mem_set_heap (t->mheap);
       if (working_copy)
 	clib_mem_free (working_copy);
       working_copy =
 	clib_mem_alloc_aligned (required_length, CLIB_CACHE_LINE_BYTES);
       t->working_copies[thread_index] = working_copy;
+      t->working_copy_lengths[thread_index] = required_length;
+      clib_mem_set_heap (oldheap);
+      vnet_classify_alloc_unlock (t);
     }
 
-  clib_mem_set_heap (oldheap);
-
   v = vnet_classify_get_entry (t, b->offset);
 
   clib_memcpy (working_copy, v, required_length);
@@ -406,47 +424,42 @@ vnet_classify_entry_release_resource (vnet_classify_entry_t * e)
     }
 }
 
-int
-vnet_classify_add_del (vnet_classify_table_t * t,
-		       vnet_classify_entry_t * add_v, int is_add)
+/*
+ * Writers lock only the bucket they update, so writers of different
+ * buckets, on any thread, do not wait for one another, bar briefly for
+ * the allocator. Readers take no lock. Before a bucket's pages are
+ * updated the readers are pointed at the writer's working copy of them;
+ * the updates, as many as the caller has for the bucket, are then made
+ * to the pages, or to new pages should the bucket split, which are
+ * published to the readers in one write of the bucket.
+ */
+
+/**
+ * Add or delete one entry to/from the unpublished pages of a bucket.
+ * The entry's hash has been shifted past the bucket index.
+ */
+static int
+vnet_classify_add_del_one (vnet_classify_table_t * t,
+			   vnet_classify_bucket_t * work,
+			   vnet_classify_entry_t * add_v, u64 hash,
+			   int is_add)
 {
-  u32 bucket_index;
-  vnet_classify_bucket_t *b, tmp_b;
-  vnet_classify_entry_t *v, *new_v, *save_new_v, *working_copy, *save_v;
+  vnet_classify_entry_t *v, *new_v, *save_new_v, *save_v;
   u32 value_index;
-  int rv = 0;
   int i;
-  u64 hash, new_hash;
+  u64 new_hash;
   u32 limit;
   u32 old_log2_pages, new_log2_pages;
-  u32 thread_index = vlib_get_thread_index ();
-  u8 *key_minus_skip;
   int resplit_once = 0;
   int mark_bucket_linear;
 
   ASSERT ((add_v->flags & VNET_CLASSIFY_ENTRY_FREE) == 0);
 
-  key_minus_skip = (u8 *) add_v->key;
-  key_minus_skip -= t->skip_n_vectors * sizeof (u32x4);
-
-  hash = vnet_classify_hash_packet (t, key_minus_skip);
-
-  bucket_index = hash & (t->nbuckets - 1);
-  b = &t->buckets[bucket_index];
-
-  hash >>= t->log2_nbuckets;
-
-  while (__sync_lock_test_and_set (t->writer_lock, 1))
-    ;
-
   /* First elt in the bucket? */
-  if (b->offset == 0)
+  if (work->offset == 0)
     {
       if (is_add == 0)
-	{
-	  rv = -1;
-	  goto unlock;
-	}
+	return -1;
 
       v = vnet_classify_entry_alloc (t, 0 /* new_log2_pages */ );
       clib_memcpy (v, add_v, sizeof (vnet_classify_entry_t) +
@@ -454,24 +467,21 @@ vnet_classify_add_del (vnet_classify_table_t * t,
       v->flags &= ~(VNET_CLASSIFY_ENTRY_FREE);
       vnet_classify_entry_claim_resource (v);
 
-      tmp_b.as_u64 = 0;
-      tmp_b.offset = vnet_classify_get_offset (t, v);
-
-      b->as_u64 = tmp_b.as_u64;
-      t->active_elements++;
+      work->offset = vnet_classify_get_offset (t, v);
+      work->log2_pages = 0;
+      work->linear_search = 0;
+      __sync_fetch_and_add (&t->active_elements, 1);
 
-      goto unlock;
+      return 0;
     }
 
-  make_working_copy (t, b);
-
-  save_v = vnet_classify_get_entry (t, t->saved_bucket.offset);
-  value_index = hash & ((1 << t->saved_bucket.log2_pages) - 1);
+  save_v = vnet_classify_get_entry (t, work->offset);
+  value_index = hash & ((1 << work->log2_pages) - 1);
   limit = t->entries_per_page;
-  if (PREDICT_FALSE (b->linear_search))
+  if (PREDICT_FALSE (work->linear_search))
     {
       value_index = 0;
-      limit *= (1 << b->log2_pages);
+      limit *= (1 << work->log2_pages);
     }
 
   if (is_add)
@@ -492,11 +502,7 @@ vnet_classify_add_del (vnet_classify_table_t * t,
 			   t->match_n_vectors * sizeof (u32x4));
 	      v->flags &= ~(VNET_CLASSIFY_ENTRY_FREE);
 	      vnet_classify_entry_claim_resource (v);
-
-	      CLIB_MEMORY_BARRIER ();
-	      /* Restore the previous (k,v) pairs */
-	      b->as_u64 = t->saved_bucket.as_u64;
-	      goto unlock;
+	      return 0;
 	    }
 	}
       for (i = 0; i < limit; i++)
@@ -509,11 +515,8 @@ vnet_classify_add_del (vnet_classify_table_t * t,
 			   t->match_n_vectors * sizeof (u32x4));
 	      v->flags &= ~(VNET_CLASSIFY_ENTRY_FREE);
 	      vnet_classify_entry_claim_resource (v);
-
-	      CLIB_MEMORY_BARRIER ();
-	      b->as_u64 = t->saved_bucket.as_u64;
-	      t->active_elements++;
-	      goto unlock;
+	      __sync_fetch_and_add (&t->active_elements, 1);
+	      return 0;
 	    }
 	}
       /* no room at the inn... split case... */
@@ -531,28 +534,27 @@ vnet_classify_add_del (vnet_classify_table_t * t,
 	      memset (v, 0xff, sizeof (vnet_classify_entry_t) +
 		      t->match_n_vectors * sizeof (u32x4));
 	      v->flags |= VNET_CLASSIFY_ENTRY_FREE;
-
-	      CLIB_MEMORY_BARRIER ();
-	      b->as_u64 = t->saved_bucket.as_u64;
-	      t->active_elements--;
-	      goto unlock;
+	      __sync_fetch_and_add (&t->active_elements, -1);
+	      return 0;
 	    }
 	}
-      rv = -3;
-      b->as_u64 = t->saved_bucket.as_u64;
-      goto unlock;
+      return -3;
     }
 
-  old_log2_pages = t->saved_bucket.log2_pages;
+  /*
+   * Split the pages into new ones, of twice the size or, should the
+   * entries not rehash into those, four times. The readers are on the
+   * working copy, so the pages are ours to free once split.
+   */
+  old_log2_pages = work->log2_pages;
   new_log2_pages = old_log2_pages + 1;
-  working_copy = t->working_copies[thread_index];
 
-  if (t->saved_bucket.linear_search)
+  if (work->linear_search)
     goto linear_resplit;
 
   mark_bucket_linear = 0;
 
-  new_v = split_and_rehash (t, working_copy, old_log2_pages, new_log2_pages);
+  new_v = split_and_rehash (t, save_v, old_log2_pages, new_log2_pages);
 
   if (new_v == 0)
     {
@@ -560,8 +562,7 @@ vnet_classify_add_del (vnet_classify_table_t * t,
       resplit_once = 1;
       new_log2_pages++;
 
-      new_v = split_and_rehash (t, working_copy, old_log2_pages,
-				new_log2_pages);
+      new_v = split_and_rehash (t, save_v, old_log2_pages, new_log2_pages);
       if (new_v == 0)
 	{
 	mark_linear:
@@ -569,11 +570,11 @@ vnet_classify_add_del (vnet_classify_table_t * t,
 
 	linear_resplit:
 	  /* pinned collisions, use linear search */
-	  new_v = split_and_rehash_linear (t, working_copy, old_log2_pages,
+	  new_v = split_and_rehash_linear (t, save_v, old_log2_pages,
 					   new_log2_pages);
 	  /* A new linear-search bucket? */
-	  if (!t->saved_bucket.linear_search)
-	    t->linear_buckets++;
+	  if (!work->linear_search)
+	    __sync_fetch_and_add (&t->linear_buckets, 1);
 	  mark_bucket_linear = 1;
 	}
     }
@@ -581,12 +582,7 @@ vnet_classify_add_del (vnet_classify_table_t * t,
   /* Try to add the new entry */
   save_new_v = new_v;
 
-  key_minus_skip = (u8 *) add_v->key;
-  key_minus_skip -= t->skip_n_vectors * sizeof (u32x4);
-
-  new_hash = vnet_classify_hash_packet_inline (t, key_minus_skip);
-  new_hash >>= t->log2_nbuckets;
-  new_hash &= (1 << new_log2_pages) - 1;
+  new_hash = hash & ((1 << new_log2_pages) - 1);
 
   limit = t->entries_per_page;
   if (mark_bucket_linear)
@@ -619,19 +615,134 @@ vnet_classify_add_del (vnet_classify_table_t * t,
     goto try_resplit;
 
 expand_ok:
-  tmp_b.log2_pages = new_log2_pages;
-  tmp_b.offset = vnet_classify_get_offset (t, save_new_v);
-  tmp_b.linear_search = mark_bucket_linear;
+  work->log2_pages = new_log2_pages;
+  work->offset = vnet_classify_get_offset (t, save_new_v);
+  work->linear_search = mark_bucket_linear;
 
-  CLIB_MEMORY_BARRIER ();
-  b->as_u64 = tmp_b.as_u64;
-  t->active_elements++;
-  v = vnet_classify_get_entry (t, t->saved_bucket.offset);
-  vnet_classify_entry_free (t, v, old_log2_pages);
+  __sync_fetch_and_add (&t->active_elements, 1);
+  vnet_classify_entry_free (t, save_v, old_log2_pages);
+
+  return 0;
+}
+
+/**
+ * Add or delete entries, all of which hash to the given bucket.
+ * Returns 0, or the error of the first entry that failed.
+ */
+static int
+vnet_classify_bucket_add_del (vnet_classify_table_t * t,
+			      vnet_classify_bucket_t * b,
+			      vnet_classify_entry_t ** entries,
+			      u64 * hashes, u32 n_entries, int is_add)
+{
+  vnet_classify_bucket_t work;
+  int rv = 0, rv0;
+  u32 i;
 
-unlock:
+  vnet_classify_bucket_lock (b);
+
+  work.as_u64 = b->as_u64;
+  if (work.offset)
+    make_working_copy (t, b);
+
+  for (i = 0; i < n_entries; i++)
+    {
+      rv0 = vnet_classify_add_del_one (t, &work, entries[i],
+				       hashes[i] >> t->log2_nbuckets,
+				       is_add);
+      if (rv0 && !rv)
+	rv = rv0;
+    }
+
+  /* Publish the pages, the bucket still locked */
+  ASSERT (work.lock);
   CLIB_MEMORY_BARRIER ();
-  t->writer_lock[0] = 0;
+  b->as_u64 = work.as_u64;
+
+  vnet_classify_bucket_unlock (b);
+
+  return rv;
+}
+
+int
+vnet_classify_add_del (vnet_classify_table_t * t,
+		       vnet_classify_entry_t * add_v, int is_add)
+{
+  u8 *key_minus_skip;
+  u64 hash;
+
+  key_minus_skip = (u8 *) add_v->key;
+  key_minus_skip -= t->skip_n_vectors * sizeof (u32x4);
+
+  hash = vnet_classify_hash_packet (t, key_minus_skip);
+
+  return (vnet_classify_bucket_add_del (t, &t->buckets[hash &
+							(t->nbuckets - 1)],
+					&add_v, &hash, 1, is_add));
+}
+
+static int
+vnet_classify_bulk_order_cmp (void *a1, void *a2)
+{
+  u64 *o1 = a1, *o2 = a2;
+
+  return (*o1 < *o2 ? -1 : *o1 > *o2);
+}
+
+int
+vnet_classify_add_del_bulk (vnet_classify_table_t * t,
+			    vnet_classify_entry_t ** entries,
+			    u32 n_entries, int is_add)
+{
+  vnet_classify_entry_t **group = 0;
+  u64 *order = 0, *hashes = 0, *group_hashes = 0;
+  u8 *key_minus_skip;
+  u32 i, j, bucket_index;
+  int rv = 0, rv0;
+
+  vec_validate (hashes, n_entries - 1);
+  vec_validate (order, n_entries - 1);
+
+  /*
+   * Sort the entries by bucket, so that each bucket is locked, copied
+   * for the readers and published once, however many of the entries it
+   * takes, and the buckets are visited in the order they are in memory
+   */
+  for (i = 0; i < n_entries; i++)
+    {
+      key_minus_skip = (u8 *) entries[i]->key;
+      key_minus_skip -= t->skip_n_vectors * sizeof (u32x4);
+
+      hashes[i] = vnet_classify_hash_packet_inline (t, key_minus_skip);
+      order[i] = ((hashes[i] & (t->nbuckets - 1)) << 32) | i;
+    }
+
+  vec_sort_with_function (order, vnet_classify_bulk_order_cmp);
+
+  for (i = 0; i < n_entries; i = j)
+    {
+      bucket_index = order[i] >> 32;
+
+      vec_reset_length (group);
+      vec_reset_length (group_hashes);
+      for (j = i; j < n_entries && (order[j] >> 32) == bucket_index; j++)
+	{
+	  vec_add1 (group, entries[(u32) order[j]]);
+	  vec_add1 (group_hashes, hashes[(u32) order[j]]);
+	}
+
+      rv0 = vnet_classify_bucket_add_del (t, &t->buckets[bucket_index],
+					  group, group_hashes,
+					  vec_len (group), is_add);
+      if (rv0 && !rv)
+	rv = rv0;
+    }
+
+  vec_free (group);
+  vec_free (group_hashes);
+  vec_free (order);
+  vec_free (hashes);
+
   return rv;
 }
 
@@ -2139,26 +2250,16 @@ unformat_classify_match (unformat_input_t * input, va_list * args)
   return 0;
 }
 
-int
-vnet_classify_add_del_session (vnet_classify_main_t * cm,
-			       u32 table_index,
-			       u8 * match,
-			       u32 hit_next_index,
-			       u32 opaque_index,
-			       i32 advance,
-			       u8 action, u32 metadata, int is_add)
+static void
+vnet_classify_session_init (vnet_classify_table_t * t,
+			    vnet_classify_entry_t * e,
+			    u8 * match,
+			    u32 hit_next_index,
+			    u32 opaque_index,
+			    i32 advance, u8 action, u32 metadata)
 {
-  vnet_classify_table_t *t;
-  vnet_classify_entry_5_t _max_e __attribute__ ((aligned (16)));
-  vnet_classify_entry_t *e;
-  int i, rv;
-
-  if (pool_is_free_index (cm->tables, table_index))
-    return VNET_API_ERROR_NO_SUCH_TABLE;
-
-  t = pool_elt_at_index (cm->tables, table_index);
+  int i;
 
-  e = (vnet_classify_entry_t *) & _max_e;
   e->next_index = hit_next_index;
   e->opaque_index = opaque_index;
   e->advance = advance;
@@ -2186,6 +2287,30 @@ vnet_classify_add_del_session (vnet_classify_main_t * cm,
   /* Clear don't-care bits; likely when dynamically creating sessions */
   for (i = 0; i < t->match_n_vectors; i++)
     e->key[i] &= t->mask[i];
+}
+
+int
+vnet_classify_add_del_session (vnet_classify_main_t * cm,
+			       u32 table_index,
+			       u8 * match,
+			       u32 hit_next_index,
+			       u32 opaque_index,
+			       i32 advance,
+			       u8 action, u32 metadata, int is_add)
+{
+  vnet_classify_table_t *t;
+  vnet_classify_entry_5_t _max_e __attribute__ ((aligned (16)));
+  vnet_classify_entry_t *e;
+  int rv;
+
+  if (pool_is_free_index (cm->tables, table_index))
+    return VNET_API_ERROR_NO_SUCH_TABLE;
+
+  t = pool_elt_at_index (cm->tables, table_index);
+
+  e = (vnet_classify_entry_t *) & _max_e;
+  vnet_classify_session_init (t, e, match, hit_next_index, opaque_index,
+			      advance, action, metadata);
 
   rv = vnet_classify_add_del (t, e, is_add);
 
@@ -2196,6 +2321,61 @@ vnet_classify_add_del_session (vnet_classify_main_t * cm,
   return 0;
 }
 
+/**
+ * Add or delete a session per match, with the given opaque indices, or
+ * ~0 should there be none. Cheaper by far than a session at a time for
+ * the many sessions of e.g. an ACL.
+ */
+int
+vnet_classify_add_del_sessions (vnet_classify_main_t * cm,
+				u32 table_index,
+				u8 ** matches,
+				u32 hit_next_index,
+				u32 * opaque_indices,
+				i32 advance,
+				u8 action, u32 metadata, int is_add)
+{
+  vnet_classify_table_t *t;
+  vnet_classify_entry_t **entries = 0;
+  u8 *entry_data = 0;
+  u32 i, entry_size;
+  int rv;
+
+  if (pool_is_free_index (cm->tables, table_index))
+    return VNET_API_ERROR_NO_SUCH_TABLE;
+
+  if (vec_len (matches) == 0)
+    return 0;
+
+  t = pool_elt_at_index (cm->tables, table_index);
+  entry_size = sizeof (vnet_classify_entry_t) +
+    t->match_n_vectors * sizeof (u32x4);
+
+  vec_validate_aligned (entry_data, vec_len (matches) * entry_size - 1,
+			sizeof (u32x4));
+  vec_validate (entries, vec_len (matches) - 1);
+
+  for (i = 0; i < vec_len (matches); i++)
+    {
+      entries[i] = (vnet_classify_entry_t *) (entry_data + i * entry_size);
+      vnet_classify_session_init (t, entries[i], matches[i], hit_next_index,
+				  opaque_indices ? opaque_indices[i] : ~0,
+				  advance, action, metadata);
+    }
+
+  rv = vnet_classify_add_del_bulk (t, entries, vec_len (entries), is_add);
+
+  for (i = 0; i < vec_len (entries); i++)
+    vnet_classify_entry_release_resource (entries[i]);
+
+  vec_free (entries);
+  vec_free (entry_data);
+
+  if (rv)
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+  return 0;
+}
+
 static clib_error_t *
 classify_session_command_fn (vlib_main_t * vm,
 			     unformat_input_t * input,
@@ -2642,6 +2822,217 @@ test_classify_churn (test_classify_main_t * tm)
   return 0;
 }
 
+/*
+ * The perf test's reader, a thread of its own, looking up the sessions
+ * that stay in the table while the CLI thread updates the others
+ */
+typedef struct
+{
+  vnet_classify_table_t *table;
+  classify_data_or_mask_t *data;
+  test_entry_t *entries;
+  volatile u32 stop;
+  u64 n_lookups;
+  u64 n_misses;
+} test_classify_reader_t;
+
+static void *
+test_classify_reader (void *arg)
+{
+  test_classify_reader_t *r = arg;
+  vnet_classify_entry_t *e;
+  u32 i, n_entries = vec_len (r->entries);
+  u64 hash;
+
+  while (!r->stop)
+    {
+      for (i = 0; i < n_entries; i += 2)
+	{
+	  r->data->ip.src_address.as_u32 = r->entries[i].addr.as_u32;
+	  hash = vnet_classify_hash_packet (r->table, (u8 *) r->data);
+	  e = vnet_classify_find_entry (r->table, (u8 *) r->data, hash,
+					0 /* time_now */ );
+	  r->n_misses += (e == 0);
+	}
+      r->n_lookups += (n_entries + 1) / 2;
+    }
+  return 0;
+}
+
+static clib_error_t *
+test_classify_perf (test_classify_main_t * tm)
+{
+  test_classify_reader_t reader;
+  clib_error_t *error = 0;
+  classify_data_or_mask_t *mask, *data;
+  vlib_main_t *vm = tm->vlib_main;
+  vnet_classify_entry_t *e;
+  u8 **matches = 0, *mp = 0, *dp = 0, *rp = 0;
+  u32 *opaques = 0, tmp, n_ops;
+  pthread_t reader_thread;
+  test_entry_t *ep;
+  f64 before, delta;
+  u64 hash, n_misses;
+  int i, rv;
+
+  vec_validate_aligned (mp, 3 * sizeof (u32x4), sizeof (u32x4));
+  vec_validate_aligned (rp, 3 * sizeof (u32x4), sizeof (u32x4));
+  vec_validate_aligned (dp, tm->sessions * 3 * sizeof (u32x4),
+			sizeof (u32x4));
+  mask = (classify_data_or_mask_t *) mp;
+  data = (classify_data_or_mask_t *) dp;
+
+  /* Mask on src address */
+  memset (&mask->ip.src_address, 0xff, 4);
+
+  tmp = clib_host_to_net_u32 (tm->src.as_u32);
+  for (i = 0; i < tm->sessions; i++)
+    {
+      vec_add2 (tm->entries, ep, 1);
+      ep->addr.as_u32 = clib_host_to_net_u32 (tmp);
+      ep->in_table = 0;
+      tmp++;
+
+      data = (classify_data_or_mask_t *) (dp + i * 3 * sizeof (u32x4));
+      data->ip.src_address.as_u32 = ep->addr.as_u32;
+      vec_add1 (matches, (u8 *) data);
+      vec_add1 (opaques, i);
+    }
+
+  tm->table = vnet_classify_new_table (tm->classify_main, (u8 *) mask,
+				       tm->buckets, tm->memory_size,
+				       0 /* skip */ , 3 /* vectors */ );
+  tm->table->miss_next_index = IP_LOOKUP_NEXT_DROP;
+  tm->table_index = tm->table - tm->classify_main->tables;
+  vlib_cli_output (vm, "Created table %d, buckets %d, %d sessions",
+		   tm->table_index, tm->buckets, tm->sessions);
+
+  /* One at a time */
+  before = vlib_time_now (vm);
+  for (i = 0; i < tm->sessions; i++)
+    {
+      rv = vnet_classify_add_del_session (tm->classify_main,
+					  tm->table_index, matches[i],
+					  IP_LOOKUP_NEXT_DROP, i, 0, 0, 0,
+					  1 /* is_add */ );
+      if (rv != 0)
+	clib_warning ("add: returned %d", rv);
+    }
+  delta = vlib_time_now (vm) - before;
+  vlib_cli_output (vm, "add one at a time: %.2f sessions/sec",
+		   delta > 0 ? tm->sessions / delta : 0.0);
+
+  before = vlib_time_now (vm);
+  for (i = 0; i < tm->sessions; i++)
+    vnet_classify_add_del_session (tm->classify_main, tm->table_index,
+				   matches[i], IP_LOOKUP_NEXT_DROP, i, 0, 0,
+				   0, 0 /* is_add */ );
+  delta = vlib_time_now (vm) - before;
+  vlib_cli_output (vm, "del one at a time: %.2f sessions/sec, "
+		   "%d remain, MUST be zero",
+		   delta > 0 ? tm->sessions / delta : 0.0,
+		   tm->table->active_elements);
+
+  /* In bulk */
+  before = vlib_time_now (vm);
+  rv = vnet_classify_add_del_sessions (tm->classify_main, tm->table_index,
+				       matches, IP_LOOKUP_NEXT_DROP, opaques,
+				       0, 0, 0, 1 /* is_add */ );
+  delta = vlib_time_now (vm) - before;
+  if (rv != 0)
+    clib_warning ("bulk add: returned %d", rv);
+  vlib_cli_output (vm, "add in bulk: %.2f sessions/sec, %d in the table",
+		   delta > 0 ? tm->sessions / delta : 0.0,
+		   tm->table->active_elements);
+
+  /* Lookups, all of which should hit */
+  n_misses = 0;
+  before = vlib_time_now (vm);
+  for (i = 0; i < tm->sessions; i++)
+    {
+      data = (classify_data_or_mask_t *) matches[i];
+      hash = vnet_classify_hash_packet (tm->table, (u8 *) data);
+      e = vnet_classify_find_entry (tm->table, (u8 *) data, hash,
+				    0 /* time_now */ );
+      if (e == 0 || e->opaque_index != i)
+	n_misses++;
+    }
+  delta = vlib_time_now (vm) - before;
+  vlib_cli_output (vm, "lookups: %.2f lookups/sec, %lld misses, "
+		   "MUST be zero", delta > 0 ? tm->sessions / delta : 0.0,
+		   n_misses);
+
+  /*
+   * Lookups of the even sessions, from another thread, while the odd
+   * ones are deleted and added again
+   */
+  memset (&reader, 0, sizeof (reader));
+  reader.table = tm->table;
+  reader.data = (classify_data_or_mask_t *) rp;
+  reader.entries = tm->entries;
+
+  if (pthread_create (&reader_thread, NULL, test_classify_reader, &reader))
+    {
+      error = clib_error_return_unix (0, "pthread_create");
+      goto done;
+    }
+
+  n_ops = 0;
+  before = vlib_time_now (vm);
+  while (n_ops < tm->iterations)
+    {
+      for (i = 1; i < tm->sessions && n_ops < tm->iterations; i += 2)
+	{
+	  vnet_classify_add_del_session (tm->classify_main, tm->table_index,
+					 matches[i], IP_LOOKUP_NEXT_DROP, i,
+					 0, 0, 0, 0 /* is_add */ );
+	  vnet_classify_add_del_session (tm->classify_main, tm->table_index,
+					 matches[i], IP_LOOKUP_NEXT_DROP, i,
+					 0, 0, 0, 1 /* is_add */ );
+	  n_ops += 2;
+	}
+      if (tm->sessions < 2)
+	break;
+    }
+  delta = vlib_time_now (vm) - before;
+
+  reader.stop = 1;
+  pthread_join (reader_thread, NULL);
+
+  vlib_cli_output (vm, "concurrent: writer %.2f updates/sec, "
+		   "reader %.2f lookups/sec, %lld misses",
+		   delta > 0 ? n_ops / delta : 0.0,
+		   delta > 0 ? reader.n_lookups / delta : 0.0,
+		   reader.n_misses);
+
+  before = vlib_time_now (vm);
+  vnet_classify_add_del_sessions (tm->classify_main, tm->table_index,
+				  matches, IP_LOOKUP_NEXT_DROP, opaques,
+				  0, 0, 0, 0 /* is_add */ );
+  delta = vlib_time_now (vm) - before;
+  vlib_cli_output (vm, "del in bulk: %.2f sessions/sec, "
+		   "%d remain, MUST be zero",
+		   delta > 0 ? tm->sessions / delta : 0.0,
+		   tm->table->active_elements);
+
+  vlib_cli_output (vm, "Table after cleanup: \n%U\n",
+		   format_classify_table, tm->table, 0 /* verbose */ );
+
+done:
+  vnet_classify_delete_table_index (tm->classify_main,
+				    tm->table_index, 1 /* del_chain */ );
+  tm->table = 0;
+  tm->table_index = ~0;
+  vec_free (tm->entries);
+  vec_free (matches);
+  vec_free (opaques);
+  vec_free (mp);
+  vec_free (dp);
+  vec_free (rp);
+
+  return error;
+}
+
 static clib_error_t *
 test_classify_command_fn (vlib_main_t * vm,
 			  unformat_input_t * input, vlib_cli_command_t * cmd)
@@ -2687,6 +3078,8 @@ test_classify_command_fn (vlib_main_t * vm,
 	;
       else if (unformat (input, "churn-test"))
 	which = 0;
+      else if (unformat (input, "perf-test"))
+	which = 1;
       else
 	break;
     }
@@ -2696,6 +3089,9 @@ test_classify_command_fn (vlib_main_t * vm,
     case 0:
       error = test_classify_churn (tm);
       break;
+    case 1:
+      error = test_classify_perf (tm);
+      break;
     default:
       error = clib_error_return (0, "No such test");
       break;
@@ -2710,7 +3106,7 @@ VLIB_CLI_COMMAND (test_classify_command, static) = {
     .short_help =
     "test classify [src <ip>] [sessions <nn>] [buckets <nn>] [seed <nnn>]\n"
     "              [memory-size <nn>[M|G]]\n"
-    "              [churn-test]",
+    "              [iterations <nn>] [churn-test | perf-test]",
     .function = test_classify_command_fn,
 };
 /* *INDENT-ON* */
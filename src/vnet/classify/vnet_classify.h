@@ -34,6 +34,7 @@
 #include <vppinfra/error.h>
 #include <vppinfra/hash.h>
 #include <vppinfra/cache.h>
+#include <vppinfra/lock.h>
 #include <vppinfra/xxhash.h>
 
 extern vlib_node_registration_t ip4_classify_node;
@@ -143,13 +144,28 @@ typedef struct
     {
       u32 offset;
       u8 linear_search;
-      u8 pad[2];
+      /* held by the bucket's writer, readers ignore it */
+      u8 lock;
+      u8 pad[1];
       u8 log2_pages;
     };
     u64 as_u64;
   };
 } vnet_classify_bucket_t;
 
+static inline void
+vnet_classify_bucket_lock (vnet_classify_bucket_t * b)
+{
+  while (__sync_lock_test_and_set (&b->lock, 1))
+    CLIB_PAUSE ();
+}
+
+static inline void
+vnet_classify_bucket_unlock (vnet_classify_bucket_t * b)
+{
+  __sync_lock_release (&b->lock);
+}
+
 typedef struct
 {
   /* Mask to apply after skipping N vectors */
@@ -178,18 +194,20 @@ typedef struct
   /* Per-bucket working copies, one per thread */
   vnet_classify_entry_t **working_copies;
   int *working_copy_lengths;
-  vnet_classify_bucket_t saved_bucket;
 
   /* Free entry freelists */
   vnet_classify_entry_t **freelists;
 
   u8 *name;
 
-  /* Private allocation arena, protected by the writer lock */
+  /* Private allocation arena, protected by the allocator lock */
   void *mheap;
 
-  /* Writer (only) lock for this table */
-  volatile u32 *writer_lock;
+  /*
+   * Allocator lock for this table. Writers otherwise lock only the
+   * bucket they update
+   */
+  volatile u32 *alloc_lock;
 
 } vnet_classify_table_t;
 
@@ -522,6 +540,21 @@ int vnet_classify_add_del_session (vnet_classify_main_t * cm,
 				   i32 advance,
 				   u8 action, u32 metadata, int is_add);
 
+int vnet_classify_add_del_sessions (vnet_classify_main_t * cm,
+				    u32 table_index,
+				    u8 ** matches,
+				    u32 hit_next_index,
+				    u32 * opaque_indices,
+				    i32 advance,
+				    u8 action, u32 metadata, int is_add);
+
+int vnet_classify_add_del (vnet_classify_table_t * t,
+			   vnet_classify_entry_t * add_v, int is_add);
+
+int vnet_classify_add_del_bulk (vnet_classify_table_t * t,
+				vnet_classify_entry_t ** entries,
+				u32 n_entries, int is_add);
+
 int vnet_classify_add_del_table (vnet_classify_main_t * cm,
 				 u8 * mask,
 				 u32 nbuckets,
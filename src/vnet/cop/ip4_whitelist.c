@@ -123,7 +123,7 @@ ip4_cop_whitelist_node_fn (vlib_main_t * vm,
                &next0,
                sizeof (c0[0]));
 
-	  mtrie0 = &ip4_fib_get (c0->fib_index)->mtrie;
+	  mtrie0 = ip4_fib_get (c0->fib_index)->mtrie;
 
           leaf0 = ip4_fib_mtrie_lookup_step_one (mtrie0, &ip0->src_address);
 
@@ -159,7 +159,7 @@ ip4_cop_whitelist_node_fn (vlib_main_t * vm,
                &vnet_buffer (b1)->cop.current_config_index,
                &next1,
                sizeof (c1[0]));
-	  mtrie1 = &ip4_fib_get (c1->fib_index)->mtrie;
+	  mtrie1 = ip4_fib_get (c1->fib_index)->mtrie;
 
           leaf1 = ip4_fib_mtrie_lookup_step_one (mtrie1, &ip1->src_address);
 
@@ -253,7 +253,7 @@ ip4_cop_whitelist_node_fn (vlib_main_t * vm,
                &next0,
                sizeof (c0[0]));
 
-	  mtrie0 = &ip4_fib_get (c0->fib_index)->mtrie;
+	  mtrie0 = ip4_fib_get (c0->fib_index)->mtrie;
 
           leaf0 = ip4_fib_mtrie_lookup_step_one (mtrie0, &ip0->src_address);
 
@@ -19,6 +19,7 @@
 
 #include <linux/if_ether.h>
 #include <linux/if_packet.h>
+#include <linux/filter.h>
 #include <dirent.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -44,14 +45,17 @@ af_packet_main_t af_packet_main;
 #define AF_PACKET_TX_BLOCK_SIZE	 	(AF_PACKET_TX_FRAME_SIZE * \
 					 AF_PACKET_TX_FRAMES_PER_BLOCK)
 
-#define AF_PACKET_RX_FRAMES_PER_BLOCK	1024
+#define AF_PACKET_RX_FRAMES_PER_BLOCK	32
 #define AF_PACKET_RX_FRAME_SIZE	 	(2048 * 5)
-#define AF_PACKET_RX_BLOCK_NR		1
+#define AF_PACKET_RX_BLOCK_NR		32
 #define AF_PACKET_RX_FRAME_NR		(AF_PACKET_RX_BLOCK_NR * \
 					 AF_PACKET_RX_FRAMES_PER_BLOCK)
 #define AF_PACKET_RX_BLOCK_SIZE		(AF_PACKET_RX_FRAME_SIZE * \
 					 AF_PACKET_RX_FRAMES_PER_BLOCK)
 
+/* TPACKET_V3 hands over a partly filled rx block after this long */
+#define AF_PACKET_RX_BLOCK_TIMEOUT_MS	1
+
 #if AF_PACKET_DEBUG_SOCKET == 1
 #define DBG_SOCK(args...) clib_warning(args);
 #else
@@ -61,7 +65,7 @@ af_packet_main_t af_packet_main;
 /*defined in net/if.h but clashes with dpdk headers */
 unsigned int if_nametoindex (const char *ifname);
 
-typedef struct tpacket_req tpacket_req_t;
+typedef struct tpacket_req3 tpacket_req3_t;
 
 static u32
 af_packet_eth_flag_change (vnet_main_t * vnm, vnet_hw_interface_t * hi,
@@ -95,14 +99,15 @@ af_packet_fd_read_ready (clib_file_t * uf)
 {
   af_packet_main_t *apm = &af_packet_main;
   vnet_main_t *vnm = vnet_get_main ();
-  u32 idx = uf->private_data;
+  u32 idx = uf->private_data >> 16;
+  u16 qid = uf->private_data & 0xffff;
   af_packet_if_t *apif = pool_elt_at_index (apm->interfaces, idx);
 
   apm->pending_input_bitmap =
     clib_bitmap_set (apm->pending_input_bitmap, idx, 1);
 
   /* Schedule the rx node */
-  vnet_device_input_set_interrupt_pending (vnm, apif->hw_if_index, 0);
+  vnet_device_input_set_interrupt_pending (vnm, apif->hw_if_index, qid);
 
   return 0;
 }
@@ -126,16 +131,29 @@ is_bridge (const u8 * host_if_name)
   return -1;
 }
 
+/*
+ * Open a TPACKET_V3 socket with an rx ring, and a tx ring if tx_req is
+ * given, bound to the host interface. Fails with SYSCALL_ERROR_2 when
+ * only the tx ring cannot be had, as on kernels before 4.11. With
+ * fanout_id >= 0 the socket joins that PACKET_FANOUT_HASH group, which
+ * spreads the flows received over the sockets of the group, one per rx
+ * queue.
+ */
 static int
-create_packet_v2_sock (int host_if_index, tpacket_req_t * rx_req,
-		       tpacket_req_t * tx_req, int *fd, u8 ** ring)
+create_packet_v3_sock (int host_if_index, tpacket_req3_t * rx_req,
+		       tpacket_req3_t * tx_req, int fanout_id, int *fd,
+		       u8 ** ring)
 {
   int ret, err;
   struct sockaddr_ll sll;
-  int ver = TPACKET_V2;
-  socklen_t req_sz = sizeof (struct tpacket_req);
-  u32 ring_sz = rx_req->tp_block_size * rx_req->tp_block_nr +
-    tx_req->tp_block_size * tx_req->tp_block_nr;
+  int ver = TPACKET_V3;
+  socklen_t req_sz = sizeof (struct tpacket_req3);
+  u32 ring_sz = rx_req->tp_block_size * rx_req->tp_block_nr;
+
+  if (tx_req)
+    ring_sz += tx_req->tp_block_size * tx_req->tp_block_nr;
+
+  *ring = MAP_FAILED;
 
   if ((*fd = socket (AF_PACKET, SOCK_RAW, htons (ETH_P_ALL))) < 0)
     {
@@ -152,25 +170,148 @@ create_packet_v2_sock (int host_if_index, tpacket_req_t * rx_req,
       goto error;
     }
 
-  int opt = 1;
+  if (tx_req)
+    {
+      int opt = 1;
+      if ((err =
+	   setsockopt (*fd, SOL_PACKET, PACKET_LOSS, &opt, sizeof (opt))) < 0)
+	{
+	  DBG_SOCK ("Failed to set packet tx ring error handling option");
+	  ret = VNET_API_ERROR_SYSCALL_ERROR_1;
+	  goto error;
+	}
+
+      /* hand tx frames straight to the driver, the veth or the host
+         interface has nothing to gain from queueing them again */
+      if ((err = setsockopt (*fd, SOL_PACKET, PACKET_QDISC_BYPASS, &opt,
+			     sizeof (opt))) < 0)
+	DBG_SOCK ("Failed to set qdisc bypass, tx goes through the qdisc");
+    }
+
   if ((err =
-       setsockopt (*fd, SOL_PACKET, PACKET_LOSS, &opt, sizeof (opt))) < 0)
+       setsockopt (*fd, SOL_PACKET, PACKET_RX_RING, rx_req, req_sz)) < 0)
     {
-      DBG_SOCK ("Failed to set packet tx ring error handling option");
+      DBG_SOCK ("Failed to set packet rx ring options");
+      ret = VNET_API_ERROR_SYSCALL_ERROR_1;
+      goto error;
+    }
+
+  if (tx_req &&
+      (err = setsockopt (*fd, SOL_PACKET, PACKET_TX_RING, tx_req, req_sz)) < 0)
+    {
+      DBG_SOCK ("Failed to set packet tx ring options");
+      ret = VNET_API_ERROR_SYSCALL_ERROR_2;
+      goto error;
+    }
+
+  *ring =
+    mmap (NULL, ring_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, *fd,
+	  0);
+  if (*ring == MAP_FAILED)
+    {
+      DBG_SOCK ("mmap failure");
+      ret = VNET_API_ERROR_SYSCALL_ERROR_1;
+      goto error;
+    }
+
+  memset (&sll, 0, sizeof (sll));
+  sll.sll_family = PF_PACKET;
+  sll.sll_protocol = htons (ETH_P_ALL);
+  sll.sll_ifindex = host_if_index;
+
+  if ((err = bind (*fd, (struct sockaddr *) &sll, sizeof (sll))) < 0)
+    {
+      DBG_SOCK ("Failed to bind rx packet socket (error %d)", err);
+      ret = VNET_API_ERROR_SYSCALL_ERROR_1;
+      goto error;
+    }
+
+  if (fanout_id >= 0)
+    {
+      int fanout = (fanout_id & 0xffff) | (PACKET_FANOUT_HASH << 16);
+      if ((err = setsockopt (*fd, SOL_PACKET, PACKET_FANOUT, &fanout,
+			     sizeof (fanout))) < 0)
+	{
+	  DBG_SOCK ("Failed to join fanout group %d", fanout_id);
+	  ret = VNET_API_ERROR_SYSCALL_ERROR_1;
+	  goto error;
+	}
+    }
+
+  return 0;
+error:
+  if (*ring != MAP_FAILED)
+    munmap (*ring, ring_sz);
+  *ring = 0;
+  if (*fd >= 0)
+    close (*fd);
+  *fd = -1;
+  return ret;
+}
+
+/*
+ * Open a TPACKET_V2 socket with a tx ring only, bound to the host
+ * interface, for kernels whose TPACKET_V3 sockets have no tx ring. A
+ * filter that accepts nothing keeps it from queueing the packets it
+ * sees; the rx queues have their own sockets.
+ */
+static int
+create_packet_v2_tx_sock (int host_if_index, tpacket_req3_t * tx_req,
+			  int *fd, u8 ** ring)
+{
+  int ret, err;
+  struct sockaddr_ll sll;
+  int ver = TPACKET_V2;
+  int opt = 1;
+  u32 ring_sz = tx_req->tp_block_size * tx_req->tp_block_nr;
+  struct sock_filter drop_all[] = { BPF_STMT (BPF_RET | BPF_K, 0) };
+  struct sock_fprog fprog = {
+    .len = ARRAY_LEN (drop_all),
+    .filter = drop_all,
+  };
+
+  *ring = MAP_FAILED;
+
+  /* protocol 0 receives nothing until bound */
+  if ((*fd = socket (AF_PACKET, SOCK_RAW, 0)) < 0)
+    {
+      DBG_SOCK ("Failed to create tx socket");
+      ret = VNET_API_ERROR_SYSCALL_ERROR_1;
+      goto error;
+    }
+
+  if ((err = setsockopt (*fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog,
+			 sizeof (fprog))) < 0)
+    {
+      DBG_SOCK ("Failed to attach tx socket filter");
       ret = VNET_API_ERROR_SYSCALL_ERROR_1;
       goto error;
     }
 
   if ((err =
-       setsockopt (*fd, SOL_PACKET, PACKET_RX_RING, rx_req, req_sz)) < 0)
+       setsockopt (*fd, SOL_PACKET, PACKET_VERSION, &ver, sizeof (ver))) < 0)
     {
-      DBG_SOCK ("Failed to set packet rx ring options");
+      DBG_SOCK ("Failed to set tx packet interface version");
       ret = VNET_API_ERROR_SYSCALL_ERROR_1;
       goto error;
     }
 
   if ((err =
-       setsockopt (*fd, SOL_PACKET, PACKET_TX_RING, tx_req, req_sz)) < 0)
+       setsockopt (*fd, SOL_PACKET, PACKET_LOSS, &opt, sizeof (opt))) < 0)
+    {
+      DBG_SOCK ("Failed to set packet tx ring error handling option");
+      ret = VNET_API_ERROR_SYSCALL_ERROR_1;
+      goto error;
+    }
+
+  /* also keeps the packets sent from the taps of the rx queues */
+  if ((err = setsockopt (*fd, SOL_PACKET, PACKET_QDISC_BYPASS, &opt,
+			 sizeof (opt))) < 0)
+    clib_warning ("no qdisc bypass, the rx queues see the packets sent");
+
+  /* struct tpacket_req3 starts with the fields of struct tpacket_req */
+  if ((err = setsockopt (*fd, SOL_PACKET, PACKET_TX_RING, tx_req,
+			 sizeof (struct tpacket_req))) < 0)
     {
       DBG_SOCK ("Failed to set packet tx ring options");
       ret = VNET_API_ERROR_SYSCALL_ERROR_1;
@@ -194,29 +335,84 @@ create_packet_v2_sock (int host_if_index, tpacket_req_t * rx_req,
 
   if ((err = bind (*fd, (struct sockaddr *) &sll, sizeof (sll))) < 0)
     {
-      DBG_SOCK ("Failed to bind rx packet socket (error %d)", err);
+      DBG_SOCK ("Failed to bind tx packet socket (error %d)", err);
       ret = VNET_API_ERROR_SYSCALL_ERROR_1;
       goto error;
     }
 
   return 0;
 error:
+  if (*ring != MAP_FAILED)
+    munmap (*ring, ring_sz);
+  *ring = 0;
   if (*fd >= 0)
     close (*fd);
   *fd = -1;
   return ret;
 }
 
+static void
+af_packet_close_tx (af_packet_if_t * apif)
+{
+  u32 ring_sz;
+
+  /* on the socket of queue 0, gone with it */
+  if (apif->tx_tpacket_version != TPACKET_V2)
+    return;
+
+  ring_sz = apif->tx_req->tp_block_size * apif->tx_req->tp_block_nr;
+  if (apif->tx_ring && munmap (apif->tx_ring, ring_sz))
+    clib_warning ("Host interface %s could not free tx ring",
+		  apif->host_if_name);
+  if (apif->tx_fd >= 0)
+    close (apif->tx_fd);
+  apif->tx_ring = NULL;
+  apif->tx_fd = -1;
+}
+
+static void
+af_packet_close_rx_queues (af_packet_if_t * apif)
+{
+  af_packet_queue_t *rxq;
+  u32 ring_sz;
+
+  vec_foreach (rxq, apif->rx_queues)
+  {
+    if (rxq->clib_file_index != ~0)
+      {
+	clib_file_del (&file_main, file_main.file_pool + rxq->clib_file_index);
+	rxq->clib_file_index = ~0;
+      }
+    else if (rxq->fd >= 0)
+      close (rxq->fd);
+
+    if (rxq->rx_ring == 0)
+      continue;
+
+    ring_sz = apif->rx_req->tp_block_size * apif->rx_req->tp_block_nr;
+    if (rxq == apif->rx_queues && apif->tx_tpacket_version == TPACKET_V3)
+      ring_sz += apif->tx_req->tp_block_size * apif->tx_req->tp_block_nr;
+    if (munmap (rxq->rx_ring, ring_sz))
+      clib_warning ("Host interface %s could not free rx/tx ring",
+		    apif->host_if_name);
+    rxq->rx_ring = 0;
+    rxq->fd = -1;
+  }
+  vec_free (apif->rx_queues);
+  if (apif->tx_tpacket_version == TPACKET_V3)
+    apif->tx_ring = NULL;
+}
+
 int
 af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
-		     u32 * sw_if_index)
+		     u16 num_rx_queues, u32 * sw_if_index)
 {
   af_packet_main_t *apm = &af_packet_main;
-  int ret, fd = -1;
-  struct tpacket_req *rx_req = 0;
-  struct tpacket_req *tx_req = 0;
-  u8 *ring = 0;
+  int ret = 0, fanout_id = -1;
+  tpacket_req3_t *rx_req = 0;
+  tpacket_req3_t *tx_req = 0;
   af_packet_if_t *apif = 0;
+  af_packet_queue_t *rxq;
   u8 hw_addr[6];
   clib_error_t *error;
   vnet_sw_interface_t *sw;
@@ -225,8 +421,9 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
   vnet_main_t *vnm = vnet_get_main ();
   uword *p;
   uword if_index;
-  u8 *host_if_name_dup = vec_dup (host_if_name);
+  u8 *host_if_name_dup = 0;
   int host_if_index = -1;
+  u16 qid;
 
   p = mhash_get (&apm->if_index_by_host_if_name, host_if_name);
   if (p)
@@ -234,11 +431,23 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
       return VNET_API_ERROR_SUBIF_ALREADY_EXISTS;
     }
 
+  if (num_rx_queues == 0)
+    num_rx_queues = 1;
+
+  host_if_index = if_nametoindex ((const char *) host_if_name);
+
+  if (!host_if_index)
+    {
+      DBG_SOCK ("Wrong host interface name");
+      return VNET_API_ERROR_INVALID_INTERFACE;
+    }
+
   vec_validate (rx_req, 0);
   rx_req->tp_block_size = AF_PACKET_RX_BLOCK_SIZE;
   rx_req->tp_frame_size = AF_PACKET_RX_FRAME_SIZE;
   rx_req->tp_block_nr = AF_PACKET_RX_BLOCK_NR;
   rx_req->tp_frame_nr = AF_PACKET_RX_FRAME_NR;
+  rx_req->tp_retire_blk_tov = AF_PACKET_RX_BLOCK_TIMEOUT_MS;
 
   vec_validate (tx_req, 0);
   tx_req->tp_block_size = AF_PACKET_TX_BLOCK_SIZE;
@@ -246,18 +455,52 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
   tx_req->tp_block_nr = AF_PACKET_TX_BLOCK_NR;
   tx_req->tp_frame_nr = AF_PACKET_TX_FRAME_NR;
 
-  host_if_index = if_nametoindex ((const char *) host_if_name);
+  /* the group id is global to the network namespace */
+  if (num_rx_queues > 1)
+    fanout_id = (getpid () ^ (host_if_index << 4)) & 0xffff;
 
-  if (!host_if_index)
-    {
-      DBG_SOCK ("Wrong host interface name");
-      return VNET_API_ERROR_INVALID_INTERFACE;
-    }
+  pool_get (apm->interfaces, apif);
+  memset (apif, 0, sizeof (*apif));
+  if_index = apif - apm->interfaces;
+  apif->rx_req = rx_req;
+  apif->tx_req = tx_req;
+  apif->tx_fd = -1;
+  apif->tx_tpacket_version = TPACKET_V3;
 
-  ret = create_packet_v2_sock (host_if_index, rx_req, tx_req, &fd, &ring);
+  vec_validate_aligned (apif->rx_queues, num_rx_queues - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (rxq, apif->rx_queues)
+  {
+    rxq->fd = -1;
+    rxq->clib_file_index = ~0;
+  }
 
-  if (ret != 0)
-    goto error;
+  for (qid = 0; qid < num_rx_queues; qid++)
+    {
+      rxq = vec_elt_at_index (apif->rx_queues, qid);
+      ret = create_packet_v3_sock (host_if_index, rx_req,
+				   qid == 0 ? tx_req : 0, fanout_id,
+				   &rxq->fd, &rxq->rx_ring);
+      if (qid == 0 && ret == VNET_API_ERROR_SYSCALL_ERROR_2)
+	{
+	  clib_warning ("%s: no TPACKET_V3 tx ring (Linux < 4.11), "
+			"falling back to a TPACKET_V2 tx socket",
+			host_if_name);
+	  apif->tx_tpacket_version = TPACKET_V2;
+	  ret = create_packet_v3_sock (host_if_index, rx_req, 0, fanout_id,
+				       &rxq->fd, &rxq->rx_ring);
+	  if (ret == 0)
+	    ret = create_packet_v2_tx_sock (host_if_index, tx_req,
+					    &apif->tx_fd, &apif->tx_ring);
+	}
+      if (ret != 0)
+	{
+	  af_packet_close_tx (apif);
+	  af_packet_close_rx_queues (apif);
+	  pool_put (apm->interfaces, apif);
+	  goto error;
+	}
+    }
 
   ret = is_bridge (host_if_name);
 
@@ -265,32 +508,33 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
     host_if_index = -1;
 
   /* So far everything looks good, let's create interface */
-  pool_get (apm->interfaces, apif);
-  if_index = apif - apm->interfaces;
-
+  host_if_name_dup = vec_dup (host_if_name);
   apif->host_if_index = host_if_index;
-  apif->fd = fd;
-  apif->rx_ring = ring;
-  apif->tx_ring = ring + rx_req->tp_block_size * rx_req->tp_block_nr;
-  apif->rx_req = rx_req;
-  apif->tx_req = tx_req;
+  if (apif->tx_tpacket_version == TPACKET_V3)
+    {
+      apif->tx_fd = apif->rx_queues[0].fd;
+      apif->tx_ring = apif->rx_queues[0].rx_ring +
+	rx_req->tp_block_size * rx_req->tp_block_nr;
+    }
   apif->host_if_name = host_if_name_dup;
   apif->per_interface_next_index = ~0;
   apif->next_tx_frame = 0;
-  apif->next_rx_frame = 0;
 
   if (tm->n_vlib_mains > 1)
     clib_spinlock_init (&apif->lockp);
 
+  vec_foreach_index (qid, apif->rx_queues)
   {
     clib_file_t template = { 0 };
+    rxq = vec_elt_at_index (apif->rx_queues, qid);
     template.read_function = af_packet_fd_read_ready;
-    template.file_descriptor = fd;
-    template.private_data = if_index;
+    template.file_descriptor = rxq->fd;
+    template.private_data = (if_index << 16) | qid;
     template.flags = UNIX_FILE_EVENT_EDGE_TRIGGERED;
-    template.description = format (0, "%U", format_af_packet_device_name,
-				   if_index);
-    apif->clib_file_index = clib_file_add (&file_main, &template);
+    template.description = format (0, "%U rx %u",
+				   format_af_packet_device_name, if_index,
+				   qid);
+    rxq->clib_file_index = clib_file_add (&file_main, &template);
   }
 
   /*use configured or generate random MAC address */
@@ -314,6 +558,9 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
 
   if (error)
     {
+      af_packet_close_tx (apif);
+      af_packet_close_rx_queues (apif);
+      clib_spinlock_free (&apif->lockp);
       memset (apif, 0, sizeof (*apif));
       pool_put (apm->interfaces, apif);
       clib_error_report (error);
@@ -327,15 +574,18 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
   vnet_hw_interface_set_input_node (vnm, apif->hw_if_index,
 				    af_packet_input_node.index);
 
-  vnet_hw_interface_assign_rx_thread (vnm, apif->hw_if_index, 0,	/* queue */
-				      ~0 /* any cpu */ );
+  /* spread the queues over the workers */
+  vec_foreach_index (qid, apif->rx_queues)
+    vnet_hw_interface_assign_rx_thread (vnm, apif->hw_if_index, qid,
+					~0 /* any cpu */ );
 
   hw->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_INT_MODE;
   vnet_hw_interface_set_flags (vnm, apif->hw_if_index,
 			       VNET_HW_INTERFACE_FLAG_LINK_UP);
 
-  vnet_hw_interface_set_rx_mode (vnm, apif->hw_if_index, 0,
-				 VNET_HW_INTERFACE_RX_MODE_INTERRUPT);
+  vec_foreach_index (qid, apif->rx_queues)
+    vnet_hw_interface_set_rx_mode (vnm, apif->hw_if_index, qid,
+				   VNET_HW_INTERFACE_RX_MODE_INTERRUPT);
 
   mhash_set_mem (&apm->if_index_by_host_if_name, host_if_name_dup, &if_index,
 		 0);
@@ -359,7 +609,7 @@ af_packet_delete_if (vlib_main_t * vm, u8 * host_if_name)
   af_packet_if_t *apif;
   uword *p;
   uword if_index;
-  u32 ring_sz;
+  u16 qid;
 
   p = mhash_get (&apm->if_index_by_host_if_name, host_if_name);
   if (p == NULL)
@@ -372,25 +622,12 @@ af_packet_delete_if (vlib_main_t * vm, u8 * host_if_name)
 
   /* bring down the interface */
   vnet_hw_interface_set_flags (vnm, apif->hw_if_index, 0);
-  vnet_hw_interface_unassign_rx_thread (vnm, apif->hw_if_index, 0);
+  vec_foreach_index (qid, apif->rx_queues)
+    vnet_hw_interface_unassign_rx_thread (vnm, apif->hw_if_index, qid);
 
   /* clean up */
-  if (apif->clib_file_index != ~0)
-    {
-      clib_file_del (&file_main, file_main.file_pool + apif->clib_file_index);
-      apif->clib_file_index = ~0;
-    }
-  else
-    close (apif->fd);
-
-  ring_sz = apif->rx_req->tp_block_size * apif->rx_req->tp_block_nr +
-    apif->tx_req->tp_block_size * apif->tx_req->tp_block_nr;
-  if (munmap (apif->rx_ring, ring_sz))
-    clib_warning ("Host interface %s could not free rx/tx ring",
-		  host_if_name);
-  apif->rx_ring = NULL;
-  apif->tx_ring = NULL;
-  apif->fd = -1;
+  af_packet_close_tx (apif);
+  af_packet_close_rx_queues (apif);
 
   vec_free (apif->rx_req);
   apif->rx_req = NULL;
@@ -19,22 +19,39 @@
 
 #include <vppinfra/lock.h>
 
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  int fd;
+  u8 *rx_ring;
+  u32 clib_file_index;
+
+  /* TPACKET_V3: the block being read, the number of its packets not read
+     yet and the offset of the next one */
+  u32 next_rx_block;
+  u32 rx_pkts_left;
+  u32 rx_pkt_offset;
+} af_packet_queue_t;
+
 typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   clib_spinlock_t lockp;
   u8 *host_if_name;
   int host_if_index;
-  int fd;
-  struct tpacket_req *rx_req;
-  struct tpacket_req *tx_req;
-  u8 *rx_ring;
+  struct tpacket_req3 *rx_req;
+  struct tpacket_req3 *tx_req;
   u8 *tx_ring;
   u32 hw_if_index;
   u32 sw_if_index;
-  u32 clib_file_index;
 
-  u32 next_rx_frame;
+  /* one PACKET_FANOUT_HASH socket per rx queue; the tx ring is on the
+     socket of queue 0, or, on kernels before 4.11, which have no
+     TPACKET_V3 tx rings, a TPACKET_V2 ring on a socket of its own */
+  af_packet_queue_t *rx_queues;
+  int tx_fd;
+  int tx_tpacket_version;
+
   u32 next_tx_frame;
 
   u32 per_interface_next_index;
@@ -61,7 +78,8 @@ extern vnet_device_class_t af_packet_device_class;
 extern vlib_node_registration_t af_packet_input_node;
 
 int af_packet_create_if (vlib_main_t * vm, u8 * host_if_name,
-			 u8 * hw_addr_set, u32 * sw_if_index);
+			 u8 * hw_addr_set, u16 num_rx_queues,
+			 u32 * sw_if_index);
 int af_packet_delete_if (vlib_main_t * vm, u8 * host_if_name);
 int af_packet_set_l4_cksum_offload (vlib_main_t * vm, u32 sw_if_index,
 				    u8 set);
@@ -65,7 +65,18 @@ format_af_packet_device_name (u8 * s, va_list * args)
 static u8 *
 format_af_packet_device (u8 * s, va_list * args)
 {
+  u32 dev_instance = va_arg (*args, u32);
+  CLIB_UNUSED (int verbose) = va_arg (*args, int);
+  af_packet_main_t *apm = &af_packet_main;
+  af_packet_if_t *apif = pool_elt_at_index (apm->interfaces, dev_instance);
+  u32 indent = format_get_indent (s);
+
   s = format (s, "Linux PACKET socket interface");
+  s = format (s, "\n%UTPACKET_V3, %u rx queue%s", format_white_space,
+	      indent + 2, vec_len (apif->rx_queues),
+	      vec_len (apif->rx_queues) > 1 ? "s, fanout hash" : "");
+  if (apif->tx_tpacket_version == TPACKET_V2)
+    s = format (s, ", TPACKET_V2 tx socket");
   return s;
 }
 
@@ -94,7 +105,11 @@ af_packet_interface_tx (vlib_main_t * vm,
   u32 frame_num = apif->tx_req->tp_frame_nr;
   u8 *block_start = apif->tx_ring + block * block_size;
   u32 tx_frame = apif->next_tx_frame;
-  struct tpacket2_hdr *tph;
+  int is_v2 = apif->tx_tpacket_version == TPACKET_V2;
+  u32 hdr_len = is_v2 ? TPACKET_ALIGN (sizeof (struct tpacket2_hdr)) :
+    TPACKET_ALIGN (sizeof (struct tpacket3_hdr));
+  struct tpacket3_hdr *tph;
+  struct tpacket2_hdr *tph2;
   u32 frame_not_ready = 0;
 
   while (n_left > 0)
@@ -106,10 +121,11 @@ af_packet_interface_tx (vlib_main_t * vm,
       u32 bi = buffers[0];
       buffers++;
 
-      tph = (struct tpacket2_hdr *) (block_start + tx_frame * frame_size);
+      tph = (struct tpacket3_hdr *) (block_start + tx_frame * frame_size);
+      tph2 = (struct tpacket2_hdr *) tph;
 
-      if (PREDICT_FALSE
-	  (tph->tp_status & (TP_STATUS_SEND_REQUEST | TP_STATUS_SENDING)))
+      if (PREDICT_FALSE ((is_v2 ? tph2->tp_status : tph->tp_status) &
+			 (TP_STATUS_SEND_REQUEST | TP_STATUS_SENDING)))
 	{
 	  frame_not_ready++;
 	  goto next;
@@ -119,16 +135,25 @@ af_packet_interface_tx (vlib_main_t * vm,
 	{
 	  b0 = vlib_get_buffer (vm, bi);
 	  len = b0->current_length;
-	  clib_memcpy ((u8 *) tph +
-		       TPACKET_ALIGN (sizeof (struct tpacket2_hdr)) + offset,
+	  clib_memcpy ((u8 *) tph + hdr_len + offset,
 		       vlib_buffer_get_current (b0), len);
 	  offset += len;
 	}
       while ((bi =
 	      (b0->flags & VLIB_BUFFER_NEXT_PRESENT) ? b0->next_buffer : 0));
 
-      tph->tp_len = tph->tp_snaplen = offset;
-      tph->tp_status = TP_STATUS_SEND_REQUEST;
+      if (is_v2)
+	{
+	  tph2->tp_len = tph2->tp_snaplen = offset;
+	  tph2->tp_status = TP_STATUS_SEND_REQUEST;
+	}
+      else
+	{
+	  tph->tp_len = tph->tp_snaplen = offset;
+	  /* TPACKET_V3 tx frames are fixed size, no offset to the next one */
+	  tph->tp_next_offset = 0;
+	  tph->tp_status = TP_STATUS_SEND_REQUEST;
+	}
       n_sent++;
     next:
       tx_frame = (tx_frame + 1) % frame_num;
@@ -144,7 +169,7 @@ af_packet_interface_tx (vlib_main_t * vm,
     {
       apif->next_tx_frame = tx_frame;
 
-      if (PREDICT_FALSE (sendto (apif->fd, NULL, 0,
+      if (PREDICT_FALSE (sendto (apif->tx_fd, NULL, 0,
 				 MSG_DONTWAIT, NULL, 0) == -1))
 	{
 	  /* Uh-oh, drop & move on, but count whether it was fatal or not.
@@ -50,8 +50,9 @@ typedef struct
 {
   u32 next_index;
   u32 hw_if_index;
-  int block;
-  struct tpacket2_hdr tph;
+  u16 queue_id;
+  u32 block;
+  struct tpacket3_hdr tph;
 } af_packet_input_trace_t;
 
 static u8 *
@@ -62,18 +63,18 @@ format_af_packet_input_trace (u8 * s, va_list * args)
   af_packet_input_trace_t *t = va_arg (*args, af_packet_input_trace_t *);
   u32 indent = format_get_indent (s);
 
-  s = format (s, "af_packet: hw_if_index %d next-index %d",
-	      t->hw_if_index, t->next_index);
+  s = format (s, "af_packet: hw_if_index %d queue %u next-index %d",
+	      t->hw_if_index, t->queue_id, t->next_index);
 
   s =
     format (s,
-	    "\n%Utpacket2_hdr:\n%Ustatus 0x%x len %u snaplen %u mac %u net %u"
-	    "\n%Usec 0x%x nsec 0x%x vlan %U"
+	    "\n%Utpacket3_hdr (block %u):\n%Ustatus 0x%x len %u snaplen %u "
+	    "mac %u net %u\n%Usec 0x%x nsec 0x%x vlan %U"
 #ifdef TP_STATUS_VLAN_TPID_VALID
 	    " vlan_tpid %u"
 #endif
 	    ,
-	    format_white_space, indent + 2,
+	    format_white_space, indent + 2, t->block,
 	    format_white_space, indent + 4,
 	    t->tph.tp_status,
 	    t->tph.tp_len,
@@ -82,9 +83,9 @@ format_af_packet_input_trace (u8 * s, va_list * args)
 	    t->tph.tp_net,
 	    format_white_space, indent + 4,
 	    t->tph.tp_sec,
-	    t->tph.tp_nsec, format_ethernet_vlan_tci, t->tph.tp_vlan_tci
+	    t->tph.tp_nsec, format_ethernet_vlan_tci, t->tph.hv1.tp_vlan_tci
 #ifdef TP_STATUS_VLAN_TPID_VALID
-	    , t->tph.tp_vlan_tpid
+	    , t->tph.hv1.tp_vlan_tpid
 #endif
     );
   return s;
@@ -173,23 +174,31 @@ mark_tcp_udp_cksum_calc (vlib_buffer_t * b)
     }
 }
 
+/*
+ * TPACKET_V3: the kernel fills whole blocks of packets and hands each
+ * block over with one status word, which is given back once every packet
+ * in it has been read. A block may be left half read when the frame or
+ * the buffers run out; the queue keeps the place for the next call.
+ */
 always_inline uword
 af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
-			   vlib_frame_t * frame, af_packet_if_t * apif)
+			   vlib_frame_t * frame, af_packet_if_t * apif,
+			   u16 queue_id)
 {
   af_packet_main_t *apm = &af_packet_main;
-  struct tpacket2_hdr *tph;
+  af_packet_queue_t *rxq = vec_elt_at_index (apif->rx_queues, queue_id);
+  struct tpacket_block_desc *bd;
+  struct tpacket3_hdr *tph;
   u32 next_index = VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
-  u32 block = 0;
-  u32 rx_frame;
+  u32 block = rxq->next_rx_block;
+  u32 n_pkts_left = rxq->rx_pkts_left;
+  u32 pkt_offset = rxq->rx_pkt_offset;
   u32 n_free_bufs;
   u32 n_rx_packets = 0;
   u32 n_rx_bytes = 0;
   u32 *to_next = 0;
   u32 block_size = apif->rx_req->tp_block_size;
-  u32 frame_size = apif->rx_req->tp_frame_size;
-  u32 frame_num = apif->rx_req->tp_frame_nr;
-  u8 *block_start = apif->rx_ring + block * block_size;
+  u32 block_nr = apif->rx_req->tp_block_nr;
   uword n_trace = vlib_get_trace_count (vm, node);
   u32 thread_index = vlib_get_thread_index ();
   u32 n_buffer_bytes = vlib_buffer_free_list_buffer_size (vm,
@@ -210,22 +219,33 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
       _vec_len (apm->rx_buffers[thread_index]) = n_free_bufs;
     }
 
-  rx_frame = apif->next_rx_frame;
-  tph = (struct tpacket2_hdr *) (block_start + rx_frame * frame_size);
-  while ((tph->tp_status & TP_STATUS_USER) && (n_free_bufs > min_bufs))
+  bd = (struct tpacket_block_desc *) (rxq->rx_ring + block * block_size);
+  while ((n_pkts_left || (bd->hdr.bh1.block_status & TP_STATUS_USER)) &&
+	 (n_free_bufs > min_bufs))
     {
       vlib_buffer_t *b0 = 0, *first_b0 = 0;
       u32 next0 = next_index;
 
       u32 n_left_to_next;
       vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
-      while ((tph->tp_status & TP_STATUS_USER) && (n_free_bufs > min_bufs) &&
-	     n_left_to_next)
+      while ((n_free_bufs > min_bufs) && n_left_to_next)
 	{
-	  u32 data_len = tph->tp_snaplen;
-	  u32 offset = 0;
+	  u32 data_len, offset = 0;
 	  u32 bi0 = 0, first_bi0 = 0, prev_bi0;
 
+	  if (n_pkts_left == 0)
+	    {
+	      if ((bd->hdr.bh1.block_status & TP_STATUS_USER) == 0)
+		break;
+	      n_pkts_left = bd->hdr.bh1.num_pkts;
+	      pkt_offset = bd->hdr.bh1.offset_to_first_pkt;
+	      if (PREDICT_FALSE (n_pkts_left == 0))
+		goto next_block;
+	    }
+
+	  tph = (struct tpacket3_hdr *) ((u8 *) bd + pkt_offset);
+	  data_len = tph->tp_snaplen;
+
 	  while (data_len)
 	    {
 	      /* grab free buffer */
@@ -255,7 +275,7 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 		      ethernet_vlan_header_t *vlan =
 			(ethernet_vlan_header_t *) (eth + 1);
 		      vlan->priority_cfi_and_id =
-			clib_host_to_net_u16 (tph->tp_vlan_tci);
+			clib_host_to_net_u16 (tph->hv1.tp_vlan_tci);
 		      vlan->type = eth->type;
 		      eth->type = clib_host_to_net_u16 (ETHERNET_TYPE_VLAN);
 		      vlan_len = sizeof (ethernet_vlan_header_t);
@@ -319,7 +339,9 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 	      tr = vlib_add_trace (vm, node, first_b0, sizeof (*tr));
 	      tr->next_index = next0;
 	      tr->hw_if_index = apif->hw_if_index;
-	      clib_memcpy (&tr->tph, tph, sizeof (struct tpacket2_hdr));
+	      tr->queue_id = queue_id;
+	      tr->block = block;
+	      clib_memcpy (&tr->tph, tph, sizeof (struct tpacket3_hdr));
 	    }
 
 	  /* enque and take next packet */
@@ -327,15 +349,24 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 					   n_left_to_next, first_bi0, next0);
 
 	  /* next packet */
-	  tph->tp_status = TP_STATUS_KERNEL;
-	  rx_frame = (rx_frame + 1) % frame_num;
-	  tph = (struct tpacket2_hdr *) (block_start + rx_frame * frame_size);
+	  pkt_offset += tph->tp_next_offset;
+	  if (--n_pkts_left)
+	    continue;
+
+	next_block:
+	  /* all read, give the block back */
+	  bd->hdr.bh1.block_status = TP_STATUS_KERNEL;
+	  block = (block + 1) % block_nr;
+	  bd = (struct tpacket_block_desc *) (rxq->rx_ring +
+					      block * block_size);
 	}
 
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
 
-  apif->next_rx_frame = rx_frame;
+  rxq->next_rx_block = block;
+  rxq->rx_pkts_left = n_pkts_left;
+  rxq->rx_pkt_offset = pkt_offset;
 
   vlib_increment_combined_counter
     (vnet_get_main ()->interface_main.combined_sw_if_counters
@@ -360,7 +391,8 @@ af_packet_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
     af_packet_if_t *apif;
     apif = vec_elt_at_index (apm->interfaces, dq->dev_instance);
     if (apif->is_admin_up)
-      n_rx_packets += af_packet_device_input_fn (vm, node, frame, apif);
+      n_rx_packets += af_packet_device_input_fn (vm, node, frame, apif,
+						 dq->queue_id);
   }
 
   return n_rx_packets;
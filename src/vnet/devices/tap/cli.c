@@ -37,6 +37,7 @@ tap_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
   unformat_input_t _line_input, *line_input = &_line_input;
   tap_create_if_args_t args = { 0 };
   int ip_addr_set = 0;
+  u32 num_rx_queues;
 
   args.id = ~0;
 
@@ -75,6 +76,10 @@ tap_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
 	    ;
 	  else if (unformat (line_input, "tx-ring-size %d", &args.tx_ring_sz))
 	    ;
+	  else if (unformat (line_input, "num-rx-queues %u", &num_rx_queues))
+	    args.num_rx_queues = num_rx_queues;
+	  else if (unformat (line_input, "gso"))
+	    args.enable_gso = 1;
 	  else if (unformat (line_input, "hw-addr %U",
 			     unformat_ethernet_address, args.mac_addr))
 	    args.mac_addr_set = 1;
@@ -106,10 +111,11 @@ tap_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
 VLIB_CLI_COMMAND (tap_create_command, static) = {
   .path = "create tap",
   .short_help = "create tap {id <if-id>} [hw-addr <mac-address>] "
-    "[rx-ring-size <size>] [tx-ring-size <size>] [host-ns <netns>] "
-    "[host-bridge <bridge-name>] [host-ip4-addr <ip4addr/mask>] "
-    "[host-ip6-addr <ip6-addr>] [host-ip4-gw <ip4-addr>] "
-    "[host-ip6-gw <ip6-addr>] [host-if-name <name>]",
+    "[rx-ring-size <size>] [tx-ring-size <size>] [num-rx-queues <n>] "
+    "[gso] [host-ns <netns>] [host-bridge <bridge-name>] "
+    "[host-ip4-addr <ip4addr/mask>] [host-ip6-addr <ip6-addr>] "
+    "[host-ip4-gw <ip4-addr>] [host-ip6-gw <ip6-addr>] "
+    "[host-if-name <name>]",
   .function = tap_create_command_fn,
 };
 /* *INDENT-ON* */
@@ -240,8 +246,12 @@ tap_show_command_fn (vlib_main_t * vm, unformat_input_t * input,
 			     flag_entry->bit);
 	  flag_entry++;
 	}
-      vlib_cli_output (vm, "  fd %d", vif->fd);
-      vlib_cli_output (vm, "  tap-fd %d", vif->tap_fd);
+      vlib_cli_output (vm, "  queue pairs %u", vif->num_queue_pairs);
+      vec_foreach_index (i, vif->vhost_fds)
+      {
+	vlib_cli_output (vm, "    qid %d: fd %d, tap-fd %d", i,
+			 vif->vhost_fds[i], vif->tap_fds[i]);
+      }
       vlib_cli_output (vm, "  features 0x%lx", vif->features);
       feat_entry = (struct feat_struct *) &feat_array;
       while (feat_entry->str)
@@ -264,7 +274,8 @@ tap_show_command_fn (vlib_main_t * vm, unformat_input_t * input,
       {
 	// RX = 0, TX = 1
 	vring = vec_elt_at_index (vif->vrings, i);
-	vlib_cli_output (vm, "  Virtqueue (%s)", (i & 1) ? "TX" : "RX");
+	vlib_cli_output (vm, "  Virtqueue %d (%s)", i >> 1,
+			 (i & 1) ? "TX" : "RX");
 	vlib_cli_output (vm, "    qsz %d, last_used_idx %d, desc_in_use %d",
 			 vring->size, vring->last_used_idx,
 			 vring->desc_in_use);
@@ -281,7 +292,6 @@ tap_show_command_fn (vlib_main_t * vm, unformat_input_t * input,
 			     "   id          addr         len  flags  next      user_addr\n");
 	    vlib_cli_output (vm,
 			     "  ===== ================== ===== ====== ===== ==================\n");
-	    vring = vif->vrings;
 	    for (j = 0; j < vring->size; j++)
 	      {
 		struct vring_desc *desc = &vring->desc[j];
@@ -75,6 +75,24 @@ open_netns_fd (char *netns)
   return fd;
 }
 
+static void
+tap_close_fds (virtio_if_t * vif)
+{
+  int i;
+
+  vec_foreach_index (i, vif->tap_fds)
+  {
+    if (vif->tap_fds[i] != -1)
+      close (vif->tap_fds[i]);
+  }
+  vec_foreach_index (i, vif->vhost_fds)
+  {
+    if (vif->vhost_fds[i] != -1)
+      close (vif->vhost_fds[i]);
+  }
+  vec_free (vif->tap_fds);
+  vec_free (vif->vhost_fds);
+}
 
 void
 tap_create_if (vlib_main_t * vm, tap_create_if_args_t * args)
@@ -92,8 +110,18 @@ tap_create_if (vlib_main_t * vm, tap_create_if_args_t * args)
   struct vhost_memory *vhost_mem = 0;
   virtio_if_t *vif = 0;
   clib_error_t *err = 0;
+  u16 num_qp = args->num_rx_queues ? args->num_rx_queues : 1;
+  u16 qid;
   uword *p;
 
+  if (num_qp > TAP_MAX_QUEUE_PAIRS)
+    {
+      args->rv = VNET_API_ERROR_INVALID_ARGUMENT;
+      args->error = clib_error_return (0, "number of rx queues must be %u "
+				       "or lower", TAP_MAX_QUEUE_PAIRS);
+      return;
+    }
+
   if (args->id != ~0)
     {
       p = hash_get (tm->dev_instance_by_interface_id, args->id);
@@ -127,17 +155,22 @@ tap_create_if (vlib_main_t * vm, tap_create_if_args_t * args)
   memset (&ifr, 0, sizeof (ifr));
   pool_get (vim->interfaces, vif);
   vif->dev_instance = vif - vim->interfaces;
-  vif->tap_fd = -1;
   vif->id = args->id;
+  vif->num_queue_pairs = num_qp;
+  vec_validate_init_empty (vif->vhost_fds, num_qp - 1, -1);
+  vec_validate_init_empty (vif->tap_fds, num_qp - 1, -1);
+
+  /* vhost-net serves one rx/tx vring pair per device, so one per queue */
+  for (qid = 0; qid < num_qp; qid++)
+    if ((vif->vhost_fds[qid] = open ("/dev/vhost-net",
+				     O_RDWR | O_NONBLOCK)) < 0)
+      {
+	args->rv = VNET_API_ERROR_SYSCALL_ERROR_1;
+	args->error = clib_error_return_unix (0, "open '/dev/vhost-net'");
+	goto error;
+      }
 
-  if ((vif->fd = open ("/dev/vhost-net", O_RDWR | O_NONBLOCK)) < 0)
-    {
-      args->rv = VNET_API_ERROR_SYSCALL_ERROR_1;
-      args->error = clib_error_return_unix (0, "open '/dev/vhost-net'");
-      goto error;
-    }
-
-  _IOCTL (vif->fd, VHOST_GET_FEATURES, &vif->remote_features);
+  _IOCTL (vif->vhost_fds[0], VHOST_GET_FEATURES, &vif->remote_features);
 
   if ((vif->remote_features & (1ULL << VIRTIO_NET_F_MRG_RXBUF)) == 0)
     {
@@ -167,24 +200,38 @@ tap_create_if (vlib_main_t * vm, tap_create_if_args_t * args)
   vif->features |= 1ULL << VIRTIO_F_VERSION_1;
   vif->features |= 1ULL << VIRTIO_RING_F_INDIRECT_DESC;
 
-  _IOCTL (vif->fd, VHOST_SET_FEATURES, &vif->features);
+  for (qid = 0; qid < num_qp; qid++)
+    _IOCTL (vif->vhost_fds[qid], VHOST_SET_FEATURES, &vif->features);
+
+  ifr.ifr_flags = IFF_TAP | IFF_NO_PI | IFF_ONE_QUEUE | IFF_VNET_HDR;
+  if (num_qp > 1)
+    ifr.ifr_flags |= IFF_MULTI_QUEUE;
 
-  if ((vif->tap_fd = open ("/dev/net/tun", O_RDWR | O_NONBLOCK)) < 0)
+  /* the first TUNSETIFF creates the tap, the others attach queues to it */
+  for (qid = 0; qid < num_qp; qid++)
     {
-      args->rv = VNET_API_ERROR_SYSCALL_ERROR_2;
-      args->error = clib_error_return_unix (0, "open '/dev/net/tun'");
-      goto error;
+      if ((vif->tap_fds[qid] = open ("/dev/net/tun", O_RDWR | O_NONBLOCK)) < 0)
+	{
+	  args->rv = VNET_API_ERROR_SYSCALL_ERROR_2;
+	  args->error = clib_error_return_unix (0, "open '/dev/net/tun'");
+	  goto error;
+	}
+      _IOCTL (vif->tap_fds[qid], TUNSETIFF, (void *) &ifr);
     }
-
-  ifr.ifr_flags = IFF_TAP | IFF_NO_PI | IFF_ONE_QUEUE | IFF_VNET_HDR;
-  _IOCTL (vif->tap_fd, TUNSETIFF, (void *) &ifr);
   vif->ifindex = if_nametoindex (ifr.ifr_ifrn.ifrn_name);
 
+  /*
+   * The offloads are those the kernel may leave to us in the packets it
+   * sends; it takes any in the packets we send.
+   */
   unsigned int offload = 0;
+  if (args->enable_gso)
+    offload = TUN_F_CSUM | TUN_F_TSO4 | TUN_F_TSO6;
   hdrsz = sizeof (struct virtio_net_hdr_v1);
-  _IOCTL (vif->tap_fd, TUNSETOFFLOAD, offload);
-  _IOCTL (vif->tap_fd, TUNSETVNETHDRSZ, &hdrsz);
-  _IOCTL (vif->fd, VHOST_SET_OWNER, 0);
+  _IOCTL (vif->tap_fds[0], TUNSETOFFLOAD, offload);
+  _IOCTL (vif->tap_fds[0], TUNSETVNETHDRSZ, &hdrsz);
+  for (qid = 0; qid < num_qp; qid++)
+    _IOCTL (vif->vhost_fds[qid], VHOST_SET_OWNER, 0);
 
   /* if namespace is specified, all further netlink messages should be excuted
      after we change our net namespace */
@@ -329,18 +376,28 @@ tap_create_if (vlib_main_t * vm, tap_create_if_args_t * args)
   memset (vhost_mem, 0, i);
   vhost_mem->nregions = 1;
   vhost_mem->regions[0].memory_size = (1ULL << 47) - 4096;
-  _IOCTL (vif->fd, VHOST_SET_MEM_TABLE, vhost_mem);
+  for (qid = 0; qid < num_qp; qid++)
+    _IOCTL (vif->vhost_fds[qid], VHOST_SET_MEM_TABLE, vhost_mem);
 
-  if ((args->error = virtio_vring_init (vm, vif, 0, args->rx_ring_sz)))
+  for (qid = 0; qid < num_qp; qid++)
     {
-      args->rv = VNET_API_ERROR_INIT_FAILED;
-      goto error;
-    }
+      if ((args->error = virtio_vring_init (vm, vif, VIRTIO_RX_VRING (qid),
+					    args->rx_ring_sz)))
+	{
+	  args->rv = VNET_API_ERROR_INIT_FAILED;
+	  goto error;
+	}
 
-  if ((args->error = virtio_vring_init (vm, vif, 1, args->tx_ring_sz)))
-    {
-      args->rv = VNET_API_ERROR_INIT_FAILED;
-      goto error;
+      if ((args->error = virtio_vring_init (vm, vif, VIRTIO_TX_VRING (qid),
+					    args->tx_ring_sz)))
+	{
+	  args->rv = VNET_API_ERROR_INIT_FAILED;
+	  goto error;
+	}
+
+      /* threads beyond the queues share them, see virtio_interface_tx */
+      if (thm->n_vlib_mains > num_qp)
+	clib_spinlock_init (&vif->vrings[VIRTIO_TX_VRING (qid)].lockp);
     }
 
   if (!args->mac_addr_set)
@@ -388,18 +445,25 @@ tap_create_if (vlib_main_t * vm, tap_create_if_args_t * args)
   args->sw_if_index = vif->sw_if_index;
   hw = vnet_get_hw_interface (vnm, vif->hw_if_index);
   hw->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_INT_MODE;
+  if (args->enable_gso)
+    {
+      hw->flags |= (VNET_HW_INTERFACE_FLAG_SUPPORTS_TX_L4_CKSUM_OFFLOAD |
+		    VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO);
+      vif->flags |= VIRTIO_IF_FLAG_GSO;
+    }
   vnet_hw_interface_set_input_node (vnm, vif->hw_if_index,
 				    virtio_input_node.index);
-  vnet_hw_interface_assign_rx_thread (vnm, vif->hw_if_index, 0, ~0);
-  vnet_hw_interface_set_rx_mode (vnm, vif->hw_if_index, 0,
-				 VNET_HW_INTERFACE_RX_MODE_DEFAULT);
+  for (qid = 0; qid < num_qp; qid++)
+    {
+      vnet_hw_interface_assign_rx_thread (vnm, vif->hw_if_index, qid, ~0);
+      vnet_hw_interface_set_rx_mode (vnm, vif->hw_if_index, qid,
+				     VNET_HW_INTERFACE_RX_MODE_DEFAULT);
+    }
   vif->per_interface_next_index = ~0;
   vif->type = VIRTIO_IF_TYPE_TAP;
   vif->flags |= VIRTIO_IF_FLAG_ADMIN_UP;
   vnet_hw_interface_set_flags (vnm, vif->hw_if_index,
 			       VNET_HW_INTERFACE_FLAG_LINK_UP);
-  if (thm->n_vlib_mains > 1)
-    clib_spinlock_init (&vif->lockp);
   goto done;
 
 error:
@@ -409,11 +473,9 @@ error:
       args->error = err;
       args->rv = VNET_API_ERROR_SYSCALL_ERROR_3;
     }
-  if (vif->tap_fd != -1)
-    close (vif->tap_fd);
-  if (vif->fd != -1)
-    close (vif->fd);
+  tap_close_fds (vif);
   vec_foreach_index (i, vif->vrings) virtio_vring_free (vm, vif, i);
+  vec_free (vif->vrings);
   memset (vif, 0, sizeof (virtio_if_t));
   pool_put (vim->interfaces, vif);
 
@@ -433,6 +495,7 @@ tap_delete_if (vlib_main_t * vm, u32 sw_if_index)
   int i;
   virtio_if_t *vif;
   vnet_hw_interface_t *hw;
+  u16 qid;
 
   hw = vnet_get_sup_hw_interface (vnm, sw_if_index);
   if (hw == NULL || virtio_device_class.index != hw->dev_class_index)
@@ -443,21 +506,18 @@ tap_delete_if (vlib_main_t * vm, u32 sw_if_index)
   /* bring down the interface */
   vnet_hw_interface_set_flags (vnm, vif->hw_if_index, 0);
   vnet_sw_interface_set_flags (vnm, vif->sw_if_index, 0);
-  vnet_hw_interface_unassign_rx_thread (vnm, vif->hw_if_index, 0);
+  for (qid = 0; qid < vif->num_queue_pairs; qid++)
+    vnet_hw_interface_unassign_rx_thread (vnm, vif->hw_if_index, qid);
 
   ethernet_delete_interface (vnm, vif->hw_if_index);
   vif->hw_if_index = ~0;
 
-  if (vif->tap_fd != -1)
-    close (vif->tap_fd);
-  if (vif->fd != -1)
-    close (vif->fd);
+  tap_close_fds (vif);
 
   vec_foreach_index (i, vif->vrings) virtio_vring_free (vm, vif, i);
   vec_free (vif->vrings);
 
   hash_unset (tm->dev_instance_by_interface_id, vif->id);
-  clib_spinlock_free (&vif->lockp);
   memset (vif, 0, sizeof (*vif));
   pool_put (mm->interfaces, vif);
 
@@ -486,6 +546,8 @@ tap_dump_ifs (tap_interface_details_t ** out_tapids)
                      strlen ((const char *) hi->name)));
     tapid->rx_ring_sz = vif->rx_ring_sz;
     tapid->tx_ring_sz = vif->tx_ring_sz;
+    tapid->num_rx_queues = vif->num_queue_pairs;
+    tapid->gso_enabled = (vif->flags & VIRTIO_IF_FLAG_GSO) != 0;
     clib_memcpy(tapid->host_mac_addr, vif->host_mac_addr, 6);
     if (vif->host_if_name)
       {
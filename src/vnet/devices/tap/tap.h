@@ -29,6 +29,10 @@ typedef struct
   u8 mac_addr[6];
   u16 rx_ring_sz;
   u16 tx_ring_sz;
+  /* queue pairs, to spread over the threads; 0 means 1 */
+  u16 num_rx_queues;
+  /* negotiate checksum and TCP segmentation offloads with the kernel */
+  u8 enable_gso;
   u8 *host_namespace;
   u8 *host_if_name;
   u8 host_mac_addr[6];
@@ -55,6 +59,8 @@ typedef struct
   u8 dev_name[64];
   u16 tx_ring_sz;
   u16 rx_ring_sz;
+  u16 num_rx_queues;
+  u8 gso_enabled;
   u8 host_mac_addr[6];
   u8 host_if_name[64];
   u8 host_namespace[64];
@@ -65,6 +71,9 @@ typedef struct
   u8 host_ip6_prefix_len;
 } tap_interface_details_t;
 
+/* The kernel's limit on the queues of a tap, MAX_TAP_QUEUES */
+#define TAP_MAX_QUEUE_PAIRS 256
+
 typedef struct
 {
   u32 last_used_interface_id;
@@ -67,6 +67,8 @@ vl_api_tap_create_v2_t_handler (vl_api_tap_create_v2_t * mp)
     }
   ap->rx_ring_sz = ntohs (mp->rx_ring_sz);
   ap->tx_ring_sz = ntohs (mp->tx_ring_sz);
+  ap->num_rx_queues = ntohs (mp->num_rx_queues);
+  ap->enable_gso = mp->enable_gso;
   ap->sw_if_index = (u32) ~ 0;
 
   if (mp->host_if_name_set)
@@ -184,6 +186,8 @@ tap_send_sw_interface_details (vpe_api_main_t * am,
 		    strlen ((const char *) tap_if->dev_name)));
   mp->rx_ring_sz = htons (tap_if->rx_ring_sz);
   mp->tx_ring_sz = htons (tap_if->tx_ring_sz);
+  mp->num_rx_queues = htons (tap_if->num_rx_queues);
+  mp->gso_enabled = tap_if->gso_enabled;
   clib_memcpy (mp->host_mac_addr, tap_if->host_mac_addr, 6);
   clib_memcpy (mp->host_if_name, tap_if->host_if_name,
 	       MIN (ARRAY_LEN (mp->host_if_name) - 1,
@@ -24,8 +24,7 @@
 #include <vlib/vlib.h>
 #include <vlib/unix/unix.h>
 #include <vnet/ethernet/ethernet.h>
-#include <vnet/ip/ip4_packet.h>
-#include <vnet/ip/ip6_packet.h>
+#include <vnet/ip/ip.h>
 #include <vnet/devices/virtio/virtio.h>
 
 #define foreach_virtio_tx_func_error	       \
@@ -121,9 +120,69 @@ virtio_free_used_desc (vlib_main_t * vm, virtio_vring_t * vring)
   vring->last_used_idx = last;
 }
 
+/*
+ * Fill in the virtio header of a packet with offloads for the kernel to
+ * complete: the L4 checksum, of which the kernel expects the field to
+ * hold the pseudo-header sum, and the segmentation.
+ */
+static void
+virtio_tx_offload (vlib_main_t * vm, vlib_buffer_t * b,
+		   struct virtio_net_hdr_v1 *hdr)
+{
+  u16 l4_offset = vnet_buffer (b)->l4_hdr_offset - b->current_data;
+  void *l3 = b->data + vnet_buffer (b)->l3_hdr_offset;
+  void *l4 = b->data + vnet_buffer (b)->l4_hdr_offset;
+  u32 l4_len = vlib_buffer_length_in_chain (vm, b) - l4_offset;
+  u8 proto;
+  ip_csum_t sum;
+  u16 *csum;
+
+  if (b->flags & VNET_BUFFER_F_OFFLOAD_TCP_CKSUM)
+    {
+      proto = IP_PROTOCOL_TCP;
+      csum = &((tcp_header_t *) l4)->checksum;
+      hdr->csum_offset = STRUCT_OFFSET_OF (tcp_header_t, checksum);
+    }
+  else
+    {
+      proto = IP_PROTOCOL_UDP;
+      csum = &((udp_header_t *) l4)->checksum;
+      hdr->csum_offset = STRUCT_OFFSET_OF (udp_header_t, checksum);
+    }
+
+  sum = clib_host_to_net_u32 (l4_len + (proto << 16));
+  if (b->flags & VNET_BUFFER_F_IS_IP4)
+    {
+      ip4_header_t *ip4 = l3;
+      if (b->flags & VNET_BUFFER_F_OFFLOAD_IP_CKSUM)
+	ip4->checksum = ip4_header_checksum (ip4);
+      sum = ip_incremental_checksum (sum, &ip4->src_address,
+				     2 * sizeof (ip4_address_t));
+    }
+  else
+    {
+      ip6_header_t *ip6 = l3;
+      sum = ip_incremental_checksum (sum, &ip6->src_address,
+				     2 * sizeof (ip6_address_t));
+    }
+  *csum = ip_csum_fold (sum);
+
+  hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+  hdr->csum_start = l4_offset;
+
+  if (b->flags & VNET_BUFFER_F_GSO)
+    {
+      hdr->gso_type = (b->flags & VNET_BUFFER_F_IS_IP4) ?
+	VIRTIO_NET_HDR_GSO_TCPV4 : VIRTIO_NET_HDR_GSO_TCPV6;
+      hdr->gso_size = vnet_buffer2 (b)->gso_size;
+      hdr->hdr_len = l4_offset + vnet_buffer2 (b)->gso_l4_hdr_sz;
+    }
+}
+
 static_always_inline u16
-add_buffer_to_slot (vlib_main_t * vm, virtio_vring_t * vring, u32 bi,
-		    u16 avail, u16 next, u16 mask)
+add_buffer_to_slot (vlib_main_t * vm, virtio_if_t * vif,
+		    virtio_vring_t * vring, u32 bi, u16 avail, u16 next,
+		    u16 mask)
 {
   u16 n_added = 0;
   const int hdr_sz = sizeof (struct virtio_net_hdr_v1);
@@ -134,6 +193,11 @@ add_buffer_to_slot (vlib_main_t * vm, virtio_vring_t * vring, u32 bi,
 
   memset (hdr, 0, hdr_sz);
 
+  if (PREDICT_FALSE ((vif->flags & VIRTIO_IF_FLAG_GSO) &&
+		     (b->flags & (VNET_BUFFER_F_OFFLOAD_TCP_CKSUM |
+				  VNET_BUFFER_F_OFFLOAD_UDP_CKSUM))))
+    virtio_tx_offload (vm, b, hdr);
+
   if (PREDICT_TRUE ((b->flags & VLIB_BUFFER_NEXT_PRESENT) == 0))
     {
       d->addr = pointer_to_uword (vlib_buffer_get_current (b)) - hdr_sz;
@@ -174,15 +238,16 @@ static_always_inline uword
 virtio_interface_tx_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			    vlib_frame_t * frame, virtio_if_t * vif)
 {
-  u8 qid = 0;
+  u16 qid = vm->thread_index % vif->num_queue_pairs;
   u16 n_left = frame->n_vectors;
-  virtio_vring_t *vring = vec_elt_at_index (vif->vrings, (qid << 1) + 1);
+  virtio_vring_t *vring = vec_elt_at_index (vif->vrings,
+					     VIRTIO_TX_VRING (qid));
   u16 used, next, avail;
   u16 sz = vring->size;
   u16 mask = sz - 1;
   u32 *buffers = vlib_frame_args (frame);
 
-  clib_spinlock_lock_if_init (&vif->lockp);
+  clib_spinlock_lock_if_init (&vring->lockp);
 
   /* free consumed buffers */
   virtio_free_used_desc (vm, vring);
@@ -194,7 +259,8 @@ virtio_interface_tx_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   while (n_left && used < sz)
     {
       u16 n_added;
-      n_added = add_buffer_to_slot (vm, vring, buffers[0], avail, next, mask);
+      n_added = add_buffer_to_slot (vm, vif, vring, buffers[0], avail, next,
+				    mask);
       avail += n_added;
       next = (next + n_added) & mask;
       used += n_added;
@@ -223,7 +289,7 @@ virtio_interface_tx_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
       vlib_buffer_free (vm, buffers, n_left);
     }
 
-  clib_spinlock_unlock_if_init (&vif->lockp);
+  clib_spinlock_unlock_if_init (&vring->lockp);
 
   return frame->n_vectors - n_left;
 }
@@ -272,7 +338,8 @@ virtio_interface_rx_mode_change (vnet_main_t * vnm, u32 hw_if_index, u32 qid,
   virtio_main_t *mm = &virtio_main;
   vnet_hw_interface_t *hw = vnet_get_hw_interface (vnm, hw_if_index);
   virtio_if_t *vif = pool_elt_at_index (mm->interfaces, hw->dev_instance);
-  virtio_vring_t *vring = vec_elt_at_index (vif->vrings, qid);
+  virtio_vring_t *vring = vec_elt_at_index (vif->vrings,
+					     VIRTIO_RX_VRING (qid));
 
   if (mode == VNET_HW_INTERFACE_RX_MODE_POLLING)
     vring->avail->flags |= VIRTIO_RING_FLAG_MASK_INT;
@@ -32,6 +32,8 @@
 #include <vnet/feature/feature.h>
 #include <vnet/ip/ip4_packet.h>
 #include <vnet/ip/ip6_packet.h>
+#include <vnet/tcp/tcp_packet.h>
+#include <vnet/udp/udp_packet.h>
 #include <vnet/devices/virtio/virtio.h>
 
 
@@ -123,6 +125,68 @@ virtio_refill_vring (vlib_main_t * vm, virtio_vring_t * vring)
     }
 }
 
+/*
+ * Apply the virtio header of a packet from the kernel: a packet with a
+ * partial L4 checksum goes on with the checksum offload flags so the
+ * output completes it, a packet still to be segmented with its segment
+ * size.
+ */
+static void
+virtio_input_offload (vlib_buffer_t * b, struct virtio_net_hdr_v1 *hdr)
+{
+  ethernet_header_t *eh = vlib_buffer_get_current (b);
+  u16 ethertype = clib_net_to_host_u16 (eh->type);
+  u16 l2hdr_sz = sizeof (ethernet_header_t);
+  u16 l4_offset;
+  tcp_header_t *tcp;
+  u8 gso_type;
+
+  if (ethernet_frame_is_tagged (ethertype))
+    {
+      ethernet_vlan_header_t *vlan = (void *) (eh + 1);
+      ethertype = clib_net_to_host_u16 (vlan->type);
+      l2hdr_sz += sizeof (*vlan);
+    }
+
+  vnet_buffer (b)->l2_hdr_offset = b->current_data;
+  vnet_buffer (b)->l3_hdr_offset = b->current_data + l2hdr_sz;
+  if (ethertype == ETHERNET_TYPE_IP4)
+    b->flags |= VNET_BUFFER_F_IS_IP4;
+  else if (ethertype == ETHERNET_TYPE_IP6)
+    b->flags |= VNET_BUFFER_F_IS_IP6;
+  else
+    return;
+
+  /* The kernel sets csum_start on all the packets it leaves offloads to */
+  if ((hdr->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) == 0)
+    return;
+  l4_offset = hdr->csum_start;
+  if (PREDICT_FALSE (l4_offset + sizeof (tcp_header_t) > b->current_length))
+    return;
+
+  vnet_buffer (b)->l4_hdr_offset = b->current_data + l4_offset;
+  b->flags |= (VNET_BUFFER_F_L2_HDR_OFFSET_VALID |
+	       VNET_BUFFER_F_L3_HDR_OFFSET_VALID |
+	       VNET_BUFFER_F_L4_HDR_OFFSET_VALID);
+
+  if (hdr->csum_offset == STRUCT_OFFSET_OF (tcp_header_t, checksum))
+    b->flags |= VNET_BUFFER_F_OFFLOAD_TCP_CKSUM;
+  else if (hdr->csum_offset == STRUCT_OFFSET_OF (udp_header_t, checksum))
+    b->flags |= VNET_BUFFER_F_OFFLOAD_UDP_CKSUM;
+  b->flags |= (VNET_BUFFER_F_L4_CHECKSUM_COMPUTED |
+	       VNET_BUFFER_F_L4_CHECKSUM_CORRECT);
+
+  gso_type = hdr->gso_type & ~VIRTIO_NET_HDR_GSO_ECN;
+  if ((gso_type == VIRTIO_NET_HDR_GSO_TCPV4 ||
+       gso_type == VIRTIO_NET_HDR_GSO_TCPV6) && hdr->gso_size)
+    {
+      tcp = (tcp_header_t *) (b->data + vnet_buffer (b)->l4_hdr_offset);
+      vnet_buffer2 (b)->gso_size = hdr->gso_size;
+      vnet_buffer2 (b)->gso_l4_hdr_sz = tcp_header_bytes (tcp);
+      b->flags |= VNET_BUFFER_F_GSO;
+    }
+}
+
 static_always_inline uword
 virtio_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			    vlib_frame_t * frame, virtio_if_t * vif, u16 qid)
@@ -130,7 +194,8 @@ virtio_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   vnet_main_t *vnm = vnet_get_main ();
   u32 thread_index = vlib_get_thread_index ();
   uword n_trace = vlib_get_trace_count (vm, node);
-  virtio_vring_t *vring = vec_elt_at_index (vif->vrings, 0);
+  virtio_vring_t *vring = vec_elt_at_index (vif->vrings,
+					     VIRTIO_RX_VRING (qid));
   u32 next_index = VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
   const int hdr_sz = sizeof (struct virtio_net_hdr_v1);
   u32 *to_next = 0;
@@ -198,6 +263,9 @@ virtio_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 		}
 	    }
 
+	  if (PREDICT_FALSE (hdr->flags || hdr->gso_type))
+	    virtio_input_offload (b0, hdr);
+
 	  if (PREDICT_FALSE (vif->per_interface_next_index != ~0))
 	    next0 = vif->per_interface_next_index;
 	  else
@@ -215,6 +283,7 @@ virtio_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	      tr = vlib_add_trace (vm, node, b0, sizeof (*tr));
 	      tr->next_index = next0;
 	      tr->hw_if_index = vif->hw_if_index;
+	      tr->ring = VIRTIO_RX_VRING (qid);
 	      tr->len = len;
 	      clib_memcpy (&tr->hdr, hdr, hdr_sz);
 	    }
@@ -733,6 +733,23 @@ vhost_user_log_dirty_pages (vhost_user_intf_t * vui, u64 addr, u64 len)
                              sizeof(vq->used->member)); \
   }
 
+/*
+ * Tell the output path what the guest negotiated it would accept:
+ * packets with partial L4 checksums and packets still to be segmented.
+ */
+static void
+vhost_user_update_offload_flags (vnet_main_t * vnm, vhost_user_intf_t * vui)
+{
+  vnet_hw_interface_t *hw = vnet_get_hw_interface (vnm, vui->hw_if_index);
+
+  hw->flags &= ~(VNET_HW_INTERFACE_FLAG_SUPPORTS_TX_L4_CKSUM_OFFLOAD |
+		 VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO);
+  if (vui->tx_csum_offload)
+    hw->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_TX_L4_CKSUM_OFFLOAD;
+  if (vui->tx_gso_offload)
+    hw->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO;
+}
+
 static clib_error_t *
 vhost_user_socket_read (clib_file_t * uf)
 {
@@ -840,7 +857,7 @@ vhost_user_socket_read (clib_file_t * uf)
 	(1ULL << FEAT_VIRTIO_NET_F_GUEST_ANNOUNCE) |
 	(1ULL << FEAT_VIRTIO_NET_F_MQ) |
 	(1ULL << FEAT_VHOST_USER_F_PROTOCOL_FEATURES) |
-	(1ULL << FEAT_VIRTIO_F_VERSION_1);
+	(1ULL << FEAT_VIRTIO_F_VERSION_1) | VHOST_USER_OFFLOAD_FEATURES;
       msg.u64 &= vui->feature_mask;
       msg.size = sizeof (msg.u64);
       DBG_SOCK ("if %d msg VHOST_USER_GET_FEATURES - reply 0x%016llx",
@@ -863,6 +880,17 @@ vhost_user_socket_read (clib_file_t * uf)
       vui->is_any_layout =
 	(vui->features & (1 << FEAT_VIRTIO_F_ANY_LAYOUT)) ? 1 : 0;
 
+      vui->rx_offloads =
+	(vui->features & ((1ULL << FEAT_VIRTIO_NET_F_CSUM) |
+			  (1ULL << FEAT_VIRTIO_NET_F_HOST_TSO4) |
+			  (1ULL << FEAT_VIRTIO_NET_F_HOST_TSO6))) ? 1 : 0;
+      vui->tx_csum_offload =
+	(vui->features & (1ULL << FEAT_VIRTIO_NET_F_GUEST_CSUM)) ? 1 : 0;
+      vui->tx_gso_offload = vui->tx_csum_offload &&
+	(vui->features & (1ULL << FEAT_VIRTIO_NET_F_GUEST_TSO4)) &&
+	(vui->features & (1ULL << FEAT_VIRTIO_NET_F_GUEST_TSO6));
+      vhost_user_update_offload_flags (vnm, vui);
+
       ASSERT (vui->virtio_net_hdr_sz < VLIB_BUFFER_PRE_DATA_SIZE);
       vnet_hw_interface_set_flags (vnm, vui->hw_if_index, 0);
       vui->is_up = 0;
@@ -1543,6 +1571,90 @@ vhost_user_input_rewind_buffers (vlib_main_t * vm,
   cpu->rx_buffers_len++;
 }
 
+/*
+ * Apply the virtio header of a received packet: a packet with a partial
+ * L4 checksum, which the guest vouches for, goes on with the checksum
+ * offload flags so the output completes it, a packet still to be
+ * segmented with its segment size.
+ */
+static void
+vhost_user_input_offload (vlib_buffer_t * b, virtio_net_hdr_t * hdr)
+{
+  ethernet_header_t *eh = vlib_buffer_get_current (b);
+  u16 ethertype = clib_net_to_host_u16 (eh->type);
+  u16 l2hdr_sz = sizeof (ethernet_header_t);
+  u16 l4hdr_sz, l4_offset;
+  tcp_header_t *tcp;
+  u8 gso_type;
+  int i;
+
+  for (i = 0; i < 2 && ethernet_frame_is_tagged (ethertype); i++)
+    {
+      ethernet_vlan_header_t *vlan = (void *) (b->data + b->current_data +
+					       l2hdr_sz);
+      ethertype = clib_net_to_host_u16 (vlan->type);
+      l2hdr_sz += sizeof (*vlan);
+    }
+
+  vnet_buffer (b)->l2_hdr_offset = b->current_data;
+  vnet_buffer (b)->l3_hdr_offset = b->current_data + l2hdr_sz;
+  if (ethertype == ETHERNET_TYPE_IP4)
+    {
+      ip4_header_t *ip4 = (void *) (b->data + b->current_data + l2hdr_sz);
+      l4_offset = l2hdr_sz + ip4_header_bytes (ip4);
+      b->flags |= VNET_BUFFER_F_IS_IP4;
+    }
+  else if (ethertype == ETHERNET_TYPE_IP6)
+    {
+      l4_offset = l2hdr_sz + sizeof (ip6_header_t);
+      b->flags |= VNET_BUFFER_F_IS_IP6;
+    }
+  else
+    return;
+
+  /* The guest knows better where the L4 header is, e.g. past extensions */
+  if (hdr->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM)
+    l4_offset = hdr->csum_start;
+  if (PREDICT_FALSE (l4_offset + sizeof (tcp_header_t) > b->current_length))
+    return;
+
+  vnet_buffer (b)->l4_hdr_offset = b->current_data + l4_offset;
+  b->flags |= (VNET_BUFFER_F_L2_HDR_OFFSET_VALID |
+	       VNET_BUFFER_F_L3_HDR_OFFSET_VALID |
+	       VNET_BUFFER_F_L4_HDR_OFFSET_VALID);
+
+  if (hdr->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM)
+    {
+      if (hdr->csum_offset == STRUCT_OFFSET_OF (tcp_header_t, checksum))
+	b->flags |= VNET_BUFFER_F_OFFLOAD_TCP_CKSUM;
+      else if (hdr->csum_offset == STRUCT_OFFSET_OF (udp_header_t, checksum))
+	b->flags |= VNET_BUFFER_F_OFFLOAD_UDP_CKSUM;
+      b->flags |= (VNET_BUFFER_F_L4_CHECKSUM_COMPUTED |
+		   VNET_BUFFER_F_L4_CHECKSUM_CORRECT);
+    }
+
+  gso_type = hdr->gso_type & ~VIRTIO_NET_HDR_GSO_ECN;
+  if ((gso_type == VIRTIO_NET_HDR_GSO_TCPV4 ||
+       gso_type == VIRTIO_NET_HDR_GSO_TCPV6) && hdr->gso_size)
+    {
+      tcp = (tcp_header_t *) (b->data + vnet_buffer (b)->l4_hdr_offset);
+      l4hdr_sz = tcp_header_bytes (tcp);
+      vnet_buffer2 (b)->gso_size = hdr->gso_size;
+      vnet_buffer2 (b)->gso_l4_hdr_sz = l4hdr_sz;
+      b->flags |= VNET_BUFFER_F_GSO;
+    }
+}
+
+static_always_inline void
+vhost_user_input_offloads (vlib_main_t * vm, vhost_cpu_t * cpu,
+			   u32 n_offloads)
+{
+  vhost_rx_offload_t *o;
+
+  for (o = cpu->rx_offloads; o < cpu->rx_offloads + n_offloads; o++)
+    vhost_user_input_offload (vlib_get_buffer (vm, o->bi), &o->hdr);
+}
+
 static u32
 vhost_user_if_input (vlib_main_t * vm,
 		     vhost_user_main_t * vum,
@@ -1560,6 +1672,7 @@ vhost_user_if_input (vlib_main_t * vm,
   u32 map_hint = 0;
   u16 thread_index = vlib_get_thread_index ();
   u16 copy_len = 0;
+  u32 n_offloads = 0;
 
   {
     /* do we have pending interrupts ? */
@@ -1681,6 +1794,7 @@ vhost_user_if_input (vlib_main_t * vm,
 	  u16 desc_current;
 	  u32 desc_data_offset;
 	  vring_desc_t *desc_table = txvq->desc;
+	  virtio_net_hdr_t *hdr = 0;
 
 	  if (PREDICT_FALSE (vum->cpus[thread_index].rx_buffers_len <= 1))
 	    {
@@ -1748,6 +1862,10 @@ vhost_user_if_input (vlib_main_t * vm,
 		}
 	    }
 
+	  if (PREDICT_FALSE (vui->rx_offloads))
+	    hdr = map_guest_mem (vui, desc_table[desc_current].addr,
+				 &map_hint);
+
 	  if (PREDICT_TRUE (vui->is_any_layout) ||
 	      (!(desc_table[desc_current].flags & VIRTQ_DESC_F_NEXT)))
 	    {
@@ -1850,6 +1968,15 @@ vhost_user_if_input (vlib_main_t * vm,
 	  vnet_buffer (b_head)->sw_if_index[VLIB_TX] = (u32) ~ 0;
 	  b_head->error = 0;
 
+	  /* The headers are parsed once the data is copied */
+	  if (PREDICT_FALSE (hdr && (hdr->flags || hdr->gso_type)))
+	    {
+	      vhost_rx_offload_t *o =
+		&vum->cpus[thread_index].rx_offloads[n_offloads++];
+	      o->bi = to_next[-1];
+	      o->hdr = *hdr;
+	    }
+
 	  {
 	    u32 next0 = VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
 
@@ -1880,6 +2007,9 @@ vhost_user_if_input (vlib_main_t * vm,
 				    VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL, 1);
 		}
 	      copy_len = 0;
+	      vhost_user_input_offloads (vm, &vum->cpus[thread_index],
+					 n_offloads);
+	      n_offloads = 0;
 
 	      /* give buffers back to driver */
 	      CLIB_MEMORY_BARRIER ();
@@ -1899,6 +2029,7 @@ vhost_user_if_input (vlib_main_t * vm,
       vlib_error_count (vm, node->node_index,
 			VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL, 1);
     }
+  vhost_user_input_offloads (vm, &vum->cpus[thread_index], n_offloads);
 
   /* give buffers back to driver */
   CLIB_MEMORY_BARRIER ();
@@ -2008,6 +2139,67 @@ vhost_user_tx_trace (vhost_trace_t * t,
   t->first_desc_len = hdr_desc ? hdr_desc->len : 0;
 }
 
+/*
+ * Fill in the virtio header of a packet with offloads for the guest to
+ * complete: the L4 checksum, of which the guest expects the field to hold
+ * the pseudo-header sum, and the segmentation.
+ */
+static void
+vhost_user_tx_offload (vlib_main_t * vm, vhost_user_intf_t * vui,
+		       vlib_buffer_t * b, virtio_net_hdr_t * hdr)
+{
+  u16 l3_offset = vnet_buffer (b)->l3_hdr_offset - b->current_data;
+  u16 l4_offset = vnet_buffer (b)->l4_hdr_offset - b->current_data;
+  void *l3 = b->data + vnet_buffer (b)->l3_hdr_offset;
+  void *l4 = b->data + vnet_buffer (b)->l4_hdr_offset;
+  u32 l4_len = vlib_buffer_length_in_chain (vm, b) - l4_offset;
+  u8 proto;
+  ip_csum_t sum;
+  u16 *csum;
+
+  if (b->flags & VNET_BUFFER_F_OFFLOAD_TCP_CKSUM)
+    {
+      proto = IP_PROTOCOL_TCP;
+      csum = &((tcp_header_t *) l4)->checksum;
+      hdr->csum_offset = STRUCT_OFFSET_OF (tcp_header_t, checksum);
+    }
+  else
+    {
+      proto = IP_PROTOCOL_UDP;
+      csum = &((udp_header_t *) l4)->checksum;
+      hdr->csum_offset = STRUCT_OFFSET_OF (udp_header_t, checksum);
+    }
+
+  sum = clib_host_to_net_u32 (l4_len + (proto << 16));
+  if (b->flags & VNET_BUFFER_F_IS_IP4)
+    {
+      ip4_header_t *ip4 = l3;
+      if (b->flags & VNET_BUFFER_F_OFFLOAD_IP_CKSUM)
+	ip4->checksum = ip4_header_checksum (ip4);
+      sum = ip_incremental_checksum (sum, &ip4->src_address,
+				     2 * sizeof (ip4_address_t));
+    }
+  else
+    {
+      ip6_header_t *ip6 = l3;
+      sum = ip_incremental_checksum (sum, &ip6->src_address,
+				     2 * sizeof (ip6_address_t));
+    }
+  *csum = ip_csum_fold (sum);
+
+  hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+  hdr->csum_start = l4_offset;
+
+  if ((b->flags & VNET_BUFFER_F_GSO) && vui->tx_gso_offload)
+    {
+      hdr->gso_type = (b->flags & VNET_BUFFER_F_IS_IP4) ?
+	VIRTIO_NET_HDR_GSO_TCPV4 : VIRTIO_NET_HDR_GSO_TCPV6;
+      hdr->gso_size = vnet_buffer2 (b)->gso_size;
+      hdr->hdr_len = l4_offset + vnet_buffer2 (b)->gso_l4_hdr_sz;
+    }
+  ASSERT (l4_offset > l3_offset);
+}
+
 static_always_inline u32
 vhost_user_tx_copy (vhost_user_intf_t * vui, vhost_copy_t * cpy,
 		    u16 copy_len, u32 * map_hint)
@@ -2101,9 +2293,11 @@ retry:
   while (n_left > 0)
     {
       vlib_buffer_t *b0, *current_b0;
-      u16 desc_head, desc_index, desc_len;
+      u16 desc_head, desc_index;
+      u32 desc_len;
       vring_desc_t *desc_table;
-      uword buffer_map_addr;
+      virtio_net_hdr_mrg_rxbuf_t *hdr;
+      uword buffer_map_addr, hdr_map_addr;
       u32 buffer_len;
       u16 bytes_left;
 
@@ -2158,13 +2352,18 @@ retry:
 
       {
 	// Get a header from the header array
-	virtio_net_hdr_mrg_rxbuf_t *hdr =
-	  &vum->cpus[thread_index].tx_headers[tx_headers_len];
+	hdr = &vum->cpus[thread_index].tx_headers[tx_headers_len];
+	hdr_map_addr = buffer_map_addr;
 	tx_headers_len++;
 	hdr->hdr.flags = 0;
 	hdr->hdr.gso_type = 0;
 	hdr->num_buffers = 1;	//This is local, no need to check
 
+	if (PREDICT_FALSE (vui->tx_csum_offload &&
+			   (b0->flags & (VNET_BUFFER_F_OFFLOAD_TCP_CKSUM |
+					 VNET_BUFFER_F_OFFLOAD_UDP_CKSUM))))
+	  vhost_user_tx_offload (vm, vui, b0, &hdr->hdr);
+
 	// Prepare a copy order executed later for the header
 	vhost_copy_t *cpy = &vum->cpus[thread_index].copy[copy_len];
 	copy_len++;
@@ -2190,9 +2389,6 @@ retry:
 		}
 	      else if (vui->virtio_net_hdr_sz == 12)	//MRG is available
 		{
-		  virtio_net_hdr_mrg_rxbuf_t *hdr =
-		    &vum->cpus[thread_index].tx_headers[tx_headers_len - 1];
-
 		  //Move from available to used buffer
 		  rxvq->used->ring[rxvq->last_used_idx & rxvq->qsz_mask].id =
 		    desc_head;
@@ -2252,6 +2448,27 @@ retry:
 		}
 	    }
 
+	  /*
+	   * A large, e.g. GSO, packet may need more copies than are left.
+	   * Do those queued, then the header's again, as the number of
+	   * buffers it gives is not final yet.
+	   */
+	  if (PREDICT_FALSE (copy_len >= VHOST_USER_COPY_ARRAY_N - 1))
+	    {
+	      vhost_copy_t *cpy = vum->cpus[thread_index].copy;
+
+	      if (PREDICT_FALSE
+		  (vhost_user_tx_copy (vui, cpy, copy_len, &map_hint)))
+		{
+		  vlib_error_count (vm, node->node_index,
+				    VHOST_USER_TX_FUNC_ERROR_MMAP_FAIL, 1);
+		}
+	      cpy->len = vui->virtio_net_hdr_sz;
+	      cpy->dst = hdr_map_addr;
+	      cpy->src = (uword) hdr;
+	      copy_len = 1;
+	    }
+
 	  {
 	    vhost_copy_t *cpy = &vum->cpus[thread_index].copy[copy_len];
 	    copy_len++;
@@ -3054,7 +3271,8 @@ vhost_user_connect_command_fn (vlib_main_t * vm,
   u8 *sock_filename = NULL;
   u32 sw_if_index;
   u8 is_server = 0;
-  u64 feature_mask = (u64) ~ (0ULL);
+  u64 feature_mask = VHOST_USER_DEFAULT_FEATURE_MASK;
+  u8 enable_gso = 0;
   u8 renumber = 0;
   u32 custom_dev_instance = ~0;
   u8 hwaddr[6];
@@ -3073,6 +3291,8 @@ vhost_user_connect_command_fn (vlib_main_t * vm,
 	is_server = 1;
       else if (unformat (line_input, "feature-mask 0x%llx", &feature_mask))
 	;
+      else if (unformat (line_input, "gso"))
+	enable_gso = 1;
       else
 	if (unformat
 	    (line_input, "hwaddr %U", unformat_ethernet_address, hwaddr))
@@ -3089,6 +3309,9 @@ vhost_user_connect_command_fn (vlib_main_t * vm,
 	}
     }
 
+  if (enable_gso)
+    feature_mask |= VHOST_USER_OFFLOAD_FEATURES;
+
   vnet_main_t *vnm = vnet_get_main ();
 
   int rv;
@@ -3449,7 +3672,14 @@ done:
  * - <b>feature-mask <hex></b> - Optional virtio/vhost feature set negotiated at
  * startup. <b>This is intended for degugging only.</b> It is recommended that this
  * parameter not be used except by experienced users. By default, all supported
- * features will be advertised. Otherwise, provide the set of features desired.
+ * features, bar the offloads, will be advertised. Otherwise, provide the set
+ * of features desired.
+ *   - 0x000000001 (0)  - VIRTIO_NET_F_CSUM
+ *   - 0x000000002 (1)  - VIRTIO_NET_F_GUEST_CSUM
+ *   - 0x000000080 (7)  - VIRTIO_NET_F_GUEST_TSO4
+ *   - 0x000000100 (8)  - VIRTIO_NET_F_GUEST_TSO6
+ *   - 0x000000800 (11) - VIRTIO_NET_F_HOST_TSO4
+ *   - 0x000001000 (12) - VIRTIO_NET_F_HOST_TSO6
  *   - 0x000008000 (15) - VIRTIO_NET_F_MRG_RXBUF
  *   - 0x000020000 (17) - VIRTIO_NET_F_CTRL_VQ
  *   - 0x000200000 (21) - VIRTIO_NET_F_GUEST_ANNOUNCE
@@ -3460,6 +3690,11 @@ done:
  *   - 0x040000000 (30) - VHOST_USER_F_PROTOCOL_FEATURES
  *   - 0x100000000 (32) - VIRTIO_F_VERSION_1
  *
+ * - <b>gso</b> - Optional flag to also advertise the checksum and TCP
+ * segmentation offloads. The guest may then send packets of up to 64k with
+ * partial checksums, which are segmented and checksummed on output, and is
+ * sent such packets from interfaces that do the same.
+ *
  * - <b>hwaddr <mac-addr></b> - Optional ethernet address, can be in either
  * X:X:X:X:X:X unix or X.X.X cisco format.
  *
@@ -3484,7 +3719,8 @@ done:
 VLIB_CLI_COMMAND (vhost_user_connect_command, static) = {
     .path = "create vhost-user",
     .short_help = "create vhost-user socket <socket-filename> [server] "
-    "[feature-mask <hex>] [hwaddr <mac-addr>] [renumber <dev_instance>] ",
+    "[feature-mask <hex>] [gso] [hwaddr <mac-addr>] "
+    "[renumber <dev_instance>] ",
     .function = vhost_user_connect_command_fn,
 };
 /* *INDENT-ON* */
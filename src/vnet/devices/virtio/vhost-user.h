@@ -46,6 +46,12 @@
 #define VRING_AVAIL_F_NO_INTERRUPT 1
 
 #define foreach_virtio_net_feature      \
+ _ (VIRTIO_NET_F_CSUM, 0)               \
+ _ (VIRTIO_NET_F_GUEST_CSUM, 1)         \
+ _ (VIRTIO_NET_F_GUEST_TSO4, 7)         \
+ _ (VIRTIO_NET_F_GUEST_TSO6, 8)         \
+ _ (VIRTIO_NET_F_HOST_TSO4, 11)         \
+ _ (VIRTIO_NET_F_HOST_TSO6, 12)         \
  _ (VIRTIO_NET_F_MRG_RXBUF, 15)         \
  _ (VIRTIO_NET_F_CTRL_VQ, 17)           \
  _ (VIRTIO_NET_F_GUEST_ANNOUNCE, 21)    \
@@ -64,6 +70,22 @@ typedef enum
 #undef _
 } virtio_net_feature_t;
 
+/**
+ * The checksum and segmentation offloads. These are only offered to
+ * the guest when the interface is created with them enabled, since
+ * buffers from the guest then carry GSO metadata that the rest of the
+ * graph must honour.
+ */
+#define VHOST_USER_OFFLOAD_FEATURES               \
+  ((1ULL << FEAT_VIRTIO_NET_F_CSUM) |             \
+   (1ULL << FEAT_VIRTIO_NET_F_GUEST_CSUM) |       \
+   (1ULL << FEAT_VIRTIO_NET_F_GUEST_TSO4) |       \
+   (1ULL << FEAT_VIRTIO_NET_F_GUEST_TSO6) |       \
+   (1ULL << FEAT_VIRTIO_NET_F_HOST_TSO4) |        \
+   (1ULL << FEAT_VIRTIO_NET_F_HOST_TSO6))
+
+#define VHOST_USER_DEFAULT_FEATURE_MASK (~VHOST_USER_OFFLOAD_FEATURES)
+
 int vhost_user_create_if (vnet_main_t * vnm, vlib_main_t * vm,
 			  const char *sock_filename, u8 is_server,
 			  u32 * sw_if_index, u64 feature_mask,
@@ -169,6 +191,14 @@ typedef struct
   u16 csum_offset;
 } __attribute ((packed)) virtio_net_hdr_t;
 
+#define VIRTIO_NET_HDR_F_NEEDS_CSUM 1
+
+#define VIRTIO_NET_HDR_GSO_NONE  0
+#define VIRTIO_NET_HDR_GSO_TCPV4 1
+#define VIRTIO_NET_HDR_GSO_UDP   3
+#define VIRTIO_NET_HDR_GSO_TCPV6 4
+#define VIRTIO_NET_HDR_GSO_ECN   0x80
+
 typedef struct  {
   virtio_net_hdr_t hdr;
   u16 num_buffers;
@@ -249,6 +279,12 @@ typedef struct
   int virtio_net_hdr_sz;
   int is_any_layout;
 
+  /* The guest sends packets with partial checksums and/or GSO */
+  u8 rx_offloads;
+  /* The guest accepts the same */
+  u8 tx_csum_offload;
+  u8 tx_gso_offload;
+
   void *log_base_addr;
   u64 log_size;
 
@@ -280,6 +316,13 @@ typedef struct
 #define VHOST_USER_RX_BUFFERS_N (2 * VLIB_FRAME_SIZE + 2)
 #define VHOST_USER_COPY_ARRAY_N (4 * VLIB_FRAME_SIZE)
 
+/* The virtio header of a received packet, to be applied to its buffer */
+typedef struct
+{
+  u32 bi;
+  virtio_net_hdr_t hdr;
+} vhost_rx_offload_t;
+
 typedef struct
 {
   u32 rx_buffers_len;
@@ -287,6 +330,7 @@ typedef struct
 
   virtio_net_hdr_mrg_rxbuf_t tx_headers[VLIB_FRAME_SIZE];
   vhost_copy_t copy[VHOST_USER_COPY_ARRAY_N];
+  vhost_rx_offload_t rx_offloads[VLIB_FRAME_SIZE];
 
   /* This is here so it doesn't end-up
    * using stack or registers. */
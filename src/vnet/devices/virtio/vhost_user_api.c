@@ -76,9 +76,13 @@ vl_api_create_vhost_user_if_t_handler (vl_api_create_vhost_user_if_t * mp)
   u32 sw_if_index = (u32) ~ 0;
   vnet_main_t *vnm = vnet_get_main ();
   vlib_main_t *vm = vlib_get_main ();
+  u64 feature_mask = VHOST_USER_DEFAULT_FEATURE_MASK;
+
+  if (mp->enable_gso)
+    feature_mask |= VHOST_USER_OFFLOAD_FEATURES;
 
   rv = vhost_user_create_if (vnm, vm, (char *) mp->sock_filename,
-			     mp->is_server, &sw_if_index, (u64) ~ 0,
+			     mp->is_server, &sw_if_index, feature_mask,
 			     mp->renumber, ntohl (mp->custom_dev_instance),
 			     (mp->use_custom_mac) ? mp->mac_address : NULL);
 
@@ -109,12 +113,16 @@ vl_api_modify_vhost_user_if_t_handler (vl_api_modify_vhost_user_if_t * mp)
   int rv = 0;
   vl_api_modify_vhost_user_if_reply_t *rmp;
   u32 sw_if_index = ntohl (mp->sw_if_index);
+  u64 feature_mask = VHOST_USER_DEFAULT_FEATURE_MASK;
 
   vnet_main_t *vnm = vnet_get_main ();
   vlib_main_t *vm = vlib_get_main ();
 
+  if (mp->enable_gso)
+    feature_mask |= VHOST_USER_OFFLOAD_FEATURES;
+
   rv = vhost_user_modify_if (vnm, vm, (char *) mp->sock_filename,
-			     mp->is_server, sw_if_index, (u64) ~ 0,
+			     mp->is_server, sw_if_index, feature_mask,
 			     mp->renumber, ntohl (mp->custom_dev_instance));
 
   REPLY_MACRO (VL_API_MODIFY_VHOST_USER_IF_REPLY);
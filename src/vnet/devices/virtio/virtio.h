@@ -55,7 +55,8 @@
 
 #define foreach_virtio_if_flag		\
   _(0, ADMIN_UP, "admin-up")		\
-  _(1, DELETING, "deleting")
+  _(1, DELETING, "deleting")		\
+  _(2, GSO, "gso")
 
 typedef enum
 {
@@ -86,20 +87,27 @@ typedef struct
   u32 call_file_index;
   u32 *buffers;
   u16 last_used_idx;
+  /* tx only, if the threads outnumber the queues */
+  clib_spinlock_t lockp;
 } virtio_vring_t;
 
+/* Each queue pair has its vrings side by side, rx first */
+#define VIRTIO_RX_VRING(qid) ((qid) << 1)
+#define VIRTIO_TX_VRING(qid) (((qid) << 1) + 1)
+
 typedef struct
 {
   u32 flags;
-  clib_spinlock_t lockp;
 
   u32 id;
   u32 dev_instance;
   u32 hw_if_index;
   u32 sw_if_index;
   u32 per_interface_next_index;
-  int fd;
-  int tap_fd;
+  /* One vhost-net and one tap fd per queue pair */
+  int *vhost_fds;
+  int *tap_fds;
+  u16 num_queue_pairs;
   virtio_vring_t *vrings;
 
   u64 features, remote_features;
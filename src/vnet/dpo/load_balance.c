@@ -83,13 +83,38 @@ load_balance_get_buckets (load_balance_t *lb)
 static load_balance_t *
 load_balance_alloc_i (void)
 {
+    vlib_main_t *vm = vlib_get_main();
     load_balance_t *lb;
+    u8 need_barrier_sync;
+
+    /*
+     * the workers read the pool and the counters without locks, so they
+     * must be stopped should either of them move.
+     */
+    pool_get_aligned_will_expand(load_balance_pool, need_barrier_sync,
+                                 CLIB_CACHE_LINE_BYTES);
+    if (need_barrier_sync)
+        vlib_worker_thread_barrier_sync(vm);
 
     pool_get_aligned(load_balance_pool, lb, CLIB_CACHE_LINE_BYTES);
     memset(lb, 0, sizeof(*lb));
 
     lb->lb_map = INDEX_INVALID;
     lb->lb_urpf = INDEX_INVALID;
+
+    if (!need_barrier_sync)
+    {
+        need_barrier_sync =
+            (vlib_validate_combined_counter_will_expand
+             (&(load_balance_main.lbm_to_counters),
+              load_balance_get_index(lb)) ||
+             vlib_validate_combined_counter_will_expand
+             (&(load_balance_main.lbm_via_counters),
+              load_balance_get_index(lb)));
+        if (need_barrier_sync)
+            vlib_worker_thread_barrier_sync(vm);
+    }
+
     vlib_validate_combined_counter(&(load_balance_main.lbm_to_counters),
                                    load_balance_get_index(lb));
     vlib_validate_combined_counter(&(load_balance_main.lbm_via_counters),
@@ -99,6 +124,9 @@ load_balance_alloc_i (void)
     vlib_zero_combined_counter(&(load_balance_main.lbm_via_counters),
                                load_balance_get_index(lb));
 
+    if (need_barrier_sync)
+        vlib_worker_thread_barrier_release(vm);
+
     return (lb);
 }
 
@@ -457,6 +485,22 @@ load_balance_multipath_next_hop_fixup (const load_balance_path_t *nhs,
  * Fill in adjacencies in block based on corresponding
  * next hop adjacencies.
  */
+/*
+ * Release a bucket array that has been replaced. The workers may still
+ * be switching through it, so this waits for a grace period.
+ */
+static void
+load_balance_buckets_free_rcu (void *arg)
+{
+    dpo_id_t *buckets = arg, *tmp_dpo;
+
+    vec_foreach(tmp_dpo, buckets)
+    {
+        dpo_reset(tmp_dpo);
+    }
+    vec_free(buckets);
+}
+
 static void
 load_balance_fill_buckets (load_balance_t *lb,
                            load_balance_path_t *nhs,
@@ -499,7 +543,6 @@ load_balance_multipath_update (const dpo_id_t *dpo,
     u32 sum_of_weights, n_buckets, ii;
     index_t lbmi, old_lbmi;
     load_balance_t *lb;
-    dpo_id_t *tmp_dpo;
 
     nhs = NULL;
 
@@ -621,7 +664,7 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                      * we are not crossing the threshold. We need a new bucket array to
                      * hold the increased number of choices.
                      */
-                    dpo_id_t *new_buckets, *old_buckets, *tmp_dpo;
+                    dpo_id_t *new_buckets, *old_buckets;
 
                     new_buckets = NULL;
                     old_buckets = load_balance_get_buckets(lb);
@@ -636,11 +679,8 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                     CLIB_MEMORY_BARRIER();
                     load_balance_set_n_buckets(lb, n_buckets);
 
-                    vec_foreach(tmp_dpo, old_buckets)
-                    {
-                        dpo_reset(tmp_dpo);
-                    }
-                    vec_free(old_buckets);
+                    vlib_rcu_call(load_balance_buckets_free_rcu,
+                                  old_buckets);
                 }
             }
 
@@ -679,11 +719,9 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                 load_balance_set_n_buckets(lb, n_buckets);
                 CLIB_MEMORY_BARRIER();
 
-                vec_foreach(tmp_dpo, lb->lb_buckets)
-                {
-                    dpo_reset(tmp_dpo);
-                }
-                vec_free(lb->lb_buckets);
+                vlib_rcu_call(load_balance_buckets_free_rcu,
+                              lb->lb_buckets);
+                lb->lb_buckets = NULL;
             }
             else
             {
@@ -734,12 +772,18 @@ load_balance_lock (dpo_id_t *dpo)
     lb->lb_locks++;
 }
 
+/*
+ * Called a grace period after the last lock went, when no worker can
+ * still be switching through the load-balance.
+ */
 static void
-load_balance_destroy (load_balance_t *lb)
+load_balance_destroy (void *arg)
 {
+    load_balance_t *lb;
     dpo_id_t *buckets;
     int i;
 
+    lb = load_balance_get(pointer_to_uword(arg));
     buckets = load_balance_get_buckets(lb);
 
     for (i = 0; i < lb->lb_n_buckets; i++)
@@ -770,7 +814,8 @@ load_balance_unlock (dpo_id_t *dpo)
 
     if (0 == lb->lb_locks)
     {
-        load_balance_destroy(lb);
+        vlib_rcu_call(load_balance_destroy,
+                      uword_to_pointer(dpo->dpoi_index, void *));
     }
 }
 
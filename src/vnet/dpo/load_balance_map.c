@@ -383,10 +383,22 @@ load_balance_map_fill (load_balance_map_t *lbm)
 static load_balance_map_t*
 load_balance_map_alloc (const load_balance_path_t *paths)
 {
+    vlib_main_t *vm = vlib_get_main();
     load_balance_map_t *lbm;
+    u8 need_barrier_sync;
     u32 ii;
 
+    /* the workers read the pool unlocked; stop them should it move */
+    pool_get_aligned_will_expand(load_balance_map_pool, need_barrier_sync,
+                                 CLIB_CACHE_LINE_BYTES);
+    if (need_barrier_sync)
+        vlib_worker_thread_barrier_sync(vm);
+
     pool_get_aligned(load_balance_map_pool, lbm, CLIB_CACHE_LINE_BYTES);
+
+    if (need_barrier_sync)
+        vlib_worker_thread_barrier_release(vm);
+
     memset(lbm, 0, sizeof(*lbm));
 
     vec_validate(lbm->lbm_paths, vec_len(paths)-1);
@@ -415,9 +427,16 @@ load_balance_map_init (load_balance_map_t *lbm,
     return (lbm);
 }
 
+/*
+ * Called a grace period after the last lock went, when no worker can
+ * still be using the map.
+ */
 static void
-load_balance_map_destroy (load_balance_map_t *lbm)
+load_balance_map_destroy (void *arg)
 {
+    load_balance_map_t *lbm;
+
+    lbm = load_balance_map_get(pointer_to_uword(arg));
     vec_free(lbm->lbm_paths);
     vec_free(lbm->lbm_buckets);
     pool_put(load_balance_map_pool, lbm);
@@ -477,7 +496,8 @@ load_balance_map_unlock (index_t lbmi)
     if (0 == lbm->lbm_locks)
     {
         load_balance_map_db_remove(lbm);
-        load_balance_map_destroy(lbm);
+        vlib_rcu_call(load_balance_map_destroy,
+                      uword_to_pointer(lbmi, void *));
     }
 }
 
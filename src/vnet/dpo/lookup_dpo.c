@@ -266,7 +266,7 @@ ip4_src_fib_lookup_one (u32 src_fib_index0,
     ip4_fib_mtrie_leaf_t leaf0;
     ip4_fib_mtrie_t * mtrie0;
 
-    mtrie0 = &ip4_fib_get (src_fib_index0)->mtrie;
+    mtrie0 = ip4_fib_get (src_fib_index0)->mtrie;
 
     leaf0 = ip4_fib_mtrie_lookup_step_one (mtrie0, addr0);
     leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, addr0, 2);
@@ -286,8 +286,8 @@ ip4_src_fib_lookup_two (u32 src_fib_index0,
     ip4_fib_mtrie_leaf_t leaf0, leaf1;
     ip4_fib_mtrie_t * mtrie0, * mtrie1;
 
-    mtrie0 = &ip4_fib_get (src_fib_index0)->mtrie;
-    mtrie1 = &ip4_fib_get (src_fib_index1)->mtrie;
+    mtrie0 = ip4_fib_get (src_fib_index0)->mtrie;
+    mtrie1 = ip4_fib_get (src_fib_index1)->mtrie;
 
     leaf0 = ip4_fib_mtrie_lookup_step_one (mtrie0, addr0);
     leaf1 = ip4_fib_mtrie_lookup_step_one (mtrie1, addr1);
@@ -54,9 +54,20 @@ format_fib_urpf_list (u8 *s, va_list *args)
 index_t
 fib_urpf_list_alloc_and_lock (void)
 {
+    vlib_main_t *vm = vlib_get_main();
     fib_urpf_list_t *urpf;
+    u8 need_barrier_sync;
+
+    /* the workers read the pool unlocked; stop them should it move */
+    pool_get_will_expand(fib_urpf_list_pool, need_barrier_sync);
+    if (need_barrier_sync)
+        vlib_worker_thread_barrier_sync(vm);
 
     pool_get(fib_urpf_list_pool, urpf);
+
+    if (need_barrier_sync)
+        vlib_worker_thread_barrier_release(vm);
+
     memset(urpf, 0, sizeof(*urpf));
 
     urpf->furpf_locks++;
@@ -64,6 +75,21 @@ fib_urpf_list_alloc_and_lock (void)
     return (urpf - fib_urpf_list_pool);
 }
 
+/*
+ * Called a grace period after the last lock went, when no worker can
+ * still be checking against the list.
+ */
+static void
+fib_urpf_list_destroy (void *arg)
+{
+    fib_urpf_list_t *urpf;
+
+    urpf = fib_urpf_list_get(pointer_to_uword(arg));
+
+    vec_free(urpf->furpf_itfs);
+    pool_put(fib_urpf_list_pool, urpf);
+}
+
 void
 fib_urpf_list_unlock (index_t ui)
 {
@@ -78,8 +104,8 @@ fib_urpf_list_unlock (index_t ui)
 
     if (0 == urpf->furpf_locks)
     {
-	vec_free(urpf->furpf_itfs);
-	pool_put(fib_urpf_list_pool, urpf);
+	vlib_rcu_call(fib_urpf_list_destroy,
+		      uword_to_pointer(ui, void *));
     }
 }
 
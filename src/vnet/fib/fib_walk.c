@@ -38,6 +38,10 @@ typedef enum fib_walk_flags_t_
      * An indication that the walk is currently executing.
      */
     FIB_WALK_FLAG_EXECUTING = (1 << 2),
+    /**
+     * A synchronous walk held until the end of the batch.
+     */
+    FIB_WALK_FLAG_HELD = (1 << 3),
 } fib_walk_flags_t;
 
 /**
@@ -95,6 +99,42 @@ typedef struct fib_walk_t_
  */
 static fib_walk_t *fib_walk_pool;
 
+/**
+ * @brief State of the batch of updates, see fib_walk_batch_begin()
+ */
+typedef struct fib_walk_batch_t_
+{
+    /**
+     * Depth of nested batches
+     */
+    u32 fwb_depth;
+
+    /**
+     * The parents of the held walks, in the order the walks were requested.
+     * A parent can appear again after its walk was run early.
+     */
+    u64 *fwb_parents;
+
+    /**
+     * The held walk of each parent
+     */
+    uword *fwb_walk_by_parent;
+
+    /**
+     * Number of walks held, and number merged into a held walk
+     */
+    u64 fwb_n_held;
+    u64 fwb_n_merged;
+} fib_walk_batch_t;
+
+static fib_walk_batch_t fib_walk_batch;
+
+static inline u64
+fib_walk_batch_key (const fib_node_ptr_t *parent)
+{
+    return (((u64) parent->fnp_type << 32) | parent->fnp_index);
+}
+
 /**
  * Statistics maintained per-walk queue
  */
@@ -246,6 +286,14 @@ fib_walk_destroy (index_t fwi)
     {
 	fib_node_list_elt_remove(fwalk->fw_prio_sibling);
     }
+    if (FIB_WALK_FLAG_HELD & fwalk->fw_flags)
+    {
+        /*
+         * a sync walk merged with, and so ran, this held walk
+         */
+        hash_unset(fib_walk_batch.fwb_walk_by_parent,
+                   fib_walk_batch_key(&fwalk->fw_parent));
+    }
     fib_node_child_remove(fwalk->fw_parent.fnp_type,
 			  fwalk->fw_parent.fnp_index,
 			  fwalk->fw_dep_sibling);
@@ -640,6 +688,46 @@ fib_walk_alloc (fib_node_type_t parent_type,
     return (fwalk);
 }
 
+/**
+ * @brief Merge the context of another walk onto this one, so that
+ * this one does the work of both.
+ */
+static void
+fib_walk_merge_ctx (fib_walk_t *fwalk,
+                    fib_node_back_walk_ctx_t *ctx)
+{
+    fib_node_back_walk_ctx_t *last;
+
+    /*
+     * check whether the walk context can be merged with the most recent.
+     * the most recent was the one last added and is thus at the back of the vector.
+     * we can merge walks if the reason for the walk is the same.
+     */
+    last = vec_end(fwalk->fw_ctx) - 1;
+
+    if (last->fnbw_reason == ctx->fnbw_reason)
+    {
+        /*
+         * copy the largest of the depth values. in the presence of a loop,
+         * the same walk will merge with itself. if we take the smaller depth
+         * then it will never end.
+         */
+        last->fnbw_depth = ((last->fnbw_depth >= ctx->fnbw_depth) ?
+                            last->fnbw_depth :
+                            ctx->fnbw_depth);
+    }
+    else
+    {
+        /*
+         * walks could not be merged, this means that the walk infront needs to
+         * perform different action to this one that has caught up. the one in
+         * front was scheduled first so append the new walk context to the back
+         * of the list.
+         */
+        vec_add1(fwalk->fw_ctx, *ctx);
+    }
+}
+
 /**
  * @brief Enqueue a walk onto the appropriate priority queue. Then signal
  * the background process there is work to do.
@@ -717,48 +805,15 @@ fib_walk_async (fib_node_type_t parent_type,
 }
 
 /**
- * @brief Back walk all the children of a FIB node.
- *
- * note this is a synchronous depth first walk. Children visited may propagate
- * the walk to thier children. Other children node types may not propagate,
- * synchronously but instead queue the walk for later async completion.
+ * @brief Run a synchronous walk to completion
  */
-void
-fib_walk_sync (fib_node_type_t parent_type,
-	       fib_node_index_t parent_index,
-	       fib_node_back_walk_ctx_t *ctx)
+static void
+fib_walk_sync_run (fib_node_index_t fwi)
 {
     fib_walk_advance_rc_t rc;
-    fib_node_index_t fwi;
     fib_walk_t *fwalk;
 
-    if (FIB_NODE_GRAPH_MAX_DEPTH < ++ctx->fnbw_depth)
-    {
-	/*
-	 * The walk has reached the maximum depth. there is a loop in the graph.
-	 * bail.
-	 */
-	return;
-    }
-    if (0 == fib_node_get_n_children(parent_type,
-                                     parent_index))
-    {
-        /*
-         * no children to walk - quit now
-         */
-        return;
-    }
-
-    fwalk = fib_walk_alloc(parent_type,
-			   parent_index,
-			   FIB_WALK_FLAG_SYNC,
-			   ctx);
-
-    fwalk->fw_dep_sibling = fib_node_child_add(parent_type,
-					       parent_index,
-					       FIB_NODE_TYPE_WALK,
-					       fib_walk_get_index(fwalk));
-    fwi = fib_walk_get_index(fwalk);
+    fwalk = fib_walk_get(fwi);
 
     while (1)
     {
@@ -831,6 +886,155 @@ fib_walk_sync (fib_node_type_t parent_type,
     }
 }
 
+/**
+ * @brief Hold a synchronous walk until the end of the batch, merging it
+ * with one already held for the same parent.
+ */
+static void
+fib_walk_batch_hold (fib_node_type_t parent_type,
+                     fib_node_index_t parent_index,
+                     fib_node_back_walk_ctx_t *ctx)
+{
+    fib_node_ptr_t parent = {
+        .fnp_type = parent_type,
+        .fnp_index = parent_index,
+    };
+    fib_walk_t *fwalk;
+    uword *p;
+
+    p = hash_get(fib_walk_batch.fwb_walk_by_parent,
+                 fib_walk_batch_key(&parent));
+
+    if (NULL != p)
+    {
+        fwalk = fib_walk_get(p[0]);
+        fib_walk_merge_ctx(fwalk, ctx);
+        fib_walk_batch.fwb_n_merged++;
+        return;
+    }
+
+    fwalk = fib_walk_alloc(parent_type,
+			   parent_index,
+			   FIB_WALK_FLAG_SYNC | FIB_WALK_FLAG_HELD,
+			   ctx);
+
+    /*
+     * as a child of the parent the walk holds a lock on it, and other
+     * walks of the parent meet and merge with it.
+     */
+    fwalk->fw_dep_sibling = fib_node_child_add(parent_type,
+					       parent_index,
+					       FIB_NODE_TYPE_WALK,
+					       fib_walk_get_index(fwalk));
+
+    hash_set(fib_walk_batch.fwb_walk_by_parent,
+             fib_walk_batch_key(&parent),
+             fib_walk_get_index(fwalk));
+    vec_add1(fib_walk_batch.fwb_parents, fib_walk_batch_key(&parent));
+    fib_walk_batch.fwb_n_held++;
+}
+
+/**
+ * @brief Back walk all the children of a FIB node.
+ *
+ * note this is a synchronous depth first walk. Children visited may propagate
+ * the walk to thier children. Other children node types may not propagate,
+ * synchronously but instead queue the walk for later async completion.
+ * Within a batch the walk is held until the batch ends, unless its
+ * originator insists it is synchronous.
+ */
+void
+fib_walk_sync (fib_node_type_t parent_type,
+	       fib_node_index_t parent_index,
+	       fib_node_back_walk_ctx_t *ctx)
+{
+    fib_walk_t *fwalk;
+
+    if (FIB_NODE_GRAPH_MAX_DEPTH < ++ctx->fnbw_depth)
+    {
+	/*
+	 * The walk has reached the maximum depth. there is a loop in the graph.
+	 * bail.
+	 */
+	return;
+    }
+    if (0 == fib_node_get_n_children(parent_type,
+                                     parent_index))
+    {
+        /*
+         * no children to walk - quit now
+         */
+        return;
+    }
+    if (0 != fib_walk_batch.fwb_depth &&
+        !(ctx->fnbw_flags & FIB_NODE_BW_FLAG_FORCE_SYNC))
+    {
+        fib_walk_batch_hold(parent_type, parent_index, ctx);
+        return;
+    }
+
+    fwalk = fib_walk_alloc(parent_type,
+			   parent_index,
+			   FIB_WALK_FLAG_SYNC,
+			   ctx);
+
+    fwalk->fw_dep_sibling = fib_node_child_add(parent_type,
+					       parent_index,
+					       FIB_NODE_TYPE_WALK,
+					       fib_walk_get_index(fwalk));
+
+    fib_walk_sync_run(fib_walk_get_index(fwalk));
+}
+
+void
+fib_walk_batch_begin (void)
+{
+    fib_walk_batch.fwb_depth++;
+}
+
+void
+fib_walk_batch_end (void)
+{
+    fib_walk_t *fwalk;
+    index_t fwi;
+    uword *p;
+    u32 ii;
+
+    ASSERT(fib_walk_batch.fwb_depth > 0);
+
+    if (0 != --fib_walk_batch.fwb_depth)
+    {
+        return;
+    }
+
+    /*
+     * the held walks may spawn more walks, which now run at once, and
+     * the vector of parents is not touched by them.
+     */
+    vec_foreach_index(ii, fib_walk_batch.fwb_parents)
+    {
+        p = hash_get(fib_walk_batch.fwb_walk_by_parent,
+                     fib_walk_batch.fwb_parents[ii]);
+
+        if (NULL == p)
+        {
+            /* already run, when another walk merged with it */
+            continue;
+        }
+        fwi = p[0];
+        hash_unset(fib_walk_batch.fwb_walk_by_parent,
+                   fib_walk_batch.fwb_parents[ii]);
+
+        fwalk = fib_walk_get(fwi);
+        fwalk->fw_flags &= ~FIB_WALK_FLAG_HELD;
+
+        fib_walk_sync_run(fwi);
+    }
+
+    vec_reset_length(fib_walk_batch.fwb_parents);
+    ASSERT(0 == hash_elts(fib_walk_batch.fwb_walk_by_parent));
+}
+
 static fib_node_t *
 fib_walk_get_node (fib_node_index_t index)
 {
@@ -867,39 +1071,11 @@ static fib_node_back_walk_rc_t
 fib_walk_back_walk_notify (fib_node_t *node,
 			   fib_node_back_walk_ctx_t *ctx)
 {
-    fib_node_back_walk_ctx_t *last;
     fib_walk_t *fwalk;
 
     fwalk = fib_walk_get_from_node(node);
 
-    /*
-     * check whether the walk context can be merged with the most recent.
-     * the most recent was the one last added and is thus at the back of the vector.
-     * we can merge walks if the reason for the walk is the same.
-     */
-    last = vec_end(fwalk->fw_ctx) - 1;
-
-    if (last->fnbw_reason == ctx->fnbw_reason)
-    {
-        /*
-         * copy the largest of the depth values. in the presence of a loop,
-         * the same walk will merge with itself. if we take the smaller depth
-         * then it will never end.
-         */
-        last->fnbw_depth = ((last->fnbw_depth >= ctx->fnbw_depth) ?
-                            last->fnbw_depth :
-                            ctx->fnbw_depth);
-    }
-    else
-    {
-        /*
-         * walks could not be merged, this means that the walk infront needs to
-         * perform different action to this one that has caught up. the one in
-         * front was scheduled first so append the new walk context to the back
-         * of the list.
-         */
-        vec_add1(fwalk->fw_ctx, *ctx);
-    }
+    fib_walk_merge_ctx(fwalk, ctx);
 
     return (FIB_NODE_BACK_WALK_MERGE);
 }
@@ -993,6 +1169,12 @@ fib_walk_show (vlib_main_t * vm,
 	}
     }
 
+    vlib_cli_output(vm, "FIB Walk batches:");
+    vlib_cli_output(vm, "  held:%lld merged:%lld pending:%d",
+                    fib_walk_batch.fwb_n_held,
+                    fib_walk_batch.fwb_n_merged,
+                    hash_elts(fib_walk_batch.fwb_walk_by_parent));
+
     vlib_cli_output(vm, "Histogram Statistics:");
     vlib_cli_output(vm, " Number of Elements visit per-quota:");
     for (ii = 0; ii < N_ELTS_BUCKETS; ii++)
@@ -52,6 +52,20 @@ extern void fib_walk_sync(fib_node_type_t parent_type,
                           fib_node_index_t parent_index,
                           fib_node_back_walk_ctx_t *ctx);
 
+/**
+ * @brief Begin a batch of updates.
+ * Until the matching fib_walk_batch_end() synchronous walks are held,
+ * and all walks of the same parent are merged into one, so that a child
+ * affected by many updates in the batch is visited once. Batches nest.
+ */
+extern void fib_walk_batch_begin(void);
+
+/**
+ * @brief End a batch of updates, running the walks it held in the order
+ * they were requested.
+ */
+extern void fib_walk_batch_end(void);
+
 extern u8* format_fib_walk_priority(u8 *s, va_list *ap);
 
 extern void fib_walk_process_enable(void);
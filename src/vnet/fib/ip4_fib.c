@@ -100,6 +100,37 @@ static const ip4_fib_table_special_prefix_t ip4_specials[] = {
 };
 
 
+ip4_fib_mtrie_type_t
+ip4_fib_table_get_mtrie_type (u32 table_id)
+{
+    uword *p;
+
+    p = hash_get(ip4_main.mtrie_type_by_table_id, table_id);
+
+    if (NULL != p)
+    {
+        return (p[0]);
+    }
+    return (ip4_main.mtrie_type_default);
+}
+
+int
+ip4_fib_table_set_mtrie_type (u32 table_id,
+                              ip4_fib_mtrie_type_t type)
+{
+    if (~0 != ip4_fib_index_from_table_id(table_id))
+    {
+        /*
+         * changing the layout means rebuilding the trie under the workers
+         */
+        return (VNET_API_ERROR_VALUE_EXIST);
+    }
+
+    hash_set(ip4_main.mtrie_type_by_table_id, table_id, type);
+
+    return (0);
+}
+
 static u32
 ip4_create_fib_with_table_id (u32 table_id,
                               fib_source_t src)
@@ -134,7 +165,8 @@ ip4_create_fib_with_table_id (u32 table_id,
     
     fib_table_lock(fib_table->ft_index, FIB_PROTOCOL_IP4, src);
 
-    ip4_mtrie_init(&v4_fib->mtrie);
+    v4_fib->mtrie =
+        ip4_mtrie_alloc(ip4_fib_table_get_mtrie_type(table_id));
 
     /*
      * add the special entries into the new FIB
@@ -194,7 +226,7 @@ ip4_fib_table_destroy (u32 fib_index)
 	hash_unset (ip4_main.fib_index_by_table_id, fib_table->ft_table_id);
     }
 
-    ip4_mtrie_free(&v4_fib->mtrie);
+    ip4_mtrie_free(v4_fib->mtrie);
 
     pool_put(ip4_main.v4_fibs, v4_fib);
     pool_put(ip4_main.fibs, fib_table);
@@ -383,7 +415,7 @@ ip4_fib_table_fwding_dpo_update (ip4_fib_t *fib,
 				 u32 len,
 				 const dpo_id_t *dpo)
 {
-    ip4_fib_mtrie_route_add(&fib->mtrie, addr, len, dpo->dpoi_index);
+    ip4_fib_mtrie_route_add(fib->mtrie, addr, len, dpo->dpoi_index);
 }
 
 void
@@ -406,7 +438,7 @@ ip4_fib_table_fwding_dpo_remove (ip4_fib_t *fib,
     fib_entry_get_prefix(cover_index, &cover_prefix);
     cover_dpo = fib_entry_contribute_ip_forwarding(cover_index);
 
-    ip4_fib_mtrie_route_del(&fib->mtrie,
+    ip4_fib_mtrie_route_del(fib->mtrie,
                             addr, len, dpo->dpoi_index,
                             cover_prefix.fp_len,
                             cover_dpo->dpoi_index);
@@ -641,7 +673,7 @@ ip4_show_fib (vlib_main_t * vm,
         {
             uword mtrie_size, hash_size;
 
-            mtrie_size = ip4_fib_mtrie_memory_usage(&fib->mtrie);
+            mtrie_size = ip4_fib_mtrie_memory_usage(fib->mtrie);
             hash_size = 0;
 
 	    for (i = 0; i < ARRAY_LEN (fib->fib_entry_by_dst_address); i++)
@@ -653,10 +685,12 @@ ip4_show_fib (vlib_main_t * vm,
                 }
             }
             if (verbose)
-                vlib_cli_output (vm, "%U mtrie:%d hash:%d",
+                vlib_cli_output (vm, "%U mtrie:%d (%U) hash:%d",
                                  format_fib_table_name, fib->index,
                                  FIB_PROTOCOL_IP4,
                                  mtrie_size,
+                                 format_ip4_fib_mtrie_type,
+                                 fib->mtrie->type,
                                  hash_size);
             total_mtrie_memory += mtrie_size;
             total_hash_memory += hash_size;
@@ -685,7 +719,7 @@ ip4_show_fib (vlib_main_t * vm,
 	/* Show summary? */
 	if (mtrie)
         {
-	    vlib_cli_output (vm, "%U", format_ip4_fib_mtrie, &fib->mtrie, verbose);
+	    vlib_cli_output (vm, "%U", format_ip4_fib_mtrie, fib->mtrie, verbose);
             continue;
         }
 	if (! verbose)
@@ -40,9 +40,10 @@ typedef struct ip4_fib_t_
 {
   /**
    * Mtrie for fast lookups. Hash is used to maintain overlapping prefixes.
-   * First member so it's in the first cacheline.
+   * First member so it's in the first cacheline. Its size depends on its
+   * layout, so it is not embedded.
    */
-  ip4_fib_mtrie_t mtrie;
+  ip4_fib_mtrie_t *mtrie;
 
   /* Hash table for each prefix length mapping. */
   uword *fib_entry_by_dst_address[33];
@@ -158,6 +159,14 @@ u32 ip4_fib_index_from_table_id (u32 table_id)
 
 extern u32 ip4_fib_table_get_index_for_sw_if_index(u32 sw_if_index);
 
+/**
+ * @brief Choose the layout of the mtrie of the table, when it is created.
+ * @returns VNET_API_ERROR_VALUE_EXIST if the table already exists.
+ */
+extern int ip4_fib_table_set_mtrie_type(u32 table_id,
+                                        ip4_fib_mtrie_type_t type);
+extern ip4_fib_mtrie_type_t ip4_fib_table_get_mtrie_type(u32 table_id);
+
 always_inline index_t
 ip4_fib_forwarding_lookup (u32 fib_index,
                            const ip4_address_t * addr)
@@ -165,7 +174,7 @@ ip4_fib_forwarding_lookup (u32 fib_index,
     ip4_fib_mtrie_leaf_t leaf;
     ip4_fib_mtrie_t * mtrie;
 
-    mtrie = &ip4_fib_get(fib_index)->mtrie;
+    mtrie = ip4_fib_get(fib_index)->mtrie;
 
     leaf = ip4_fib_mtrie_lookup_step_one (mtrie, addr);
     leaf = ip4_fib_mtrie_lookup_step (mtrie, leaf, addr, 2);
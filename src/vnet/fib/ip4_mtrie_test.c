@@ -0,0 +1,398 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vnet/ip/ip.h>
+#include <vnet/ip/ip4_mtrie.h>
+#include <vppinfra/random.h>
+
+/*
+ * Unit tests, and a comparison of the memory use and lookup rate, of the
+ * mtrie's layouts. The tries are built standalone, i.e. without a FIB,
+ * and checked against a reference table of hashes per-prefix length.
+ */
+
+#define MTRIE_TEST_I(_cond, _comment, _args...)			\
+({								\
+    int _evald = (_cond);					\
+    if (!(_evald)) {						\
+	fformat(stderr, "FAIL:%d: " _comment "\n",		\
+		__LINE__, ##_args);				\
+    }								\
+    _evald;							\
+})
+#define MTRIE_TEST(_cond, _comment, _args...)			\
+{								\
+    if (!MTRIE_TEST_I(_cond, _comment, ##_args)) {		\
+	return 1;                                               \
+	ASSERT(!("FAIL: " _comment));				\
+    }								\
+}
+
+/**
+ * The reference; the LB index of each prefix, in a hash per-length
+ */
+typedef struct mtrie_test_ref_t_
+{
+    uword *mtr_by_addr[33];
+} mtrie_test_ref_t;
+
+typedef struct mtrie_test_route_t_
+{
+    ip4_address_t mtr_addr;
+    u32 mtr_len;
+    u32 mtr_lbi;
+} mtrie_test_route_t;
+
+static u32
+mtrie_test_ref_lookup (const mtrie_test_ref_t *ref,
+                       const ip4_address_t *addr,
+                       i32 max_len,
+                       u32 *len)
+{
+    uword *p;
+    i32 ii;
+
+    for (ii = max_len; ii >= 0; ii--)
+    {
+        p = hash_get(ref->mtr_by_addr[ii],
+                     addr->as_u32 & ip4_main.fib_masks[ii]);
+        if (NULL != p)
+        {
+            *len = ii;
+            return (p[0]);
+        }
+    }
+
+    /* nothing matches, as the mtrie's empty leaf */
+    *len = 0;
+    return (0);
+}
+
+static u32
+mtrie_test_lookup (const ip4_fib_mtrie_t *m,
+                   const ip4_address_t *addr)
+{
+    ip4_fib_mtrie_leaf_t leaf;
+
+    leaf = ip4_fib_mtrie_lookup_step_one(m, addr);
+    leaf = ip4_fib_mtrie_lookup_step(m, leaf, addr, 2);
+    leaf = ip4_fib_mtrie_lookup_step(m, leaf, addr, 3);
+
+    return (ip4_fib_mtrie_leaf_get_adj_index(leaf));
+}
+
+static int
+mtrie_test_validate (const ip4_fib_mtrie_t *m,
+                     const mtrie_test_ref_t *ref,
+                     const mtrie_test_route_t *routes,
+                     const ip4_address_t *addrs)
+{
+    const mtrie_test_route_t *r;
+    const ip4_address_t *a;
+    ip4_address_t addr;
+    u32 lbi, len;
+
+    vec_foreach(r, routes)
+    {
+        /* the first and last address of each route's range */
+        addr = r->mtr_addr;
+        lbi = mtrie_test_ref_lookup(ref, &addr, 32, &len);
+        MTRIE_TEST(lbi == mtrie_test_lookup(m, &addr),
+                   "%U: %U is %d, not %d",
+                   format_ip4_fib_mtrie_type, m->type,
+                   format_ip4_address, &addr,
+                   mtrie_test_lookup(m, &addr), lbi);
+
+        addr.as_u32 |= ~ip4_main.fib_masks[r->mtr_len];
+        lbi = mtrie_test_ref_lookup(ref, &addr, 32, &len);
+        MTRIE_TEST(lbi == mtrie_test_lookup(m, &addr),
+                   "%U: %U is %d, not %d",
+                   format_ip4_fib_mtrie_type, m->type,
+                   format_ip4_address, &addr,
+                   mtrie_test_lookup(m, &addr), lbi);
+    }
+    vec_foreach(a, addrs)
+    {
+        lbi = mtrie_test_ref_lookup(ref, a, 32, &len);
+        MTRIE_TEST(lbi == mtrie_test_lookup(m, a),
+                   "%U: %U is %d, not %d",
+                   format_ip4_fib_mtrie_type, m->type,
+                   format_ip4_address, a,
+                   mtrie_test_lookup(m, a), lbi);
+    }
+
+    return (0);
+}
+
+static void
+mtrie_test_route_del (ip4_fib_mtrie_t *m,
+                      const mtrie_test_ref_t *ref,
+                      const mtrie_test_route_t *r)
+{
+    u32 cover_lbi, cover_len;
+
+    cover_lbi = mtrie_test_ref_lookup(ref, &r->mtr_addr,
+                                      (i32) r->mtr_len - 1,
+                                      &cover_len);
+
+    ip4_fib_mtrie_route_del(m, &r->mtr_addr, r->mtr_len, r->mtr_lbi,
+                            cover_len, cover_lbi);
+}
+
+/**
+ * The lookup rate of the layout, taking the steps four addresses at a
+ * time as the ip4-lookup node does.
+ */
+static f64
+mtrie_test_lookup_rate (vlib_main_t *vm,
+                        const ip4_fib_mtrie_t *m,
+                        const ip4_address_t *addrs,
+                        u32 n_rounds,
+                        u32 *sum)
+{
+    ip4_fib_mtrie_leaf_t leaf0, leaf1, leaf2, leaf3;
+    u32 ii, jj, n_addrs;
+    f64 t[2];
+
+    n_addrs = vec_len(addrs) & ~3;
+    t[0] = vlib_time_now(vm);
+
+    for (jj = 0; jj < n_rounds; jj++)
+    {
+        for (ii = 0; ii < n_addrs; ii += 4)
+        {
+            leaf0 = ip4_fib_mtrie_lookup_step_one(m, &addrs[ii + 0]);
+            leaf1 = ip4_fib_mtrie_lookup_step_one(m, &addrs[ii + 1]);
+            leaf2 = ip4_fib_mtrie_lookup_step_one(m, &addrs[ii + 2]);
+            leaf3 = ip4_fib_mtrie_lookup_step_one(m, &addrs[ii + 3]);
+
+            leaf0 = ip4_fib_mtrie_lookup_step(m, leaf0, &addrs[ii + 0], 2);
+            leaf1 = ip4_fib_mtrie_lookup_step(m, leaf1, &addrs[ii + 1], 2);
+            leaf2 = ip4_fib_mtrie_lookup_step(m, leaf2, &addrs[ii + 2], 2);
+            leaf3 = ip4_fib_mtrie_lookup_step(m, leaf3, &addrs[ii + 3], 2);
+
+            leaf0 = ip4_fib_mtrie_lookup_step(m, leaf0, &addrs[ii + 0], 3);
+            leaf1 = ip4_fib_mtrie_lookup_step(m, leaf1, &addrs[ii + 1], 3);
+            leaf2 = ip4_fib_mtrie_lookup_step(m, leaf2, &addrs[ii + 2], 3);
+            leaf3 = ip4_fib_mtrie_lookup_step(m, leaf3, &addrs[ii + 3], 3);
+
+            /* keep the compiler from discarding the lookups */
+            *sum += (ip4_fib_mtrie_leaf_get_adj_index(leaf0) +
+                     ip4_fib_mtrie_leaf_get_adj_index(leaf1) +
+                     ip4_fib_mtrie_leaf_get_adj_index(leaf2) +
+                     ip4_fib_mtrie_leaf_get_adj_index(leaf3));
+        }
+    }
+
+    t[1] = vlib_time_now(vm);
+
+    return ((f64) n_addrs * n_rounds / (t[1] - t[0]));
+}
+
+static int
+mtrie_test (vlib_main_t *vm,
+            u32 n_routes,
+            u32 n_lookups,
+            u32 seed)
+{
+    ip4_fib_mtrie_t *mtries[IP4_FIB_MTRIE_N_TYPES], *m;
+    mtrie_test_route_t *routes, *r;
+    ip4_fib_mtrie_type_t type;
+    ip4_address_t *addrs, *a;
+    mtrie_test_ref_t ref;
+    uword empty_size[2];
+    u32 ii, sum = 0;
+    int res = 0;
+
+    memset(&ref, 0, sizeof(ref));
+    routes = NULL;
+    addrs = NULL;
+
+    /*
+     * Random routes, biased, as are real tables, towards /16 to /24
+     */
+    for (ii = 0; ii < n_routes; ii++)
+    {
+        mtrie_test_route_t route;
+        u32 rnd;
+
+        rnd = random_u32(&seed);
+        route.mtr_len = ((rnd & 3) ? 16 + (rnd >> 2) % 9 : (rnd >> 2) % 33);
+        route.mtr_addr.as_u32 = (random_u32(&seed) &
+                                 ip4_main.fib_masks[route.mtr_len]);
+        route.mtr_lbi = ii + 1;
+
+        if (NULL != hash_get(ref.mtr_by_addr[route.mtr_len],
+                             route.mtr_addr.as_u32))
+            continue;
+
+        hash_set(ref.mtr_by_addr[route.mtr_len],
+                 route.mtr_addr.as_u32, route.mtr_lbi);
+        vec_add1(routes, route);
+    }
+    vec_validate(addrs, n_lookups - 1);
+    vec_foreach(a, addrs)
+    {
+        a->as_u32 = random_u32(&seed);
+    }
+
+    vlib_cli_output(vm, "%d routes, %d addresses", vec_len(routes), n_lookups);
+
+    FOR_EACH_IP4_FIB_MTRIE_TYPE(type)
+    {
+        m = mtries[type] = ip4_mtrie_alloc(type);
+        empty_size[type] = ip4_fib_mtrie_memory_usage(m);
+
+        vec_foreach(r, routes)
+        {
+            ip4_fib_mtrie_route_add(m, &r->mtr_addr, r->mtr_len, r->mtr_lbi);
+        }
+        if (mtrie_test_validate(m, &ref, routes, addrs))
+        {
+            res = 1;
+            goto done;
+        }
+    }
+
+    /*
+     * compare the layouts, on the full tables
+     */
+    FOR_EACH_IP4_FIB_MTRIE_TYPE(type)
+    {
+        m = mtries[type];
+        vlib_cli_output(vm, "%U: empty %U, full %U, %.6e lookups/sec",
+                        format_ip4_fib_mtrie_type, type,
+                        format_memory_size, empty_size[type],
+                        format_memory_size, ip4_fib_mtrie_memory_usage(m),
+                        mtrie_test_lookup_rate(vm, m, addrs, 16, &sum));
+    }
+
+    /*
+     * remove the first half, in the reverse of the order they were
+     * added, so some are removed from under their more specifics
+     */
+    for (ii = vec_len(routes) / 2; ii > 0; ii--)
+    {
+        r = &routes[ii - 1];
+
+        hash_unset(ref.mtr_by_addr[r->mtr_len], r->mtr_addr.as_u32);
+
+        FOR_EACH_IP4_FIB_MTRIE_TYPE(type)
+        {
+            mtrie_test_route_del(mtries[type], &ref, r);
+        }
+    }
+    vec_delete(routes, vec_len(routes) / 2, 0);
+
+    FOR_EACH_IP4_FIB_MTRIE_TYPE(type)
+    {
+        if (mtrie_test_validate(mtries[type], &ref, routes, addrs))
+        {
+            res = 1;
+            goto done;
+        }
+    }
+
+    /*
+     * and the rest, leaving the tries as they were made
+     */
+    vec_foreach(r, routes)
+    {
+        hash_unset(ref.mtr_by_addr[r->mtr_len], r->mtr_addr.as_u32);
+
+        FOR_EACH_IP4_FIB_MTRIE_TYPE(type)
+        {
+            mtrie_test_route_del(mtries[type], &ref, r);
+        }
+    }
+    FOR_EACH_IP4_FIB_MTRIE_TYPE(type)
+    {
+        if (mtrie_test_validate(mtries[type], &ref, NULL, addrs))
+        {
+            res = 1;
+            goto done;
+        }
+        if (!MTRIE_TEST_I(empty_size[type] ==
+                          ip4_fib_mtrie_memory_usage(mtries[type]),
+                          "%U: all plies freed",
+                          format_ip4_fib_mtrie_type, type))
+        {
+            res = 1;
+            goto done;
+        }
+    }
+
+done:
+    FOR_EACH_IP4_FIB_MTRIE_TYPE(type)
+    {
+        if (res)
+        {
+            /* the trie is not empty; leak it rather than assert */
+            continue;
+        }
+        ip4_mtrie_free(mtries[type]);
+    }
+    for (ii = 0; ii < ARRAY_LEN(ref.mtr_by_addr); ii++)
+    {
+        hash_free(ref.mtr_by_addr[ii]);
+    }
+    vec_free(routes);
+    vec_free(addrs);
+
+    return (res);
+}
+
+static clib_error_t *
+mtrie_test_cli (vlib_main_t * vm,
+                unformat_input_t * input,
+                vlib_cli_command_t * cmd_arg)
+{
+    u32 n_routes, n_lookups, seed;
+
+    n_routes = 10000;
+    n_lookups = 1 << 16;
+    seed = 0xdeaddabe;
+
+    while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+        if (unformat (input, "routes %d", &n_routes))
+            ;
+        else if (unformat (input, "lookups %d", &n_lookups))
+            ;
+        else if (unformat (input, "seed %d", &seed))
+            ;
+        else
+            return (clib_error_return(0, "unknown input '%U'",
+                                      format_unformat_error, input));
+    }
+
+    if (0 == n_lookups)
+    {
+        return (clib_error_return(0, "no lookups"));
+    }
+
+    if (mtrie_test(vm, n_routes, n_lookups, seed))
+    {
+        return clib_error_return(0, "MTRIE Unit Test Failed");
+    }
+    return (NULL);
+}
+
+VLIB_CLI_COMMAND (test_mtrie_command, static) = {
+    .path = "test mtrie",
+    .short_help = "mtrie unit tests - DO NOT RUN ON A LIVE SYSTEM "
+                  "[routes <n>] [lookups <n>] [seed <n>]",
+    .function = mtrie_test_cli,
+};
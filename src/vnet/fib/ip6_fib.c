@@ -83,6 +83,8 @@ create_fib_with_table_id (u32 table_id,
     fib_table->ft_flags = flags;
     fib_table->ft_desc = desc;
 
+    ip6_lpm_init(&v6_fib->lpm, fib_table->ft_index);
+
     vnet_ip6_fib_init(fib_table->ft_index);
     fib_table_lock(fib_table->ft_index, FIB_PROTOCOL_IP6, src);
 
@@ -161,6 +163,7 @@ ip6_fib_table_destroy (u32 fib_index)
     {
 	hash_unset (ip6_main.fib_index_by_table_id, fib_table->ft_table_id);
     }
+    ip6_lpm_free(&ip6_fib_get(fib_index)->lpm);
     pool_put_index(ip6_main.v6_fibs, fib_table->ft_index);
     pool_put(ip6_main.fibs, fib_table);
 }
@@ -339,28 +342,12 @@ ip6_fib_table_fwding_dpo_update (u32 fib_index,
 				 u32 len,
 				 const dpo_id_t *dpo)
 {
-    ip6_fib_table_instance_t *table;
-    BVT(clib_bihash_kv) kv;
-    ip6_address_t *mask;
-    u64 fib;
-
-    table = &ip6_main.ip6_table[IP6_FIB_TABLE_FWDING];
-    mask = &ip6_main.fib_masks[len];
-    fib = ((u64)((fib_index))<<32);
-
-    kv.key[0] = addr->as_u64[0] & mask->as_u64[0];
-    kv.key[1] = addr->as_u64[1] & mask->as_u64[1];
-    kv.key[2] = fib | len;
-    kv.value = dpo->dpoi_index;
-
-    BV(clib_bihash_add_del)(&table->ip6_hash, &kv, 1);
-
-    table->dst_address_length_refcounts[len]++;
-
-    table->non_empty_dst_address_length_bitmap =
-        clib_bitmap_set (table->non_empty_dst_address_length_bitmap, 
-			 128 - len, 1);
-    compute_prefix_lengths_in_search_order (table);
+    /*
+     * the route, and the markers of the binary search that lead to it,
+     * go in the FWDING table
+     */
+    ip6_lpm_route_add(&ip6_fib_get(fib_index)->lpm,
+                      addr, len, dpo->dpoi_index);
 }
 
 void
@@ -369,31 +356,7 @@ ip6_fib_table_fwding_dpo_remove (u32 fib_index,
 				 u32 len,
 				 const dpo_id_t *dpo)
 {
-    ip6_fib_table_instance_t *table;
-    BVT(clib_bihash_kv) kv;
-    ip6_address_t *mask;
-    u64 fib;
-
-    table = &ip6_main.ip6_table[IP6_FIB_TABLE_FWDING];
-    mask = &ip6_main.fib_masks[len];
-    fib = ((u64)((fib_index))<<32);
-
-    kv.key[0] = addr->as_u64[0] & mask->as_u64[0];
-    kv.key[1] = addr->as_u64[1] & mask->as_u64[1];
-    kv.key[2] = fib | len;
-    kv.value = dpo->dpoi_index;
-
-    BV(clib_bihash_add_del)(&table->ip6_hash, &kv, 0);
-
-    /* refcount accounting */
-    ASSERT (table->dst_address_length_refcounts[len] > 0);
-    if (--table->dst_address_length_refcounts[len] == 0)
-    {
-	table->non_empty_dst_address_length_bitmap =
-            clib_bitmap_set (table->non_empty_dst_address_length_bitmap,
-                             128 - len, 0);
-	compute_prefix_lengths_in_search_order (table);
-    }
+    ip6_lpm_route_del(&ip6_fib_get(fib_index)->lpm, addr, len);
 }
 
 /**
@@ -568,6 +531,7 @@ ip6_fib_table_show_one (ip6_fib_t *fib,
 u8 *
 format_ip6_fib_table_memory (u8 * s, va_list * args)
 {
+    ip6_fib_t *v6_fib;
     uword bytes_inuse;
 
     bytes_inuse = 
@@ -578,6 +542,11 @@ format_ip6_fib_table_memory (u8 * s, va_list * args)
         ip6_main.ip6_table[IP6_FIB_TABLE_FWDING].ip6_hash.alloc_arena_next
         - ip6_main.ip6_table[IP6_FIB_TABLE_FWDING].ip6_hash.alloc_arena;
 
+    pool_foreach (v6_fib, ip6_main.v6_fibs,
+    ({
+        bytes_inuse += ip6_lpm_memory_usage(&v6_fib->lpm);
+    }));
+
     s = format(s, "%=30s %=6d %=8ld\n",
                "IPv6 unicast",
                pool_elts(ip6_main.fibs),
@@ -701,6 +670,7 @@ ip6_show_fib (vlib_main_t * vm,
 		    vlib_cli_output (vm, "%=20d%=16lld", 
 				     len, ca->count_by_prefix_length[len]);
             }
+	    vlib_cli_output (vm, "  forwarding: %U", format_ip6_lpm, &fib->lpm);
 	    continue;
 	}
 
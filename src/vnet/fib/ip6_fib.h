@@ -63,43 +63,155 @@ extern void ip6_fib_table_walk(u32 fib_index,
                                fib_table_walk_fn_t fn,
                                void *ctx);
 
+/**
+ * @brief The longest prefix match of the address in the FIB's binary
+ * search on prefix lengths.
+ * A hit, on a route or a marker, is the best match so far and there may
+ * be better at longer lengths; a miss means there are none.
+ */
 always_inline u32
-ip6_fib_table_fwding_lookup (ip6_main_t * im,
-                             u32 fib_index,
-                             const ip6_address_t * dst)
+ip6_fib_lpm_lookup (const ip6_lpm_t *lpm,
+                    const ip6_address_t * dst)
 {
     ip6_fib_table_instance_t *table;
-    int i, len;
-    int rv;
     BVT(clib_bihash_kv) kv, value;
+    const ip6_address_t *mask;
+    const u8 *lengths;
+    i32 lo, hi, mid;
+    u32 lbi, len;
     u64 fib;
 
     table = &ip6_main.ip6_table[IP6_FIB_TABLE_FWDING];
-    len = vec_len (table->prefix_lengths_in_search_order);
+    lengths = lpm->lengths;
+    fib = ((u64)((lpm->fib_index))<<32);
+    lbi = 0;
+    lo = 0;
+    hi = vec_len(lengths) - 1;
+
+    while (lo <= hi)
+    {
+        mid = (lo + hi) >> 1;
+        len = lengths[mid];
+        mask = &ip6_main.fib_masks[len];
 
-    kv.key[0] = dst->as_u64[0];
-    kv.key[1] = dst->as_u64[1];
-    fib = ((u64)((fib_index))<<32);
+        kv.key[0] = dst->as_u64[0] & mask->as_u64[0];
+        kv.key[1] = dst->as_u64[1] & mask->as_u64[1];
+        kv.key[2] = fib | len;
 
-    for (i = 0; i < len; i++)
+        if (0 == BV(clib_bihash_search_inline_2)(&table->ip6_hash,
+                                                 &kv, &value))
+        {
+            lbi = value.value;
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+
+    /* the default route is always present */
+    return (lbi);
+}
+
+/**
+ * @brief The lookup of four addresses, the probes of each step of their
+ * searches made together, so the misses on the bihash overlap.
+ */
+always_inline void
+ip6_fib_lpm_lookup_x4 (const ip6_lpm_t **lpm,
+                       const ip6_address_t **dst,
+                       u32 *lbi)
+{
+    BVT(clib_bihash_kv) kv[4];
+    BVT(clib_bihash) *h;
+    const ip6_address_t *mask;
+    const u8 *lengths[4];
+    i32 lo[4], hi[4], mid[4];
+    u32 ii, len, active;
+    u64 hash[4];
+
+    h = &ip6_main.ip6_table[IP6_FIB_TABLE_FWDING].ip6_hash;
+    active = 0;
+
+    for (ii = 0; ii < 4; ii++)
     {
-	int dst_address_length = table->prefix_lengths_in_search_order[i];
-	ip6_address_t * mask = &ip6_main.fib_masks[dst_address_length];
-
-	ASSERT(dst_address_length >= 0 && dst_address_length <= 128);
-	//As lengths are decreasing, masks are increasingly specific.
-	kv.key[0] &= mask->as_u64[0];
-	kv.key[1] &= mask->as_u64[1];
-	kv.key[2] = fib | dst_address_length;
-
-	rv = BV(clib_bihash_search_inline_2)(&table->ip6_hash, &kv, &value);
-	if (rv == 0)
-	    return value.value;
+        lengths[ii] = lpm[ii]->lengths;
+        lbi[ii] = 0;
+        lo[ii] = 0;
+        hi[ii] = vec_len(lengths[ii]) - 1;
+
+        if (lo[ii] <= hi[ii])
+            active |= (1 << ii);
     }
 
-    /* default route is always present */
-    ASSERT(0);
-    return 0;
+    while (active)
+    {
+        for (ii = 0; ii < 4; ii++)
+        {
+            if (!(active & (1 << ii)))
+                continue;
+
+            mid[ii] = (lo[ii] + hi[ii]) >> 1;
+            len = lengths[ii][mid[ii]];
+            mask = &ip6_main.fib_masks[len];
+
+            kv[ii].key[0] = dst[ii]->as_u64[0] & mask->as_u64[0];
+            kv[ii].key[1] = dst[ii]->as_u64[1] & mask->as_u64[1];
+            kv[ii].key[2] = ((u64)((lpm[ii]->fib_index))<<32) | len;
+
+            hash[ii] = BV(clib_bihash_hash)(&kv[ii]);
+            BV(clib_bihash_prefetch_bucket)(h, hash[ii]);
+        }
+        for (ii = 0; ii < 4; ii++)
+        {
+            if (active & (1 << ii))
+                BV(clib_bihash_prefetch_data)(h, hash[ii]);
+        }
+        for (ii = 0; ii < 4; ii++)
+        {
+            if (!(active & (1 << ii)))
+                continue;
+
+            if (0 == BV(clib_bihash_search_inline_with_hash)(h, hash[ii],
+                                                            &kv[ii]))
+            {
+                lbi[ii] = kv[ii].value;
+                lo[ii] = mid[ii] + 1;
+            }
+            else
+            {
+                hi[ii] = mid[ii] - 1;
+            }
+            if (lo[ii] > hi[ii])
+                active &= ~(1 << ii);
+        }
+    }
+}
+
+always_inline u32
+ip6_fib_table_fwding_lookup (ip6_main_t * im,
+                             u32 fib_index,
+                             const ip6_address_t * dst)
+{
+    return (ip6_fib_lpm_lookup(&pool_elt_at_index(im->v6_fibs,
+                                                  fib_index)->lpm,
+                               dst));
+}
+
+always_inline void
+ip6_fib_table_fwding_lookup_x4 (ip6_main_t * im,
+                                const u32 *fib_index,
+                                const ip6_address_t **dst,
+                                u32 *lbi)
+{
+    const ip6_lpm_t *lpm[4];
+    u32 ii;
+
+    for (ii = 0; ii < 4; ii++)
+        lpm[ii] = &pool_elt_at_index(im->v6_fibs, fib_index[ii])->lpm;
+
+    ip6_fib_lpm_lookup_x4(lpm, dst, lbi);
 }
 
 /**
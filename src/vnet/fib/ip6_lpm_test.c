@@ -0,0 +1,441 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vnet/fib/ip6_fib.h>
+#include <vppinfra/random.h>
+
+/*
+ * Unit tests of the IPv6 binary search on prefix lengths, and a
+ * comparison of its cost per-lookup with that of probing each length in
+ * turn, as the number of distinct lengths grows.
+ * The search is built standalone, i.e. without a FIB, in the FWDING
+ * table under a FIB index that no FIB has. It is checked against a
+ * reference table, of the routes only, probed one length at a time.
+ */
+
+#define LPM_TEST_I(_cond, _comment, _args...)			\
+({								\
+    int _evald = (_cond);					\
+    if (!(_evald)) {						\
+	fformat(stderr, "FAIL:%d: " _comment "\n",		\
+		__LINE__, ##_args);				\
+    }								\
+    _evald;							\
+})
+#define LPM_TEST(_cond, _comment, _args...)			\
+{								\
+    if (!LPM_TEST_I(_cond, _comment, ##_args)) {		\
+	return 1;                                               \
+	ASSERT(!("FAIL: " _comment));				\
+    }								\
+}
+
+#define LPM_TEST_FIB_INDEX (~0 - 1)
+
+/**
+ * The reference; the routes in a bihash of their own, and their
+ * lengths, longest first.
+ */
+typedef struct lpm_test_ref_t_
+{
+    BVT(clib_bihash) ltr_hash;
+    u8 *ltr_lengths;
+} lpm_test_ref_t;
+
+typedef struct lpm_test_route_t_
+{
+    ip6_address_t ltr_addr;
+    u32 ltr_len;
+    u32 ltr_lbi;
+} lpm_test_route_t;
+
+static void
+lpm_test_ref_kv (BVT(clib_bihash_kv) *kv,
+                 const ip6_address_t *addr,
+                 u32 len)
+{
+    kv->key[0] = addr->as_u64[0] & ip6_main.fib_masks[len].as_u64[0];
+    kv->key[1] = addr->as_u64[1] & ip6_main.fib_masks[len].as_u64[1];
+    kv->key[2] = len;
+}
+
+/**
+ * The lookup as it was; a probe of each length, longest first
+ */
+static u32
+lpm_test_ref_lookup (lpm_test_ref_t *ref,
+                     const ip6_address_t *addr)
+{
+    BVT(clib_bihash_kv) kv, value;
+    u32 ii;
+
+    vec_foreach_index(ii, ref->ltr_lengths)
+    {
+        lpm_test_ref_kv(&kv, addr, ref->ltr_lengths[ii]);
+
+        if (0 == BV(clib_bihash_search_inline_2)(&ref->ltr_hash,
+                                                 &kv, &value))
+            return (value.value);
+    }
+
+    return (0);
+}
+
+static void
+lpm_test_random_addr (ip6_address_t *addr,
+                      u32 *seed)
+{
+    u32 ii;
+
+    for (ii = 0; ii < ARRAY_LEN(addr->as_u32); ii++)
+    {
+        addr->as_u32[ii] = random_u32(seed);
+    }
+}
+
+static int
+lpm_test_validate (const ip6_lpm_t *lpm,
+                   lpm_test_ref_t *ref,
+                   const ip6_address_t *addrs)
+{
+    const ip6_address_t *dst[4];
+    const ip6_lpm_t *lpms[4];
+    u32 ii, jj, lbi, lbis[4];
+
+    for (ii = 0; ii < 4; ii++)
+        lpms[ii] = lpm;
+
+    vec_foreach_index(ii, addrs)
+    {
+        lbi = lpm_test_ref_lookup(ref, &addrs[ii]);
+
+        LPM_TEST(lbi == ip6_fib_lpm_lookup(lpm, &addrs[ii]),
+                 "%U is %d, not %d",
+                 format_ip6_address, &addrs[ii],
+                 ip6_fib_lpm_lookup(lpm, &addrs[ii]), lbi);
+
+        if (ii & 3)
+            continue;
+        if (ii + 4 > vec_len(addrs))
+            break;
+
+        for (jj = 0; jj < 4; jj++)
+            dst[jj] = &addrs[ii + jj];
+        ip6_fib_lpm_lookup_x4(lpms, dst, lbis);
+
+        for (jj = 0; jj < 4; jj++)
+        {
+            lbi = lpm_test_ref_lookup(ref, dst[jj]);
+            LPM_TEST(lbi == lbis[jj],
+                     "x4: %U is %d, not %d",
+                     format_ip6_address, dst[jj], lbis[jj], lbi);
+        }
+    }
+
+    return (0);
+}
+
+static void
+lpm_test_route_add_del (ip6_lpm_t *lpm,
+                        lpm_test_ref_t *ref,
+                        const lpm_test_route_t *r,
+                        int is_add)
+{
+    BVT(clib_bihash_kv) kv;
+
+    lpm_test_ref_kv(&kv, &r->ltr_addr, r->ltr_len);
+    kv.value = r->ltr_lbi;
+    BV(clib_bihash_add_del)(&ref->ltr_hash, &kv, is_add);
+
+    if (is_add)
+        ip6_lpm_route_add(lpm, &r->ltr_addr, r->ltr_len, r->ltr_lbi);
+    else
+        ip6_lpm_route_del(lpm, &r->ltr_addr, r->ltr_len);
+}
+
+/**
+ * The cycles per-lookup of; the probe of each length, the binary
+ * search, and the binary search four at a time as the ip6-lookup node
+ * does it. Not inlined, lest the compiler discard the lookups, whose
+ * results are only summed.
+ */
+static never_inline void
+lpm_test_lookup_cost (const ip6_lpm_t *lpm,
+                      lpm_test_ref_t *ref,
+                      const ip6_address_t *addrs,
+                      u32 n_rounds,
+                      f64 *cost,
+                      u32 *sum)
+{
+    const ip6_address_t *dst[4];
+    const ip6_lpm_t *lpms[4];
+    u32 ii, jj, n_addrs, lbis[4];
+    u64 t[2];
+
+    n_addrs = vec_len(addrs) & ~3;
+
+    for (ii = 0; ii < 4; ii++)
+        lpms[ii] = lpm;
+
+    t[0] = clib_cpu_time_now();
+    for (jj = 0; jj < n_rounds; jj++)
+        for (ii = 0; ii < n_addrs; ii++)
+            *sum += lpm_test_ref_lookup(ref, &addrs[ii]);
+    t[1] = clib_cpu_time_now();
+    cost[0] = (f64) (t[1] - t[0]) / (n_addrs * n_rounds);
+
+    t[0] = clib_cpu_time_now();
+    for (jj = 0; jj < n_rounds; jj++)
+        for (ii = 0; ii < n_addrs; ii++)
+            *sum += ip6_fib_lpm_lookup(lpm, &addrs[ii]);
+    t[1] = clib_cpu_time_now();
+    cost[1] = (f64) (t[1] - t[0]) / (n_addrs * n_rounds);
+
+    t[0] = clib_cpu_time_now();
+    for (jj = 0; jj < n_rounds; jj++)
+        for (ii = 0; ii < n_addrs; ii += 4)
+        {
+            dst[0] = &addrs[ii + 0];
+            dst[1] = &addrs[ii + 1];
+            dst[2] = &addrs[ii + 2];
+            dst[3] = &addrs[ii + 3];
+            ip6_fib_lpm_lookup_x4(lpms, dst, lbis);
+            *sum += lbis[0] + lbis[1] + lbis[2] + lbis[3];
+        }
+    t[1] = clib_cpu_time_now();
+    cost[2] = (f64) (t[1] - t[0]) / (n_addrs * n_rounds);
+}
+
+static int
+lpm_test_one (vlib_main_t *vm,
+              u32 n_lengths,
+              u32 n_routes,
+              u32 n_lookups,
+              u32 *seed)
+{
+    lpm_test_route_t *routes, *r;
+    BVT(clib_bihash_kv) kv, value;
+    ip6_address_t *addrs, *a;
+    uword empty_size, *lengths;
+    lpm_test_ref_t ref;
+    ip6_lpm_t lpm;
+    u32 ii, len, sum;
+    f64 cost[3];
+    int res = 0;
+
+    memset(&ref, 0, sizeof(ref));
+    BV(clib_bihash_init)(&ref.ltr_hash, "ip6 lpm test",
+                         4096, 64 << 20);
+    ip6_lpm_init(&lpm, LPM_TEST_FIB_INDEX);
+    empty_size = ip6_lpm_memory_usage(&lpm);
+    routes = NULL;
+    addrs = NULL;
+
+    /*
+     * The lengths; the default route's and a random n-1 of the others
+     */
+    lengths = clib_bitmap_set(NULL, 0, 1);
+    while (clib_bitmap_count_set_bits(lengths) < n_lengths)
+    {
+        lengths = clib_bitmap_set(lengths, 1 + random_u32(seed) % 128, 1);
+    }
+    clib_bitmap_foreach(len, lengths,
+    ({
+        vec_insert(ref.ltr_lengths, 1, 0);
+        ref.ltr_lengths[0] = len;
+    }));
+
+    /*
+     * The default route first, as a FIB has it, then random routes of
+     * the lengths
+     */
+    for (ii = 0; ii < n_routes; ii++)
+    {
+        lpm_test_route_t route;
+
+        len = ref.ltr_lengths[(0 == ii ?
+                               n_lengths - 1 :
+                               random_u32(seed) % n_lengths)];
+        lpm_test_random_addr(&route.ltr_addr, seed);
+        ip6_address_mask(&route.ltr_addr, &ip6_main.fib_masks[len]);
+        route.ltr_len = len;
+        route.ltr_lbi = ii + 1;
+
+        lpm_test_ref_kv(&kv, &route.ltr_addr, len);
+        if (0 == BV(clib_bihash_search_inline_2)(&ref.ltr_hash, &kv, &value))
+            continue;
+
+        vec_add1(routes, route);
+        lpm_test_route_add_del(&lpm, &ref, &route, 1);
+    }
+
+    /*
+     * Addresses within the routes, and so matching at a good few lengths
+     */
+    vec_validate(addrs, n_lookups - 1);
+    vec_foreach(a, addrs)
+    {
+        ip6_address_t host;
+
+        r = &routes[random_u32(seed) % vec_len(routes)];
+        lpm_test_random_addr(&host, seed);
+
+        a->as_u64[0] = (r->ltr_addr.as_u64[0] |
+                        (host.as_u64[0] &
+                         ~ip6_main.fib_masks[r->ltr_len].as_u64[0]));
+        a->as_u64[1] = (r->ltr_addr.as_u64[1] |
+                        (host.as_u64[1] &
+                         ~ip6_main.fib_masks[r->ltr_len].as_u64[1]));
+    }
+
+    if (lpm_test_validate(&lpm, &ref, addrs))
+    {
+        res = 1;
+        goto done;
+    }
+
+    sum = 0;
+    lpm_test_lookup_cost(&lpm, &ref, addrs, 8, cost, &sum);
+    vlib_cli_output(vm, "%=8d%=8d%12.1f%12.1f%12.1f    %U",
+                    n_lengths, vec_len(routes),
+                    cost[0], cost[1], cost[2],
+                    format_memory_size, ip6_lpm_memory_usage(&lpm));
+
+    /*
+     * update the LB of every other route; the markers that lead to
+     * them follow
+     */
+    for (ii = 0; ii < vec_len(routes); ii += 2)
+    {
+        routes[ii].ltr_lbi += n_routes;
+        lpm_test_route_add_del(&lpm, &ref, &routes[ii], 1);
+    }
+    if (lpm_test_validate(&lpm, &ref, addrs))
+    {
+        res = 1;
+        goto done;
+    }
+
+    /*
+     * remove the later half, in the reverse of the order they were
+     * added, so some are removed from under their more specifics
+     */
+    for (ii = vec_len(routes); ii > vec_len(routes) / 2; ii--)
+    {
+        lpm_test_route_add_del(&lpm, &ref, &routes[ii - 1], 0);
+    }
+    _vec_len(routes) = vec_len(routes) / 2;
+
+    if (lpm_test_validate(&lpm, &ref, addrs))
+    {
+        res = 1;
+        goto done;
+    }
+
+    /*
+     * and the rest, the default route last
+     */
+    for (ii = vec_len(routes); ii > 0; ii--)
+    {
+        lpm_test_route_add_del(&lpm, &ref, &routes[ii - 1], 0);
+    }
+    if (lpm_test_validate(&lpm, &ref, addrs))
+    {
+        res = 1;
+        goto done;
+    }
+    if (!LPM_TEST_I(empty_size == ip6_lpm_memory_usage(&lpm),
+                    "%d lengths: all nodes freed", n_lengths))
+    {
+        res = 1;
+        goto done;
+    }
+
+    ip6_lpm_free(&lpm);
+
+done:
+    BV(clib_bihash_free)(&ref.ltr_hash);
+    clib_bitmap_free(lengths);
+    vec_free(ref.ltr_lengths);
+    vec_free(routes);
+    vec_free(addrs);
+
+    return (res);
+}
+
+static int
+lpm_test (vlib_main_t *vm,
+          u32 n_routes,
+          u32 n_lookups,
+          u32 seed)
+{
+    u32 n_lengths;
+
+    vlib_cli_output(vm, "%=8s%=8s%=12s%=12s%=12s%=12s",
+                    "lengths", "routes",
+                    "probe-each", "search", "search-x4", "trie");
+    vlib_cli_output(vm, "%=8s%=8s%=36s",
+                    "", "", "(clocks per-lookup)");
+
+    for (n_lengths = 1; n_lengths <= 128; n_lengths <<= 1)
+    {
+        if (lpm_test_one(vm, n_lengths, n_routes, n_lookups, &seed))
+            return (1);
+    }
+    return (0);
+}
+
+static clib_error_t *
+lpm_test_cli (vlib_main_t * vm,
+              unformat_input_t * input,
+              vlib_cli_command_t * cmd_arg)
+{
+    u32 n_routes, n_lookups, seed;
+
+    n_routes = 10000;
+    n_lookups = 1 << 14;
+    seed = 0xdeaddabe;
+
+    while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+        if (unformat (input, "routes %d", &n_routes))
+            ;
+        else if (unformat (input, "lookups %d", &n_lookups))
+            ;
+        else if (unformat (input, "seed %d", &seed))
+            ;
+        else
+            return (clib_error_return(0, "unknown input '%U'",
+                                      format_unformat_error, input));
+    }
+
+    if (0 == n_lookups || 0 == n_routes)
+    {
+        return (clib_error_return(0, "no routes or lookups"));
+    }
+
+    if (lpm_test(vm, n_routes, n_lookups, seed))
+    {
+        return clib_error_return(0, "IP6 LPM Unit Test Failed");
+    }
+    return (NULL);
+}
+
+VLIB_CLI_COMMAND (test_ip6_lpm_command, static) = {
+    .path = "test ip6 lpm",
+    .short_help = "ip6 lpm unit tests - DO NOT RUN ON A LIVE SYSTEM "
+                  "[routes <n>] [lookups <n>] [seed <n>]",
+    .function = lpm_test_cli,
+};
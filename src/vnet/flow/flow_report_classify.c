@@ -195,15 +195,14 @@ ipfix_classify_send_flows (flow_report_main_t * frm,
 
   t = pool_elt_at_index (vcm->tables, table->classify_table_index);
 
-  while (__sync_lock_test_and_set (t->writer_lock, 1))
-    ;
-
   for (i = 0; i < t->nbuckets; i++)
     {
       b = &t->buckets[i];
       if (b->offset == 0)
 	continue;
 
+      /* Hold off the bucket's writers while its entries are read */
+      vnet_classify_bucket_lock (b);
       save_v = vnet_classify_get_entry (t, b->offset);
       for (j = 0; j < (1 << b->log2_pages); j++)
 	{
@@ -219,7 +218,10 @@ ipfix_classify_send_flows (flow_report_main_t * frm,
 	      if (PREDICT_FALSE (b0 == 0))
 		{
 		  if (vlib_buffer_alloc (vm, &bi0, 1) != 1)
-		    goto flush;
+		    {
+		      vnet_classify_bucket_unlock (b);
+		      goto flush;
+		    }
 		  b0 = vlib_get_buffer (vm, bi0);
 
 		  u32 copy_len = sizeof (ip4_header_t) +
@@ -337,6 +339,7 @@ ipfix_classify_send_flows (flow_report_main_t * frm,
 		}
 	    }
 	}
+      vnet_classify_bucket_unlock (b);
     }
 
 flush:
@@ -383,7 +386,6 @@ flush:
       bi0 = ~0;
     }
 
-  *(t->writer_lock) = 0;
   return f;
 }
 
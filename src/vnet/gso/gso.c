@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/vnet.h>
+#include <vnet/feature/feature.h>
+#include <vnet/gso/gso.h>
+
+gso_main_t gso_main;
+
+int
+vnet_gso_enable_disable (u32 sw_if_index, int enable)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  gso_main_t *gm = &gso_main;
+  int rv;
+
+  if (pool_is_free_index (vnm->interface_main.sw_interfaces, sw_if_index))
+    return VNET_API_ERROR_INVALID_SW_IF_INDEX;
+
+  rv = vnet_feature_enable_disable ("interface-output", "gso",
+				    sw_if_index, enable, 0, 0);
+  if (rv == 0)
+    gm->enabled_by_sw_if_index =
+      clib_bitmap_set (gm->enabled_by_sw_if_index, sw_if_index, enable);
+
+  return rv;
+}
+
+static clib_error_t *
+set_interface_gso_command_fn (vlib_main_t * vm,
+			      unformat_input_t * input,
+			      vlib_cli_command_t * cmd)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 sw_if_index = ~0;
+  int enable = 1;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (input, "enable"))
+	enable = 1;
+      else if (unformat (input, "disable"))
+	enable = 0;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (sw_if_index == ~0)
+    return clib_error_return (0, "interface required");
+
+  if (vnet_gso_enable_disable (sw_if_index, enable))
+    return clib_error_return (0, "failed to %s gso on %U",
+			      enable ? "enable" : "disable",
+			      format_vnet_sw_if_index_name, vnm, sw_if_index);
+  return 0;
+}
+
+/*?
+ * Segment, in software, the GSO packets sent on an interface whose
+ * device cannot, e.g. the 64k TCP segments from a vhost-user guest with
+ * TSO. Each segment gets a copy of the headers, with the IP ID, TCP
+ * sequence number, lengths and checksums fixed up. Packets that are not
+ * GSO, and all packets sent on a device that segments, go on as they
+ * are.
+ *
+ * @cliexpar
+ * @cliexcmd{set interface gso GigabitEthernet2/0/0 enable}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_interface_gso_command, static) = {
+  .path = "set interface gso",
+  .short_help = "set interface gso <interface> [enable | disable]",
+  .function = set_interface_gso_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+gso_init (vlib_main_t * vm)
+{
+  gso_main_t *gm = &gso_main;
+
+  vec_validate_aligned (gm->per_thread,
+			vlib_get_thread_main ()->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+
+#define _(bit, name, v) gm->vlib_buffer_flags |= VLIB_BUFFER_##name;
+  foreach_vlib_buffer_flag
+#undef _
+
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (gso_init);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
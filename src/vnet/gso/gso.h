@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * gso/gso.h: generic segmentation offload in software
+ *
+ * Packets marked VNET_BUFFER_F_GSO, e.g. the 64k TCP segments of a
+ * guest with TSO, cross the graph as one (chained) buffer. On interfaces
+ * whose device cannot segment them, the 'gso' feature of the
+ * interface-output arc cuts them into packets of gso_size bytes of
+ * payload, each with a copy of the headers, fixed up, just before the
+ * device.
+ */
+
+#ifndef included_vnet_gso_h
+#define included_vnet_gso_h
+
+#include <vnet/vnet.h>
+
+#define foreach_gso_error					\
+  _(SEGMENTED, "packets segmented")				\
+  _(SEGMENTS, "segments sent")					\
+  _(NO_BUFFERS, "no buffers to segment into")			\
+  _(UNSUPPORTED, "not TCP or UDP, or headers not in first buffer")
+
+typedef enum
+{
+#define _(sym,str) GSO_ERROR_##sym,
+  foreach_gso_error
+#undef _
+    GSO_N_ERROR,
+} gso_error_t;
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  /* Buffers allocated in bulk, not yet used for segments */
+  u32 *buffers;
+
+  /* The segments of the packet in hand */
+  u32 *segments;
+
+  /* The packets segmented, freed once the frame is done */
+  u32 *to_free;
+} gso_per_thread_t;
+
+typedef struct
+{
+  gso_per_thread_t *per_thread;
+
+  /* The buffer flags of vlib's own, not to be copied to segments */
+  u32 vlib_buffer_flags;
+
+  /* Bitmap of the interfaces the feature is enabled on */
+  uword *enabled_by_sw_if_index;
+} gso_main_t;
+
+extern gso_main_t gso_main;
+
+/**
+ * @brief Is software segmentation enabled on output of the interface.
+ */
+static_always_inline int
+vnet_gso_is_enabled (u32 sw_if_index)
+{
+  return clib_bitmap_get (gso_main.enabled_by_sw_if_index, sw_if_index);
+}
+
+extern vlib_node_registration_t gso_node;
+
+/**
+ * @brief Enable or disable software segmentation on output of the
+ * interface.
+ */
+int vnet_gso_enable_disable (u32 sw_if_index, int enable);
+
+#endif /* included_vnet_gso_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
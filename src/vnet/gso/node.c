@@ -0,0 +1,457 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/vnet.h>
+#include <vnet/feature/feature.h>
+#include <vnet/ip/ip.h>
+#include <vnet/tcp/tcp_packet.h>
+#include <vnet/udp/udp_packet.h>
+#include <vnet/gso/gso.h>
+
+typedef struct
+{
+  u32 flags;
+  u16 gso_size;
+  u16 gso_l4_hdr_sz;
+  u32 n_segments;
+} gso_trace_t;
+
+static u8 *
+format_gso_trace (u8 * s, va_list * args)
+{
+  CLIB_UNUSED (vlib_main_t * vm) = va_arg (*args, vlib_main_t *);
+  CLIB_UNUSED (vlib_node_t * node) = va_arg (*args, vlib_node_t *);
+  gso_trace_t *t = va_arg (*args, gso_trace_t *);
+
+  if (!(t->flags & VNET_BUFFER_F_GSO))
+    s = format (s, "not a gso packet");
+  else if (t->n_segments == 0)
+    s = format (s, "gso_size %u l4_hdr_sz %u not segmented",
+		t->gso_size, t->gso_l4_hdr_sz);
+  else
+    s = format (s, "gso_size %u l4_hdr_sz %u segments %u",
+		t->gso_size, t->gso_l4_hdr_sz, t->n_segments);
+  return s;
+}
+
+static_always_inline void
+gso_trace_buffer (vlib_main_t * vm, vlib_node_runtime_t * node,
+		  vlib_buffer_t * b, u32 n_segments)
+{
+  gso_trace_t *t = vlib_add_trace (vm, node, b, sizeof (*t));
+
+  t->flags = b->flags;
+  t->gso_size = vnet_buffer2 (b)->gso_size;
+  t->gso_l4_hdr_sz = vnet_buffer2 (b)->gso_l4_hdr_sz;
+  t->n_segments = n_segments;
+}
+
+static char *gso_error_strings[] = {
+#define _(sym,string) string,
+  foreach_gso_error
+#undef _
+};
+
+typedef enum
+{
+  GSO_NEXT_DROP,
+  GSO_N_NEXT,
+} gso_next_t;
+
+/*
+ * The state of the segmentation of one packet, i.e. what of its headers
+ * varies from segment to segment.
+ */
+typedef struct
+{
+  u16 hdr_sz;
+  i16 l3_hdr_offset;
+  i16 l4_hdr_offset;
+  u8 is_ip4;
+  u8 is_tcp;
+  u16 ip4_id;
+  u32 tcp_seq;
+  u8 tcp_flags;
+} gso_state_t;
+
+static_always_inline vlib_buffer_t *
+gso_alloc_buffer (vlib_main_t * vm, gso_per_thread_t * ptd, u32 * bi)
+{
+  u32 n_alloc;
+  vlib_buffer_t *b;
+
+  if (PREDICT_FALSE (vec_len (ptd->buffers) == 0))
+    {
+      vec_validate (ptd->buffers, VLIB_FRAME_SIZE - 1);
+      n_alloc = vlib_buffer_alloc (vm, ptd->buffers, VLIB_FRAME_SIZE);
+      _vec_len (ptd->buffers) = n_alloc;
+      if (PREDICT_FALSE (n_alloc == 0))
+	return 0;
+    }
+
+  *bi = vec_pop (ptd->buffers);
+  b = vlib_get_buffer (vm, *bi);
+  b->current_data = 0;
+  b->current_length = 0;
+  b->total_length_not_including_first_buffer = 0;
+  b->flags = 0;
+  return b;
+}
+
+/*
+ * Fix up the headers of a segment: lengths, the IP ID and TCP sequence
+ * number that follow from its place in the packet, the TCP flags that
+ * are only for the first or the last segment, then the checksums.
+ */
+static_always_inline void
+gso_fixup_segment (vlib_main_t * vm, vlib_buffer_t * b, gso_state_t * gs,
+		   u32 seg_index, u32 seg_sz, int is_last,
+		   int do_csum_offload)
+{
+  u32 l3_len = vlib_buffer_length_in_chain (vm, b) -
+    (gs->l3_hdr_offset - b->current_data);
+  void *l3 = b->data + gs->l3_hdr_offset;
+  tcp_header_t *tcp = (tcp_header_t *) (b->data + gs->l4_hdr_offset);
+  udp_header_t *udp = (udp_header_t *) (b->data + gs->l4_hdr_offset);
+  ip4_header_t *ip4 = l3;
+  ip6_header_t *ip6 = l3;
+  int bogus;
+
+  if (gs->is_ip4)
+    {
+      ip4->length = clib_host_to_net_u16 (l3_len);
+      ip4->fragment_id = clib_host_to_net_u16 (gs->ip4_id + seg_index);
+      ip4->checksum = ip4_header_checksum (ip4);
+    }
+  else
+    ip6->payload_length =
+      clib_host_to_net_u16 (l3_len - sizeof (ip6_header_t));
+
+  if (gs->is_tcp)
+    {
+      u8 flags = gs->tcp_flags;
+
+      tcp->seq_number = clib_host_to_net_u32 (gs->tcp_seq);
+      gs->tcp_seq += seg_sz;
+      if (!is_last)
+	flags &= ~(TCP_FLAG_FIN | TCP_FLAG_PSH);
+      if (seg_index)
+	flags &= ~TCP_FLAG_CWR;
+      tcp->flags = flags;
+      tcp->checksum = 0;
+    }
+  else
+    {
+      udp->length = clib_host_to_net_u16 (seg_sz + sizeof (udp_header_t));
+      udp->checksum = 0;
+    }
+
+  b->flags &= ~(VNET_BUFFER_F_OFFLOAD_IP_CKSUM |
+		VNET_BUFFER_F_OFFLOAD_TCP_CKSUM |
+		VNET_BUFFER_F_OFFLOAD_UDP_CKSUM);
+  if (do_csum_offload)
+    b->flags |= gs->is_tcp ? VNET_BUFFER_F_OFFLOAD_TCP_CKSUM :
+      VNET_BUFFER_F_OFFLOAD_UDP_CKSUM;
+  else
+    {
+      u16 csum = gs->is_ip4 ? ip4_tcp_udp_compute_checksum (vm, b, ip4) :
+	ip6_tcp_udp_icmp_compute_checksum (vm, b, ip6, &bogus);
+      if (gs->is_tcp)
+	tcp->checksum = csum;
+      else
+	udp->checksum = csum;
+    }
+}
+
+/*
+ * Segment the packet into ptd->segments. Each segment is a copy of the
+ * headers followed by gso_size bytes of the payload, the last by what
+ * is left; a segment bigger than a buffer is chained.
+ * Returns the number of segments, 0 on failure.
+ */
+static u32
+gso_segment_buffer (vlib_main_t * vm, gso_main_t * gm,
+		    gso_per_thread_t * ptd, vlib_buffer_t * b0,
+		    int do_csum_offload, gso_error_t * error)
+{
+  u16 gso_size = vnet_buffer2 (b0)->gso_size;
+  u32 payload_left, seg_index, n_segs, src_off;
+  vlib_buffer_t *src, *first, *dst;
+  gso_state_t gs;
+  u8 proto;
+  u32 bi;
+
+  gs.l3_hdr_offset = vnet_buffer (b0)->l3_hdr_offset;
+  gs.l4_hdr_offset = vnet_buffer (b0)->l4_hdr_offset;
+  gs.hdr_sz = gs.l4_hdr_offset - b0->current_data +
+    vnet_buffer2 (b0)->gso_l4_hdr_sz;
+  gs.is_ip4 = (b0->flags & VNET_BUFFER_F_IS_IP4) != 0;
+
+  if (PREDICT_FALSE (gs.hdr_sz > b0->current_length || gso_size == 0))
+    {
+      *error = GSO_ERROR_UNSUPPORTED;
+      return 0;
+    }
+
+  if (gs.is_ip4)
+    {
+      ip4_header_t *ip4 = (ip4_header_t *) (b0->data + gs.l3_hdr_offset);
+      gs.ip4_id = clib_net_to_host_u16 (ip4->fragment_id);
+      proto = ip4->protocol;
+    }
+  else
+    proto = ((ip6_header_t *) (b0->data + gs.l3_hdr_offset))->protocol;
+
+  if (proto == IP_PROTOCOL_TCP)
+    {
+      tcp_header_t *tcp = (tcp_header_t *) (b0->data + gs.l4_hdr_offset);
+      gs.is_tcp = 1;
+      gs.tcp_seq = clib_net_to_host_u32 (tcp->seq_number);
+      gs.tcp_flags = tcp->flags;
+    }
+  else if (proto == IP_PROTOCOL_UDP)
+    gs.is_tcp = 0;
+  else
+    {
+      *error = GSO_ERROR_UNSUPPORTED;
+      return 0;
+    }
+
+  payload_left = vlib_buffer_length_in_chain (vm, b0) - gs.hdr_sz;
+  n_segs = clib_max (1, (payload_left + gso_size - 1) / gso_size);
+  src = b0;
+  src_off = gs.hdr_sz;
+  vec_reset_length (ptd->segments);
+
+  for (seg_index = 0; seg_index < n_segs; seg_index++)
+    {
+      u32 seg_sz = clib_min (gso_size, payload_left);
+      u32 seg_left = seg_sz;
+
+      if (PREDICT_FALSE (!(first = gso_alloc_buffer (vm, ptd, &bi))))
+	goto no_buffers;
+      vec_add1 (ptd->segments, bi);
+
+      /* The headers, and metadata, at the same offsets as in the packet */
+      first->current_data = b0->current_data;
+      first->current_length = gs.hdr_sz;
+      first->flags = b0->flags & ~(gm->vlib_buffer_flags |
+				   VNET_BUFFER_F_GSO);
+      first->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID;
+      first->current_config_index = b0->current_config_index;
+      first->feature_arc_index = b0->feature_arc_index;
+      first->error = b0->error;
+      clib_memcpy (first->opaque, b0->opaque, sizeof (b0->opaque));
+      clib_memcpy (first->opaque2, b0->opaque2, sizeof (b0->opaque2));
+      clib_memcpy (vlib_buffer_get_current (first),
+		   vlib_buffer_get_current (b0), gs.hdr_sz);
+      dst = first;
+
+      while (seg_left)
+	{
+	  u32 n_copy;
+
+	  if (src_off == src->current_length)
+	    {
+	      src = vlib_get_buffer (vm, src->next_buffer);
+	      src_off = 0;
+	      continue;
+	    }
+	  if (dst->current_data + dst->current_length ==
+	      VLIB_BUFFER_DATA_SIZE)
+	    {
+	      vlib_buffer_t *next;
+
+	      if (PREDICT_FALSE (!(next = gso_alloc_buffer (vm, ptd, &bi))))
+		goto no_buffers;
+	      dst->next_buffer = bi;
+	      dst->flags |= VLIB_BUFFER_NEXT_PRESENT;
+	      dst = next;
+	    }
+
+	  n_copy = clib_min (seg_left, src->current_length - src_off);
+	  n_copy = clib_min (n_copy, VLIB_BUFFER_DATA_SIZE -
+			     dst->current_data - dst->current_length);
+	  clib_memcpy (vlib_buffer_get_current (dst) + dst->current_length,
+		       vlib_buffer_get_current (src) + src_off, n_copy);
+	  dst->current_length += n_copy;
+	  if (dst != first)
+	    first->total_length_not_including_first_buffer += n_copy;
+	  src_off += n_copy;
+	  seg_left -= n_copy;
+	}
+
+      payload_left -= seg_sz;
+      gso_fixup_segment (vm, first, &gs, seg_index, seg_sz,
+			 seg_index == n_segs - 1, do_csum_offload);
+    }
+
+  return n_segs;
+
+no_buffers:
+  /* Freeing a segment frees its chain */
+  vlib_buffer_free (vm, ptd->segments, vec_len (ptd->segments));
+  vec_reset_length (ptd->segments);
+  *error = GSO_ERROR_NO_BUFFERS;
+  return 0;
+}
+
+static uword
+gso_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
+	     vlib_frame_t * frame)
+{
+  gso_main_t *gm = &gso_main;
+  gso_per_thread_t *ptd = vec_elt_at_index (gm->per_thread,
+					    vm->thread_index);
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 n_left_from, *from, next_index, n_left_to_next, *to_next;
+  u32 last_sw_if_index = ~0, hw_flags = 0;
+  u32 n_segmented = 0, n_segments = 0;
+
+  from = vlib_frame_vector_args (frame);
+  n_left_from = frame->n_vectors;
+  next_index = node->cached_next_index;
+
+  vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
+
+  while (n_left_from > 0)
+    {
+      u32 bi0, next0, sw_if_index0, n_segs, i;
+      gso_error_t error0 = GSO_ERROR_UNSUPPORTED;
+      vlib_buffer_t *b0;
+
+      if (n_left_from > 1)
+	vlib_prefetch_buffer_with_index (vm, from[1], LOAD);
+
+      bi0 = from[0];
+      from += 1;
+      n_left_from -= 1;
+      b0 = vlib_get_buffer (vm, bi0);
+
+      sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_TX];
+      vnet_feature_next (sw_if_index0, &next0, b0);
+
+      if (PREDICT_FALSE (sw_if_index0 != last_sw_if_index))
+	{
+	  last_sw_if_index = sw_if_index0;
+	  hw_flags = vnet_get_sup_hw_interface (vnm, sw_if_index0)->flags;
+	}
+
+      /* The device takes it as it is */
+      if (PREDICT_TRUE (!(b0->flags & VNET_BUFFER_F_GSO) ||
+			(hw_flags & VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO)))
+	{
+	  if (PREDICT_FALSE (b0->flags & VLIB_BUFFER_IS_TRACED))
+	    gso_trace_buffer (vm, node, b0, 0);
+	  goto enqueue;
+	}
+
+      n_segs = gso_segment_buffer
+	(vm, gm, ptd, b0,
+	 hw_flags & VNET_HW_INTERFACE_FLAG_SUPPORTS_TX_L4_CKSUM_OFFLOAD,
+	 &error0);
+
+      if (PREDICT_FALSE (b0->flags & VLIB_BUFFER_IS_TRACED))
+	gso_trace_buffer (vm, node, b0, n_segs);
+
+      if (PREDICT_FALSE (n_segs == 0))
+	{
+	  b0->error = node->errors[error0];
+	  next0 = GSO_NEXT_DROP;
+	  goto enqueue;
+	}
+
+      /* The packet is done with once its segments are sent on */
+      vec_add1 (ptd->to_free, bi0);
+      n_segmented += 1;
+      n_segments += n_segs;
+
+      for (i = 0; i < n_segs; i++)
+	{
+	  if (PREDICT_FALSE (n_left_to_next == 0))
+	    {
+	      vlib_put_next_frame (vm, node, next_index, 0);
+	      vlib_get_next_frame (vm, node, next_index, to_next,
+				   n_left_to_next);
+	    }
+	  bi0 = ptd->segments[i];
+	  to_next[0] = bi0;
+	  to_next += 1;
+	  n_left_to_next -= 1;
+	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index, to_next,
+					   n_left_to_next, bi0, next0);
+	}
+      continue;
+
+    enqueue:
+      if (PREDICT_FALSE (n_left_to_next == 0))
+	{
+	  vlib_put_next_frame (vm, node, next_index, 0);
+	  vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
+	}
+      to_next[0] = bi0;
+      to_next += 1;
+      n_left_to_next -= 1;
+      vlib_validate_buffer_enqueue_x1 (vm, node, next_index, to_next,
+				       n_left_to_next, bi0, next0);
+    }
+  vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+
+  if (vec_len (ptd->to_free))
+    {
+      vlib_buffer_free (vm, ptd->to_free, vec_len (ptd->to_free));
+      vec_reset_length (ptd->to_free);
+    }
+
+  vlib_node_increment_counter (vm, node->node_index, GSO_ERROR_SEGMENTED,
+			       n_segmented);
+  vlib_node_increment_counter (vm, node->node_index, GSO_ERROR_SEGMENTS,
+			       n_segments);
+
+  return frame->n_vectors;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (gso_node) = {
+  .function = gso_node_fn,
+  .name = "gso",
+  .vector_size = sizeof (u32),
+  .format_trace = format_gso_trace,
+  .type = VLIB_NODE_TYPE_INTERNAL,
+  .n_errors = ARRAY_LEN (gso_error_strings),
+  .error_strings = gso_error_strings,
+  .n_next_nodes = GSO_N_NEXT,
+  .next_nodes = {
+    [GSO_NEXT_DROP] = "error-drop",
+  },
+};
+
+VLIB_NODE_FUNCTION_MULTIARCH (gso_node, gso_node_fn);
+
+VNET_FEATURE_INIT (gso_output, static) = {
+  .arc_name = "interface-output",
+  .node_name = "gso",
+  .runs_before = VNET_FEATURES ("interface-tx"),
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
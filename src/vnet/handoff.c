@@ -20,12 +20,35 @@
 #include <vnet/handoff.h>
 #include <vnet/feature/feature.h>
 
+#define HANDOFF_RETA_DEFAULT_SIZE 128
+#define HANDOFF_RETA_MAX_SIZE 4096
+
 typedef struct
 {
   uword *workers_bitmap;
   u32 *workers;
+
+  /* The hash the packets are spread with, of the registered ones */
+  u32 hash_index;
+  handoff_hash_fn_t *hash_fn;
+
+  /* Indirection table, as in RSS: the worker of each bucket of the hash */
+  u16 *reta;
+
+  /* Packets hashed to each bucket */
+  vlib_simple_counter_main_t bucket_counters;
+
+  /* The bucket counters as of the last rebalance */
+  u64 *bucket_counts_at_rebalance;
 } per_inteface_handoff_data_t;
 
+typedef struct
+{
+  char *name;
+  char *description;
+  handoff_hash_fn_t *fn;
+} handoff_hash_t;
+
 typedef struct
 {
   u32 cached_next_index;
@@ -37,20 +60,37 @@ typedef struct
   /* Worker handoff index */
   u32 frame_queue_index;
 
+  /* Registered hashes, and their index by name */
+  handoff_hash_t *hashes;
+  uword *hash_index_by_name;
+
+  /* Seconds between rebalances of the indirection tables, 0 for never */
+  f64 rebalance_interval;
+
   /* convenience variables */
   vlib_main_t *vlib_main;
   vnet_main_t *vnet_main;
-
-    u64 (*hash_fn) (ethernet_header_t *);
 } handoff_main_t;
 
 handoff_main_t handoff_main;
 vlib_node_registration_t handoff_dispatch_node;
 
+#define foreach_handoff_hash						\
+  _ ("eth", eth_get_key, "outer addresses and protocol")		\
+  _ ("symmetric", eth_get_sym_key,					\
+     "outer addresses and protocol, either way")			\
+  _ ("5-tuple", eth_get_5tuple_key,					\
+     "outer addresses, protocol and ports")				\
+  _ ("symmetric-5-tuple", eth_get_sym_5tuple_key,			\
+     "outer addresses, protocol and ports, either way")		\
+  _ ("inner-5-tuple", eth_get_inner_5tuple_key,				\
+     "VXLAN and GTP-U inner 5-tuple, else outer")
+
 typedef struct
 {
   u32 sw_if_index;
   u32 next_worker_index;
+  u32 bucket;
   u32 buffer_index;
 } worker_handoff_trace_t;
 
@@ -63,40 +103,43 @@ format_worker_handoff_trace (u8 * s, va_list * args)
   worker_handoff_trace_t *t = va_arg (*args, worker_handoff_trace_t *);
 
   s =
-    format (s, "worker-handoff: sw_if_index %d, next_worker %d, buffer 0x%x",
-	    t->sw_if_index, t->next_worker_index, t->buffer_index);
+    format (s, "worker-handoff: sw_if_index %d, next_worker %d, bucket %d, "
+	    "buffer 0x%x", t->sw_if_index, t->next_worker_index, t->bucket,
+	    t->buffer_index);
   return s;
 }
 
 vlib_node_registration_t handoff_node;
 
+#define foreach_worker_handoff_error			\
+  _ (CONGESTION_DROP, "congestion drop")
+
+typedef enum
+{
+#define _(sym,str) WORKER_HANDOFF_ERROR_##sym,
+  foreach_worker_handoff_error
+#undef _
+    WORKER_HANDOFF_N_ERROR,
+} worker_handoff_error_t;
+
+static char *worker_handoff_error_strings[] = {
+#define _(sym,string) string,
+  foreach_worker_handoff_error
+#undef _
+};
+
 static uword
 worker_handoff_node_fn (vlib_main_t * vm,
 			vlib_node_runtime_t * node, vlib_frame_t * frame)
 {
   handoff_main_t *hm = &handoff_main;
-  vlib_thread_main_t *tm = vlib_get_thread_main ();
-  u32 n_left_from, *from;
-  static __thread vlib_frame_queue_elt_t **handoff_queue_elt_by_worker_index;
-  static __thread vlib_frame_queue_t **congested_handoff_queue_by_worker_index
-    = 0;
-  vlib_frame_queue_elt_t *hf = 0;
-  int i;
-  u32 n_left_to_next_worker = 0, *to_next_worker = 0;
-  u32 next_worker_index = 0;
-  u32 current_worker_index = ~0;
-
-  if (PREDICT_FALSE (handoff_queue_elt_by_worker_index == 0))
-    {
-      vec_validate (handoff_queue_elt_by_worker_index, tm->n_vlib_mains - 1);
-
-      vec_validate_init_empty (congested_handoff_queue_by_worker_index,
-			       hm->first_worker_index + hm->num_workers - 1,
-			       (vlib_frame_queue_t *) (~0));
-    }
+  u32 n_left_from, *from, n_enq;
+  u16 thread_indices[VLIB_FRAME_SIZE], *ti;
+  u32 thread_index = vm->thread_index;
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
+  ti = thread_indices;
 
   while (n_left_from > 0)
     {
@@ -106,7 +149,7 @@ worker_handoff_node_fn (vlib_main_t * vm,
       u32 hash;
       u64 hash_key;
       per_inteface_handoff_data_t *ihd0;
-      u32 index0;
+      u32 bucket0;
 
       bi0 = from[0];
       from += 1;
@@ -117,15 +160,8 @@ worker_handoff_node_fn (vlib_main_t * vm,
       ASSERT (hm->if_data);
       ihd0 = vec_elt_at_index (hm->if_data, sw_if_index0);
 
-      next_worker_index = hm->first_worker_index;
-
-      /*
-       * Force unknown traffic onto worker 0,
-       * and into ethernet-input. $$$$ add more hashes.
-       */
-
       /* Compute ingress LB hash */
-      hash_key = hm->hash_fn ((ethernet_header_t *) b0->data);
+      hash_key = ihd0->hash_fn ((ethernet_header_t *) b0->data);
       hash = (u32) clib_xxhash (hash_key);
 
       /* if input node did not specify next index, then packet
@@ -141,40 +177,13 @@ worker_handoff_node_fn (vlib_main_t * vm,
 	       HANDOFF_DISPATCH_NEXT_MPLS_INPUT)
 	vlib_buffer_advance (b0, (sizeof (ethernet_header_t)));
 
-      if (PREDICT_TRUE (is_pow2 (vec_len (ihd0->workers))))
-	index0 = hash & (vec_len (ihd0->workers) - 1);
-      else
-	index0 = hash % vec_len (ihd0->workers);
+      /* The worker is the one of the bucket in the indirection table */
+      bucket0 = hash & (vec_len (ihd0->reta) - 1);
+      vlib_increment_simple_counter (&ihd0->bucket_counters, thread_index,
+				     bucket0, 1);
 
-      next_worker_index += ihd0->workers[index0];
-
-      if (next_worker_index != current_worker_index)
-	{
-	  if (hf)
-	    hf->n_vectors = VLIB_FRAME_SIZE - n_left_to_next_worker;
-
-	  hf = vlib_get_worker_handoff_queue_elt (hm->frame_queue_index,
-						  next_worker_index,
-						  handoff_queue_elt_by_worker_index);
-
-	  n_left_to_next_worker = VLIB_FRAME_SIZE - hf->n_vectors;
-	  to_next_worker = &hf->buffer_index[hf->n_vectors];
-	  current_worker_index = next_worker_index;
-	}
-
-      /* enqueue to correct worker thread */
-      to_next_worker[0] = bi0;
-      to_next_worker++;
-      n_left_to_next_worker--;
-
-      if (n_left_to_next_worker == 0)
-	{
-	  hf->n_vectors = VLIB_FRAME_SIZE;
-	  vlib_put_frame_queue_elt (hf);
-	  current_worker_index = ~0;
-	  handoff_queue_elt_by_worker_index[next_worker_index] = 0;
-	  hf = 0;
-	}
+      ti[0] = hm->first_worker_index + ihd0->reta[bucket0];
+      ti += 1;
 
       if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
 			 && (b0->flags & VLIB_BUFFER_IS_TRACED)))
@@ -182,38 +191,21 @@ worker_handoff_node_fn (vlib_main_t * vm,
 	  worker_handoff_trace_t *t =
 	    vlib_add_trace (vm, node, b0, sizeof (*t));
 	  t->sw_if_index = sw_if_index0;
-	  t->next_worker_index = next_worker_index - hm->first_worker_index;
+	  t->next_worker_index = ihd0->reta[bucket0];
+	  t->bucket = bucket0;
 	  t->buffer_index = bi0;
 	}
-
     }
 
-  if (hf)
-    hf->n_vectors = VLIB_FRAME_SIZE - n_left_to_next_worker;
+  /* enqueue to the worker threads */
+  n_enq = vlib_buffer_enqueue_to_thread (vm, hm->frame_queue_index,
+					 vlib_frame_vector_args (frame),
+					 thread_indices, frame->n_vectors);
 
-  /* Ship frames to the worker nodes */
-  for (i = 0; i < vec_len (handoff_queue_elt_by_worker_index); i++)
-    {
-      if (handoff_queue_elt_by_worker_index[i])
-	{
-	  hf = handoff_queue_elt_by_worker_index[i];
-	  /*
-	   * It works better to let the handoff node
-	   * rate-adapt, always ship the handoff queue element.
-	   */
-	  if (1 || hf->n_vectors == hf->last_n_vectors)
-	    {
-	      vlib_put_frame_queue_elt (hf);
-	      handoff_queue_elt_by_worker_index[i] = 0;
-	    }
-	  else
-	    hf->last_n_vectors = hf->n_vectors;
-	}
-      congested_handoff_queue_by_worker_index[i] =
-	(vlib_frame_queue_t *) (~0);
-    }
-  hf = 0;
-  current_worker_index = ~0;
+  if (n_enq < frame->n_vectors)
+    vlib_node_increment_counter (vm, node->node_index,
+				 WORKER_HANDOFF_ERROR_CONGESTION_DROP,
+				 frame->n_vectors - n_enq);
   return frame->n_vectors;
 }
 
@@ -224,6 +216,8 @@ VLIB_REGISTER_NODE (worker_handoff_node) = {
   .vector_size = sizeof (u32),
   .format_trace = format_worker_handoff_trace,
   .type = VLIB_NODE_TYPE_INTERNAL,
+  .n_errors = ARRAY_LEN (worker_handoff_error_strings),
+  .error_strings = worker_handoff_error_strings,
 
   .n_next_nodes = 1,
   .next_nodes = {
@@ -234,9 +228,72 @@ VLIB_REGISTER_NODE (worker_handoff_node) = {
 VLIB_NODE_FUNCTION_MULTIARCH (worker_handoff_node, worker_handoff_node_fn)
 /* *INDENT-ON* */
 
+u32
+handoff_register_hash (char *name, char *description,
+		       handoff_hash_fn_t * fn)
+{
+  handoff_main_t *hm = &handoff_main;
+  handoff_hash_t *h;
+
+  vec_add2 (hm->hashes, h, 1);
+  h->name = name;
+  h->description = description;
+  h->fn = fn;
+  hash_set_mem (hm->hash_index_by_name, name, h - hm->hashes);
+
+  return h - hm->hashes;
+}
+
+static uword
+unformat_handoff_hash (unformat_input_t * input, va_list * args)
+{
+  handoff_main_t *hm = &handoff_main;
+  u32 *hash_index = va_arg (*args, u32 *);
+  u8 *name = 0;
+  uword *p;
+
+  if (!unformat (input, "%s", &name))
+    return 0;
+
+  vec_add1 (name, 0);
+  p = hash_get_mem (hm->hash_index_by_name, name);
+  vec_free (name);
+  if (!p)
+    return 0;
+
+  *hash_index = p[0];
+  return 1;
+}
+
+/*
+ * Fill the indirection table round-robin with the workers, and start its
+ * bucket counters from 0.
+ */
+static void
+handoff_reta_init (per_inteface_handoff_data_t * d, u32 reta_size)
+{
+  u32 bucket;
+
+  vec_reset_length (d->reta);
+  vec_validate (d->reta, reta_size - 1);
+  vec_foreach_index (bucket, d->reta)
+  {
+    d->reta[bucket] = d->workers[bucket % vec_len (d->workers)];
+  }
+
+  vlib_validate_simple_counter (&d->bucket_counters, reta_size - 1);
+  for (bucket = 0; bucket < reta_size; bucket++)
+    vlib_zero_simple_counter (&d->bucket_counters, bucket);
+
+  vec_validate (d->bucket_counts_at_rebalance, reta_size - 1);
+  memset (d->bucket_counts_at_rebalance, 0,
+	  vec_bytes (d->bucket_counts_at_rebalance));
+}
+
 int
 interface_handoff_enable_disable (vlib_main_t * vm, u32 sw_if_index,
-				  uword * bitmap, int enable_disable)
+				  uword * bitmap, u32 hash_index,
+				  u32 reta_size, int enable_disable)
 {
   handoff_main_t *hm = &handoff_main;
   vnet_sw_interface_t *sw;
@@ -254,10 +311,20 @@ interface_handoff_enable_disable (vlib_main_t * vm, u32 sw_if_index,
   if (clib_bitmap_last_set (bitmap) >= hm->num_workers)
     return VNET_API_ERROR_INVALID_WORKER;
 
+  if (hash_index != ~0 && hash_index >= vec_len (hm->hashes))
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  if (reta_size != 0 &&
+      (!is_pow2 (reta_size) || reta_size > HANDOFF_RETA_MAX_SIZE))
+    return VNET_API_ERROR_INVALID_VALUE;
+
   if (hm->frame_queue_index == ~0)
     hm->frame_queue_index =
       vlib_frame_queue_main_init (handoff_dispatch_node.index, 0);
 
+  /* The workers look up if_data, and the tables in it, for each packet */
+  vlib_worker_thread_barrier_sync (vm);
+
   vec_validate (hm->if_data, sw_if_index);
   d = vec_elt_at_index (hm->if_data, sw_if_index);
 
@@ -273,13 +340,171 @@ interface_handoff_enable_disable (vlib_main_t * vm, u32 sw_if_index,
 	  vec_add1(d->workers, i);
 	}));
       /* *INDENT-ON* */
+
+      if (hash_index != ~0)
+	d->hash_index = hash_index;
+      d->hash_fn = hm->hashes[d->hash_index].fn;
+
+      if (reta_size == 0)
+	reta_size = vec_len (d->reta) ? vec_len (d->reta) :
+	  HANDOFF_RETA_DEFAULT_SIZE;
+      handoff_reta_init (d, reta_size);
     }
 
+  vlib_worker_thread_barrier_release (vm);
+
   vnet_feature_enable_disable ("device-input", "worker-handoff",
 			       sw_if_index, enable_disable, 0, 0);
   return rv;
 }
 
+int
+vnet_handoff_reta_set (u32 sw_if_index, u32 bucket, u32 worker)
+{
+  handoff_main_t *hm = &handoff_main;
+  per_inteface_handoff_data_t *d;
+
+  if (sw_if_index >= vec_len (hm->if_data))
+    return VNET_API_ERROR_INVALID_SW_IF_INDEX;
+
+  d = vec_elt_at_index (hm->if_data, sw_if_index);
+  if (vec_len (d->workers) == 0)
+    return VNET_API_ERROR_INVALID_SW_IF_INDEX;
+
+  if (bucket >= vec_len (d->reta))
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  if (!clib_bitmap_get (d->workers_bitmap, worker))
+    return VNET_API_ERROR_INVALID_WORKER;
+
+  /*
+   * A single store the workers see as they will: the packets of the
+   * bucket in flight to the old worker may be overtaken, once.
+   */
+  d->reta[bucket] = worker;
+  return 0;
+}
+
+typedef struct
+{
+  u64 n_packets;
+  u32 bucket;
+} handoff_bucket_load_t;
+
+static int
+handoff_bucket_load_cmp (void *a1, void *a2)
+{
+  handoff_bucket_load_t *l1 = a1, *l2 = a2;
+
+  /* busiest first */
+  if (l1->n_packets != l2->n_packets)
+    return l1->n_packets < l2->n_packets ? 1 : -1;
+  return (int) l1->bucket - (int) l2->bucket;
+}
+
+/*
+ * Give the buckets out to the workers, the busiest bucket since the last
+ * rebalance first, each to the worker with the least load so far. A
+ * bucket stays on its worker if that is as little loaded, and idle
+ * buckets stay where they are, so that flows move only to even out the
+ * load.
+ */
+static void
+handoff_reta_rebalance (per_inteface_handoff_data_t * d)
+{
+  handoff_bucket_load_t *loads = 0, *l;
+  u64 *worker_load = 0, count;
+  u32 bucket, i, least, n_workers = vec_len (d->workers);
+
+  vec_foreach_index (bucket, d->reta)
+  {
+    count = vlib_get_simple_counter (&d->bucket_counters, bucket);
+    vec_add2 (loads, l, 1);
+    l->n_packets = count - d->bucket_counts_at_rebalance[bucket];
+    l->bucket = bucket;
+    d->bucket_counts_at_rebalance[bucket] = count;
+  }
+  vec_sort_with_function (loads, handoff_bucket_load_cmp);
+
+  /* As indexed in d->workers */
+  vec_validate (worker_load, n_workers - 1);
+
+  vec_foreach (l, loads)
+  {
+    if (l->n_packets == 0)
+      break;
+
+    least = 0;
+    for (i = 0; i < n_workers; i++)
+      {
+	if (worker_load[i] < worker_load[least] ||
+	    (worker_load[i] == worker_load[least] &&
+	     d->workers[i] == d->reta[l->bucket]))
+	  least = i;
+      }
+
+    d->reta[l->bucket] = d->workers[least];
+    worker_load[least] += l->n_packets;
+  }
+
+  vec_free (loads);
+  vec_free (worker_load);
+}
+
+int
+vnet_handoff_reta_rebalance (u32 sw_if_index)
+{
+  handoff_main_t *hm = &handoff_main;
+  per_inteface_handoff_data_t *d;
+
+  if (sw_if_index >= vec_len (hm->if_data))
+    return VNET_API_ERROR_INVALID_SW_IF_INDEX;
+
+  d = vec_elt_at_index (hm->if_data, sw_if_index);
+  if (vec_len (d->workers) == 0)
+    return VNET_API_ERROR_INVALID_SW_IF_INDEX;
+
+  handoff_reta_rebalance (d);
+  return 0;
+}
+
+static uword
+handoff_rebalance_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
+			   vlib_frame_t * f)
+{
+  handoff_main_t *hm = &handoff_main;
+  per_inteface_handoff_data_t *d;
+  uword event_type;
+
+  while (1)
+    {
+      if (hm->rebalance_interval > 0)
+	vlib_process_wait_for_event_or_clock (vm, hm->rebalance_interval);
+      else
+	vlib_process_wait_for_event (vm);
+
+      /* An event is a new interval, to start waiting for */
+      event_type = vlib_process_get_events (vm, 0);
+      if (event_type != ~0)
+	continue;
+
+      vec_foreach (d, hm->if_data)
+      {
+	if (vec_len (d->workers))
+	  handoff_reta_rebalance (d);
+      }
+    }
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (handoff_rebalance_node, static) = {
+  .function = handoff_rebalance_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "handoff-rebalance-process",
+};
+/* *INDENT-ON* */
+
 static clib_error_t *
 set_interface_handoff_command_fn (vlib_main_t * vm,
 				  unformat_input_t * input,
@@ -289,7 +514,8 @@ set_interface_handoff_command_fn (vlib_main_t * vm,
   u32 sw_if_index = ~0;
   int enable_disable = 1;
   uword *bitmap = 0;
-  u32 sym = ~0;
+  u32 hash_index = ~0;
+  u32 reta_size = 0;
 
   int rv = 0;
 
@@ -303,9 +529,14 @@ set_interface_handoff_command_fn (vlib_main_t * vm,
 			 vnet_get_main (), &sw_if_index))
 	;
       else if (unformat (input, "symmetrical"))
-	sym = 1;
+	hash_index = hash_get_mem (hm->hash_index_by_name, "symmetric")[0];
       else if (unformat (input, "asymmetrical"))
-	sym = 0;
+	hash_index = hash_get_mem (hm->hash_index_by_name, "eth")[0];
+      else if (unformat (input, "hash %U", unformat_handoff_hash,
+			 &hash_index))
+	;
+      else if (unformat (input, "reta-size %u", &reta_size))
+	;
       else
 	break;
     }
@@ -317,8 +548,8 @@ set_interface_handoff_command_fn (vlib_main_t * vm,
     return clib_error_return (0, "Please specify list of workers...");
 
   rv =
-    interface_handoff_enable_disable (vm, sw_if_index, bitmap,
-				      enable_disable);
+    interface_handoff_enable_disable (vm, sw_if_index, bitmap, hash_index,
+				      reta_size, enable_disable);
 
   switch (rv)
     {
@@ -333,6 +564,11 @@ set_interface_handoff_command_fn (vlib_main_t * vm,
       return clib_error_return (0, "Invalid worker(s)");
       break;
 
+    case VNET_API_ERROR_INVALID_VALUE:
+      return clib_error_return (0, "reta-size must be a power of 2, "
+				"up to %u", HANDOFF_RETA_MAX_SIZE);
+      break;
+
     case VNET_API_ERROR_UNIMPLEMENTED:
       return clib_error_return (0,
 				"Device driver doesn't support redirection");
@@ -342,23 +578,241 @@ set_interface_handoff_command_fn (vlib_main_t * vm,
       return clib_error_return (0, "unknown return value %d", rv);
     }
 
-  if (sym == 1)
-    hm->hash_fn = eth_get_sym_key;
-  else if (sym == 0)
-    hm->hash_fn = eth_get_key;
-
   return 0;
 }
 
+/*?
+ * Spread the packets received on an interface over a set of workers. A
+ * hash of each packet picks a bucket of the interface's indirection
+ * table, as in RSS, and the bucket the worker. The hashes are:
+ * - eth: outer addresses and protocol, the default
+ * - symmetric: the same, equal for both directions of a flow
+ * - 5-tuple: outer addresses, protocol and ports
+ * - symmetric-5-tuple: the same, equal for both directions of a flow
+ * - inner-5-tuple: the 5-tuple of the packet inside VXLAN or GTP-U, so
+ *   that the inner flows keep to a worker, else the outer one
+ *
+ * symmetrical and asymmetrical are the older names of symmetric and eth.
+ * The table has 128 buckets unless given otherwise.
+ *
+ * @cliexpar
+ * @cliexcmd{set interface handoff GigabitEthernet2/0/0 workers 0-3 hash inner-5-tuple reta-size 256}
+?*/
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (set_interface_handoff_command, static) = {
   .path = "set interface handoff",
   .short_help =
-  "set interface handoff <interface-name> workers <workers-list> [symmetrical|asymmetrical]",
+  "set interface handoff <interface-name> workers <workers-list> "
+  "[symmetrical|asymmetrical] [hash <name>] [reta-size <n>] [disable]",
   .function = set_interface_handoff_command_fn,
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+set_interface_handoff_reta_command_fn (vlib_main_t * vm,
+				       unformat_input_t * input,
+				       vlib_cli_command_t * cmd)
+{
+  u32 sw_if_index = ~0, bucket = ~0, worker = ~0;
+  int rv;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "%U", unformat_vnet_sw_interface,
+		    vnet_get_main (), &sw_if_index))
+	;
+      else if (unformat (input, "bucket %u", &bucket))
+	;
+      else if (unformat (input, "worker %u", &worker))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (sw_if_index == ~0 || bucket == ~0 || worker == ~0)
+    return clib_error_return (0, "interface, bucket and worker required");
+
+  rv = vnet_handoff_reta_set (sw_if_index, bucket, worker);
+  switch (rv)
+    {
+    case 0:
+      break;
+    case VNET_API_ERROR_INVALID_SW_IF_INDEX:
+      return clib_error_return (0, "handoff not enabled on the interface");
+    case VNET_API_ERROR_INVALID_VALUE:
+      return clib_error_return (0, "no such bucket");
+    case VNET_API_ERROR_INVALID_WORKER:
+      return clib_error_return (0, "not one of the interface's workers");
+    default:
+      return clib_error_return (0, "unknown return value %d", rv);
+    }
+  return 0;
+}
+
+/*?
+ * Move a bucket of the indirection table of an interface to another of
+ * its workers, while traffic runs.
+ *
+ * @cliexpar
+ * @cliexcmd{set interface handoff reta GigabitEthernet2/0/0 bucket 5 worker 2}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_interface_handoff_reta_command, static) = {
+  .path = "set interface handoff reta",
+  .short_help =
+  "set interface handoff reta <interface-name> bucket <n> worker <n>",
+  .function = set_interface_handoff_reta_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+set_interface_handoff_rebalance_command_fn (vlib_main_t * vm,
+					    unformat_input_t * input,
+					    vlib_cli_command_t * cmd)
+{
+  handoff_main_t *hm = &handoff_main;
+  per_inteface_handoff_data_t *d;
+  u32 sw_if_index = ~0;
+  f64 interval = -1;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "%U", unformat_vnet_sw_interface,
+		    vnet_get_main (), &sw_if_index))
+	;
+      else if (unformat (input, "interval %f", &interval))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (interval >= 0)
+    {
+      hm->rebalance_interval = interval;
+      vlib_process_signal_event (vm, handoff_rebalance_node.index, 1, 0);
+      return 0;
+    }
+
+  if (sw_if_index != ~0)
+    {
+      if (vnet_handoff_reta_rebalance (sw_if_index))
+	return clib_error_return (0, "handoff not enabled on the interface");
+      return 0;
+    }
+
+  vec_foreach (d, hm->if_data)
+  {
+    if (vec_len (d->workers))
+      handoff_reta_rebalance (d);
+  }
+  return 0;
+}
+
+/*?
+ * Rebalance the indirection table of an interface, or of all, by the
+ * packets hashed to each bucket since the last rebalance: the busiest
+ * buckets are spread first, each to the least loaded worker so far.
+ * With an interval, rebalance all of them every so many seconds; 0
+ * stops that.
+ *
+ * @cliexpar
+ * @cliexcmd{set interface handoff rebalance interval 10}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_interface_handoff_rebalance_command, static) = {
+  .path = "set interface handoff rebalance",
+  .short_help =
+  "set interface handoff rebalance [<interface-name>] [interval <secs>]",
+  .function = set_interface_handoff_rebalance_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+show_interface_handoff_command_fn (vlib_main_t * vm,
+				   unformat_input_t * input,
+				   vlib_cli_command_t * cmd)
+{
+  handoff_main_t *hm = &handoff_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  per_inteface_handoff_data_t *d;
+  u32 sw_if_index = ~0, bucket, *w;
+  u64 *worker_packets = 0, *n_buckets = 0;
+  int verbose = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (input, "buckets"))
+	verbose = 1;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  vec_foreach (d, hm->if_data)
+  {
+    if (vec_len (d->workers) == 0)
+      continue;
+    if (sw_if_index != ~0 && d - hm->if_data != sw_if_index)
+      continue;
+
+    vlib_cli_output (vm, "%U: hash %s, workers %U, %u buckets",
+		     format_vnet_sw_if_index_name, vnm, d - hm->if_data,
+		     hm->hashes[d->hash_index].name,
+		     format_vec32, d->workers, "%d", vec_len (d->reta));
+
+    vec_validate (worker_packets, hm->num_workers);
+    vec_validate (n_buckets, hm->num_workers);
+    memset (worker_packets, 0, vec_bytes (worker_packets));
+    memset (n_buckets, 0, vec_bytes (n_buckets));
+
+    vec_foreach_index (bucket, d->reta)
+    {
+      u64 n = vlib_get_simple_counter (&d->bucket_counters, bucket);
+
+      worker_packets[d->reta[bucket]] += n;
+      n_buckets[d->reta[bucket]] += 1;
+      if (verbose)
+	vlib_cli_output (vm, "  bucket %4u: worker %u, %llu packets",
+			 bucket, d->reta[bucket], n);
+    }
+
+    vec_foreach (w, d->workers)
+    {
+      vlib_cli_output (vm, "  worker %u: %llu buckets, %llu packets",
+		       w[0], n_buckets[w[0]], worker_packets[w[0]]);
+    }
+  }
+
+  if (hm->rebalance_interval > 0)
+    vlib_cli_output (vm, "rebalanced every %.2f seconds",
+		     hm->rebalance_interval);
+
+  vec_free (worker_packets);
+  vec_free (n_buckets);
+  return 0;
+}
+
+/*?
+ * Show the hash, workers and indirection table of the interfaces that
+ * hand off their packets, and the packets hashed to the buckets of each
+ * worker so far; with buckets, to each bucket.
+ *
+ * @cliexpar
+ * @cliexcmd{show interface handoff GigabitEthernet2/0/0 buckets}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_interface_handoff_command, static) = {
+  .path = "show interface handoff",
+  .short_help = "show interface handoff [<interface-name>] [buckets]",
+  .function = show_interface_handoff_command_fn,
+};
+/* *INDENT-ON* */
+
 typedef struct
 {
   u32 buffer_index;
@@ -573,7 +1027,13 @@ handoff_init (vlib_main_t * vm)
 	}
     }
 
-  hm->hash_fn = eth_get_key;
+  hm->hash_index_by_name = hash_create_string (0, sizeof (uword));
+
+  /* The first is the default */
+#define _(name, fn, description) \
+  handoff_register_hash (name, description, fn);
+  foreach_handoff_hash
+#undef _
 
   hm->vlib_main = vm;
   hm->vnet_main = &vnet_main;
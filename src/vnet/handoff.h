@@ -21,6 +21,7 @@
 #include <vnet/ip/ip4_packet.h>
 #include <vnet/ip/ip6_packet.h>
 #include <vnet/mpls/packet.h>
+#include <vnet/udp/udp.h>
 
 typedef enum
 {
@@ -246,6 +247,216 @@ eth_get_key (ethernet_header_t * h0)
   return hash_key;
 }
 
+/*
+ * The L3 header of a frame, past up to two VLAN tags, and its ethertype,
+ * in network order.
+ */
+static inline void *
+eth_get_l3_header (ethernet_header_t * h0, u16 * type)
+{
+  ethernet_vlan_header_t *vlan;
+
+  *type = h0->type;
+  if (PREDICT_TRUE (*type != clib_host_to_net_u16 (ETHERNET_TYPE_VLAN) &&
+		    *type != clib_host_to_net_u16 (ETHERNET_TYPE_DOT1AD)))
+    return h0 + 1;
+
+  vlan = (ethernet_vlan_header_t *) (h0 + 1);
+  if (vlan->type == clib_host_to_net_u16 (ETHERNET_TYPE_VLAN))
+    vlan++;
+  *type = vlan->type;
+  return vlan + 1;
+}
+
+static inline int
+ip_protocol_has_ports (u8 protocol)
+{
+  return (protocol == IP_PROTOCOL_TCP || protocol == IP_PROTOCOL_UDP ||
+	  protocol == IP_PROTOCOL_SCTP);
+}
+
+/* Source and destination ports, as read, 0 if none or a fragment */
+static inline u32
+ipv4_get_ports (ip4_header_t * ip)
+{
+  if (PREDICT_FALSE (ip4_is_fragment (ip) ||
+		     !ip_protocol_has_ports (ip->protocol)))
+    return 0;
+  return *(u32 *) ip4_next_header (ip);
+}
+
+static inline u32
+ipv6_get_ports (ip6_header_t * ip)
+{
+  if (PREDICT_FALSE (!ip_protocol_has_ports (ip->protocol)))
+    return 0;
+  return *(u32 *) (ip + 1);
+}
+
+/*
+ * The 5-tuple keys. The symmetric ones are the same for both directions
+ * of a flow.
+ */
+static inline u64
+ipv4_get_5tuple_key (ip4_header_t * ip, int is_symmetric)
+{
+  u64 ports = ipv4_get_ports (ip);
+
+  if (is_symmetric)
+    return (u64) (ip->src_address.as_u32 ^ ip->dst_address.as_u32) ^
+      (((ports ^ (ports >> 16)) & 0xffff) << 32) ^
+      ((u64) ip->protocol << 48);
+
+  return *((u64 *) (&ip->address_pair)) ^ (ports << 16) ^ ip->protocol;
+}
+
+static inline u64
+ipv6_get_5tuple_key (ip6_header_t * ip, int is_symmetric)
+{
+  u64 ports = ipv6_get_ports (ip);
+
+  if (is_symmetric)
+    return (ip->src_address.as_u64[0] ^ ip->src_address.as_u64[1] ^
+	    ip->dst_address.as_u64[0] ^ ip->dst_address.as_u64[1] ^
+	    (((ports ^ (ports >> 16)) & 0xffff) << 16) ^ ip->protocol);
+
+  return ipv6_get_key (ip) ^ (ports << 16);
+}
+
+static inline u64
+eth_get_5tuple_key_inline (ethernet_header_t * h0, int is_symmetric)
+{
+  u16 type;
+  void *l3 = eth_get_l3_header (h0, &type);
+
+  if (PREDICT_TRUE (type == clib_host_to_net_u16 (ETHERNET_TYPE_IP4)))
+    return ipv4_get_5tuple_key (l3, is_symmetric);
+  else if (type == clib_host_to_net_u16 (ETHERNET_TYPE_IP6))
+    return ipv6_get_5tuple_key (l3, is_symmetric);
+  else if (type == clib_host_to_net_u16 (ETHERNET_TYPE_MPLS))
+    return mpls_get_key (l3);
+
+  return type;
+}
+
+static inline u64
+eth_get_5tuple_key (ethernet_header_t * h0)
+{
+  return eth_get_5tuple_key_inline (h0, 0 /* is_symmetric */ );
+}
+
+static inline u64
+eth_get_sym_5tuple_key (ethernet_header_t * h0)
+{
+  return eth_get_5tuple_key_inline (h0, 1 /* is_symmetric */ );
+}
+
+#define HANDOFF_GTPU_FLAGS_E_S_PN	0x07
+#define HANDOFF_GTPU_TYPE_GPDU		255
+
+/*
+ * The 5-tuple key of the packet inside a VXLAN or GTP-U tunnel, so that
+ * the packets of an inner flow stay on one worker whatever the tunnel.
+ * Returns 0 if the UDP packet is not one of these, or the inner packet
+ * is not found.
+ */
+static inline int
+udp_tunnel_get_inner_key (udp_header_t * udp, u64 * key)
+{
+  if (udp->dst_port == clib_host_to_net_u16 (UDP_DST_PORT_vxlan))
+    {
+      /* An 8 byte VXLAN header, then the inner frame */
+      *key = eth_get_5tuple_key ((ethernet_header_t *) ((u8 *) (udp + 1) +
+							8));
+      return 1;
+    }
+
+  if (udp->dst_port == clib_host_to_net_u16 (UDP_DST_PORT_GTPU))
+    {
+      u8 *gtpu = (u8 *) (udp + 1), *inner = gtpu + 8;
+
+      if (gtpu[1] != HANDOFF_GTPU_TYPE_GPDU)
+	return 0;
+
+      /* The sequence number, N-PDU and next extension type; extension
+         headers are not followed */
+      if (gtpu[0] & HANDOFF_GTPU_FLAGS_E_S_PN)
+	{
+	  if (gtpu[11] != 0)
+	    return 0;
+	  inner += 4;
+	}
+
+      if ((inner[0] >> 4) == 4)
+	*key = ipv4_get_5tuple_key ((ip4_header_t *) inner, 0);
+      else if ((inner[0] >> 4) == 6)
+	*key = ipv6_get_5tuple_key ((ip6_header_t *) inner, 0);
+      else
+	return 0;
+      return 1;
+    }
+
+  return 0;
+}
+
+/* The inner 5-tuple of VXLAN and GTP-U packets, else the outer one */
+static inline u64
+eth_get_inner_5tuple_key (ethernet_header_t * h0)
+{
+  u16 type;
+  void *l3 = eth_get_l3_header (h0, &type);
+  u64 key;
+
+  if (PREDICT_TRUE (type == clib_host_to_net_u16 (ETHERNET_TYPE_IP4)))
+    {
+      ip4_header_t *ip = l3;
+
+      if (ip->protocol == IP_PROTOCOL_UDP && !ip4_is_fragment (ip) &&
+	  udp_tunnel_get_inner_key (ip4_next_header (ip), &key))
+	return key;
+      return ipv4_get_5tuple_key (ip, 0);
+    }
+  else if (type == clib_host_to_net_u16 (ETHERNET_TYPE_IP6))
+    {
+      ip6_header_t *ip = l3;
+
+      if (ip->protocol == IP_PROTOCOL_UDP &&
+	  udp_tunnel_get_inner_key ((udp_header_t *) (ip + 1), &key))
+	return key;
+      return ipv6_get_5tuple_key (ip, 0);
+    }
+  else if (type == clib_host_to_net_u16 (ETHERNET_TYPE_MPLS))
+    return mpls_get_key (l3);
+
+  return type;
+}
+
+typedef u64 (handoff_hash_fn_t) (ethernet_header_t * h0);
+
+/**
+ * @brief Register a hash for worker-handoff to spread packets with
+ *
+ * @param name - as given to 'set interface handoff ... hash <name>'
+ * @param description - for 'show interface handoff'
+ * @param fn - the key of a frame; it is hashed, then looked up in the
+ *             interface's indirection table
+ * @return the index of the hash
+ */
+u32 handoff_register_hash (char *name, char *description,
+			   handoff_hash_fn_t * fn);
+
+/**
+ * @brief Set the worker, in 0..n_workers-1, of a bucket of the
+ * indirection table of an interface, while it runs
+ */
+int vnet_handoff_reta_set (u32 sw_if_index, u32 bucket, u32 worker);
+
+/**
+ * @brief Spread the buckets of the indirection table of an interface
+ * over its workers, by the packets hashed to each since the last time
+ */
+int vnet_handoff_reta_rebalance (u32 sw_if_index);
+
 #endif /* included_vnet_handoff_h */
 
 /*
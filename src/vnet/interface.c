@@ -1233,11 +1233,31 @@ vnet_interface_init (vlib_main_t * vm)
   im->sw_if_counters[VNET_INTERFACE_COUNTER_RX_MISS].name = "rx-miss";
   im->sw_if_counters[VNET_INTERFACE_COUNTER_RX_ERROR].name = "rx-error";
   im->sw_if_counters[VNET_INTERFACE_COUNTER_TX_ERROR].name = "tx-error";
+  im->sw_if_counters[VNET_INTERFACE_COUNTER_DROP].stat_segment_name =
+    "/if/drops";
+  im->sw_if_counters[VNET_INTERFACE_COUNTER_PUNT].stat_segment_name =
+    "/if/punts";
+  im->sw_if_counters[VNET_INTERFACE_COUNTER_IP4].stat_segment_name =
+    "/if/ip4";
+  im->sw_if_counters[VNET_INTERFACE_COUNTER_IP6].stat_segment_name =
+    "/if/ip6";
+  im->sw_if_counters[VNET_INTERFACE_COUNTER_RX_NO_BUF].stat_segment_name =
+    "/if/rx-no-buf";
+  im->sw_if_counters[VNET_INTERFACE_COUNTER_RX_MISS].stat_segment_name =
+    "/if/rx-miss";
+  im->sw_if_counters[VNET_INTERFACE_COUNTER_RX_ERROR].stat_segment_name =
+    "/if/rx-error";
+  im->sw_if_counters[VNET_INTERFACE_COUNTER_TX_ERROR].stat_segment_name =
+    "/if/tx-error";
 
   vec_validate (im->combined_sw_if_counters,
 		VNET_N_COMBINED_INTERFACE_COUNTER - 1);
   im->combined_sw_if_counters[VNET_INTERFACE_COUNTER_RX].name = "rx";
   im->combined_sw_if_counters[VNET_INTERFACE_COUNTER_TX].name = "tx";
+  im->combined_sw_if_counters[VNET_INTERFACE_COUNTER_RX].stat_segment_name =
+    "/if/rx";
+  im->combined_sw_if_counters[VNET_INTERFACE_COUNTER_TX].stat_segment_name =
+    "/if/tx";
 
   im->sw_if_counter_lock[0] = 0;
 
@@ -412,6 +412,9 @@ typedef struct vnet_hw_interface_t
   /* tx checksum offload */
 #define VNET_HW_INTERFACE_FLAG_SUPPORTS_TX_L4_CKSUM_OFFLOAD (1 << 11)
 
+  /* tx segmentation offload, i.e. accepts VNET_BUFFER_F_GSO packets */
+#define VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO (1 << 12)
+
   /* Hardware address as vector.  Zero (e.g. zero-length vector) if no
      address for this class (e.g. PPP). */
   u8 *hw_address;
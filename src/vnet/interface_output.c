@@ -43,6 +43,7 @@
 #include <vnet/ip/ip6.h>
 #include <vnet/udp/udp_packet.h>
 #include <vnet/feature/feature.h>
+#include <vnet/gso/gso.h>
 
 typedef struct
 {
@@ -158,7 +159,7 @@ vnet_interface_output_trace (vlib_main_t * vm,
 }
 
 static_always_inline void
-calc_checksums (vlib_main_t * vm, vlib_buffer_t * b)
+calc_checksums (vlib_main_t * vm, vlib_buffer_t * b, int gso_downstream)
 {
   ip4_header_t *ip4;
   ip6_header_t *ip6;
@@ -170,6 +171,11 @@ calc_checksums (vlib_main_t * vm, vlib_buffer_t * b)
 
   ASSERT (!(is_ip4 && is_ip6));
 
+  /* Each segment is checksummed as it is cut, by the gso feature or the
+     device; nothing cuts the packets of other interfaces */
+  if (PREDICT_FALSE (b->flags & VNET_BUFFER_F_GSO) && gso_downstream)
+    return;
+
   ip4 = (ip4_header_t *) (b->data + vnet_buffer (b)->l3_hdr_offset);
   ip6 = (ip6_header_t *) (b->data + vnet_buffer (b)->l3_hdr_offset);
   th = (tcp_header_t *) (b->data + vnet_buffer (b)->l4_hdr_offset);
@@ -180,18 +186,33 @@ calc_checksums (vlib_main_t * vm, vlib_buffer_t * b)
       ip4 = (ip4_header_t *) (b->data + vnet_buffer (b)->l3_hdr_offset);
       if (b->flags & VNET_BUFFER_F_OFFLOAD_IP_CKSUM)
 	ip4->checksum = ip4_header_checksum (ip4);
+      /* The field may hold a pseudo-header sum, e.g. from a guest */
       if (b->flags & VNET_BUFFER_F_OFFLOAD_TCP_CKSUM)
-	th->checksum = ip4_tcp_udp_compute_checksum (vm, b, ip4);
+	{
+	  th->checksum = 0;
+	  th->checksum = ip4_tcp_udp_compute_checksum (vm, b, ip4);
+	}
       if (b->flags & VNET_BUFFER_F_OFFLOAD_UDP_CKSUM)
-	uh->checksum = ip4_tcp_udp_compute_checksum (vm, b, ip4);
+	{
+	  uh->checksum = 0;
+	  uh->checksum = ip4_tcp_udp_compute_checksum (vm, b, ip4);
+	}
     }
   if (is_ip6)
     {
       int bogus;
       if (b->flags & VNET_BUFFER_F_OFFLOAD_TCP_CKSUM)
-	th->checksum = ip6_tcp_udp_icmp_compute_checksum (vm, b, ip6, &bogus);
+	{
+	  th->checksum = 0;
+	  th->checksum =
+	    ip6_tcp_udp_icmp_compute_checksum (vm, b, ip6, &bogus);
+	}
       if (b->flags & VNET_BUFFER_F_OFFLOAD_UDP_CKSUM)
-	uh->checksum = ip6_tcp_udp_icmp_compute_checksum (vm, b, ip6, &bogus);
+	{
+	  uh->checksum = 0;
+	  uh->checksum =
+	    ip6_tcp_udp_icmp_compute_checksum (vm, b, ip6, &bogus);
+	}
     }
 
   b->flags &= ~VNET_BUFFER_F_OFFLOAD_TCP_CKSUM;
@@ -216,6 +237,7 @@ vnet_interface_output_node_inline (vlib_main_t * vm,
   u32 next_index = VNET_INTERFACE_OUTPUT_NEXT_TX;
   u32 current_config_index = ~0;
   u8 arc = im->output_feature_arc_index;
+  int gso_downstream;
 
   n_buffers = frame->n_vectors;
 
@@ -255,6 +277,9 @@ vnet_interface_output_node_inline (vlib_main_t * vm,
 
   from_end = from + n_buffers;
 
+  gso_downstream = (hi->flags & VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO)
+    || vnet_gso_is_enabled (rt->sw_if_index);
+
   /* Total byte count of all buffers. */
   n_bytes = 0;
   n_packets = 0;
@@ -382,10 +407,10 @@ vnet_interface_output_node_inline (vlib_main_t * vm,
 		   VNET_BUFFER_F_OFFLOAD_UDP_CKSUM |
 		   VNET_BUFFER_F_OFFLOAD_IP_CKSUM))
 		{
-		  calc_checksums (vm, b0);
-		  calc_checksums (vm, b1);
-		  calc_checksums (vm, b2);
-		  calc_checksums (vm, b3);
+		  calc_checksums (vm, b0, gso_downstream);
+		  calc_checksums (vm, b1, gso_downstream);
+		  calc_checksums (vm, b2, gso_downstream);
+		  calc_checksums (vm, b3, gso_downstream);
 		}
 	    }
 	}
@@ -429,7 +454,7 @@ vnet_interface_output_node_inline (vlib_main_t * vm,
 	    }
 
 	  if (do_tx_offloads)
-	    calc_checksums (vm, b0);
+	    calc_checksums (vm, b0, gso_downstream);
 	}
 
       vlib_put_next_frame (vm, node, next_index, n_left_to_tx);
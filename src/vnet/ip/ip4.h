@@ -45,6 +45,7 @@
 #include <vnet/buffer.h>
 #include <vnet/feature/feature.h>
 #include <vnet/ip/icmp46_packet.h>
+#include <vnet/ip/ip4_mtrie.h>
 
 typedef struct ip4_mfib_t
 {
@@ -154,6 +155,12 @@ typedef struct ip4_main_t
 
   /** The memory heap for the mtries */
   void *mtrie_mheap;
+
+  /** The mtrie layout of new tables */
+  ip4_fib_mtrie_type_t mtrie_type_default;
+
+  /** The mtrie layout chosen for a table, by table-id */
+  uword *mtrie_type_by_table_id;
 } ip4_main_t;
 
 /** Global ip4 main structure. */
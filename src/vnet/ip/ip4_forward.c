@@ -1274,8 +1274,8 @@ ip4_local_inline (vlib_main_t * vm,
 	  vnet_buffer (p0)->ip.fib_index = fib_index0;
 	  vnet_buffer (p1)->ip.fib_index = fib_index1;
 
-	  mtrie0 = &ip4_fib_get (fib_index0)->mtrie;
-	  mtrie1 = &ip4_fib_get (fib_index1)->mtrie;
+	  mtrie0 = ip4_fib_get (fib_index0)->mtrie;
+	  mtrie1 = ip4_fib_get (fib_index1)->mtrie;
 
 	  leaf0 = ip4_fib_mtrie_lookup_step_one (mtrie0, &ip0->src_address);
 	  leaf1 = ip4_fib_mtrie_lookup_step_one (mtrie1, &ip1->src_address);
@@ -1418,7 +1418,7 @@ ip4_local_inline (vlib_main_t * vm,
 	    (vnet_buffer (p0)->sw_if_index[VLIB_TX] ==
 	     (u32) ~ 0) ? fib_index0 : vnet_buffer (p0)->sw_if_index[VLIB_TX];
 	  vnet_buffer (p0)->ip.fib_index = fib_index0;
-	  mtrie0 = &ip4_fib_get (fib_index0)->mtrie;
+	  mtrie0 = ip4_fib_get (fib_index0)->mtrie;
 	  leaf0 = ip4_fib_mtrie_lookup_step_one (mtrie0, &ip0->src_address);
 	  leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, &ip0->src_address,
 					     2);
@@ -2110,7 +2110,7 @@ ip4_rewrite_inline (vlib_main_t * vm,
 	  vnet_buffer (p1)->ip.save_rewrite_length = rw_len1;
 
 	  /* Check MTU of outgoing interface. */
-	  if (vlib_buffer_length_in_chain (vm, p0) >
+	  if (vnet_buffer_mtu_check_length (vm, p0) >
 	      adj0[0].rewrite_header.max_l3_packet_bytes)
 	    {
 	      error0 = IP4_ERROR_MTU_EXCEEDED;
@@ -2120,7 +2120,7 @@ ip4_rewrite_inline (vlib_main_t * vm,
 		 ICMP4_destination_unreachable_fragmentation_needed_and_dont_fragment_set,
 		 0);
 	    }
-	  if (vlib_buffer_length_in_chain (vm, p1) >
+	  if (vnet_buffer_mtu_check_length (vm, p1) >
 	      adj1[0].rewrite_header.max_l3_packet_bytes)
 	    {
 	      error1 = IP4_ERROR_MTU_EXCEEDED;
@@ -2301,7 +2301,7 @@ ip4_rewrite_inline (vlib_main_t * vm,
 	       vlib_buffer_length_in_chain (vm, p0) + rw_len0);
 
 	  /* Check MTU of outgoing interface. */
-	  if (vlib_buffer_length_in_chain (vm, p0) >
+	  if (vnet_buffer_mtu_check_length (vm, p0) >
 	      adj0[0].rewrite_header.max_l3_packet_bytes)
 	    {
 	      error0 = IP4_ERROR_MTU_EXCEEDED;
@@ -2488,7 +2488,7 @@ ip4_lookup_validate (ip4_address_t * a, u32 fib_index0)
   ip4_fib_mtrie_leaf_t leaf0;
   u32 lbi0;
 
-  mtrie0 = &ip4_fib_get (fib_index0)->mtrie;
+  mtrie0 = ip4_fib_get (fib_index0)->mtrie;
 
   leaf0 = ip4_fib_mtrie_lookup_step_one (mtrie0, a);
   leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, a, 2);
@@ -2863,9 +2863,13 @@ ip4_config (vlib_main_t * vm, unformat_input_t * input)
     {
       if (unformat (input, "heap-size %U", unformat_memory_size, &heapsize))
 	;
+      else if (unformat (input, "mtrie %U",
+			 unformat_ip4_fib_mtrie_type,
+			 &im->mtrie_type_default))
+	;
       else
 	return clib_error_return (0,
-				  "invalid heap-size parameter `%U'",
+				  "invalid ip parameter `%U'",
 				  format_unformat_error, input);
     }
 
@@ -161,10 +161,10 @@ ip4_lookup_inline (vlib_main_t * vm,
 
 	  if (!lookup_for_responses_to_locally_received_packets)
 	    {
-	      mtrie0 = &ip4_fib_get (fib_index0)->mtrie;
-	      mtrie1 = &ip4_fib_get (fib_index1)->mtrie;
-	      mtrie2 = &ip4_fib_get (fib_index2)->mtrie;
-	      mtrie3 = &ip4_fib_get (fib_index3)->mtrie;
+	      mtrie0 = ip4_fib_get (fib_index0)->mtrie;
+	      mtrie1 = ip4_fib_get (fib_index1)->mtrie;
+	      mtrie2 = ip4_fib_get (fib_index2)->mtrie;
+	      mtrie3 = ip4_fib_get (fib_index3)->mtrie;
 
 	      leaf0 = ip4_fib_mtrie_lookup_step_one (mtrie0, dst_addr0);
 	      leaf1 = ip4_fib_mtrie_lookup_step_one (mtrie1, dst_addr1);
@@ -340,7 +340,7 @@ ip4_lookup_inline (vlib_main_t * vm,
 
 	  if (!lookup_for_responses_to_locally_received_packets)
 	    {
-	      mtrie0 = &ip4_fib_get (fib_index0)->mtrie;
+	      mtrie0 = ip4_fib_get (fib_index0)->mtrie;
 
 	      leaf0 = ip4_fib_mtrie_lookup_step_one (mtrie0, dst_addr0);
 	    }
@@ -177,16 +177,35 @@ ply_create (ip4_fib_mtrie_t * m,
 {
   ip4_fib_mtrie_8_ply_t *p;
   void *old_heap;
+  u8 need_barrier_sync;
   /* Get cache aligned ply. */
 
   old_heap = clib_mem_set_heap (ip4_main.mtrie_mheap);
+
+  /* The workers walk the pool unlocked; stop them should it move */
+  pool_get_aligned_will_expand (ip4_ply_pool, need_barrier_sync,
+				CLIB_CACHE_LINE_BYTES);
+  if (need_barrier_sync)
+    vlib_worker_thread_barrier_sync (vlib_get_main ());
+
   pool_get_aligned (ip4_ply_pool, p, CLIB_CACHE_LINE_BYTES);
+
+  if (need_barrier_sync)
+    vlib_worker_thread_barrier_release (vlib_get_main ());
+
   clib_mem_set_heap (old_heap);
 
   ply_8_init (p, init_leaf, leaf_prefix_len, ply_base_len);
   return ip4_fib_mtrie_leaf_set_next_ply_index (p - ip4_ply_pool);
 }
 
+/* A grace period after the ply was unlinked: no worker can be in it */
+static void
+ply_free_rcu (void *arg)
+{
+  pool_put_index (ip4_ply_pool, pointer_to_uword (arg));
+}
+
 always_inline ip4_fib_mtrie_8_ply_t *
 get_next_ply_for_leaf (ip4_fib_mtrie_t * m, ip4_fib_mtrie_leaf_t l)
 {
@@ -195,26 +214,80 @@ get_next_ply_for_leaf (ip4_fib_mtrie_t * m, ip4_fib_mtrie_leaf_t l)
   return pool_elt_at_index (ip4_ply_pool, n);
 }
 
+/* A grace period after the FIB let go of the trie: no worker can be in it */
+static void
+mtrie_free_rcu (void *arg)
+{
+  void *old_heap;
+
+  old_heap = clib_mem_set_heap (ip4_main.mtrie_mheap);
+  clib_mem_free (arg);
+  clib_mem_set_heap (old_heap);
+}
+
 void
 ip4_mtrie_free (ip4_fib_mtrie_t * m)
 {
-  /* the root ply is embedded so the is nothing to do,
-   * the assumption being that the IP4 FIB table has emptied the trie
+  /* the assumption being that the IP4 FIB table has emptied the trie
    * before deletion.
    */
 #if CLIB_DEBUG > 0
   int i;
-  for (i = 0; i < ARRAY_LEN (m->root_ply.leaves); i++)
+  if (IP4_FIB_MTRIE_16_8_8 == m->type)
+    {
+      for (i = 0; i < ARRAY_LEN (m->root_ply->leaves); i++)
+	{
+	  ASSERT (!ip4_fib_mtrie_leaf_is_next_ply (m->root_ply->leaves[i]));
+	}
+    }
+  else
     {
-      ASSERT (!ip4_fib_mtrie_leaf_is_next_ply (m->root_ply.leaves[i]));
+      ip4_fib_mtrie_8_ply_t *p;
+
+      p = pool_elt_at_index (ip4_ply_pool, m->root_ply_8_index);
+      for (i = 0; i < ARRAY_LEN (p->leaves); i++)
+	{
+	  ASSERT (!ip4_fib_mtrie_leaf_is_next_ply (p->leaves[i]));
+	}
     }
 #endif
+
+  if (IP4_FIB_MTRIE_8_8_8_8 == m->type)
+    vlib_rcu_call (ply_free_rcu,
+		   uword_to_pointer (m->root_ply_8_index, void *));
+  vlib_rcu_call (mtrie_free_rcu, m);
 }
 
-void
-ip4_mtrie_init (ip4_fib_mtrie_t * m)
+ip4_fib_mtrie_t *
+ip4_mtrie_alloc (ip4_fib_mtrie_type_t type)
 {
-  ply_16_init (&m->root_ply, IP4_FIB_MTRIE_LEAF_EMPTY, 0);
+  ip4_fib_mtrie_t *m;
+  void *old_heap;
+  uword n_bytes;
+
+  n_bytes = sizeof (*m);
+  if (IP4_FIB_MTRIE_16_8_8 == type)
+    n_bytes += sizeof (m->root_ply[0]);
+
+  old_heap = clib_mem_set_heap (ip4_main.mtrie_mheap);
+  m = clib_mem_alloc_aligned (n_bytes, CLIB_CACHE_LINE_BYTES);
+  clib_mem_set_heap (old_heap);
+  m->type = type;
+
+  if (IP4_FIB_MTRIE_8_8_8_8 == type)
+    {
+      m->root_ply_8_index =
+	ip4_fib_mtrie_leaf_get_next_ply_index (ply_create
+					       (m, IP4_FIB_MTRIE_LEAF_EMPTY,
+						0, 0));
+    }
+  else
+    {
+      m->root_ply_8_index = ~0;
+      ply_16_init (m->root_ply, IP4_FIB_MTRIE_LEAF_EMPTY, 0);
+    }
+
+  return (m);
 }
 
 typedef struct
@@ -369,9 +442,13 @@ set_leaf (ip4_fib_mtrie_t * m,
 	  old_ply->n_non_empty_leafs -=
 	    ip4_fib_mtrie_leaf_is_non_empty (old_ply, dst_byte);
 
+	  /*
+	   * the new ply's leaves keep the length of the prefix they are
+	   * from, even when that is shorter than the ply's base, so that
+	   * a later route of a length in between replaces them
+	   */
 	  new_leaf = ply_create (m, old_leaf,
-				 clib_max (old_ply->dst_address_bits_of_leaves
-					   [dst_byte], ply_base_len),
+				 old_ply->dst_address_bits_of_leaves[dst_byte],
 				 ply_base_len);
 	  new_ply = get_next_ply_for_leaf (m, new_leaf);
 
@@ -403,7 +480,14 @@ set_root_leaf (ip4_fib_mtrie_t * m,
   i32 n_dst_bits_next_plies;
   u16 dst_byte;
 
-  old_ply = &m->root_ply;
+  if (IP4_FIB_MTRIE_8_8_8_8 == m->type)
+    {
+      /* the 8 bit root ply takes the same path as those below it */
+      set_leaf (m, a, m->root_ply_8_index, 0);
+      return;
+    }
+
+  old_ply = m->root_ply;
 
   ASSERT (a->dst_address_length <= 32);
 
@@ -492,9 +576,13 @@ set_root_leaf (ip4_fib_mtrie_t * m,
       if (ip4_fib_mtrie_leaf_is_terminal (old_leaf))
 	{
 	  /* There is a leaf occupying the slot. Replace it with a new ply */
+	  /*
+	   * the new ply's leaves keep the length of the prefix they are
+	   * from, even when that is shorter than the ply's base, so that
+	   * a later route of a length in between replaces them
+	   */
 	  new_leaf = ply_create (m, old_leaf,
-				 clib_max (old_ply->dst_address_bits_of_leaves
-					   [dst_byte], ply_base_len),
+				 old_ply->dst_address_bits_of_leaves[dst_byte],
 				 ply_base_len);
 	  new_ply = get_next_ply_for_leaf (m, new_leaf);
 
@@ -551,9 +639,7 @@ unset_leaf (ip4_fib_mtrie_t * m,
 
 	  old_ply->leaves[i] =
 	    ip4_fib_mtrie_leaf_set_adj_index (a->cover_adj_index);
-	  old_ply->dst_address_bits_of_leaves[i] =
-	    clib_max (old_ply->dst_address_bits_base,
-		      a->cover_address_length);
+	  old_ply->dst_address_bits_of_leaves[i] = a->cover_address_length;
 
 	  old_ply->n_non_empty_leafs +=
 	    ip4_fib_mtrie_leaf_is_non_empty (old_ply, i);
@@ -561,7 +647,10 @@ unset_leaf (ip4_fib_mtrie_t * m,
 	  ASSERT (old_ply->n_non_empty_leafs >= 0);
 	  if (old_ply->n_non_empty_leafs == 0 && dst_address_byte_index > 0)
 	    {
-	      pool_put (ip4_ply_pool, old_ply);
+	      /* the caller unlinks it, the workers may still be in it */
+	      vlib_rcu_call (ply_free_rcu,
+			     uword_to_pointer (old_ply - ip4_ply_pool,
+					       void *));
 	      /* Old ply was deleted. */
 	      return 1;
 	    }
@@ -595,7 +684,15 @@ unset_root_leaf (ip4_fib_mtrie_t * m,
 
   ASSERT (a->dst_address_length <= 32);
 
-  old_ply = &m->root_ply;
+  if (IP4_FIB_MTRIE_8_8_8_8 == m->type)
+    {
+      /* the 8 bit root ply is never removed, as byte 0 */
+      unset_leaf (m, a, pool_elt_at_index (ip4_ply_pool,
+					   m->root_ply_8_index), 0);
+      return;
+    }
+
+  old_ply = m->root_ply;
   n_dst_bits_next_plies = a->dst_address_length - BITS (u16);
 
   dst_byte = a->dst_address.as_u16[0];
@@ -692,9 +789,16 @@ ip4_fib_mtrie_memory_usage (ip4_fib_mtrie_t * m)
   uword bytes, i;
 
   bytes = sizeof (*m);
-  for (i = 0; i < ARRAY_LEN (m->root_ply.leaves); i++)
+
+  if (IP4_FIB_MTRIE_8_8_8_8 == m->type)
+    return (bytes + mtrie_ply_memory_usage (m, pool_elt_at_index
+					    (ip4_ply_pool,
+					     m->root_ply_8_index)));
+
+  bytes += sizeof (m->root_ply[0]);
+  for (i = 0; i < ARRAY_LEN (m->root_ply->leaves); i++)
     {
-      ip4_fib_mtrie_leaf_t l = m->root_ply.leaves[i];
+      ip4_fib_mtrie_leaf_t l = m->root_ply->leaves[i];
       if (ip4_fib_mtrie_leaf_is_next_ply (l))
 	bytes += mtrie_ply_memory_usage (m, get_next_ply_for_leaf (m, l));
     }
@@ -772,16 +876,20 @@ format_ip4_fib_mtrie (u8 * s, va_list * va)
   u32 base_address = 0;
   int i;
 
-  s = format (s, "%d plies, memory usage %U\n",
+  s = format (s, "%U, %d plies, memory usage %U\n",
+	      format_ip4_fib_mtrie_type, m->type,
 	      pool_elts (ip4_ply_pool),
 	      format_memory_size, ip4_fib_mtrie_memory_usage (m));
   s = format (s, "root-ply");
-  p = &m->root_ply;
 
-  if (verbose)
+  if (verbose && IP4_FIB_MTRIE_8_8_8_8 == m->type)
     {
-      s = format (s, "root-ply");
-      p = &m->root_ply;
+      s = format (s, " %U", format_ip4_fib_mtrie_ply, m, base_address,
+		  m->root_ply_8_index);
+    }
+  else if (verbose)
+    {
+      p = m->root_ply;
 
       for (i = 0; i < ARRAY_LEN (p->leaves); i++)
 	{
@@ -799,6 +907,32 @@ format_ip4_fib_mtrie (u8 * s, va_list * va)
   return s;
 }
 
+static char *ip4_fib_mtrie_type_names[] = IP4_FIB_MTRIE_TYPES;
+
+u8 *
+format_ip4_fib_mtrie_type (u8 * s, va_list * va)
+{
+  ip4_fib_mtrie_type_t type = va_arg (*va, int);
+
+  return (format (s, "%s", ip4_fib_mtrie_type_names[type]));
+}
+
+uword
+unformat_ip4_fib_mtrie_type (unformat_input_t * input, va_list * va)
+{
+  ip4_fib_mtrie_type_t *type = va_arg (*va, ip4_fib_mtrie_type_t *);
+  int i;
+
+  for (i = 0; i < ARRAY_LEN (ip4_fib_mtrie_type_names); i++)
+    if (unformat (input, ip4_fib_mtrie_type_names[i]))
+      {
+	*type = i;
+	return (1);
+      }
+
+  return (0);
+}
+
 /** Default heap size for the IPv4 mtries */
 #define IP4_FIB_DEFAULT_MTRIE_HEAP_SIZE (32<<20)
 
@@ -45,7 +45,7 @@
 #include <vnet/ip/lookup.h>
 #include <vnet/ip/ip4_packet.h>	/* for ip4_address_t */
 
-/* ip4 fib leafs: 4 ply 8-8-8-8 mtrie.
+/* ip4 fib leafs: 3 ply 16-8-8 or 4 ply 8-8-8-8 mtrie.
    1 + 2*adj_index for terminal leaves.
    0 + 2*next_ply_index for non-terminals, i.e. PLYs
    1 => empty (adjacency index of zero is special miss adjacency). */
@@ -122,27 +122,61 @@ ip4_fib_mtrie_8_ply_t;
 STATIC_ASSERT (0 == sizeof (ip4_fib_mtrie_8_ply_t) % CLIB_CACHE_LINE_BYTES,
 	       "IP4 Mtrie ply cache line");
 
+/**
+ * @brief The layout, i.e. the strides, of the mtrie.
+ * The lookups of a 16-8-8 trie start in its 16 bit root ply, 320k of
+ * leaves and lengths, which tables of many, sparse, VRFs mostly waste
+ * memory and cache on. The root of an 8-8-8-8 trie is an 8 bit ply of
+ * about 1k, for a fourth, dependent, read on lookups beyond the root.
+ */
+typedef enum ip4_fib_mtrie_type_t_
+{
+  IP4_FIB_MTRIE_16_8_8,
+  IP4_FIB_MTRIE_8_8_8_8,
+} __attribute__ ((packed)) ip4_fib_mtrie_type_t;
+
+#define IP4_FIB_MTRIE_N_TYPES (IP4_FIB_MTRIE_8_8_8_8 + 1)
+
+#define IP4_FIB_MTRIE_TYPES {                   \
+    [IP4_FIB_MTRIE_16_8_8] = "16-8-8",          \
+    [IP4_FIB_MTRIE_8_8_8_8] = "8-8-8-8",        \
+}
+
+#define FOR_EACH_IP4_FIB_MTRIE_TYPE(_type)      \
+  for (_type = IP4_FIB_MTRIE_16_8_8;            \
+       _type < IP4_FIB_MTRIE_N_TYPES;           \
+       _type++)
+
 /**
  * @brief The mutiway-TRIE.
- * There is no data associated with the mtrie apart from the top PLY
+ * There is no data associated with the mtrie apart from the top PLY.
+ * It is allocated by its layout: the 16 bit root PLY ends a 16-8-8 trie,
+ * and is left off an 8-8-8-8 one.
  */
 typedef struct
 {
+  ip4_fib_mtrie_type_t type;
+
+  /**
+   * Index in the ply pool of the 8 bit root PLY of an 8-8-8-8 trie
+   */
+  u32 root_ply_8_index;
+
   /**
-   * Embed the PLY with the mtrie struct. This means that the Data-plane
-   * 'get me the mtrie' returns the first ply, and not an indirect 'pointer'
-   * to it. therefore no cachline misses in the data-path.
+   * The 16 bit root PLY of a 16-8-8 trie. In the same allocation as the
+   * type, so the lookup reads both without a pointer in between.
    */
-  ip4_fib_mtrie_16_ply_t root_ply;
+  ip4_fib_mtrie_16_ply_t root_ply[0];
 } ip4_fib_mtrie_t;
 
 /**
- * @brief Initialise an mtrie
+ * @brief Allocate and initialise an mtrie of the given layout
  */
-void ip4_mtrie_init (ip4_fib_mtrie_t * m);
+ip4_fib_mtrie_t *ip4_mtrie_alloc (ip4_fib_mtrie_type_t type);
 
 /**
- * @brief Free an mtrie, It must be emty when free'd
+ * @brief Free an mtrie, It must be emty when free'd.
+ * The memory is returned once no worker can be looking up in it.
  */
 void ip4_mtrie_free (ip4_fib_mtrie_t * m);
 
@@ -170,6 +204,8 @@ uword ip4_fib_mtrie_memory_usage (ip4_fib_mtrie_t * m);
  * @brief Format/display the contents of the mtrie
  */
 format_function_t format_ip4_fib_mtrie;
+format_function_t format_ip4_fib_mtrie_type;
+unformat_function_t unformat_ip4_fib_mtrie_type;
 
 /**
  * @brief A global pool of 8bit stride plys
@@ -219,6 +255,8 @@ ip4_fib_mtrie_lookup_step (const ip4_fib_mtrie_t * m,
 
 /**
  * @brief Lookup step number 1.  Processes 2 bytes of 4 byte ip4 address.
+ * An 8-8-8-8 trie takes two steps over its first two plies here, so
+ * that all layouts continue with the same steps 2 and 3.
  */
 always_inline ip4_fib_mtrie_leaf_t
 ip4_fib_mtrie_lookup_step_one (const ip4_fib_mtrie_t * m,
@@ -226,9 +264,12 @@ ip4_fib_mtrie_lookup_step_one (const ip4_fib_mtrie_t * m,
 {
   ip4_fib_mtrie_leaf_t next_leaf;
 
-  next_leaf = m->root_ply.leaves[dst_address->as_u16[0]];
+  if (PREDICT_TRUE (IP4_FIB_MTRIE_16_8_8 == m->type))
+    return (m->root_ply->leaves[dst_address->as_u16[0]]);
+
+  next_leaf = ip4_ply_pool[m->root_ply_8_index].leaves[dst_address->as_u8[0]];
 
-  return next_leaf;
+  return (ip4_fib_mtrie_lookup_step (m, next_leaf, dst_address, 1));
 }
 
 #endif /* included_ip_ip4_fib_h */
@@ -28,14 +28,20 @@
 
 /**
  * @brief set ip4 reassembly configuration
+ *
+ * max_reassemblies is shared out between the worker threads, each of
+ * which reassembles the fragments hashing to it; a max_reassembly_length
+ * of 0 selects the default number of fragments per reassembly.
  */
 vnet_api_error_t ip4_reass_set (u32 timeout_ms, u32 max_reassemblies,
+				u32 max_reassembly_length,
 				u32 expire_walk_interval_ms);
 
 /**
  * @brief get ip4 reassembly configuration
  */
 vnet_api_error_t ip4_reass_get (u32 * timeout_ms, u32 * max_reassemblies,
+				u32 * max_reassembly_length,
 				u32 * expire_walk_interval_ms);
 
 #endif /* __included_ip4_reassembly_h */
@@ -159,8 +159,8 @@ ip4_source_check_inline (vlib_main_t * vm,
 					 [VLIB_RX], &next1, p1,
 					 sizeof (c1[0]));
 
-	  mtrie0 = &ip4_fib_get (c0->fib_index)->mtrie;
-	  mtrie1 = &ip4_fib_get (c1->fib_index)->mtrie;
+	  mtrie0 = ip4_fib_get (c0->fib_index)->mtrie;
+	  mtrie1 = ip4_fib_get (c1->fib_index)->mtrie;
 
 	  leaf0 = ip4_fib_mtrie_lookup_step_one (mtrie0, &ip0->src_address);
 	  leaf1 = ip4_fib_mtrie_lookup_step_one (mtrie1, &ip1->src_address);
@@ -239,7 +239,7 @@ ip4_source_check_inline (vlib_main_t * vm,
 					 [VLIB_RX], &next0, p0,
 					 sizeof (c0[0]));
 
-	  mtrie0 = &ip4_fib_get (c0->fib_index)->mtrie;
+	  mtrie0 = ip4_fib_get (c0->fib_index)->mtrie;
 
 	  leaf0 = ip4_fib_mtrie_lookup_step_one (mtrie0, &ip0->src_address);
 
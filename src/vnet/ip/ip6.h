@@ -50,6 +50,7 @@
 #include <vppinfra/bihash_24_8.h>
 #include <vppinfra/bihash_template.h>
 #include <vnet/util/radix.h>
+#include <vnet/ip/ip6_lpm.h>
 
 /*
  * Default size of the ip6 fib hash table
@@ -71,6 +72,9 @@ typedef struct
 
   /* Index into FIB vector. */
   u32 index;
+
+  /* The forwarding lookup; binary search on prefix lengths */
+  ip6_lpm_t lpm;
 } ip6_fib_t;
 
 typedef struct ip6_mfib_t
@@ -69,66 +69,110 @@ ip6_lookup_inline (vlib_main_t * vm,
     {
       vlib_get_next_frame (vm, node, next, to_next, n_left_to_next);
 
-      while (n_left_from >= 4 && n_left_to_next >= 2)
+      while (n_left_from >= 8 && n_left_to_next >= 4)
 	{
-	  vlib_buffer_t *p0, *p1;
-	  u32 pi0, pi1, lbi0, lbi1, wrong_next;
-	  ip_lookup_next_t next0, next1;
-	  ip6_header_t *ip0, *ip1;
-	  ip6_address_t *dst_addr0, *dst_addr1;
-	  u32 fib_index0, fib_index1;
-	  u32 flow_hash_config0, flow_hash_config1;
-	  const dpo_id_t *dpo0, *dpo1;
-	  const load_balance_t *lb0, *lb1;
+	  vlib_buffer_t *p0, *p1, *p2, *p3;
+	  ip6_header_t *ip0, *ip1, *ip2, *ip3;
+	  ip_lookup_next_t next0, next1, next2, next3;
+	  const load_balance_t *lb0, *lb1, *lb2, *lb3;
+	  const ip6_address_t *dst_addr[4];
+	  u32 pi0, pi1, pi2, pi3;
+	  u32 fib_index[4], lbi[4];
+	  flow_hash_config_t flow_hash_config0, flow_hash_config1;
+	  flow_hash_config_t flow_hash_config2, flow_hash_config3;
+	  const dpo_id_t *dpo0, *dpo1, *dpo2, *dpo3;
 
 	  /* Prefetch next iteration. */
 	  {
-	    vlib_buffer_t *p2, *p3;
-
-	    p2 = vlib_get_buffer (vm, from[2]);
-	    p3 = vlib_get_buffer (vm, from[3]);
-
-	    vlib_prefetch_buffer_header (p2, LOAD);
-	    vlib_prefetch_buffer_header (p3, LOAD);
-	    CLIB_PREFETCH (p2->data, sizeof (ip0[0]), LOAD);
-	    CLIB_PREFETCH (p3->data, sizeof (ip0[0]), LOAD);
+	    vlib_buffer_t *p4, *p5, *p6, *p7;
+
+	    p4 = vlib_get_buffer (vm, from[4]);
+	    p5 = vlib_get_buffer (vm, from[5]);
+	    p6 = vlib_get_buffer (vm, from[6]);
+	    p7 = vlib_get_buffer (vm, from[7]);
+
+	    vlib_prefetch_buffer_header (p4, LOAD);
+	    vlib_prefetch_buffer_header (p5, LOAD);
+	    vlib_prefetch_buffer_header (p6, LOAD);
+	    vlib_prefetch_buffer_header (p7, LOAD);
+
+	    CLIB_PREFETCH (p4->data, sizeof (ip0[0]), LOAD);
+	    CLIB_PREFETCH (p5->data, sizeof (ip0[0]), LOAD);
+	    CLIB_PREFETCH (p6->data, sizeof (ip0[0]), LOAD);
+	    CLIB_PREFETCH (p7->data, sizeof (ip0[0]), LOAD);
 	  }
 
 	  pi0 = to_next[0] = from[0];
 	  pi1 = to_next[1] = from[1];
+	  pi2 = to_next[2] = from[2];
+	  pi3 = to_next[3] = from[3];
+
+	  from += 4;
+	  to_next += 4;
+	  n_left_to_next -= 4;
+	  n_left_from -= 4;
 
 	  p0 = vlib_get_buffer (vm, pi0);
 	  p1 = vlib_get_buffer (vm, pi1);
+	  p2 = vlib_get_buffer (vm, pi2);
+	  p3 = vlib_get_buffer (vm, pi3);
 
 	  ip0 = vlib_buffer_get_current (p0);
 	  ip1 = vlib_buffer_get_current (p1);
+	  ip2 = vlib_buffer_get_current (p2);
+	  ip3 = vlib_buffer_get_current (p3);
 
-	  dst_addr0 = &ip0->dst_address;
-	  dst_addr1 = &ip1->dst_address;
+	  dst_addr[0] = &ip0->dst_address;
+	  dst_addr[1] = &ip1->dst_address;
+	  dst_addr[2] = &ip2->dst_address;
+	  dst_addr[3] = &ip3->dst_address;
 
-	  fib_index0 =
+	  fib_index[0] =
 	    vec_elt (im->fib_index_by_sw_if_index,
 		     vnet_buffer (p0)->sw_if_index[VLIB_RX]);
-	  fib_index1 =
+	  fib_index[1] =
 	    vec_elt (im->fib_index_by_sw_if_index,
 		     vnet_buffer (p1)->sw_if_index[VLIB_RX]);
+	  fib_index[2] =
+	    vec_elt (im->fib_index_by_sw_if_index,
+		     vnet_buffer (p2)->sw_if_index[VLIB_RX]);
+	  fib_index[3] =
+	    vec_elt (im->fib_index_by_sw_if_index,
+		     vnet_buffer (p3)->sw_if_index[VLIB_RX]);
+	  fib_index[0] =
+	    (vnet_buffer (p0)->sw_if_index[VLIB_TX] ==
+	     (u32) ~ 0) ? fib_index[0] : vnet_buffer (p0)->sw_if_index[VLIB_TX];
+	  fib_index[1] =
+	    (vnet_buffer (p1)->sw_if_index[VLIB_TX] ==
+	     (u32) ~ 0) ? fib_index[1] : vnet_buffer (p1)->sw_if_index[VLIB_TX];
+	  fib_index[2] =
+	    (vnet_buffer (p2)->sw_if_index[VLIB_TX] ==
+	     (u32) ~ 0) ? fib_index[2] : vnet_buffer (p2)->sw_if_index[VLIB_TX];
+	  fib_index[3] =
+	    (vnet_buffer (p3)->sw_if_index[VLIB_TX] ==
+	     (u32) ~ 0) ? fib_index[3] : vnet_buffer (p3)->sw_if_index[VLIB_TX];
+
+	  /* the four searches in step, their bihash misses overlapping */
+	  ip6_fib_table_fwding_lookup_x4 (im, fib_index, dst_addr, lbi);
+
+	  lb0 = load_balance_get (lbi[0]);
+	  lb1 = load_balance_get (lbi[1]);
+	  lb2 = load_balance_get (lbi[2]);
+	  lb3 = load_balance_get (lbi[3]);
 
-	  fib_index0 = (vnet_buffer (p0)->sw_if_index[VLIB_TX] == (u32) ~ 0) ?
-	    fib_index0 : vnet_buffer (p0)->sw_if_index[VLIB_TX];
-	  fib_index1 = (vnet_buffer (p1)->sw_if_index[VLIB_TX] == (u32) ~ 0) ?
-	    fib_index1 : vnet_buffer (p1)->sw_if_index[VLIB_TX];
-
-	  lbi0 = ip6_fib_table_fwding_lookup (im, fib_index0, dst_addr0);
-	  lbi1 = ip6_fib_table_fwding_lookup (im, fib_index1, dst_addr1);
-
-	  lb0 = load_balance_get (lbi0);
-	  lb1 = load_balance_get (lbi1);
 	  ASSERT (lb0->lb_n_buckets > 0);
-	  ASSERT (lb1->lb_n_buckets > 0);
 	  ASSERT (is_pow2 (lb0->lb_n_buckets));
+	  ASSERT (lb1->lb_n_buckets > 0);
 	  ASSERT (is_pow2 (lb1->lb_n_buckets));
+	  ASSERT (lb2->lb_n_buckets > 0);
+	  ASSERT (is_pow2 (lb2->lb_n_buckets));
+	  ASSERT (lb3->lb_n_buckets > 0);
+	  ASSERT (is_pow2 (lb3->lb_n_buckets));
 
-	  vnet_buffer (p0)->ip.flow_hash = vnet_buffer (p1)->ip.flow_hash = 0;
+	  vnet_buffer (p0)->ip.flow_hash = 0;
+	  vnet_buffer (p1)->ip.flow_hash = 0;
+	  vnet_buffer (p2)->ip.flow_hash = 0;
+	  vnet_buffer (p3)->ip.flow_hash = 0;
 
 	  if (PREDICT_FALSE (lb0->lb_n_buckets > 1))
 	    {
@@ -158,8 +202,39 @@ ip6_lookup_inline (vlib_main_t * vm,
 	    {
 	      dpo1 = load_balance_get_bucket_i (lb1, 0);
 	    }
+	  if (PREDICT_FALSE (lb2->lb_n_buckets > 1))
+	    {
+	      flow_hash_config2 = lb2->lb_hash_config;
+	      vnet_buffer (p2)->ip.flow_hash =
+		ip6_compute_flow_hash (ip2, flow_hash_config2);
+	      dpo2 =
+		load_balance_get_fwd_bucket (lb2,
+					     (vnet_buffer (p2)->ip.flow_hash &
+					      (lb2->lb_n_buckets_minus_1)));
+	    }
+	  else
+	    {
+	      dpo2 = load_balance_get_bucket_i (lb2, 0);
+	    }
+	  if (PREDICT_FALSE (lb3->lb_n_buckets > 1))
+	    {
+	      flow_hash_config3 = lb3->lb_hash_config;
+	      vnet_buffer (p3)->ip.flow_hash =
+		ip6_compute_flow_hash (ip3, flow_hash_config3);
+	      dpo3 =
+		load_balance_get_fwd_bucket (lb3,
+					     (vnet_buffer (p3)->ip.flow_hash &
+					      (lb3->lb_n_buckets_minus_1)));
+	    }
+	  else
+	    {
+	      dpo3 = load_balance_get_bucket_i (lb3, 0);
+	    }
+
 	  next0 = dpo0->dpoi_next_node;
 	  next1 = dpo1->dpoi_next_node;
+	  next2 = dpo2->dpoi_next_node;
+	  next3 = dpo3->dpoi_next_node;
 
 	  /* Only process the HBH Option Header if explicitly configured to do so */
 	  if (PREDICT_FALSE
@@ -174,55 +249,40 @@ ip6_lookup_inline (vlib_main_t * vm,
 	      next1 = (dpo_is_adj (dpo1) && im->hbh_enabled) ?
 		(ip_lookup_next_t) IP6_LOOKUP_NEXT_HOP_BY_HOP : next1;
 	    }
+	  if (PREDICT_FALSE
+	      (ip2->protocol == IP_PROTOCOL_IP6_HOP_BY_HOP_OPTIONS))
+	    {
+	      next2 = (dpo_is_adj (dpo2) && im->hbh_enabled) ?
+		(ip_lookup_next_t) IP6_LOOKUP_NEXT_HOP_BY_HOP : next2;
+	    }
+	  if (PREDICT_FALSE
+	      (ip3->protocol == IP_PROTOCOL_IP6_HOP_BY_HOP_OPTIONS))
+	    {
+	      next3 = (dpo_is_adj (dpo3) && im->hbh_enabled) ?
+		(ip_lookup_next_t) IP6_LOOKUP_NEXT_HOP_BY_HOP : next3;
+	    }
 	  vnet_buffer (p0)->ip.adj_index[VLIB_TX] = dpo0->dpoi_index;
 	  vnet_buffer (p1)->ip.adj_index[VLIB_TX] = dpo1->dpoi_index;
+	  vnet_buffer (p2)->ip.adj_index[VLIB_TX] = dpo2->dpoi_index;
+	  vnet_buffer (p3)->ip.adj_index[VLIB_TX] = dpo3->dpoi_index;
 
 	  vlib_increment_combined_counter
-	    (cm, thread_index, lbi0, 1, vlib_buffer_length_in_chain (vm, p0));
+	    (cm, thread_index, lbi[0], 1,
+	     vlib_buffer_length_in_chain (vm, p0));
 	  vlib_increment_combined_counter
-	    (cm, thread_index, lbi1, 1, vlib_buffer_length_in_chain (vm, p1));
-
-	  from += 2;
-	  to_next += 2;
-	  n_left_to_next -= 2;
-	  n_left_from -= 2;
+	    (cm, thread_index, lbi[1], 1,
+	     vlib_buffer_length_in_chain (vm, p1));
+	  vlib_increment_combined_counter
+	    (cm, thread_index, lbi[2], 1,
+	     vlib_buffer_length_in_chain (vm, p2));
+	  vlib_increment_combined_counter
+	    (cm, thread_index, lbi[3], 1,
+	     vlib_buffer_length_in_chain (vm, p3));
 
-	  wrong_next = (next0 != next) + 2 * (next1 != next);
-	  if (PREDICT_FALSE (wrong_next != 0))
-	    {
-	      switch (wrong_next)
-		{
-		case 1:
-		  /* A B A */
-		  to_next[-2] = pi1;
-		  to_next -= 1;
-		  n_left_to_next += 1;
-		  vlib_set_next_frame_buffer (vm, node, next0, pi0);
-		  break;
-
-		case 2:
-		  /* A A B */
-		  to_next -= 1;
-		  n_left_to_next += 1;
-		  vlib_set_next_frame_buffer (vm, node, next1, pi1);
-		  break;
-
-		case 3:
-		  /* A B C */
-		  to_next -= 2;
-		  n_left_to_next += 2;
-		  vlib_set_next_frame_buffer (vm, node, next0, pi0);
-		  vlib_set_next_frame_buffer (vm, node, next1, pi1);
-		  if (next0 == next1)
-		    {
-		      /* A B B */
-		      vlib_put_next_frame (vm, node, next, n_left_to_next);
-		      next = next1;
-		      vlib_get_next_frame (vm, node, next, to_next,
-					   n_left_to_next);
-		    }
-		}
-	    }
+	  vlib_validate_buffer_enqueue_x4 (vm, node, next,
+					   to_next, n_left_to_next,
+					   pi0, pi1, pi2, pi3,
+					   next0, next1, next2, next3);
 	}
 
       while (n_left_from > 0 && n_left_to_next > 0)
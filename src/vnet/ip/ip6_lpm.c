@@ -0,0 +1,642 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * ip/ip6_lpm.c: ip6 longest prefix match by binary search on prefix lengths
+ */
+
+#include <vnet/ip/ip.h>
+#include <vnet/ip/ip6_lpm.h>
+
+/**
+ * A node of the control plane's trie. The trie is path compressed; a
+ * node is a route, a marker, or the glue that joins two that differ
+ * below it. Those that are routes or markers are in the bihash.
+ */
+typedef struct ip6_lpm_node_t_
+{
+  /**
+   * The prefix, masked to its length
+   */
+  ip6_address_t addr;
+
+  /**
+   * The children, by the value of the bit that follows the prefix
+   */
+  u32 child[2];
+  u32 parent;
+
+  /**
+   * The LB index of the route
+   */
+  u32 lbi;
+
+  /**
+   * The number of routes that leave a marker here
+   */
+  u32 n_markers;
+
+  u8 len;
+  u8 flags;
+} ip6_lpm_node_t;
+
+#define IP6_LPM_NODE_NONE (~0)
+
+/**
+ * The node is a route, not just a marker or glue
+ */
+#define IP6_LPM_NODE_FLAG_ROUTE (1 << 0)
+/**
+ * The node is in the forwarding table
+ */
+#define IP6_LPM_NODE_FLAG_FWDING (1 << 1)
+
+/**
+ * The value of a marker that no route covers; as the drop LB the lookup
+ * of an address that matches nothing returns.
+ */
+#define IP6_LPM_NO_ROUTE 0
+
+/**
+ * The lengths at which a route leaves markers number at most log2(129)+1
+ */
+#define IP6_LPM_MAX_MARKERS 8
+
+/**
+ * A global pool of the trie nodes of all FIBs. The data-plane never
+ * reads it.
+ */
+static ip6_lpm_node_t *ip6_lpm_node_pool;
+
+always_inline ip6_lpm_node_t *
+ip6_lpm_node_get (u32 index)
+{
+  return (pool_elt_at_index (ip6_lpm_node_pool, index));
+}
+
+always_inline u32
+ip6_lpm_addr_bit (const ip6_address_t * a, u32 bit)
+{
+  return ((a->as_u8[bit >> 3] >> (7 - (bit & 7))) & 1);
+}
+
+/**
+ * The number of leading bits two addresses have in common
+ */
+static u32
+ip6_lpm_common_len (const ip6_address_t * a, const ip6_address_t * b)
+{
+  uword x, n;
+
+  x = clib_net_to_host_u64 (a->as_u64[0] ^ b->as_u64[0]);
+  if (x)
+    {
+      count_leading_zeros (n, x);
+      return (n);
+    }
+  x = clib_net_to_host_u64 (a->as_u64[1] ^ b->as_u64[1]);
+  if (x)
+    {
+      count_leading_zeros (n, x);
+      return (64 + n);
+    }
+  return (128);
+}
+
+static u32
+ip6_lpm_node_alloc (const ip6_address_t * addr, u32 len)
+{
+  ip6_lpm_node_t *n;
+
+  pool_get (ip6_lpm_node_pool, n);
+  memset (n, 0, sizeof (*n));
+
+  n->addr.as_u64[0] = addr->as_u64[0] & ip6_main.fib_masks[len].as_u64[0];
+  n->addr.as_u64[1] = addr->as_u64[1] & ip6_main.fib_masks[len].as_u64[1];
+  n->len = len;
+  n->parent = n->child[0] = n->child[1] = IP6_LPM_NODE_NONE;
+
+  return (n - ip6_lpm_node_pool);
+}
+
+static void
+ip6_lpm_node_link (u32 parent, u32 child)
+{
+  ip6_lpm_node_t *p, *c;
+
+  p = ip6_lpm_node_get (parent);
+  c = ip6_lpm_node_get (child);
+
+  ASSERT (c->len > p->len);
+  p->child[ip6_lpm_addr_bit (&c->addr, p->len)] = child;
+  c->parent = parent;
+}
+
+static u32
+ip6_lpm_node_find (const ip6_lpm_t * lpm,
+		   const ip6_address_t * addr, u32 len)
+{
+  ip6_lpm_node_t *n;
+  u32 ni;
+
+  ni = lpm->root;
+
+  while (IP6_LPM_NODE_NONE != ni)
+    {
+      n = ip6_lpm_node_get (ni);
+
+      if (n->len > len || ip6_lpm_common_len (addr, &n->addr) < n->len)
+	return (IP6_LPM_NODE_NONE);
+      if (n->len == len)
+	return (ni);
+
+      ni = n->child[ip6_lpm_addr_bit (addr, n->len)];
+    }
+  return (IP6_LPM_NODE_NONE);
+}
+
+static u32
+ip6_lpm_node_find_or_add (const ip6_lpm_t * lpm,
+			  const ip6_address_t * addr, u32 len)
+{
+  u32 ni, ci, new, glue, cpl;
+  ip6_lpm_node_t *n, *c;
+
+  ni = lpm->root;
+
+  while (1)
+    {
+      n = ip6_lpm_node_get (ni);
+
+      if (n->len == len)
+	return (ni);
+
+      ci = n->child[ip6_lpm_addr_bit (addr, n->len)];
+
+      if (IP6_LPM_NODE_NONE == ci)
+	{
+	  new = ip6_lpm_node_alloc (addr, len);
+	  ip6_lpm_node_link (ni, new);
+	  return (new);
+	}
+
+      c = ip6_lpm_node_get (ci);
+      cpl = clib_min (ip6_lpm_common_len (addr, &c->addr),
+		      clib_min (len, c->len));
+
+      if (cpl == c->len)
+	{
+	  /* the child covers the prefix; descend */
+	  ni = ci;
+	  continue;
+	}
+
+      new = ip6_lpm_node_alloc (addr, len);
+
+      if (cpl == len)
+	{
+	  /* the prefix covers the child; insert between */
+	  ip6_lpm_node_link (ni, new);
+	  ip6_lpm_node_link (new, ci);
+	}
+      else
+	{
+	  /* they diverge below the node; join them with glue */
+	  glue = ip6_lpm_node_alloc (addr, cpl);
+	  ip6_lpm_node_link (ni, glue);
+	  ip6_lpm_node_link (glue, new);
+	  ip6_lpm_node_link (glue, ci);
+	}
+      return (new);
+    }
+}
+
+/**
+ * Remove the node, and then its parent, should they be neither a route
+ * nor a marker nor the glue of two children.
+ */
+static void
+ip6_lpm_node_try_free (const ip6_lpm_t * lpm, u32 ni)
+{
+  ip6_lpm_node_t *n, *p;
+  u32 pi, ci;
+
+  while (ni != lpm->root)
+    {
+      n = ip6_lpm_node_get (ni);
+
+      if (n->flags || n->n_markers ||
+	  (IP6_LPM_NODE_NONE != n->child[0] &&
+	   IP6_LPM_NODE_NONE != n->child[1]))
+	return;
+
+      pi = n->parent;
+      ci = (IP6_LPM_NODE_NONE != n->child[0] ? n->child[0] : n->child[1]);
+      p = ip6_lpm_node_get (pi);
+
+      p->child[ip6_lpm_addr_bit (&n->addr, p->len)] = ci;
+      if (IP6_LPM_NODE_NONE != ci)
+	ip6_lpm_node_get (ci)->parent = pi;
+
+      pool_put (ip6_lpm_node_pool, n);
+      ni = pi;
+    }
+}
+
+/**
+ * The LB index of the best matching route no longer than the node
+ */
+static u32
+ip6_lpm_node_bmp (const ip6_lpm_node_t * n)
+{
+  while (1)
+    {
+      if (n->flags & IP6_LPM_NODE_FLAG_ROUTE)
+	return (n->lbi);
+      if (IP6_LPM_NODE_NONE == n->parent)
+	return (IP6_LPM_NO_ROUTE);
+      n = ip6_lpm_node_get (n->parent);
+    }
+}
+
+/**
+ * Bring the node's entry in the forwarding table up to date
+ */
+static void
+ip6_lpm_node_sync (const ip6_lpm_t * lpm, u32 ni)
+{
+  BVT (clib_bihash_kv) kv;
+  ip6_lpm_node_t *n;
+
+  n = ip6_lpm_node_get (ni);
+
+  kv.key[0] = n->addr.as_u64[0];
+  kv.key[1] = n->addr.as_u64[1];
+  kv.key[2] = ((u64) lpm->fib_index << 32) | n->len;
+
+  if ((n->flags & IP6_LPM_NODE_FLAG_ROUTE) || n->n_markers)
+    {
+      kv.value = ip6_lpm_node_bmp (n);
+      BV (clib_bihash_add_del)
+	(&ip6_main.ip6_table[IP6_FIB_TABLE_FWDING].ip6_hash, &kv, 1);
+      n->flags |= IP6_LPM_NODE_FLAG_FWDING;
+    }
+  else if (n->flags & IP6_LPM_NODE_FLAG_FWDING)
+    {
+      BV (clib_bihash_add_del)
+	(&ip6_main.ip6_table[IP6_FIB_TABLE_FWDING].ip6_hash, &kv, 0);
+      n->flags &= ~IP6_LPM_NODE_FLAG_FWDING;
+    }
+}
+
+/**
+ * Sync the markers below the node whose best match is it, or its cover;
+ * those below a more specific route are its concern.
+ */
+static void
+ip6_lpm_node_sync_covered (const ip6_lpm_t * lpm, u32 ni)
+{
+  ip6_lpm_node_t *c;
+  u32 ii, ci;
+
+  for (ii = 0; ii < 2; ii++)
+    {
+      ci = ip6_lpm_node_get (ni)->child[ii];
+
+      if (IP6_LPM_NODE_NONE == ci)
+	continue;
+
+      c = ip6_lpm_node_get (ci);
+
+      if (c->flags & IP6_LPM_NODE_FLAG_ROUTE)
+	continue;
+
+      ip6_lpm_node_sync (lpm, ci);
+      ip6_lpm_node_sync_covered (lpm, ci);
+    }
+}
+
+/**
+ * The lengths at which a route leaves markers; those of the binary
+ * search's path, for the route's length, that the search goes right at.
+ */
+static u32
+ip6_lpm_marker_lengths (const u8 * lengths, u32 len, u8 * markers)
+{
+  i32 lo, hi, mid;
+  u32 n_markers;
+
+  n_markers = 0;
+  lo = 0;
+  hi = vec_len (lengths) - 1;
+
+  while (lo <= hi)
+    {
+      mid = (lo + hi) >> 1;
+
+      if (lengths[mid] == len)
+	break;
+      if (lengths[mid] < len)
+	{
+	  ASSERT (n_markers < IP6_LPM_MAX_MARKERS);
+	  markers[n_markers++] = lengths[mid];
+	  lo = mid + 1;
+	}
+      else
+	hi = mid - 1;
+    }
+
+  return (n_markers);
+}
+
+static void
+ip6_lpm_route_markers (const ip6_lpm_t * lpm,
+		       const u8 * lengths,
+		       const ip6_address_t * addr, u32 len, int is_add)
+{
+  u8 markers[IP6_LPM_MAX_MARKERS];
+  u32 ii, n_markers, mi;
+  ip6_lpm_node_t *m;
+
+  n_markers = ip6_lpm_marker_lengths (lengths, len, markers);
+
+  for (ii = 0; ii < n_markers; ii++)
+    {
+      if (is_add)
+	{
+	  mi = ip6_lpm_node_find_or_add (lpm, addr, markers[ii]);
+	  m = ip6_lpm_node_get (mi);
+	  m->n_markers++;
+	  ip6_lpm_node_sync (lpm, mi);
+	}
+      else
+	{
+	  mi = ip6_lpm_node_find (lpm, addr, markers[ii]);
+	  m = ip6_lpm_node_get (mi);
+	  ASSERT (m->n_markers > 0);
+	  m->n_markers--;
+	  ip6_lpm_node_sync (lpm, mi);
+	  ip6_lpm_node_try_free (lpm, mi);
+	}
+    }
+}
+
+static void
+ip6_lpm_nodes (u32 ni, u32 ** nis)
+{
+  ip6_lpm_node_t *n;
+
+  n = ip6_lpm_node_get (ni);
+  vec_add1 (*nis, ni);
+
+  if (IP6_LPM_NODE_NONE != n->child[0])
+    ip6_lpm_nodes (n->child[0], nis);
+  if (IP6_LPM_NODE_NONE != n->child[1])
+    ip6_lpm_nodes (n->child[1], nis);
+}
+
+/**
+ * The set of lengths has changed, so has the search and with it where
+ * every route leaves its markers. This is as rare as a route of a length
+ * that the FIB has no other.
+ */
+static void
+ip6_lpm_rebuild (ip6_lpm_t * lpm)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  u32 len, *nis, *ni;
+  ip6_lpm_node_t *n;
+  ip6_address_t addr;
+  u8 *lengths;
+
+  lengths = NULL;
+  nis = NULL;
+
+  for (len = 0; len < ARRAY_LEN (lpm->length_refcounts); len++)
+    {
+      if (lpm->length_refcounts[len])
+	vec_add1 (lengths, len);
+    }
+
+  /*
+   * the workers must not search the new lengths over the old markers,
+   * nor the old over the new
+   */
+  vlib_worker_thread_barrier_sync (vm);
+
+  ip6_lpm_nodes (lpm->root, &nis);
+
+  vec_foreach (ni, nis)
+  {
+    ip6_lpm_node_get (*ni)->n_markers = 0;
+  }
+  vec_foreach (ni, nis)
+  {
+    n = ip6_lpm_node_get (*ni);
+
+    if (n->flags & IP6_LPM_NODE_FLAG_ROUTE)
+      {
+	addr = n->addr;
+	ip6_lpm_route_markers (lpm, lengths, &addr, n->len, 1);
+      }
+  }
+
+  vec_reset_length (nis);
+  ip6_lpm_nodes (lpm->root, &nis);
+
+  vec_foreach (ni, nis)
+  {
+    ip6_lpm_node_sync (lpm, *ni);
+  }
+  vec_foreach (ni, nis)
+  {
+    if (!pool_is_free_index (ip6_lpm_node_pool, *ni))
+      ip6_lpm_node_try_free (lpm, *ni);
+  }
+
+  vec_free (lpm->lengths);
+  lpm->lengths = lengths;
+
+  vlib_worker_thread_barrier_release (vm);
+
+  vec_free (nis);
+}
+
+void
+ip6_lpm_route_add (ip6_lpm_t * lpm,
+		   const ip6_address_t * dst_address,
+		   u32 dst_address_length, u32 lbi)
+{
+  ip6_lpm_node_t *n;
+  ip6_address_t addr;
+  u32 ni;
+
+  ni = ip6_lpm_node_find_or_add (lpm, dst_address, dst_address_length);
+  n = ip6_lpm_node_get (ni);
+
+  if (!(n->flags & IP6_LPM_NODE_FLAG_ROUTE))
+    {
+      n->flags |= IP6_LPM_NODE_FLAG_ROUTE;
+      n->lbi = lbi;
+
+      if (0 == lpm->length_refcounts[dst_address_length]++)
+	{
+	  ip6_lpm_rebuild (lpm);
+	  return;
+	}
+
+      /* the markers first, so the route is not found before its path */
+      addr = n->addr;
+      ip6_lpm_route_markers (lpm, lpm->lengths, &addr, dst_address_length,
+			     1);
+    }
+  else
+    {
+      /* an update; the markers are where they were */
+      n->lbi = lbi;
+    }
+
+  ip6_lpm_node_sync (lpm, ni);
+  ip6_lpm_node_sync_covered (lpm, ni);
+}
+
+void
+ip6_lpm_route_del (ip6_lpm_t * lpm,
+		   const ip6_address_t * dst_address,
+		   u32 dst_address_length)
+{
+  ip6_lpm_node_t *n;
+  ip6_address_t addr;
+  u32 ni;
+
+  ni = ip6_lpm_node_find (lpm, dst_address, dst_address_length);
+
+  if (IP6_LPM_NODE_NONE == ni)
+    return;
+
+  n = ip6_lpm_node_get (ni);
+
+  if (!(n->flags & IP6_LPM_NODE_FLAG_ROUTE))
+    return;
+
+  n->flags &= ~IP6_LPM_NODE_FLAG_ROUTE;
+  n->lbi = IP6_LPM_NO_ROUTE;
+
+  ASSERT (lpm->length_refcounts[dst_address_length] > 0);
+  if (0 == --lpm->length_refcounts[dst_address_length])
+    {
+      ip6_lpm_rebuild (lpm);
+      return;
+    }
+
+  /* the route goes, or becomes a marker to its cover, before its path */
+  addr = n->addr;
+  ip6_lpm_node_sync (lpm, ni);
+  ip6_lpm_node_sync_covered (lpm, ni);
+  ip6_lpm_route_markers (lpm, lpm->lengths, &addr, dst_address_length, 0);
+  ip6_lpm_node_try_free (lpm, ni);
+}
+
+void
+ip6_lpm_init (ip6_lpm_t * lpm, u32 fib_index)
+{
+  ip6_address_t zero = { };
+
+  memset (lpm, 0, sizeof (*lpm));
+  lpm->fib_index = fib_index;
+  lpm->root = ip6_lpm_node_alloc (&zero, 0);
+}
+
+void
+ip6_lpm_free (ip6_lpm_t * lpm)
+{
+  ip6_lpm_node_t *root;
+
+  /* the FIB removes all its routes before it is deleted */
+  root = ip6_lpm_node_get (lpm->root);
+  ASSERT (0 == root->flags);
+  ASSERT (IP6_LPM_NODE_NONE == root->child[0]);
+  ASSERT (IP6_LPM_NODE_NONE == root->child[1]);
+  ASSERT (0 == vec_len (lpm->lengths));
+
+  pool_put (ip6_lpm_node_pool, root);
+  vec_free (lpm->lengths);
+  lpm->root = IP6_LPM_NODE_NONE;
+}
+
+typedef struct ip6_lpm_counts_t_
+{
+  u32 n_nodes;
+  u32 n_routes;
+  u32 n_markers;
+} ip6_lpm_counts_t;
+
+static void
+ip6_lpm_count (u32 ni, ip6_lpm_counts_t * counts)
+{
+  ip6_lpm_node_t *n;
+
+  n = ip6_lpm_node_get (ni);
+
+  counts->n_nodes++;
+  if (n->flags & IP6_LPM_NODE_FLAG_ROUTE)
+    counts->n_routes++;
+  else if (n->n_markers)
+    counts->n_markers++;
+
+  if (IP6_LPM_NODE_NONE != n->child[0])
+    ip6_lpm_count (n->child[0], counts);
+  if (IP6_LPM_NODE_NONE != n->child[1])
+    ip6_lpm_count (n->child[1], counts);
+}
+
+uword
+ip6_lpm_memory_usage (const ip6_lpm_t * lpm)
+{
+  ip6_lpm_counts_t counts = { };
+
+  ip6_lpm_count (lpm->root, &counts);
+
+  return (counts.n_nodes * sizeof (ip6_lpm_node_t) + vec_bytes (lpm->lengths));
+}
+
+u8 *
+format_ip6_lpm (u8 * s, va_list * va)
+{
+  const ip6_lpm_t *lpm = va_arg (*va, ip6_lpm_t *);
+  ip6_lpm_counts_t counts = { };
+  u32 ii, indent;
+
+  indent = format_get_indent (s);
+  ip6_lpm_count (lpm->root, &counts);
+
+  s = format (s, "%d routes, %d markers, %d nodes, %U",
+	      counts.n_routes, counts.n_markers, counts.n_nodes,
+	      format_memory_size, ip6_lpm_memory_usage (lpm));
+  s = format (s, "\n%Ulengths:", format_white_space, indent);
+  vec_foreach_index (ii, lpm->lengths)
+  {
+    s = format (s, " %d", lpm->lengths[ii]);
+  }
+
+  return (s);
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
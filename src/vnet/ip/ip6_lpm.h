@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * ip/ip6_lpm.h: ip6 longest prefix match by binary search on prefix lengths
+ *
+ * The forwarding table is the same bihash, keyed on {prefix, fib, length},
+ * that it has always been. Rather than probing it once per prefix length
+ * present, longest first, a lookup binary searches the FIB's sorted set of
+ * lengths; log2(n) probes for n lengths (Waldvogel et al.).
+ * For a search that hits at length m to be right to look only at longer
+ * lengths, each route leaves a 'marker' at those lengths of the search
+ * path it goes right at; a marker is keyed as a route is and its value is
+ * the LB of the best matching route no longer than it, so a search that
+ * finds nothing longer ends with the right answer.
+ * The markers are derived from a binary trie of the routes that only the
+ * control plane reads.
+ */
+
+#ifndef included_ip_ip6_lpm_h
+#define included_ip_ip6_lpm_h
+
+#include <vnet/ip/ip6_packet.h>
+
+/**
+ * @brief The binary search of one FIB.
+ */
+typedef struct ip6_lpm_t_
+{
+  /**
+   * The distinct prefix lengths of the FIB's routes, ascending.
+   * This is all the data-plane reads, bar the bihash.
+   */
+  u8 *lengths;
+
+  /**
+   * The index of the FIB, i.e. its part of the bihash key
+   */
+  u32 fib_index;
+
+  /**
+   * The root, ::/0, node of the trie
+   */
+  u32 root;
+
+  /**
+   * The number of routes at each length
+   */
+  u32 length_refcounts[129];
+} ip6_lpm_t;
+
+/**
+ * @brief Initialise the lookup of the given FIB.
+ */
+void ip6_lpm_init (ip6_lpm_t * lpm, u32 fib_index);
+
+/**
+ * @brief Free the lookup. It must be empty when free'd
+ */
+void ip6_lpm_free (ip6_lpm_t * lpm);
+
+/**
+ * @brief Add a route, or update the LB index of one present.
+ */
+void ip6_lpm_route_add (ip6_lpm_t * lpm,
+			const ip6_address_t * dst_address,
+			u32 dst_address_length, u32 lbi);
+
+/**
+ * @brief Remove a route
+ */
+void ip6_lpm_route_del (ip6_lpm_t * lpm,
+			const ip6_address_t * dst_address,
+			u32 dst_address_length);
+
+/**
+ * @brief return the memory used by the control plane trie
+ */
+uword ip6_lpm_memory_usage (const ip6_lpm_t * lpm);
+
+/**
+ * @brief Format the search and the trie's markers
+ */
+format_function_t format_ip6_lpm;
+
+#endif /* included_ip_ip6_lpm_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
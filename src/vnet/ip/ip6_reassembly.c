@@ -24,12 +24,14 @@
 #include <vnet/vnet.h>
 #include <vnet/ip/ip.h>
 #include <vppinfra/bihash_48_8.h>
+#include <vppinfra/xxhash.h>
 #include <vnet/ip/ip6_reassembly.h>
 
 #define MSEC_PER_SEC 1000
 #define IP6_REASS_TIMEOUT_DEFAULT_MS 100
 #define IP6_REASS_EXPIRE_WALK_INTERVAL_DEFAULT_MS 10000	// 10 seconds default
 #define IP6_REASS_MAX_REASSEMBLIES_DEAFULT 1024
+#define IP6_REASS_MAX_REASSEMBLY_LENGTH_DEFAULT 128
 #define IP6_REASS_HT_LOAD_FACTOR (0.75)
 
 static vlib_node_registration_t ip6_reass_node;
@@ -103,8 +105,32 @@ typedef struct
   u32 data_len;
   // trace operation counter
   u32 trace_op_counter;
+  // number of fragments in this reassembly
+  u32 fragments_n;
 } ip6_reass_t;
 
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  ip6_reass_t *pool;
+  clib_bihash_48_8_t hash;
+  u32 reass_n;
+  u32 id_counter;
+  u32 buffers_n;
+
+  // held by the owner thread and by the expire walk on the main thread
+  clib_spinlock_t lock;
+
+  // indexes of buffers to drop, and why
+  u32 *vec_timeout;
+  u32 *vec_drop_overlap;
+  u32 *vec_drop_compress;
+  u32 *vec_drop_too_long;
+
+  // counters
+  u64 reassembled_n;
+} ip6_reass_per_thread_t;
+
 typedef struct
 {
   // IPv6 config
@@ -112,13 +138,18 @@ typedef struct
   f64 timeout;
   u32 expire_walk_interval_ms;
   u32 max_reass_n;
+  u32 max_reass_len;
+
+  // max_reass_n split over the tables of the threads owning reassemblies
+  u32 max_reass_per_thread_n;
 
   // IPv6 runtime
-  ip6_reass_t *pool;
-  clib_bihash_48_8_t hash;
-  u32 reass_n;
-  u32 id_counter;
-  u32 buffers_n;
+  ip6_reass_per_thread_t *per_thread_data;
+
+  // fragments are handed off to the worker owning their reassembly
+  u32 first_worker_index;
+  u32 num_workers;
+  u32 fq_index;
 
   // convenience
   vlib_main_t *vlib_main;
@@ -138,6 +169,7 @@ typedef enum
   IP6_REASSEMBLY_NEXT_INPUT,
   IP6_REASSEMBLY_NEXT_DROP,
   IP6_REASSEMBLY_NEXT_ICMP_ERROR,
+  IP6_REASSEMBLY_NEXT_HANDOFF,
   IP6_REASSEMBLY_N_NEXT,
 } ip6_reass_next_t;
 
@@ -241,14 +273,14 @@ format_ip6_reass_trace (u8 * s, va_list * args)
 
 static void
 ip6_reass_add_trace (vlib_main_t * vm, vlib_node_runtime_t * node,
-		     ip6_reass_main_t * rm, ip6_reass_t * reass,
+		     ip6_reass_per_thread_t * rt, ip6_reass_t * reass,
 		     u32 bi, ip6_reass_trace_operation_e action,
 		     u32 size_diff)
 {
   vlib_buffer_t *b = vlib_get_buffer (vm, bi);
   vnet_buffer_opaque_t *vnb = vnet_buffer (b);
   ip6_reass_trace_t *t = vlib_add_trace (vm, node, b, sizeof (t[0]));
-  t->pool_index = reass - rm->pool;
+  t->pool_index = reass - rt->pool;
   t->reass_id = reass->id;
   t->action = action;
   ip6_reass_trace_details (vm, bi, &t->trace_range);
@@ -269,7 +301,7 @@ ip6_reass_add_trace (vlib_main_t * vm, vlib_node_runtime_t * node,
 }
 
 static void
-ip6_reass_free (ip6_reass_main_t * rm, ip6_reass_t * reass)
+ip6_reass_free (ip6_reass_per_thread_t * rt, ip6_reass_t * reass)
 {
   clib_bihash_kv_48_8_t kv;
   kv.key[0] = reass->key.as_u64[0];
@@ -278,13 +310,13 @@ ip6_reass_free (ip6_reass_main_t * rm, ip6_reass_t * reass)
   kv.key[3] = reass->key.as_u64[3];
   kv.key[4] = reass->key.as_u64[4];
   kv.key[5] = reass->key.as_u64[5];
-  clib_bihash_add_del_48_8 (&rm->hash, &kv, 0);
-  pool_put (rm->pool, reass);
-  --rm->reass_n;
+  clib_bihash_add_del_48_8 (&rt->hash, &kv, 0);
+  pool_put (rt->pool, reass);
+  --rt->reass_n;
 }
 
 static void
-ip6_reass_drop_all (vlib_main_t * vm, ip6_reass_main_t * rm,
+ip6_reass_drop_all (vlib_main_t * vm, ip6_reass_per_thread_t * rt,
 		    ip6_reass_t * reass, u32 ** vec_drop_bi)
 {
   u32 range_bi = reass->first_bi;
@@ -315,7 +347,7 @@ ip6_reass_drop_all (vlib_main_t * vm, ip6_reass_main_t * rm,
 
 static void
 ip6_reass_on_timeout (vlib_main_t * vm, vlib_node_runtime_t * node,
-		      ip6_reass_main_t * rm, ip6_reass_t * reass,
+		      ip6_reass_per_thread_t * rt, ip6_reass_t * reass,
 		      u32 * icmp_bi, u32 ** vec_timeout)
 {
   if (~0 == reass->first_bi)
@@ -328,7 +360,7 @@ ip6_reass_on_timeout (vlib_main_t * vm, vlib_node_runtime_t * node,
       *icmp_bi = reass->first_bi;
       if (PREDICT_FALSE (b->flags & VLIB_BUFFER_IS_TRACED))
 	{
-	  ip6_reass_add_trace (vm, node, rm, reass, reass->first_bi,
+	  ip6_reass_add_trace (vm, node, rt, reass, reass->first_bi,
 			       ICMP_ERROR_RT_EXCEEDED, 0);
 	}
       // fragment with offset zero received - send icmp message back
@@ -346,18 +378,18 @@ ip6_reass_on_timeout (vlib_main_t * vm, vlib_node_runtime_t * node,
 				   ICMP6_time_exceeded_fragment_reassembly_time_exceeded,
 				   0);
     }
-  ip6_reass_drop_all (vm, rm, reass, vec_timeout);
+  ip6_reass_drop_all (vm, rt, reass, vec_timeout);
 }
 
 static ip6_reass_t *
 ip6_reass_find_or_create (vlib_main_t * vm,
 			  vlib_node_runtime_t * node,
-			  ip6_reass_main_t * rm,
+			  ip6_reass_main_t * rm, ip6_reass_per_thread_t * rt,
 			  ip6_reass_key_t * k, u32 * icmp_bi,
 			  u32 ** vec_timeout)
 {
   ip6_reass_t *reass = NULL;
-  f64 now = vlib_time_now (rm->vlib_main);
+  f64 now = vlib_time_now (vm);
   clib_bihash_kv_48_8_t kv, value;
   kv.key[0] = k->as_u64[0];
   kv.key[1] = k->as_u64[1];
@@ -366,13 +398,13 @@ ip6_reass_find_or_create (vlib_main_t * vm,
   kv.key[4] = k->as_u64[4];
   kv.key[5] = k->as_u64[5];
 
-  if (!clib_bihash_search_48_8 (&rm->hash, &kv, &value))
+  if (!clib_bihash_search_48_8 (&rt->hash, &kv, &value))
     {
-      reass = pool_elt_at_index (rm->pool, value.value);
+      reass = pool_elt_at_index (rt->pool, value.value);
       if (now > reass->last_heard + rm->timeout)
 	{
-	  ip6_reass_on_timeout (vm, node, rm, reass, icmp_bi, vec_timeout);
-	  ip6_reass_free (rm, reass);
+	  ip6_reass_on_timeout (vm, node, rt, reass, icmp_bi, vec_timeout);
+	  ip6_reass_free (rt, reass);
 	  reass = NULL;
 	}
     }
@@ -383,21 +415,22 @@ ip6_reass_find_or_create (vlib_main_t * vm,
       return reass;
     }
 
-  if (rm->reass_n >= rm->max_reass_n)
+  if (rt->reass_n >= rm->max_reass_per_thread_n)
     {
       reass = NULL;
       return reass;
     }
   else
     {
-      pool_get (rm->pool, reass);
+      pool_get (rt->pool, reass);
       memset (reass, 0, sizeof (*reass));
-      reass->id = rm->id_counter;
-      ++rm->id_counter;
+      reass->id = rt->id_counter;
+      ++rt->id_counter;
       reass->first_bi = ~0;
       reass->last_packet_octet = ~0;
       reass->data_len = 0;
-      ++rm->reass_n;
+      reass->fragments_n = 0;
+      ++rt->reass_n;
     }
 
   reass->key.as_u64[0] = kv.key[0] = k->as_u64[0];
@@ -406,12 +439,12 @@ ip6_reass_find_or_create (vlib_main_t * vm,
   reass->key.as_u64[3] = kv.key[3] = k->as_u64[3];
   reass->key.as_u64[4] = kv.key[4] = k->as_u64[4];
   reass->key.as_u64[5] = kv.key[5] = k->as_u64[5];
-  kv.value = reass - rm->pool;
+  kv.value = reass - rt->pool;
   reass->last_heard = now;
 
-  if (clib_bihash_add_del_48_8 (&rm->hash, &kv, 1))
+  if (clib_bihash_add_del_48_8 (&rt->hash, &kv, 1))
     {
-      ip6_reass_free (rm, reass);
+      ip6_reass_free (rt, reass);
       reass = NULL;
     }
 
@@ -420,9 +453,9 @@ ip6_reass_find_or_create (vlib_main_t * vm,
 
 void
 ip6_reass_finalize (vlib_main_t * vm, vlib_node_runtime_t * node,
-		    ip6_reass_main_t * rm, ip6_reass_t * reass, u32 * bi0,
-		    u32 * next0, vlib_error_t * error0, u32 next_input,
-		    u32 ** vec_drop_compress)
+		    ip6_reass_per_thread_t * rt, ip6_reass_t * reass,
+		    u32 * bi0, u32 * next0, vlib_error_t * error0,
+		    u32 next_input, u32 ** vec_drop_compress)
 {
   ASSERT (~0 != reass->first_bi);
   *bi0 = reass->first_bi;
@@ -548,11 +581,12 @@ ip6_reass_finalize (vlib_main_t * vm, vlib_node_runtime_t * node,
   ip->payload_length =
     clib_host_to_net_u16 (total_length + first_b->current_length -
 			  sizeof (*ip));
-  ip6_reass_free (rm, reass);
+  ++rt->reassembled_n;
+  ip6_reass_free (rt, reass);
   vlib_buffer_chain_compress (vm, first_b, vec_drop_compress);
   if (PREDICT_FALSE (first_b->flags & VLIB_BUFFER_IS_TRACED))
     {
-      ip6_reass_add_trace (vm, node, rm, reass, reass->first_bi, FINALIZE, 0);
+      ip6_reass_add_trace (vm, node, rt, reass, reass->first_bi, FINALIZE, 0);
 #if 0
       // following code does a hexdump of packet fragments to stdout ...
       do
@@ -604,7 +638,7 @@ ip6_reass_get_buffer_chain_length (vlib_main_t * vm, vlib_buffer_t * b)
 
 static void
 ip6_reass_insert_range_in_chain (vlib_main_t * vm,
-				 ip6_reass_main_t * rm,
+				 ip6_reass_per_thread_t * rt,
 				 ip6_reass_t * reass,
 				 u32 prev_range_bi, u32 new_next_bi)
 {
@@ -627,12 +661,12 @@ ip6_reass_insert_range_in_chain (vlib_main_t * vm,
       reass->first_bi = new_next_bi;
     }
   reass->data_len += ip6_reass_buffer_get_data_len (new_next_b);
-  rm->buffers_n += ip6_reass_get_buffer_chain_length (vm, new_next_b);
+  rt->buffers_n += ip6_reass_get_buffer_chain_length (vm, new_next_b);
 }
 
 void
 ip6_reass_update (vlib_main_t * vm, vlib_node_runtime_t * node,
-		  ip6_reass_main_t * rm, ip6_reass_t * reass, u32 * bi0,
+		  ip6_reass_per_thread_t * rt, ip6_reass_t * reass, u32 * bi0,
 		  u32 * next0, vlib_error_t * error0,
 		  ip6_frag_hdr_t * frag_hdr, u32 ** vec_drop_overlap,
 		  u32 ** vec_drop_compress, u32 next_input, u32 next_drop,
@@ -664,7 +698,7 @@ ip6_reass_update (vlib_main_t * vm, vlib_node_runtime_t * node,
     {
       if (PREDICT_FALSE (fb->flags & VLIB_BUFFER_IS_TRACED))
 	{
-	  ip6_reass_add_trace (vm, node, rm, reass, *bi0,
+	  ip6_reass_add_trace (vm, node, rt, reass, *bi0,
 			       ICMP_ERROR_FL_NOT_MULT_8, 0);
 	}
       *next0 = next_icmp_error;
@@ -677,7 +711,7 @@ ip6_reass_update (vlib_main_t * vm, vlib_node_runtime_t * node,
     {
       if (PREDICT_FALSE (fb->flags & VLIB_BUFFER_IS_TRACED))
 	{
-	  ip6_reass_add_trace (vm, node, rm, reass, *bi0,
+	  ip6_reass_add_trace (vm, node, rt, reass, *bi0,
 			       ICMP_ERROR_FL_TOO_BIG, 0);
 	}
       *next0 = next_icmp_error;
@@ -695,10 +729,10 @@ ip6_reass_update (vlib_main_t * vm, vlib_node_runtime_t * node,
   if (~0 == reass->first_bi)
     {
       // starting a new reassembly
-      ip6_reass_insert_range_in_chain (vm, rm, reass, prev_range_bi, *bi0);
+      ip6_reass_insert_range_in_chain (vm, rt, reass, prev_range_bi, *bi0);
       if (PREDICT_FALSE (fb->flags & VLIB_BUFFER_IS_TRACED))
 	{
-	  ip6_reass_add_trace (vm, node, rm, reass, *bi0, RANGE_NEW, 0);
+	  ip6_reass_add_trace (vm, node, rt, reass, *bi0, RANGE_NEW, 0);
 	}
       *bi0 = ~0;
       return;
@@ -719,7 +753,7 @@ ip6_reass_update (vlib_main_t * vm, vlib_node_runtime_t * node,
 	      ~0 == candidate_range_bi)
 	    {
 	      // special case - this fragment falls beyond all known ranges
-	      ip6_reass_insert_range_in_chain (vm, rm, reass, prev_range_bi,
+	      ip6_reass_insert_range_in_chain (vm, rt, reass, prev_range_bi,
 					       *bi0);
 	      consumed = 1;
 	      break;
@@ -729,7 +763,7 @@ ip6_reass_update (vlib_main_t * vm, vlib_node_runtime_t * node,
       if (fragment_last < candidate_vnb->ip.reass.range_first)
 	{
 	  // this fragment ends before candidate range without any overlap
-	  ip6_reass_insert_range_in_chain (vm, rm, reass, prev_range_bi,
+	  ip6_reass_insert_range_in_chain (vm, rt, reass, prev_range_bi,
 					   *bi0);
 	  consumed = 1;
 	}
@@ -741,11 +775,11 @@ ip6_reass_update (vlib_main_t * vm, vlib_node_runtime_t * node,
       else
 	{
 	  // overlapping fragment - not allowed by RFC 8200
-	  ip6_reass_drop_all (vm, rm, reass, vec_drop_overlap);
-	  ip6_reass_free (rm, reass);
+	  ip6_reass_drop_all (vm, rt, reass, vec_drop_overlap);
+	  ip6_reass_free (rt, reass);
 	  if (PREDICT_FALSE (fb->flags & VLIB_BUFFER_IS_TRACED))
 	    {
-	      ip6_reass_add_trace (vm, node, rm, reass, *bi0, RANGE_OVERLAP,
+	      ip6_reass_add_trace (vm, node, rt, reass, *bi0, RANGE_OVERLAP,
 				   0);
 	    }
 	  *next0 = next_drop;
@@ -757,13 +791,13 @@ ip6_reass_update (vlib_main_t * vm, vlib_node_runtime_t * node,
     {
       if (PREDICT_FALSE (fb->flags & VLIB_BUFFER_IS_TRACED))
 	{
-	  ip6_reass_add_trace (vm, node, rm, reass, *bi0, RANGE_NEW, 0);
+	  ip6_reass_add_trace (vm, node, rt, reass, *bi0, RANGE_NEW, 0);
 	}
     }
   if (~0 != reass->last_packet_octet &&
       reass->data_len == reass->last_packet_octet + 1)
     {
-      ip6_reass_finalize (vm, node, rm, reass, bi0, next0, error0, next_input,
+      ip6_reass_finalize (vm, node, rt, reass, bi0, next0, error0, next_input,
 			  vec_drop_compress);
     }
   else
@@ -780,6 +814,24 @@ ip6_reass_update (vlib_main_t * vm, vlib_node_runtime_t * node,
     }
 }
 
+always_inline u32
+ip6_reass_owner_thread_index (ip6_reass_main_t * rm, ip6_header_t * ip,
+			      ip6_frag_hdr_t * frag_hdr)
+{
+  u64 hash;
+
+  if (PREDICT_FALSE (0 == rm->num_workers))
+    return 0;
+
+  /* all the fragments of a datagram hash to the same worker */
+  hash = clib_xxhash (ip->src_address.as_u64[0] ^
+		      ip->src_address.as_u64[1] ^
+		      ip->dst_address.as_u64[0] ^
+		      ip->dst_address.as_u64[1] ^
+		      ((u64) frag_hdr->identification << 8 | ip->protocol));
+  return rm->first_worker_index + hash % rm->num_workers;
+}
+
 always_inline uword
 ip6_reassembly (vlib_main_t * vm, vlib_node_runtime_t * node,
 		vlib_frame_t * frame)
@@ -787,20 +839,23 @@ ip6_reassembly (vlib_main_t * vm, vlib_node_runtime_t * node,
   u32 *from = vlib_frame_vector_args (frame);
   u32 n_left_from, n_left_to_next, *to_next, next_index;
   ip6_reass_main_t *rm = &ip6_reass_main;
+  u32 thread_index = vm->thread_index;
+  ip6_reass_per_thread_t *rt = &rm->per_thread_data[thread_index];
+
+  clib_spinlock_lock_if_init (&rt->lock);
 
   n_left_from = frame->n_vectors;
   next_index = node->cached_next_index;
-  static u32 *vec_timeout = NULL;	// indexes of buffers which timed out
-  static u32 *vec_drop_overlap = NULL;	// indexes of buffers dropped due to overlap
-  static u32 *vec_drop_compress = NULL;	// indexes of buffers dropped due to buffer compression
-  while (n_left_from > 0 || vec_len (vec_timeout) > 0 ||
-	 vec_len (vec_drop_overlap) > 0)
+  while (n_left_from > 0 || vec_len (rt->vec_timeout) > 0 ||
+	 vec_len (rt->vec_drop_overlap) > 0 ||
+	 vec_len (rt->vec_drop_compress) > 0 ||
+	 vec_len (rt->vec_drop_too_long) > 0)
     {
       vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
 
-      while (vec_len (vec_timeout) > 0 && n_left_to_next > 0)
+      while (vec_len (rt->vec_timeout) > 0 && n_left_to_next > 0)
 	{
-	  u32 bi = vec_pop (vec_timeout);
+	  u32 bi = vec_pop (rt->vec_timeout);
 	  vlib_buffer_t *b = vlib_get_buffer (vm, bi);
 	  b->error = node->errors[IP6_ERROR_REASS_TIMEOUT];
 	  to_next[0] = bi;
@@ -809,13 +864,13 @@ ip6_reassembly (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index, to_next,
 					   n_left_to_next, bi,
 					   IP6_REASSEMBLY_NEXT_DROP);
-	  ASSERT (rm->buffers_n > 0);
-	  --rm->buffers_n;
+	  ASSERT (rt->buffers_n > 0);
+	  --rt->buffers_n;
 	}
 
-      while (vec_len (vec_drop_overlap) > 0 && n_left_to_next > 0)
+      while (vec_len (rt->vec_drop_overlap) > 0 && n_left_to_next > 0)
 	{
-	  u32 bi = vec_pop (vec_drop_overlap);
+	  u32 bi = vec_pop (rt->vec_drop_overlap);
 	  vlib_buffer_t *b = vlib_get_buffer (vm, bi);
 	  b->error = node->errors[IP6_ERROR_REASS_OVERLAPPING_FRAGMENT];
 	  to_next[0] = bi;
@@ -824,13 +879,13 @@ ip6_reassembly (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index, to_next,
 					   n_left_to_next, bi,
 					   IP6_REASSEMBLY_NEXT_DROP);
-	  ASSERT (rm->buffers_n > 0);
-	  --rm->buffers_n;
+	  ASSERT (rt->buffers_n > 0);
+	  --rt->buffers_n;
 	}
 
-      while (vec_len (vec_drop_compress) > 0 && n_left_to_next > 0)
+      while (vec_len (rt->vec_drop_compress) > 0 && n_left_to_next > 0)
 	{
-	  u32 bi = vec_pop (vec_drop_compress);
+	  u32 bi = vec_pop (rt->vec_drop_compress);
 	  vlib_buffer_t *b = vlib_get_buffer (vm, bi);
 	  b->error = node->errors[IP6_ERROR_NONE];
 	  to_next[0] = bi;
@@ -839,8 +894,23 @@ ip6_reassembly (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index, to_next,
 					   n_left_to_next, bi,
 					   IP6_REASSEMBLY_NEXT_DROP);
-	  ASSERT (rm->buffers_n > 0);
-	  --rm->buffers_n;
+	  ASSERT (rt->buffers_n > 0);
+	  --rt->buffers_n;
+	}
+
+      while (vec_len (rt->vec_drop_too_long) > 0 && n_left_to_next > 0)
+	{
+	  u32 bi = vec_pop (rt->vec_drop_too_long);
+	  vlib_buffer_t *b = vlib_get_buffer (vm, bi);
+	  b->error = node->errors[IP6_ERROR_REASS_FRAGMENT_CHAIN_TOO_LONG];
+	  to_next[0] = bi;
+	  to_next += 1;
+	  n_left_to_next -= 1;
+	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index, to_next,
+					   n_left_to_next, bi,
+					   IP6_REASSEMBLY_NEXT_DROP);
+	  ASSERT (rt->buffers_n > 0);
+	  --rt->buffers_n;
 	}
 
       while (n_left_from > 0 && n_left_to_next > 0)
@@ -885,6 +955,15 @@ ip6_reassembly (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  vnet_buffer (b0)->ip.reass.ip6_frag_hdr_offset =
 	    (u8 *) frag_hdr - (u8 *) ip0;
 
+	  u32 icmp_bi = ~0;
+	  u32 error0 = IP6_ERROR_NONE;
+	  if (PREDICT_FALSE (ip6_reass_owner_thread_index (rm, ip0, frag_hdr)
+			     != thread_index))
+	    {
+	      next0 = IP6_REASSEMBLY_NEXT_HANDOFF;
+	      goto enqueue;
+	    }
+
 	  ip6_reass_key_t k;
 	  k.src.as_u64[0] = ip0->src_address.as_u64[0];
 	  k.src.as_u64[1] = ip0->src_address.as_u64[1];
@@ -894,26 +973,34 @@ ip6_reassembly (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  k.frag_id = frag_hdr->identification;
 	  k.proto = ip0->protocol;
 	  k.unused = 0;
-	  u32 icmp_bi = ~0;
 	  ip6_reass_t *reass =
-	    ip6_reass_find_or_create (vm, node, rm, &k, &icmp_bi,
-				      &vec_timeout);
+	    ip6_reass_find_or_create (vm, node, rm, rt, &k, &icmp_bi,
+				      &rt->vec_timeout);
 
-	  u32 error0 = IP6_ERROR_NONE;
-	  if (reass)
+	  if (PREDICT_FALSE (!reass))
 	    {
-	      ip6_reass_update (vm, node, rm, reass, &bi0, &next0, &error0,
-				frag_hdr, &vec_drop_overlap,
-				&vec_drop_compress, IP6_REASSEMBLY_NEXT_INPUT,
-				IP6_REASSEMBLY_NEXT_DROP,
-				IP6_REASSEMBLY_NEXT_ICMP_ERROR);
+	      next0 = IP6_REASSEMBLY_NEXT_DROP;
+	      error0 = IP6_ERROR_REASS_LIMIT_REACHED;
 	    }
-	  else
+	  else if (PREDICT_FALSE (reass->fragments_n >= rm->max_reass_len))
 	    {
+	      ip6_reass_drop_all (vm, rt, reass, &rt->vec_drop_too_long);
+	      ip6_reass_free (rt, reass);
 	      next0 = IP6_REASSEMBLY_NEXT_DROP;
-	      error0 = IP6_ERROR_REASS_LIMIT_REACHED;
+	      error0 = IP6_ERROR_REASS_FRAGMENT_CHAIN_TOO_LONG;
+	    }
+	  else
+	    {
+	      ++reass->fragments_n;
+	      ip6_reass_update (vm, node, rt, reass, &bi0, &next0, &error0,
+				frag_hdr, &rt->vec_drop_overlap,
+				&rt->vec_drop_compress,
+				IP6_REASSEMBLY_NEXT_INPUT,
+				IP6_REASSEMBLY_NEXT_DROP,
+				IP6_REASSEMBLY_NEXT_ICMP_ERROR);
 	    }
 
+	enqueue:
 	  b0->error = node->errors[error0];
 
 	  if (~0 != bi0)
@@ -943,6 +1030,8 @@ ip6_reassembly (vlib_main_t * vm, vlib_node_runtime_t * node,
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
 
+  clib_spinlock_unlock_if_init (&rt->lock);
+
   return frame->n_vectors;
 }
 
@@ -966,18 +1055,126 @@ VLIB_REGISTER_NODE (ip6_reass_node, static) = {
                 [IP6_REASSEMBLY_NEXT_INPUT] = "ip6-input",
                 [IP6_REASSEMBLY_NEXT_DROP] = "ip6-drop",
                 [IP6_REASSEMBLY_NEXT_ICMP_ERROR] = "ip6-icmp-error",
+                [IP6_REASSEMBLY_NEXT_HANDOFF] = "ip6-reassembly-handoff",
         },
 };
 /* *INDENT-ON* */
 
-VLIB_NODE_FUNCTION_MULTIARCH (ip6_reass_node, ip6_reassembly)
-     static u32 ip6_reass_get_nbuckets ()
+VLIB_NODE_FUNCTION_MULTIARCH (ip6_reass_node, ip6_reassembly);
+
+#define foreach_ip6_reass_handoff_error                 \
+  _ (FRAGMENTS, "fragments handed off to owner worker") \
+  _ (CONGESTION_DROP, "congestion drop")
+
+typedef enum
+{
+#define _(sym, str) IP6_REASS_HANDOFF_ERROR_##sym,
+  foreach_ip6_reass_handoff_error
+#undef _
+    IP6_REASS_HANDOFF_N_ERROR,
+} ip6_reass_handoff_error_t;
+
+static char *ip6_reass_handoff_error_strings[] = {
+#define _(sym, string) string,
+  foreach_ip6_reass_handoff_error
+#undef _
+};
+
+typedef struct
+{
+  u32 next_worker_index;
+} ip6_reass_handoff_trace_t;
+
+static u8 *
+format_ip6_reass_handoff_trace (u8 * s, va_list * args)
+{
+  CLIB_UNUSED (vlib_main_t * vm) = va_arg (*args, vlib_main_t *);
+  CLIB_UNUSED (vlib_node_t * node) = va_arg (*args, vlib_node_t *);
+  ip6_reass_handoff_trace_t *t = va_arg (*args, ip6_reass_handoff_trace_t *);
+
+  s = format (s, "ip6-reassembly-handoff: next-worker %d",
+	      t->next_worker_index);
+  return s;
+}
+
+static uword
+ip6_reass_handoff (vlib_main_t * vm, vlib_node_runtime_t * node,
+		   vlib_frame_t * frame)
+{
+  ip6_reass_main_t *rm = &ip6_reass_main;
+  u16 thread_indices[VLIB_FRAME_SIZE], *ti;
+  u32 n_left_from, *from, n_enq;
+
+  from = vlib_frame_vector_args (frame);
+  n_left_from = frame->n_vectors;
+  ti = thread_indices;
+
+  while (n_left_from > 0)
+    {
+      u32 bi0;
+      vlib_buffer_t *b0;
+      ip6_header_t *ip0;
+      ip6_frag_hdr_t *frag_hdr;
+      bi0 = from[0];
+      from += 1;
+      n_left_from -= 1;
+
+      b0 = vlib_get_buffer (vm, bi0);
+      ip0 = vlib_buffer_get_current (b0);
+      frag_hdr = (void *) ip0 + vnet_buffer (b0)->ip.reass.ip6_frag_hdr_offset;
+      ti[0] = ip6_reass_owner_thread_index (rm, ip0, frag_hdr);
+      if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
+			 && (b0->flags & VLIB_BUFFER_IS_TRACED)))
+	{
+	  ip6_reass_handoff_trace_t *t =
+	    vlib_add_trace (vm, node, b0, sizeof (*t));
+	  t->next_worker_index = ti[0];
+	}
+      ti += 1;
+    }
+
+  /* enqueue to the owner workers */
+  n_enq = vlib_buffer_enqueue_to_thread (vm, rm->fq_index,
+					 vlib_frame_vector_args (frame),
+					 thread_indices, frame->n_vectors);
+
+  vlib_node_increment_counter (vm, node->node_index,
+			       IP6_REASS_HANDOFF_ERROR_FRAGMENTS, n_enq);
+  if (n_enq < frame->n_vectors)
+    vlib_node_increment_counter (vm, node->node_index,
+				 IP6_REASS_HANDOFF_ERROR_CONGESTION_DROP,
+				 frame->n_vectors - n_enq);
+  return frame->n_vectors;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (ip6_reass_handoff_node, static) = {
+  .function = ip6_reass_handoff,
+  .name = "ip6-reassembly-handoff",
+  .vector_size = sizeof (u32),
+  .format_trace = format_ip6_reass_handoff_trace,
+  .type = VLIB_NODE_TYPE_INTERNAL,
+  .n_errors = ARRAY_LEN (ip6_reass_handoff_error_strings),
+  .error_strings = ip6_reass_handoff_error_strings,
+
+  .n_next_nodes = 1,
+
+  .next_nodes = {
+    [0] = "error-drop",
+  },
+};
+/* *INDENT-ON* */
+
+VLIB_NODE_FUNCTION_MULTIARCH (ip6_reass_handoff_node, ip6_reass_handoff);
+
+static u32
+ip6_reass_get_nbuckets ()
 {
   ip6_reass_main_t *rm = &ip6_reass_main;
   u32 nbuckets;
   u8 i;
 
-  nbuckets = (u32) (rm->max_reass_n / IP6_REASS_HT_LOAD_FACTOR);
+  nbuckets = (u32) (rm->max_reass_per_thread_n / IP6_REASS_HT_LOAD_FACTOR);
 
   for (i = 0; i < 31; i++)
     if ((1 << i) >= nbuckets)
@@ -1010,50 +1207,59 @@ ip6_rehash_cb (clib_bihash_kv_48_8_t * kv, void *_ctx)
 
 vnet_api_error_t
 ip6_reass_set (u32 timeout_ms, u32 max_reassemblies,
-	       u32 expire_walk_interval_ms)
+	       u32 max_reassembly_length, u32 expire_walk_interval_ms)
 {
+  ip6_reass_main_t *rm = &ip6_reass_main;
+  ip6_reass_per_thread_t *rt;
+  u32 n_tables = clib_max (rm->num_workers, 1);
   u32 old_nbuckets = ip6_reass_get_nbuckets ();
-  ip6_reass_main.timeout_ms = timeout_ms;
-  ip6_reass_main.timeout = (f64) timeout_ms / (f64) MSEC_PER_SEC;
-  ip6_reass_main.max_reass_n = max_reassemblies;
-  ip6_reass_main.expire_walk_interval_ms = expire_walk_interval_ms;
-  vlib_process_signal_event (ip6_reass_main.vlib_main,
-			     ip6_reass_main.ip6_reass_expire_node_idx,
+  rm->timeout_ms = timeout_ms;
+  rm->timeout = (f64) timeout_ms / (f64) MSEC_PER_SEC;
+  rm->max_reass_n = max_reassemblies;
+  rm->max_reass_per_thread_n = (max_reassemblies + n_tables - 1) / n_tables;
+  rm->max_reass_len = max_reassembly_length ? max_reassembly_length :
+    IP6_REASS_MAX_REASSEMBLY_LENGTH_DEFAULT;
+  rm->expire_walk_interval_ms = expire_walk_interval_ms;
+
+  vlib_process_signal_event (rm->vlib_main, rm->ip6_reass_expire_node_idx,
 			     IP6_EVENT_CONFIG_CHANGED, 0);
   u32 new_nbuckets = ip6_reass_get_nbuckets ();
-  if (ip6_reass_main.max_reass_n > 0 && new_nbuckets > 1 &&
+  if (rm->max_reass_n > 0 && new_nbuckets > 1 &&
       new_nbuckets != old_nbuckets)
     {
-      clib_bihash_48_8_t new_hash;
-      memset (&new_hash, 0, sizeof (new_hash));
-      ip6_rehash_cb_ctx ctx;
-      ctx.failure = 0;
-      ctx.new_hash = &new_hash;
-      clib_bihash_init_48_8 (&new_hash, "ip6-reass", new_nbuckets,
-			     new_nbuckets * 1024);
-      clib_bihash_foreach_key_value_pair_48_8 (&ip6_reass_main.hash,
-					       ip6_rehash_cb, &ctx);
-      if (ctx.failure)
-	{
-	  clib_bihash_free_48_8 (&new_hash);
-	  return -1;
-	}
-      else
-	{
-	  clib_bihash_free_48_8 (&ip6_reass_main.hash);
-	  clib_memcpy (&ip6_reass_main.hash, &new_hash,
-		       sizeof (ip6_reass_main.hash));
-	}
+      vec_foreach (rt, rm->per_thread_data)
+      {
+	clib_bihash_48_8_t new_hash;
+	memset (&new_hash, 0, sizeof (new_hash));
+	ip6_rehash_cb_ctx ctx;
+	ctx.failure = 0;
+	ctx.new_hash = &new_hash;
+	clib_bihash_init_48_8 (&new_hash, "ip6-reass", new_nbuckets,
+			       new_nbuckets * 1024);
+	clib_bihash_foreach_key_value_pair_48_8 (&rt->hash, ip6_rehash_cb,
+						 &ctx);
+	if (ctx.failure)
+	  {
+	    clib_bihash_free_48_8 (&new_hash);
+	    return -1;
+	  }
+	else
+	  {
+	    clib_bihash_free_48_8 (&rt->hash);
+	    clib_memcpy (&rt->hash, &new_hash, sizeof (rt->hash));
+	  }
+      }
     }
   return 0;
 }
 
 vnet_api_error_t
 ip6_reass_get (u32 * timeout_ms, u32 * max_reassemblies,
-	       u32 * expire_walk_interval_ms)
+	       u32 * max_reassembly_length, u32 * expire_walk_interval_ms)
 {
   *timeout_ms = ip6_reass_main.timeout_ms;
   *max_reassemblies = ip6_reass_main.max_reass_n;
+  *max_reassembly_length = ip6_reass_main.max_reass_len;
   *expire_walk_interval_ms = ip6_reass_main.expire_walk_interval_ms;
   return 0;
 }
@@ -1062,6 +1268,8 @@ clib_error_t *
 ip6_reass_init_function (vlib_main_t * vm)
 {
   ip6_reass_main_t *rm = &ip6_reass_main;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  ip6_reass_per_thread_t *rt;
   clib_error_t *error = 0;
   u32 nbuckets;
   vlib_node_t *node;
@@ -1069,8 +1277,12 @@ ip6_reass_init_function (vlib_main_t * vm)
   rm->vlib_main = vm;
   rm->vnet_main = vnet_get_main ();
 
-  rm->reass_n = 0;
-  pool_alloc (rm->pool, rm->max_reass_n);
+  /* with workers, each fragment is reassembled by the worker its key
+   * hashes to, in a table of that worker's own */
+  rm->num_workers = vlib_num_workers ();
+  rm->first_worker_index = vlib_get_worker_thread_index (0);
+  if (rm->num_workers)
+    rm->fq_index = vlib_frame_queue_main_init (ip6_reass_node.index, 0);
 
   node = vlib_get_node_by_name (vm, (u8 *) "ip6-reassembly-expire-walk");
   ASSERT (node);
@@ -1078,10 +1290,20 @@ ip6_reass_init_function (vlib_main_t * vm)
 
   ip6_reass_set (IP6_REASS_TIMEOUT_DEFAULT_MS,
 		 IP6_REASS_MAX_REASSEMBLIES_DEAFULT,
+		 IP6_REASS_MAX_REASSEMBLY_LENGTH_DEFAULT,
 		 IP6_REASS_EXPIRE_WALK_INTERVAL_DEFAULT_MS);
 
   nbuckets = ip6_reass_get_nbuckets ();
-  clib_bihash_init_48_8 (&rm->hash, "ip6-reass", nbuckets, nbuckets * 1024);
+  vec_validate_aligned (rm->per_thread_data, tm->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (rt, rm->per_thread_data)
+  {
+    pool_alloc (rt->pool, rm->max_reass_per_thread_n);
+    clib_bihash_init_48_8 (&rt->hash, "ip6-reass", nbuckets,
+			   nbuckets * 1024);
+    if (tm->n_vlib_mains > 1)
+      clib_spinlock_init (&rt->lock);
+  }
 
   node = vlib_get_node_by_name (vm, (u8 *) "ip6-drop");
   ASSERT (node);
@@ -1127,34 +1349,45 @@ ip6_reass_walk_expired (vlib_main_t * vm,
       f64 now = vlib_time_now (vm);
 
       ip6_reass_t *reass;
+      ip6_reass_per_thread_t *rt;
       u32 *vec_timeout = NULL;
       int *pool_indexes_to_free = NULL;
-
-      int index;
-      /* *INDENT-OFF* */
-      pool_foreach_index (index, rm->pool, ({
-                            reass = pool_elt_at_index (rm->pool, index);
-                            if (now > reass->last_heard + rm->timeout)
-                              {
-                                vec_add1 (pool_indexes_to_free, index);
-                              }
-                          }));
-      /* *INDENT-ON* */
-      int *i;
       u32 *vec_icmp_bi = NULL;
-      /* *INDENT-OFF* */
-      vec_foreach (i, pool_indexes_to_free)
+
+      vec_foreach (rt, rm->per_thread_data)
       {
-        ip6_reass_t *reass = pool_elt_at_index (rm->pool, i[0]);
-        u32 icmp_bi = ~0;
-        ip6_reass_on_timeout (vm, node, rm, reass, &icmp_bi, &vec_timeout);
-        if (~0 != icmp_bi)
-          {
-            vec_add1 (vec_icmp_bi, icmp_bi);
-          }
-        ip6_reass_free (rm, reass);
+	int index;
+	u32 n_drop = vec_len (vec_timeout) + vec_len (vec_icmp_bi);
+	clib_spinlock_lock_if_init (&rt->lock);
+	/* *INDENT-OFF* */
+	pool_foreach_index (index, rt->pool, ({
+	                      reass = pool_elt_at_index (rt->pool, index);
+	                      if (now > reass->last_heard + rm->timeout)
+	                        {
+	                          vec_add1 (pool_indexes_to_free, index);
+	                        }
+	                    }));
+	/* *INDENT-ON* */
+	int *i;
+	/* *INDENT-OFF* */
+	vec_foreach (i, pool_indexes_to_free)
+	{
+	  ip6_reass_t *reass = pool_elt_at_index (rt->pool, i[0]);
+	  u32 icmp_bi = ~0;
+	  ip6_reass_on_timeout (vm, node, rt, reass, &icmp_bi, &vec_timeout);
+	  if (~0 != icmp_bi)
+	    {
+	      vec_add1 (vec_icmp_bi, icmp_bi);
+	    }
+	  ip6_reass_free (rt, reass);
+	}
+	/* *INDENT-ON* */
+	n_drop = vec_len (vec_timeout) + vec_len (vec_icmp_bi) - n_drop;
+	ASSERT (rt->buffers_n >= n_drop);
+	rt->buffers_n -= n_drop;
+	clib_spinlock_unlock_if_init (&rt->lock);
+	vec_reset_length (pool_indexes_to_free);
       }
-      /* *INDENT-ON* */
 
       while (vec_len (vec_timeout) > 0)
 	{
@@ -1184,8 +1417,6 @@ ip6_reass_walk_expired (vlib_main_t * vm,
 	      ++f->n_vectors;
 	      to_next += 1;
 	      n_left_to_next -= 1;
-	      ASSERT (rm->buffers_n > 0);
-	      --rm->buffers_n;
 	    }
 	  if (PREDICT_FALSE (n_trace > 0))
 	    {
@@ -1223,8 +1454,6 @@ ip6_reass_walk_expired (vlib_main_t * vm,
 	      ++f->n_vectors;
 	      to_next += 1;
 	      n_left_to_next -= 1;
-	      ASSERT (rm->buffers_n > 0);
-	      --rm->buffers_n;
 	    }
 	  if (PREDICT_FALSE (n_trace > 0))
 	    {
@@ -1311,26 +1540,42 @@ show_ip6_reass (vlib_main_t * vm, unformat_input_t * input,
 		CLIB_UNUSED (vlib_cli_command_t * lmd))
 {
   ip6_reass_main_t *rm = &ip6_reass_main;
+  ip6_reass_per_thread_t *rt;
+  u64 reass_n = 0, buffers_n = 0;
+  u8 details = unformat (input, "details");
 
   vlib_cli_output (vm, "---------------------");
   vlib_cli_output (vm, "IP6 reassembly status");
   vlib_cli_output (vm, "---------------------");
-  if (unformat (input, "details"))
-    {
-      ip6_reass_t *reass;
-      /* *INDENT-OFF* */
-      pool_foreach (reass, rm->pool, {
-        vlib_cli_output (vm, "%U", format_ip6_reass, vm, reass);
-      });
-      /* *INDENT-ON* */
-    }
+  vec_foreach (rt, rm->per_thread_data)
+  {
+    clib_spinlock_lock_if_init (&rt->lock);
+    if (details)
+      {
+	ip6_reass_t *reass;
+	/* *INDENT-OFF* */
+	pool_foreach (reass, rt->pool, {
+	  vlib_cli_output (vm, "%U", format_ip6_reass, vm, reass);
+	});
+	/* *INDENT-ON* */
+      }
+    if (rt->reass_n || rt->reassembled_n)
+      vlib_cli_output (vm, "Thread %u: reassemblies %u, buffers %u, "
+		       "reassembled %lu",
+		       (u32) (rt - rm->per_thread_data), rt->reass_n,
+		       rt->buffers_n, rt->reassembled_n);
+    reass_n += rt->reass_n;
+    buffers_n += rt->buffers_n;
+    clib_spinlock_unlock_if_init (&rt->lock);
+  }
   vlib_cli_output (vm, "---------------------");
-  vlib_cli_output (vm, "Current IP6 reassemblies count: %lu\n", rm->reass_n);
+  vlib_cli_output (vm, "Current IP6 reassemblies count: %lu\n", reass_n);
   vlib_cli_output (vm,
 		   "Maximum configured concurrent IP6 reassemblies: %lu\n",
 		   (long unsigned) rm->max_reass_n);
-  vlib_cli_output (vm, "Buffers in use: %lu\n",
-		   (long unsigned) rm->buffers_n);
+  vlib_cli_output (vm, "Maximum configured fragments per reassembly: %u\n",
+		   rm->max_reass_len);
+  vlib_cli_output (vm, "Buffers in use: %lu\n", buffers_n);
   return 0;
 }
 
@@ -28,6 +28,7 @@
 #include <vnet/ip/ip6_neighbor.h>
 #include <vnet/fib/fib_table.h>
 #include <vnet/fib/fib_api.h>
+#include <vnet/fib/fib_walk.h>
 #include <vnet/dpo/drop_dpo.h>
 #include <vnet/dpo/receive_dpo.h>
 #include <vnet/dpo/lookup_dpo.h>
@@ -82,6 +83,7 @@ _(PROXY_ARP_ADD_DEL, proxy_arp_add_del)                                 \
 _(PROXY_ARP_INTFC_ENABLE_DISABLE, proxy_arp_intfc_enable_disable)       \
 _(RESET_FIB, reset_fib)							\
 _(IP_ADD_DEL_ROUTE, ip_add_del_route)                                   \
+_(IP_ROUTE_ADD_DEL_BATCH, ip_route_add_del_batch)                       \
 _(IP_TABLE_ADD_DEL, ip_table_add_del)                                   \
 _(IP_PUNT_POLICE, ip_punt_police)                                       \
 _(IP_PUNT_REDIRECT, ip_punt_redirect)                                   \
@@ -1192,25 +1194,168 @@ ip6_add_del_route_t_handler (vl_api_ip_add_del_route_t * mp)
 				   label_stack));
 }
 
+/*
+ * The message is marked mp-safe. Plain IPv4 routes only allocate
+ * objects whose pools guard their own growth (load-balances, uRPF
+ * lists, adjacencies, mtrie plies) and only free them with
+ * vlib_rcu_call(), so they are updated with the workers running.
+ * Everything else still stops them.
+ */
+static int
+ip_add_del_route_needs_barrier (vl_api_ip_add_del_route_t * mp)
+{
+  mpls_label_t via_label = ntohl (mp->next_hop_via_label);
+
+  if (mp->is_ipv6)
+    /* the IPv6 forwarding table's search order isn't reader-safe */
+    return (1);
+  if (mp->is_local || mp->is_classify || mp->is_udp_encap ||
+      mp->is_dvr || mp->is_source_lookup || mp->next_hop_n_out_labels)
+    return (1);
+  if (MPLS_LABEL_INVALID != via_label && 0 != via_label)
+    return (1);
+  if (~0 == ntohl (mp->next_hop_sw_if_index) &&
+      0 == ((ip4_address_t *) mp->next_hop_address)->as_u32)
+    /* a lookup in the next-hop table */
+    return (1);
+
+  return (0);
+}
+
 void
 vl_api_ip_add_del_route_t_handler (vl_api_ip_add_del_route_t * mp)
 {
   vl_api_ip_add_del_route_reply_t *rmp;
-  int rv;
+  int rv, need_barrier_sync;
   vnet_main_t *vnm = vnet_get_main ();
+  vlib_main_t *vm = vlib_get_main ();
 
   vnm->api_errno = 0;
 
+  need_barrier_sync = ip_add_del_route_needs_barrier (mp);
+  if (need_barrier_sync)
+    vlib_worker_thread_barrier_sync (vm);
+
   if (mp->is_ipv6)
     rv = ip6_add_del_route_t_handler (mp);
   else
     rv = ip4_add_del_route_t_handler (mp);
 
+  if (need_barrier_sync)
+    vlib_worker_thread_barrier_release (vm);
+
   rv = (rv == 0) ? vnm->api_errno : rv;
 
   REPLY_MACRO (VL_API_IP_ADD_DEL_ROUTE_REPLY);
 }
 
+static int
+ip_route_batch_entry_add_del (u32 table_id,
+			      vl_api_ip_route_batch_entry_t * e)
+{
+  u32 fib_index, next_hop_fib_index;
+  fib_protocol_t fproto;
+  dpo_proto_t dproto;
+  ip46_address_t nh;
+  int rv;
+
+  fproto = (e->is_ipv6 ? FIB_PROTOCOL_IP6 : FIB_PROTOCOL_IP4);
+  dproto = (e->is_ipv6 ? DPO_PROTO_IP6 : DPO_PROTO_IP4);
+
+  if (e->dst_address_length > (e->is_ipv6 ? 128 : 32))
+    return (VNET_API_ERROR_INVALID_VALUE);
+
+  rv = add_del_route_check (fproto,
+			    table_id,
+			    e->next_hop_sw_if_index,
+			    dproto, table_id,
+			    0, &fib_index, &next_hop_fib_index);
+
+  if (0 != rv)
+    return (rv);
+
+  fib_prefix_t pfx = {
+    .fp_len = e->dst_address_length,
+    .fp_proto = fproto,
+  };
+
+  memset (&nh, 0, sizeof (nh));
+  if (e->is_ipv6)
+    {
+      clib_memcpy (&pfx.fp_addr.ip6, e->dst_address,
+		   sizeof (pfx.fp_addr.ip6));
+      clib_memcpy (&nh.ip6, e->next_hop_address, sizeof (nh.ip6));
+    }
+  else
+    {
+      clib_memcpy (&pfx.fp_addr.ip4, e->dst_address,
+		   sizeof (pfx.fp_addr.ip4));
+      clib_memcpy (&nh.ip4, e->next_hop_address, sizeof (nh.ip4));
+    }
+
+  return (add_del_route_t_handler (e->is_multipath,
+				   e->is_add,
+				   e->is_drop,
+				   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+				   fib_index, &pfx, dproto,
+				   &nh, ~0,
+				   ntohl (e->next_hop_sw_if_index),
+				   next_hop_fib_index,
+				   e->next_hop_weight,
+				   e->next_hop_preference,
+				   MPLS_LABEL_INVALID, NULL));
+}
+
+/*
+ * The message is not mp-safe, so the whole batch is applied under
+ * the one barrier sync. The back-walks the routes trigger are merged
+ * per-parent and run once, at the end of the batch.
+ */
+static void
+vl_api_ip_route_add_del_batch_t_handler (vl_api_ip_route_add_del_batch_t *
+					 mp)
+{
+  vl_api_ip_route_add_del_batch_reply_t *rmp;
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 ii, count, n_failed = 0;
+  int rv = 0, rv1;
+
+  count = ntohl (mp->count);
+
+  if (vl_msg_api_get_msg_length (mp) <
+      sizeof (*mp) + (u64) count * sizeof (mp->routes[0]))
+    {
+      rv = VNET_API_ERROR_INVALID_VALUE;
+      goto done;
+    }
+
+  fib_walk_batch_begin ();
+
+  for (ii = 0; ii < count; ii++)
+    {
+      vnm->api_errno = 0;
+      rv1 = ip_route_batch_entry_add_del (mp->table_id, &mp->routes[ii]);
+      rv1 = (rv1 == 0) ? vnm->api_errno : rv1;
+
+      if (0 != rv1)
+	{
+	  if (0 == n_failed)
+	    rv = rv1;
+	  n_failed++;
+	}
+    }
+
+  fib_walk_batch_end ();
+
+done:
+  /* *INDENT-OFF* */
+  REPLY_MACRO2 (VL_API_IP_ROUTE_ADD_DEL_BATCH_REPLY,
+  ({
+    rmp->n_failed = htonl (n_failed);
+  }));
+  /* *INDENT-ON* */
+}
+
 void
 ip_table_create (fib_protocol_t fproto,
 		 u32 table_id, u8 is_api, const u8 * name)
@@ -2799,12 +2944,14 @@ vl_api_ip_reassembly_set_t_handler (vl_api_ip_reassembly_set_t * mp)
     {
       rv = ip6_reass_set (clib_net_to_host_u32 (mp->timeout_ms),
 			  clib_net_to_host_u32 (mp->max_reassemblies),
+			  clib_net_to_host_u32 (mp->max_reassembly_length),
 			  clib_net_to_host_u32 (mp->expire_walk_interval_ms));
     }
   else
     {
       rv = ip4_reass_set (clib_net_to_host_u32 (mp->timeout_ms),
 			  clib_net_to_host_u32 (mp->max_reassemblies),
+			  clib_net_to_host_u32 (mp->max_reassembly_length),
 			  clib_net_to_host_u32 (mp->expire_walk_interval_ms));
     }
 
@@ -2830,16 +2977,20 @@ vl_api_ip_reassembly_get_t_handler (vl_api_ip_reassembly_get_t * mp)
     {
       rmp->is_ip6 = 1;
       ip6_reass_get (&rmp->timeout_ms, &rmp->max_reassemblies,
+		     &rmp->max_reassembly_length,
 		     &rmp->expire_walk_interval_ms);
     }
   else
     {
       rmp->is_ip6 = 0;
       ip4_reass_get (&rmp->timeout_ms, &rmp->max_reassemblies,
+		     &rmp->max_reassembly_length,
 		     &rmp->expire_walk_interval_ms);
     }
   rmp->timeout_ms = clib_host_to_net_u32 (rmp->timeout_ms);
   rmp->max_reassemblies = clib_host_to_net_u32 (rmp->max_reassemblies);
+  rmp->max_reassembly_length =
+    clib_host_to_net_u32 (rmp->max_reassembly_length);
   rmp->expire_walk_interval_ms =
     clib_host_to_net_u32 (rmp->expire_walk_interval_ms);
   vl_msg_api_send_shmem (q, (u8 *) & rmp);
@@ -2872,6 +3023,9 @@ ip_api_hookup (vlib_main_t * vm)
   foreach_ip_api_msg;
 #undef _
 
+  /* takes the barrier itself, when it needs it */
+  am->is_mp_safe[VL_API_IP_ADD_DEL_ROUTE] = 1;
+
   /*
    * Set up the (msg_name, crc, message-id) table
    */
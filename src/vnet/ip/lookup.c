@@ -42,6 +42,7 @@
 #include <vnet/fib/fib_table.h>
 #include <vnet/fib/ip4_fib.h>
 #include <vnet/fib/ip6_fib.h>
+#include <vnet/fib/fib_walk.h>
 #include <vnet/mpls/mpls.h>
 #include <vnet/mfib/mfib_table.h>
 #include <vnet/dpo/drop_dpo.h>
@@ -332,12 +333,14 @@ vnet_ip_route_cmd (vlib_main_t * vm,
   fib_route_path_t *rpaths = NULL, rpath;
   fib_prefix_t *prefixs = NULL, pfx;
   clib_error_t *error = NULL;
+  u8 batch, in_batch;
   f64 count;
   int i;
 
   is_del = 0;
   table_id = 0;
   count = 1;
+  batch = in_batch = 0;
   memset (&pfx, 0, sizeof (pfx));
 
   /* Get a line of input. */
@@ -352,6 +355,8 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 	;
       else if (unformat (line_input, "count %f", &count))
 	;
+      else if (unformat (line_input, "batch"))
+	batch = 1;
 
       else if (unformat (line_input, "%U/%d",
 			 unformat_ip4_address, &pfx.fp_addr.ip4, &pfx.fp_len))
@@ -418,6 +423,13 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 	}
     }
 
+  if (batch)
+    {
+      /* merge the back-walks of all the routes, and run them at the end */
+      fib_walk_batch_begin ();
+      in_batch = 1;
+    }
+
   for (i = 0; i < vec_len (prefixs); i++)
     {
       if (is_del && 0 == vec_len (rpaths))
@@ -505,6 +517,11 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 
 		}
 	    }
+	  if (in_batch)
+	    {
+	      fib_walk_batch_end ();
+	      in_batch = 0;
+	    }
 	  t[1] = vlib_time_now (vm);
 	  if (count > 1)
 	    vlib_cli_output (vm, "%.6e routes/sec", count / (t[1] - t[0]));
@@ -518,6 +535,8 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 
 
 done:
+  if (in_batch)
+    fib_walk_batch_end ();
   vec_free (dpos);
   vec_free (prefixs);
   vec_free (rpaths);
@@ -532,11 +551,13 @@ vnet_ip_table_cmd (vlib_main_t * vm,
 {
   unformat_input_t _line_input, *line_input = &_line_input;
   clib_error_t *error = NULL;
-  u32 table_id, is_add;
+  ip4_fib_mtrie_type_t mtrie_type;
+  u32 table_id, is_add, has_mtrie_type;
   u8 *name = NULL;
 
   is_add = 1;
   table_id = ~0;
+  has_mtrie_type = 0;
 
   /* Get a line of input. */
   if (!unformat_user (main_input, unformat_line_input, line_input))
@@ -552,6 +573,10 @@ vnet_ip_table_cmd (vlib_main_t * vm,
 	is_add = 1;
       else if (unformat (line_input, "name %s", &name))
 	;
+      else if (FIB_PROTOCOL_IP4 == fproto &&
+	       unformat (line_input, "mtrie %U",
+			 unformat_ip4_fib_mtrie_type, &mtrie_type))
+	has_mtrie_type = 1;
       else
 	{
 	  error = unformat_parse_error (line_input);
@@ -573,6 +598,13 @@ vnet_ip_table_cmd (vlib_main_t * vm,
     {
       if (is_add)
 	{
+	  if (has_mtrie_type &&
+	      ip4_fib_table_set_mtrie_type (table_id, mtrie_type))
+	    {
+	      error = clib_error_return (0, "Table %d exists, its mtrie "
+					 "layout can't be changed", table_id);
+	      goto done;
+	    }
 	  ip_table_create (fproto, table_id, 0, name);
 	}
       else
@@ -644,6 +676,9 @@ VLIB_CLI_COMMAND (vlib_cli_show_ip6_command, static) = {
  * Mainly for route add/del performance testing, one can add or delete
  * multiple routes by adding 'count N' to the previous item:
  * @cliexcmd{ip route add count 10 7.0.0.0/24 via 6.0.0.1 GigabitEthernet2/0/0}
+ * Adding 'batch' merges the updates of the routes' dependents and makes
+ * them once, at the end, as the batched route API does:
+ * @cliexcmd{ip route add count 100000 batch 7.0.0.0/24 via 6.0.0.1 GigabitEthernet2/0/0}
  * Add multiple routes for the same destination to create equal-cost multipath:
  * @cliexcmd{ip route add 7.0.0.1/32 via 6.0.0.1 GigabitEthernet2/0/0}
  * @cliexcmd{ip route add 7.0.0.1/32 via 6.0.0.2 GigabitEthernet2/0/0}
@@ -658,7 +693,7 @@ VLIB_CLI_COMMAND (vlib_cli_show_ip6_command, static) = {
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (ip_route_command, static) = {
   .path = "ip route",
-  .short_help = "ip route [add|del] [count <n>] <dst-ip-addr>/<width> [table <table-id>] via [next-hop-address] [next-hop-interface] [next-hop-table <value>] [weight <value>] [preference <value>] [udp-encap-id <value>] [ip4-lookup-in-table <value>] [ip6-lookup-in-table <value>] [mpls-lookup-in-table <value>] [resolve-via-host] [resolve-via-connected] [rx-ip4 <interface>] [out-labels <value value value>]",
+  .short_help = "ip route [add|del] [count <n> [batch]] <dst-ip-addr>/<width> [table <table-id>] via [next-hop-address] [next-hop-interface] [next-hop-table <value>] [weight <value>] [preference <value>] [udp-encap-id <value>] [ip4-lookup-in-table <value>] [ip6-lookup-in-table <value>] [mpls-lookup-in-table <value>] [resolve-via-host] [resolve-via-connected] [rx-ip4 <interface>] [out-labels <value value value>]",
   .function = vnet_ip_route_cmd,
   .is_mp_safe = 1,
 };
@@ -667,13 +702,15 @@ VLIB_CLI_COMMAND (ip_route_command, static) = {
 /*?
  * This command is used to add or delete IPv4  Tables. All
  * Tables must be explicitly added before that can be used. Creating a
- * table will add both unicast and multicast FIBs
- *
+ * table will add both unicast and multicast FIBs. The layout of the
+ * unicast table's mtrie can be chosen as it is added; the 8-8-8-8 trie
+ * uses much less memory, and cache, for tables with few routes:
+ * @cliexcmd{ip table add 7 mtrie 8-8-8-8}
  ?*/
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (ip4_table_command, static) = {
   .path = "ip table",
-  .short_help = "ip table [add|del] <table-id>",
+  .short_help = "ip table [add|del] <table-id> [mtrie 16-8-8|8-8-8-8]",
   .function = vnet_ip4_table_cmd,
   .is_mp_safe = 1,
 };
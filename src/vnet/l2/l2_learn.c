@@ -45,6 +45,12 @@ l2learn_main_t l2learn_main;
  * differ in certain cases (mac move tests), but this not expected to cause
  * problems in real-world networks. It is much simpler to separate learning
  * and forwarding into separate nodes.
+ *
+ * Nor do the workers write the mac table; they enqueue the learns, and the
+ * refreshes of existing entries, to a per-thread ring that the learner
+ * process on the main thread drains in batches. A mac is therefore in the
+ * table a batch, typically some tens of microseconds, after it is seen;
+ * the packets seen in the meantime are flooded as if it were unknown.
  */
 
 
@@ -81,7 +87,9 @@ _(MAC_MOVE,          "L2 mac moves")			\
 _(MAC_MOVE_VIOLATE,  "L2 mac move violations")		\
 _(LIMIT,             "L2 not learned due to limit")	\
 _(HIT_UPDATE,        "L2 learn hit updates")		\
-_(FILTER_DROP,       "L2 filter mac drops")
+_(FILTER_DROP,       "L2 filter mac drops")		\
+_(COALESCED,         "L2 learn updates already queued")	\
+_(RING_FULL,         "L2 learn updates dropped, ring full")
 
 typedef enum
 {
@@ -105,16 +113,63 @@ typedef enum
 } l2learn_next_t;
 
 
+/**
+ * Queue an update of the mac table to the learner.
+ * An update the same as one recently queued is not queued again; a flood
+ * of packets from a new mac, of which the learner has yet to hear, is
+ * one event.
+ */
+static_always_inline void
+l2learn_enqueue (l2learn_per_thread_t * ptd, u64 * counter_base,
+		 u64 key, u64 result)
+{
+  l2learn_event_t *e;
+  u32 head, size, slot;
+
+  slot = (key ^ (key >> 16) ^ (key >> 32)) & (L2LEARN_N_RECENT - 1);
+  if (ptd->recent_keys[slot] == key && ptd->recent_results[slot] == result)
+    {
+      counter_base[L2LEARN_ERROR_COALESCED] += 1;
+      return;
+    }
+
+  head = ptd->head;
+  size = vec_len (ptd->events);
+  if (PREDICT_FALSE (head - ptd->tail_cache >= size))
+    {
+      ptd->tail_cache = ptd->tail;
+      if (head - ptd->tail_cache >= size)
+	{
+	  counter_base[L2LEARN_ERROR_RING_FULL] += 1;
+	  ptd->n_dropped++;
+	  return;
+	}
+    }
+
+  e = &ptd->events[head & (size - 1)];
+  e->key = key;
+  e->result = result;
+  e->cpu_time = clib_cpu_time_now ();
+
+  ptd->recent_keys[slot] = key;
+  ptd->recent_results[slot] = result;
+  ptd->n_enqueued++;
+
+  /* the event is written before the learner sees the head move */
+  CLIB_MEMORY_STORE_BARRIER ();
+  ptd->head = head + 1;
+}
+
 /** Perform learning on one packet based on the mac table lookup result. */
 
 static_always_inline void
 l2learn_process (vlib_node_runtime_t * node,
 		 l2learn_main_t * msm,
+		 l2learn_per_thread_t * ptd,
 		 u64 * counter_base,
 		 vlib_buffer_t * b0,
 		 u32 sw_if_index0,
 		 l2fib_entry_key_t * key0,
-		 l2fib_entry_key_t * cached_key,
 		 u32 * count,
 		 l2fib_entry_result_t * result0, u32 * next0, u8 timestamp)
 {
@@ -167,8 +222,7 @@ l2learn_process (vlib_node_runtime_t * node,
       if (key.raw == 0)
 	return;
 
-      /* It is ok to learn */
-      msm->global_learn_count++;
+      /* It is ok to learn; the learner counts it */
       result0->raw = 0;		/* clear all fields */
       result0->fields.sw_if_index = sw_if_index0;
       result0->fields.lrn_evt = (msm->client_pid != 0);
@@ -201,11 +255,8 @@ l2learn_process (vlib_node_runtime_t * node,
        * TODO: check global/bridge domain/interface learn limits
        */
       result0->fields.sw_if_index = sw_if_index0;
-      if (result0->fields.age_not)	/* The mac was provisioned */
-	{
-	  msm->global_learn_count++;
-	  result0->fields.age_not = 0;
-	}
+      /* A provisioned mac is now learned, the learner counts it */
+      result0->fields.age_not = 0;
       result0->fields.lrn_evt = (msm->client_pid != 0);
       counter_base[L2LEARN_ERROR_MAC_MOVE] += 1;
     }
@@ -214,13 +265,7 @@ l2learn_process (vlib_node_runtime_t * node,
   result0->fields.timestamp = timestamp;
   result0->fields.sn.as_u16 = vnet_buffer (b0)->l2.l2fib_sn;
 
-  BVT (clib_bihash_kv) kv;
-  kv.key = key0->raw;
-  kv.value = result0->raw;
-  BV (clib_bihash_add_del) (msm->mac_table, &kv, 1 /* is_add */ );
-
-  /* Invalidate the cache */
-  cached_key->raw = ~0;
+  l2learn_enqueue (ptd, counter_base, key0->raw, result0->raw);
 }
 
 
@@ -231,6 +276,7 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   u32 n_left_from, *from, *to_next;
   l2learn_next_t next_index;
   l2learn_main_t *msm = &l2learn_main;
+  l2learn_per_thread_t *ptd;
   vlib_node_t *n = vlib_get_node (vm, l2learn_node.index);
   u32 node_counter_base_index = n->error_heap_index;
   vlib_error_main_t *em = &vm->error_main;
@@ -247,6 +293,14 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   cached_key.raw = ~0;
   cached_result.raw = ~0;	/* warning be gone */
 
+  /* Forget the pending events once the learner has drained them */
+  ptd = vec_elt_at_index (msm->per_thread, vm->thread_index);
+  if (PREDICT_FALSE (ptd->recent_epoch != msm->learner_epoch))
+    {
+      memset (ptd->recent_keys, 0xff, sizeof (ptd->recent_keys));
+      ptd->recent_epoch = msm->learner_epoch;
+    }
+
   while (n_left_from > 0)
     {
       u32 n_left_to_next;
@@ -371,21 +425,25 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			  &bucket0, &bucket1, &bucket2, &bucket3,
 			  &result0, &result1, &result2, &result3);
 
-	  l2learn_process (node, msm, &em->counters[node_counter_base_index],
-			   b0, sw_if_index0, &key0, &cached_key,
-			   &count, &result0, &next0, timestamp);
+	  l2learn_process (node, msm, ptd,
+			   &em->counters[node_counter_base_index], b0,
+			   sw_if_index0, &key0, &count, &result0, &next0,
+			   timestamp);
 
-	  l2learn_process (node, msm, &em->counters[node_counter_base_index],
-			   b1, sw_if_index1, &key1, &cached_key,
-			   &count, &result1, &next1, timestamp);
+	  l2learn_process (node, msm, ptd,
+			   &em->counters[node_counter_base_index], b1,
+			   sw_if_index1, &key1, &count, &result1, &next1,
+			   timestamp);
 
-	  l2learn_process (node, msm, &em->counters[node_counter_base_index],
-			   b2, sw_if_index2, &key2, &cached_key,
-			   &count, &result2, &next2, timestamp);
+	  l2learn_process (node, msm, ptd,
+			   &em->counters[node_counter_base_index], b2,
+			   sw_if_index2, &key2, &count, &result2, &next2,
+			   timestamp);
 
-	  l2learn_process (node, msm, &em->counters[node_counter_base_index],
-			   b3, sw_if_index3, &key3, &cached_key,
-			   &count, &result3, &next3, timestamp);
+	  l2learn_process (node, msm, ptd,
+			   &em->counters[node_counter_base_index], b3,
+			   sw_if_index3, &key3, &count, &result3, &next3,
+			   timestamp);
 
 	  /* verify speculative enqueues, maybe switch current next frame */
 	  /* if next0==next1==next_index then nothing special needs to be done */
@@ -438,9 +496,10 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			  h0->src_address, vnet_buffer (b0)->l2.bd_index,
 			  &key0, &bucket0, &result0);
 
-	  l2learn_process (node, msm, &em->counters[node_counter_base_index],
-			   b0, sw_if_index0, &key0, &cached_key,
-			   &count, &result0, &next0, timestamp);
+	  l2learn_process (node, msm, ptd,
+			   &em->counters[node_counter_base_index], b0,
+			   sw_if_index0, &key0, &count, &result0, &next0,
+			   timestamp);
 
 	  /* verify speculative enqueue, maybe switch current next frame */
 	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
@@ -463,6 +522,147 @@ l2learn_node_fn (vlib_main_t * vm,
   return l2learn_node_inline (vm, node, frame, 0 /* do_trace */ );
 }
 
+/**
+ * Apply a worker's update to the mac table.
+ * The table may have changed since the worker looked; it is looked up
+ * again, so that the learn count and the limit are kept here, and so
+ * that a mac made static or a filter meanwhile is not overwritten.
+ */
+static void
+l2learn_apply (l2learn_main_t * lm, u64 key, u64 result)
+{
+  BVT (clib_bihash_kv) kv;
+  l2fib_entry_result_t old, new;
+
+  new.raw = result;
+  kv.key = key;
+  if (BV (clib_bihash_search) (lm->mac_table, &kv, &kv))
+    {
+      /* a new mac */
+      if (lm->global_learn_count >= lm->global_learn_limit)
+	{
+	  lm->n_over_limit++;
+	  return;
+	}
+      lm->global_learn_count++;
+    }
+  else
+    {
+      old.raw = kv.value;
+      if (old.fields.static_mac || old.fields.filter)
+	return;
+      if (old.fields.age_not && !new.fields.age_not)
+	lm->global_learn_count++;	/* The mac was provisioned */
+    }
+
+  kv.key = key;
+  kv.value = result;
+  BV (clib_bihash_add_del) (lm->mac_table, &kv, 1 /* is_add */ );
+  lm->n_applied++;
+}
+
+/**
+ * Drain the rings of all threads, returning the number of events applied
+ */
+static u32
+l2learn_drain (l2learn_main_t * lm)
+{
+  l2learn_per_thread_t *ptd;
+  l2learn_event_t *e;
+  u32 head, tail, mask, n_events = 0;
+  u64 now, latency;
+
+  vec_foreach (ptd, lm->per_thread)
+  {
+    head = ptd->head;
+    tail = ptd->tail;
+    if (head == tail)
+      continue;
+
+    /* read the events only once the head is seen to move */
+    CLIB_MEMORY_BARRIER ();
+    now = clib_cpu_time_now ();
+    mask = vec_len (ptd->events) - 1;
+
+    for (; tail != head; tail++)
+      {
+	e = &ptd->events[tail & mask];
+	l2learn_apply (lm, e->key, e->result);
+
+	latency = now - e->cpu_time;
+	lm->latency_sum += latency;
+	if (latency > lm->latency_max)
+	  lm->latency_max = latency;
+	n_events++;
+      }
+
+    /* the events are read before the worker may reuse their slots */
+    CLIB_MEMORY_BARRIER ();
+    ptd->tail = head;
+  }
+
+  if (n_events)
+    {
+      lm->n_events += n_events;
+      lm->n_batches++;
+      lm->learner_epoch++;
+    }
+
+  return n_events;
+}
+
+/**
+ * The learner; the mac table's only writer of learned entries.
+ * It polls the rings every 100us while there is learning, every 1ms when
+ * there is not.
+ */
+static uword
+l2learn_learner_process (vlib_main_t * vm,
+			 vlib_node_runtime_t * rt, vlib_frame_t * f)
+{
+  l2learn_main_t *lm = &l2learn_main;
+  f64 timeout = 1e-3;
+  uword *event_data = 0;
+
+  while (1)
+    {
+      vlib_process_wait_for_event_or_clock (vm, timeout);
+      vlib_process_get_events (vm, &event_data);
+      vec_reset_length (event_data);
+
+      timeout = l2learn_drain (lm) ? 100e-6 : 1e-3;
+    }
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (l2learn_learner_node, static) = {
+  .function = l2learn_learner_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "l2-learn-process",
+};
+/* *INDENT-ON* */
+
+static void
+l2learn_rings_init (l2learn_main_t * lm, u32 ring_size)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  l2learn_per_thread_t *ptd;
+
+  vec_foreach (ptd, lm->per_thread) vec_free (ptd->events);
+  vec_free (lm->per_thread);
+
+  lm->ring_size = ring_size;
+  vec_validate_aligned (lm->per_thread, tm->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (ptd, lm->per_thread)
+  {
+    vec_validate_aligned (ptd->events, ring_size - 1, CLIB_CACHE_LINE_BYTES);
+    memset (ptd->recent_keys, 0xff, sizeof (ptd->recent_keys));
+  }
+}
+
 /* *INDENT-OFF* */
 VLIB_REGISTER_NODE (l2learn_node,static) = {
   .function = l2learn_node_fn,
@@ -508,6 +708,9 @@ VLIB_NODE_FUNCTION_MULTIARCH (l2learn_node, l2learn_node_fn)
    */
   mp->global_learn_limit = L2LEARN_DEFAULT_LIMIT;
 
+  l2learn_rings_init (mp, L2LEARN_DEFAULT_RING_SIZE);
+  mp->stats_start_time = vlib_time_now (vm);
+
   return 0;
 }
 
@@ -568,21 +771,109 @@ VLIB_CLI_COMMAND (int_learn_cli, static) = {
 /* *INDENT-ON* */
 
 
+static clib_error_t *
+show_l2learn (vlib_main_t * vm,
+	      unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  l2learn_main_t *lm = &l2learn_main;
+  l2learn_per_thread_t *ptd;
+  f64 clocks_per_us = os_cpu_clock_frequency () * 1e-6;
+  f64 elapsed = vlib_time_now (vm) - lm->stats_start_time;
+
+  vlib_cli_output (vm, "learned %d limit %d ring-size %d",
+		   lm->global_learn_count, lm->global_learn_limit,
+		   lm->ring_size);
+  vlib_cli_output (vm, "learner: applied %lld over-limit %lld "
+		   "batches %lld rate %.2f/sec",
+		   lm->n_applied, lm->n_over_limit, lm->n_batches,
+		   elapsed > 0 ? lm->n_applied / elapsed : 0.0);
+  vlib_cli_output (vm, "latency: avg %.2fus max %.2fus",
+		   lm->n_events ?
+		   lm->latency_sum / clocks_per_us / lm->n_events : 0.0,
+		   lm->latency_max / clocks_per_us);
+
+  vlib_cli_output (vm, "%=20s%=16s%=16s%=8s", "Thread", "Enqueued",
+		   "Dropped", "Pending");
+  vec_foreach (ptd, lm->per_thread)
+  {
+    u32 index = ptd - lm->per_thread;
+    vlib_cli_output (vm, "%=20v%=16lld%=16lld%=8d",
+		     vlib_worker_threads[index].name,
+		     ptd->n_enqueued, ptd->n_dropped, ptd->head - ptd->tail);
+  }
+
+  return 0;
+}
+
+/*?
+ * Display the learner's statistics; the entries learned, the rate at
+ * which they are and the delay between a worker seeing a mac and it
+ * being in the table, and the events each thread has queued to the
+ * learner and dropped since its ring was full.
+ *
+ * @cliexpar
+ * @cliexcmd{show l2learn}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_l2learn_cli, static) = {
+  .path = "show l2learn",
+  .short_help = "show l2learn",
+  .function = show_l2learn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+clear_l2learn (vlib_main_t * vm,
+	       unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  l2learn_main_t *lm = &l2learn_main;
+  l2learn_per_thread_t *ptd;
+
+  lm->n_events = lm->n_applied = lm->n_over_limit = lm->n_batches = 0;
+  lm->latency_sum = lm->latency_max = 0;
+  lm->stats_start_time = vlib_time_now (vm);
+  vec_foreach (ptd, lm->per_thread)
+  {
+    ptd->n_enqueued = 0;
+    ptd->n_dropped = 0;
+  }
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (clear_l2learn_cli, static) = {
+  .path = "clear l2learn",
+  .short_help = "clear l2learn",
+  .function = clear_l2learn,
+};
+/* *INDENT-ON* */
+
 static clib_error_t *
 l2learn_config (vlib_main_t * vm, unformat_input_t * input)
 {
   l2learn_main_t *mp = &l2learn_main;
+  u32 ring_size = L2LEARN_DEFAULT_RING_SIZE;
 
   while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
     {
       if (unformat (input, "limit %d", &mp->global_learn_limit))
 	;
+      else if (unformat (input, "ring-size %d", &ring_size))
+	;
 
       else
 	return clib_error_return (0, "unknown input `%U'",
 				  format_unformat_error, input);
     }
 
+  if (ring_size == 0)
+    return clib_error_return (0, "ring-size must be non-zero");
+
+  ring_size = 1 << max_log2 (ring_size);
+  if (ring_size != mp->ring_size)
+    l2learn_rings_init (mp, ring_size);
+
   return 0;
 }
 
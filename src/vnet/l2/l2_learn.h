@@ -21,6 +21,52 @@
 #include <vlib/vlib.h>
 #include <vnet/ethernet/ethernet.h>
 
+/*
+ * Workers do not write the mac table. A learn, or the refresh of an
+ * entry, is an event on the worker's ring, a single producer, single
+ * consumer queue, that the learner process on the main thread drains
+ * and applies in batches; so the only writer of the table is the main
+ * thread and there is no writer lock contention between workers.
+ */
+typedef struct
+{
+  u64 key;
+  u64 result;
+  /* when the event was enqueued, for the learn latency */
+  u64 cpu_time;
+} l2learn_event_t;
+
+/* Size of the per-thread filter of recently enqueued events */
+#define L2LEARN_N_RECENT 64
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  /* Written by the worker */
+  volatile u32 head;
+  /* the worker's copy of the tail, refreshed when the ring looks full */
+  u32 tail_cache;
+  /* the learner epoch of the recent filter */
+  u32 recent_epoch;
+
+  /* events enqueued, and dropped since the ring was full */
+  u64 n_enqueued;
+  u64 n_dropped;
+
+  /* the ring, a power of 2 in size */
+  l2learn_event_t *events;
+
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+
+  /* Written by the learner */
+  volatile u32 tail;
+
+  /* Events pending, by key hash; only the worker reads this */
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline2);
+  u64 recent_keys[L2LEARN_N_RECENT];
+  u64 recent_results[L2LEARN_N_RECENT];
+} l2learn_per_thread_t;
 
 typedef struct
 {
@@ -41,12 +87,29 @@ typedef struct
   /* Next nodes for each feature */
   u32 feat_next_node_index[32];
 
+  /* Learn event rings, one per thread */
+  l2learn_per_thread_t *per_thread;
+  u32 ring_size;
+
+  /* Bumped as the learner drains, workers then forget what was pending */
+  volatile u32 learner_epoch;
+
+  /* Learner statistics */
+  u64 n_events;
+  u64 n_applied;
+  u64 n_over_limit;
+  u64 n_batches;
+  u64 latency_sum;
+  u64 latency_max;
+  f64 stats_start_time;
+
   /* convenience variables */
   vlib_main_t *vlib_main;
   vnet_main_t *vnet_main;
 } l2learn_main_t;
 
 #define L2LEARN_DEFAULT_LIMIT (L2FIB_NUM_BUCKETS * 64)
+#define L2LEARN_DEFAULT_RING_SIZE 1024
 
 extern l2learn_main_t l2learn_main;
 
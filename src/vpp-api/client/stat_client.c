@@ -0,0 +1,378 @@
+/*
+ * stat_client.c - Library for access to VPP statistics segment
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/mman.h>
+#include <regex.h>
+#include <vppinfra/mem.h>
+#include <vppinfra/format.h>
+#include <vppinfra/socket.h>
+#include "stat_client.h"
+
+typedef struct
+{
+  u8 *base;
+  uword size;
+  stat_segment_shared_header_t *shared_header;
+} stat_client_main_t;
+
+stat_client_main_t stat_client_main;
+
+/*
+ * Anything read from the segment outside an access bracket may be stale,
+ * so only follow pointers which stay within the segment.
+ */
+static inline int
+stat_segment_pointer_ok (void *p, uword len)
+{
+  stat_client_main_t *sm = &stat_client_main;
+  u8 *q = p;
+
+  return (q >= sm->base && q + len <= sm->base + sm->size);
+}
+
+static inline int
+stat_segment_vec_ok (void *v, uword elt_size)
+{
+  if (!stat_segment_pointer_ok (_vec_find (v), sizeof (vec_header_t)))
+    return 0;
+  return stat_segment_pointer_ok (v, vec_len (v) * elt_size);
+}
+
+int
+stat_segment_connect (char *socket_name)
+{
+  stat_client_main_t *sm = &stat_client_main;
+  clib_socket_t s = { 0 };
+  ssvm_shared_header_t *sh;
+  clib_error_t *err;
+  u64 size;
+  int fd = -1;
+  void *p;
+
+  /* the library may be the first user of vppinfra in the process */
+  if (!clib_mem_get_heap ())
+    clib_mem_init (0, 64 << 20);
+
+  s.config = socket_name ? socket_name : STAT_SEGMENT_SOCKET_FILE;
+  s.flags = CLIB_SOCKET_F_IS_CLIENT | CLIB_SOCKET_F_SEQPACKET;
+  if ((err = clib_socket_init (&s)))
+    {
+      clib_error_report (err);
+      return -1;
+    }
+  err = clib_socket_recvmsg (&s, &size, sizeof (size), &fd, 1);
+  clib_socket_close (&s);
+  if (err || fd < 0)
+    {
+      clib_error_report (err);
+      return -1;
+    }
+
+  /* look at the header for the address the segment lives at... */
+  sh = mmap (0, clib_mem_get_page_size (), PROT_READ, MAP_SHARED, fd, 0);
+  if (sh == MAP_FAILED)
+    {
+      close (fd);
+      return -1;
+    }
+  p = uword_to_pointer (sh->ssvm_va, void *);
+  size = sh->ssvm_size;
+  munmap (sh, clib_mem_get_page_size ());
+
+  /* ...and map it, read-only, there */
+  sh = mmap (p, size, PROT_READ, MAP_SHARED, fd, 0);
+  close (fd);
+  if (sh == MAP_FAILED)
+    return -1;
+  if ((void *) sh != p)
+    {
+      clib_warning ("stat segment address 0x%lx not available",
+		    pointer_to_uword (p));
+      munmap (sh, size);
+      return -1;
+    }
+
+  sm->base = (u8 *) sh;
+  sm->size = size;
+  sm->shared_header = sh->opaque[STAT_SEGMENT_OPAQUE_HEADER];
+
+  if (!stat_segment_pointer_ok (sm->shared_header,
+				sizeof (*sm->shared_header)) ||
+      STAT_SEGMENT_VERSION != sm->shared_header->version)
+    {
+      clib_warning ("stat segment version mismatch");
+      stat_segment_disconnect ();
+      return -1;
+    }
+
+  return 0;
+}
+
+void
+stat_segment_disconnect (void)
+{
+  stat_client_main_t *sm = &stat_client_main;
+
+  if (sm->base)
+    munmap (sm->base, sm->size);
+  memset (sm, 0, sizeof (*sm));
+}
+
+u32 *
+stat_segment_ls (u8 ** patterns)
+{
+  stat_client_main_t *sm = &stat_client_main;
+  stat_segment_directory_entry_t *dir;
+  stat_segment_access_t sa;
+  regex_t *regexes = 0;
+  u32 *indices;
+  int i, j;
+
+  for (i = 0; i < vec_len (patterns); i++)
+    {
+      regex_t *r;
+
+      vec_add2 (regexes, r, 1);
+      if (regcomp (r, (char *) patterns[i], REG_EXTENDED | REG_NOSUB))
+	{
+	  clib_warning ("invalid pattern '%s'", patterns[i]);
+	  _vec_len (regexes) -= 1;
+	}
+    }
+
+  while (1)
+    {
+      indices = 0;
+      stat_segment_access_start (&sa, sm->shared_header);
+
+      dir = sm->shared_header->directory_vector;
+      if (stat_segment_vec_ok (dir, sizeof (*dir)))
+	for (i = 0; i < vec_len (dir); i++)
+	  {
+	    char name[STAT_SEGMENT_NAME_LEN];
+
+	    /* the entry may change under us; work on a terminated copy */
+	    clib_memcpy (name, dir[i].name, sizeof (name));
+	    name[sizeof (name) - 1] = 0;
+
+	    if (0 == vec_len (regexes))
+	      vec_add1 (indices, i);
+	    else
+	      for (j = 0; j < vec_len (regexes); j++)
+		if (0 == regexec (&regexes[j], name, 0, 0, 0))
+		  {
+		    vec_add1 (indices, i);
+		    break;
+		  }
+	  }
+
+      if (stat_segment_access_end (&sa, sm->shared_header))
+	break;
+      vec_free (indices);
+    }
+
+  for (i = 0; i < vec_len (regexes); i++)
+    regfree (&regexes[i]);
+  vec_free (regexes);
+
+  return indices;
+}
+
+/*
+ * Copy a vector of per-thread vectors out of the segment.
+ * @returns 0 if any of it is not where it should be
+ */
+static void **
+stat_segment_copy_counters (void **src, uword elt_size)
+{
+  void **dst = 0;
+  int i;
+
+  if (!stat_segment_vec_ok (src, sizeof (src[0])) || 0 == vec_len (src))
+    return 0;
+
+  vec_validate (dst, vec_len (src) - 1);
+  for (i = 0; i < vec_len (src); i++)
+    {
+      if (!stat_segment_vec_ok (src[i], elt_size))
+	{
+	  for (i--; i >= 0; i--)
+	    vec_free (dst[i]);
+	  vec_free (dst);
+	  return 0;
+	}
+      dst[i] = _vec_resize (0, vec_len (src[i]), vec_len (src[i]) * elt_size,
+			    0, 0);
+      clib_memcpy (dst[i], src[i], vec_len (src[i]) * elt_size);
+    }
+
+  return dst;
+}
+
+static int
+stat_segment_copy_entry (stat_segment_directory_entry_t * e,
+			 stat_segment_data_t * d)
+{
+  d->type = e->type;
+  d->name = (char *) format (0, "%s%c", e->name, 0);
+
+  switch (e->type)
+    {
+    case STAT_DIR_TYPE_SCALAR_POINTER:
+      d->scalar_value = e->scalar_value;
+      return 1;
+    case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
+      d->simple_counter_vec = (counter_t **)
+	stat_segment_copy_counters (e->data, sizeof (counter_t));
+      return (0 != d->simple_counter_vec);
+    case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
+      d->combined_counter_vec = (vlib_counter_t **)
+	stat_segment_copy_counters (e->data, sizeof (vlib_counter_t));
+      return (0 != d->combined_counter_vec);
+    default:
+      return 1;
+    }
+}
+
+stat_segment_data_t *
+stat_segment_dump (u32 * stats)
+{
+  stat_client_main_t *sm = &stat_client_main;
+  stat_segment_directory_entry_t *dir;
+  stat_segment_data_t *res;
+  stat_segment_access_t sa;
+  int i, ok;
+
+  if (0 == vec_len (stats))
+    return 0;
+
+  while (1)
+    {
+      res = 0;
+      ok = 1;
+      stat_segment_access_start (&sa, sm->shared_header);
+
+      dir = sm->shared_header->directory_vector;
+      ok = stat_segment_vec_ok (dir, sizeof (*dir));
+
+      vec_validate (res, vec_len (stats) - 1);
+      for (i = 0; ok && i < vec_len (stats); i++)
+	{
+	  /* the directory never shrinks, so this index is just bogus */
+	  if (stats[i] >= vec_len (dir))
+	    continue;
+	  ok = stat_segment_copy_entry (&dir[stats[i]], &res[i]);
+	}
+
+      if (stat_segment_access_end (&sa, sm->shared_header) && ok)
+	break;
+      stat_segment_data_free (res);
+    }
+
+  return res;
+}
+
+void
+stat_segment_data_free (stat_segment_data_t * res)
+{
+  stat_segment_data_t *d;
+  int i;
+
+  vec_foreach (d, res)
+  {
+    switch (d->type)
+      {
+      case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
+	for (i = 0; i < vec_len (d->simple_counter_vec); i++)
+	  vec_free (d->simple_counter_vec[i]);
+	vec_free (d->simple_counter_vec);
+	break;
+      case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
+	for (i = 0; i < vec_len (d->combined_counter_vec); i++)
+	  vec_free (d->combined_counter_vec[i]);
+	vec_free (d->combined_counter_vec);
+	break;
+      default:
+	break;
+      }
+    vec_free (d->name);
+  }
+  vec_free (res);
+}
+
+int
+stat_segment_vec_len (void *vec)
+{
+  return vec_len (vec);
+}
+
+f64
+stat_segment_heartbeat (void)
+{
+  u8 **patterns = 0;
+  stat_segment_data_t *res;
+  u32 *stats;
+  f64 heartbeat = 0.0;
+
+  vec_add1 (patterns, (u8 *) "^/sys/last_update$");
+  stats = stat_segment_ls (patterns);
+  res = stat_segment_dump (stats);
+  if (vec_len (res))
+    heartbeat = res[0].scalar_value;
+
+  stat_segment_data_free (res);
+  vec_free (stats);
+  vec_free (patterns);
+
+  return heartbeat;
+}
+
+counter_t
+stat_segment_simple_counter_sum (counter_t ** counters, u32 index)
+{
+  counter_t sum = 0;
+  int i;
+
+  for (i = 0; i < vec_len (counters); i++)
+    if (index < vec_len (counters[i]))
+      sum += counters[i][index];
+
+  return sum;
+}
+
+void
+stat_segment_combined_counter_sum (vlib_counter_t ** counters, u32 index,
+				   vlib_counter_t * result)
+{
+  int i;
+
+  result->packets = result->bytes = 0;
+  for (i = 0; i < vec_len (counters); i++)
+    if (index < vec_len (counters[i]))
+      {
+	result->packets += counters[i][index].packets;
+	result->bytes += counters[i][index].bytes;
+      }
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
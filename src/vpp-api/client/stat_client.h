@@ -0,0 +1,68 @@
+/*
+ * stat_client.h - Library for access to VPP statistics segment
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef included_stat_client_h
+#define included_stat_client_h
+
+#include <vpp/stats/stat_segment.h>
+
+/** A consistent copy of one directory entry and the data it refers to */
+typedef struct
+{
+  char *name;
+  stat_directory_type_t type;
+  union
+  {
+    f64 scalar_value;
+    counter_t **simple_counter_vec;	/**< [thread][index] */
+    vlib_counter_t **combined_counter_vec;	/**< [thread][index] */
+  };
+} stat_segment_data_t;
+
+/** Map the stats segment vpp hands out on socket_name
+    (STAT_SEGMENT_SOCKET_FILE if 0). @returns 0 on success */
+int stat_segment_connect (char *socket_name);
+void stat_segment_disconnect (void);
+
+/** @returns vector of the directory indices of the entries whose name
+    matches any of the (regex) patterns, or all entries if there are none */
+u32 *stat_segment_ls (u8 ** patterns);
+
+/** @returns vector of copies of the given entries, taken in one
+    consistent snapshot; free with stat_segment_data_free */
+stat_segment_data_t *stat_segment_dump (u32 * stats);
+void stat_segment_data_free (stat_segment_data_t * res);
+
+/** vec_len, for users without vppinfra of their own */
+int stat_segment_vec_len (void *vec);
+
+/** @returns the time vpp last updated the segment's scalars */
+f64 stat_segment_heartbeat (void);
+
+/** Sum of the per-thread values of a counter */
+counter_t stat_segment_simple_counter_sum (counter_t ** counters, u32 index);
+void stat_segment_combined_counter_sum (vlib_counter_t ** counters,
+					u32 index, vlib_counter_t * result);
+
+#endif /* included_stat_client_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
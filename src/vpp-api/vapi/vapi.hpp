@@ -26,6 +26,9 @@
 #include <functional>
 #include <algorithm>
 #include <atomic>
+#include <future>
+#include <memory>
+#include <thread>
 #include <vppinfra/types.h>
 #include <vapi/vapi.h>
 #include <vapi/vapi_internal.h>
@@ -103,10 +106,23 @@ public:
     return response_state;
   }
 
+  /**
+   * @brief get a future which becomes ready once the response has been
+   * received and the callback (if any) has run
+   *
+   * @note not applicable to event registrations
+   */
+  std::shared_future<vapi_error_e> get_future () const
+  {
+    return completed;
+  }
+
 private:
   Connection &con;
   Common_req (Connection &con)
-      : con (con), context{0}, response_state{RESPONSE_NOT_READY}
+      : con (con), context{0}, response_state{RESPONSE_NOT_READY},
+        completion{std::make_shared<std::promise<vapi_error_e>> ()},
+        completed{completion->get_future ().share ()}
   {
   }
 
@@ -129,7 +145,9 @@ private:
   }
 
   u32 context;
-  vapi_response_state_e response_state;
+  std::atomic<vapi_response_state_e> response_state;
+  std::shared_ptr<std::promise<vapi_error_e>> completion;
+  std::shared_future<vapi_error_e> completed;
 
   friend class Connection;
 
@@ -153,7 +171,9 @@ private:
 class Connection
 {
 public:
-  Connection (void) : vapi_ctx{0}, event_count{0}
+  Connection (void)
+      : vapi_ctx{0}, req_context_counter{0}, pending_mask{0},
+        pending_count{0}, event_count{0}, rx_running{false}
   {
 
     vapi_error_e rv = VAPI_OK;
@@ -164,13 +184,19 @@ public:
             throw std::bad_alloc ();
           }
       }
-    events.reserve (vapi_get_message_count () + 1);
+    n_events = vapi_get_message_count () + 1;
+    events.reset (new std::atomic<Common_req *>[n_events]);
+    for (size_t i = 0; i < n_events; ++i)
+      {
+        events[i] = nullptr;
+      }
   }
 
   Connection (const Connection &) = delete;
 
   ~Connection (void)
   {
+    stop_rx_thread ();
     vapi_ctx_free (vapi_ctx);
 #if VAPI_CPP_DEBUG_LEAKS
     for (auto x : shm_data_set)
@@ -201,9 +227,27 @@ public:
   vapi_error_e connect (const char *name, const char *chroot_prefix,
                         int max_outstanding_requests, int response_queue_size)
   {
-    return vapi_connect (vapi_ctx, name, chroot_prefix,
-                         max_outstanding_requests, response_queue_size,
-                         VAPI_MODE_BLOCKING);
+    vapi_error_e rv = vapi_connect (vapi_ctx, name, chroot_prefix,
+                                    max_outstanding_requests,
+                                    response_queue_size, VAPI_MODE_BLOCKING);
+    if (VAPI_OK == rv)
+      {
+        /* twice the outstanding requests, rounded up to a power of 2, so
+         * a free slot is almost always found at the first attempt */
+        u32 size = 1;
+        while (size < 2 * static_cast<u32> (max_outstanding_requests))
+          {
+            size <<= 1;
+          }
+        pending.reset (new std::atomic<Common_req *>[size]);
+        for (u32 i = 0; i < size; ++i)
+          {
+            pending[i] = nullptr;
+          }
+        pending_mask = size - 1;
+        pending_count = 0;
+      }
+    return rv;
   }
 
   /**
@@ -213,16 +257,61 @@ public:
    */
   vapi_error_e disconnect ()
   {
-    auto x = requests.size ();
-    while (x > 0)
+    stop_rx_thread ();
+    if (pending)
       {
-        VAPI_DBG ("popping request @%p", requests.front ());
-        requests.pop_front ();
-        --x;
+        for (u32 i = 0; i <= pending_mask; ++i)
+          {
+            if (pending[i])
+              {
+                VAPI_DBG ("dropping request @%p", pending[i].load ());
+                pending[i] = nullptr;
+              }
+          }
+        pending_count = 0;
       }
     return vapi_disconnect (vapi_ctx);
   };
 
+  /**
+   * @brief start a thread which receives and dispatches all messages from
+   * vpp
+   *
+   * While the thread runs, wait_for_response() blocks on the request's
+   * future instead of dispatching, so any number of threads may execute
+   * requests and wait for their responses concurrently. Callbacks are
+   * invoked from the receive thread.
+   *
+   * @return VAPI_OK on success, other error code on error
+   */
+  vapi_error_e start_rx_thread ()
+  {
+    if (rx_running)
+      {
+        return VAPI_EINVAL;
+      }
+    rx_running = true;
+    rx_thread = std::thread ([this]() {
+      while (rx_running)
+        {
+          dispatch (nullptr, 1);
+        }
+    });
+    return VAPI_OK;
+  }
+
+  /**
+   * @brief stop the receive thread, if running
+   */
+  void stop_rx_thread ()
+  {
+    if (rx_running)
+      {
+        rx_running = false;
+        rx_thread.join ();
+      }
+  }
+
   /**
    * @brief get event file descriptor
    *
@@ -263,8 +352,6 @@ public:
 #if VAPI_CPP_DEBUG_LEAKS
         on_shm_data_alloc (shm_data);
 #endif
-        std::lock_guard<std::recursive_mutex> requests_lock (requests_mutex);
-        std::lock_guard<std::recursive_mutex> events_lock (events_mutex);
         vapi_msg_id_t id = vapi_lookup_vapi_msg_id_t (
             vapi_ctx, be16toh (*static_cast<u16 *> (shm_data)));
         bool has_context = vapi_msg_is_with_context (id);
@@ -274,30 +361,47 @@ public:
           {
             u32 context = *reinterpret_cast<u32 *> (
                 (static_cast<u8 *> (shm_data) + vapi_get_context_offset (id)));
-            const auto x = requests.front ();
-            matching_req = x;
-            if (context == x->context)
+            std::atomic<Common_req *> &slot = pending[context & pending_mask];
+            /* marking the slot busy keeps the owner from destroying the
+             * request while it is used here */
+            Common_req *x = claim_slot (slot);
+            if (x && context == x->context)
               {
+                auto completion = x->completion;
+                matching_req = x;
                 std::tie (rv, break_dispatch) =
                     x->assign_response (id, shm_data);
+                if (break_dispatch)
+                  {
+                    /* the owner may destroy the request from here on */
+                    --pending_count;
+                    slot = nullptr;
+                    completion->set_value (rv);
+                  }
+                else
+                  {
+                    slot = x;
+                  }
               }
             else
               {
-                std::tie (rv, break_dispatch) =
-                    x->assign_response (id, nullptr);
-              }
-            if (break_dispatch)
-              {
-                requests.pop_front ();
+                /* the request was abandoned before the response came */
+                if (x)
+                  {
+                    slot = x;
+                  }
+                msg_free (shm_data);
               }
           }
         else
           {
-            if (events[id])
+            Common_req *x = id < n_events ? claim_slot (events[id]) : nullptr;
+            if (x)
               {
                 std::tie (rv, break_dispatch) =
-                    events[id]->assign_response (id, shm_data);
-                matching_req = events[id];
+                    x->assign_response (id, shm_data);
+                matching_req = x;
+                events[id] = x;
               }
             else
               {
@@ -309,7 +413,7 @@ public:
           {
             return rv;
           }
-        loop_again = !requests.empty () || (event_count > 0);
+        loop_again = (pending_count > 0) || (event_count > 0);
       }
     return rv;
   }
@@ -335,6 +439,15 @@ public:
       {
         return VAPI_OK;
       }
+    if (rx_running)
+      {
+        auto f = req.get_future ();
+        if (std::future_status::ready != f.wait_for (std::chrono::seconds (5)))
+          {
+            return VAPI_ENORESP;
+          }
+        return f.get ();
+      }
     return dispatch (req);
   }
 
@@ -356,17 +469,17 @@ private:
       {
         return VAPI_EINVAL;
       }
-    u32 req_context =
-        req_context_counter.fetch_add (1, std::memory_order_relaxed);
+    u32 req_context;
+    if (!reserve_context (req, req_context))
+      {
+        return VAPI_EAGAIN;
+      }
     req->request.shm_data->header.context = req_context;
     vapi_swap_to_be<Req> (req->request.shm_data);
-    std::lock_guard<std::recursive_mutex> lock (requests_mutex);
     vapi_error_e rv = vapi_send (vapi_ctx, req->request.shm_data);
     if (VAPI_OK == rv)
       {
         VAPI_DBG ("Push %p", req);
-        requests.emplace_back (req);
-        req->set_context (req_context);
 #if VAPI_CPP_DEBUG_LEAKS
         on_shm_data_free (req->request.shm_data);
 #endif
@@ -374,6 +487,7 @@ private:
       }
     else
       {
+        release_context (req_context, req);
         vapi_swap_to_host<Req> (req->request.shm_data);
       }
     return rv;
@@ -388,18 +502,18 @@ private:
       {
         return VAPI_EINVAL;
       }
-    u32 req_context =
-        req_context_counter.fetch_add (1, std::memory_order_relaxed);
+    u32 req_context;
+    if (!reserve_context (req, req_context))
+      {
+        return VAPI_EAGAIN;
+      }
     req->request.shm_data->header.context = req_context;
     vapi_swap_to_be<Req> (req->request.shm_data);
-    std::lock_guard<std::recursive_mutex> lock (requests_mutex);
     vapi_error_e rv = vapi_send_with_control_ping (
         vapi_ctx, req->request.shm_data, req_context);
     if (VAPI_OK == rv)
       {
         VAPI_DBG ("Push %p", req);
-        requests.emplace_back (req);
-        req->set_context (req_context);
 #if VAPI_CPP_DEBUG_LEAKS
         on_shm_data_free (req->request.shm_data);
 #endif
@@ -407,21 +521,108 @@ private:
       }
     else
       {
+        release_context (req_context, req);
         vapi_swap_to_host<Req> (req->request.shm_data);
       }
     return rv;
   }
 
+  /**
+   * Allocate a context for the request and claim its slot in the pending
+   * table. Contexts whose slot is still held by an earlier request are
+   * skipped, so a claimed slot identifies a single request. Fails if every
+   * slot is taken.
+   */
+  bool reserve_context (Common_req *req, u32 &context)
+  {
+    if (!pending)
+      {
+        return false;
+      }
+    for (u32 i = 0; i <= pending_mask; ++i)
+      {
+        Common_req *expected = nullptr;
+        context = req_context_counter.fetch_add (1, std::memory_order_relaxed);
+        req->set_context (context);
+        if (pending[context & pending_mask].compare_exchange_strong (expected,
+                                                                     req))
+          {
+            ++pending_count;
+            return true;
+          }
+      }
+    return false;
+  }
+
+  /**
+   * The value of a pending or event slot whose request is in use by
+   * dispatch()
+   */
+  static Common_req *busy_marker ()
+  {
+    static char busy;
+    return reinterpret_cast<Common_req *> (&busy);
+  }
+
+  /**
+   * Take the request out of its slot, leaving the busy marker, so it is
+   * not destroyed whilst in use. The caller puts it back, or clears the
+   * slot, when done. Returns null if the slot holds no request.
+   */
+  static Common_req *claim_slot (std::atomic<Common_req *> &slot)
+  {
+    Common_req *x = slot.load ();
+    while (x && x != busy_marker ())
+      {
+        if (slot.compare_exchange_weak (x, busy_marker ()))
+          {
+            return x;
+          }
+      }
+    return nullptr;
+  }
+
+  /**
+   * Clear the slot if it holds the request, waiting for dispatch() to be
+   * done with it first. Returns false if the slot holds another request.
+   */
+  static bool release_slot (std::atomic<Common_req *> &slot, Common_req *req)
+  {
+    for (;;)
+      {
+        Common_req *expected = req;
+        if (slot.compare_exchange_strong (expected, nullptr))
+          {
+            return true;
+          }
+        if (expected != busy_marker ())
+          {
+            return false;
+          }
+        std::this_thread::yield ();
+      }
+  }
+
+  /**
+   * Release the slot of the request's context, if the request still
+   * holds it
+   */
+  void release_context (u32 context, Common_req *req)
+  {
+    if (pending && release_slot (pending[context & pending_mask], req))
+      {
+        --pending_count;
+      }
+  }
+
   void unregister_request (Common_req *request)
   {
-    std::lock_guard<std::recursive_mutex> lock (requests_mutex);
-    std::remove (requests.begin (), requests.end (), request);
+    release_context (request->get_context (), request);
   }
 
   template <typename M> void register_event (Event_registration<M> *event)
   {
     const vapi_msg_id_t id = M::get_msg_id ();
-    std::lock_guard<std::recursive_mutex> lock (events_mutex);
     events[id] = event;
     ++event_count;
   }
@@ -429,20 +630,28 @@ private:
   template <typename M> void unregister_event (Event_registration<M> *event)
   {
     const vapi_msg_id_t id = M::get_msg_id ();
-    std::lock_guard<std::recursive_mutex> lock (events_mutex);
-    events[id] = nullptr;
-    --event_count;
+    if (release_slot (events[id], event))
+      {
+        --event_count;
+      }
   }
 
   vapi_ctx_t vapi_ctx;
-  std::atomic_ulong req_context_counter;
+  std::atomic<u32> req_context_counter;
   std::mutex dispatch_mutex;
 
-  std::recursive_mutex requests_mutex;
-  std::recursive_mutex events_mutex;
-  std::deque<Common_req *> requests;
-  std::vector<Common_req *> events;
-  int event_count;
+  /* requests awaiting a response, indexed by context */
+  std::unique_ptr<std::atomic<Common_req *>[]> pending;
+  u32 pending_mask;
+  std::atomic<int> pending_count;
+
+  /* event registrations, indexed by message id */
+  std::unique_ptr<std::atomic<Common_req *>[]> events;
+  size_t n_events;
+  std::atomic<int> event_count;
+
+  std::atomic<bool> rx_running;
+  std::thread rx_thread;
 
   template <typename Req, typename Resp, typename... Args>
   friend class Request;
@@ -544,7 +753,6 @@ public:
     return shm_data->payload;
   }
 
-private:
   Msg (Msg<M> &&msg) : con{msg.con}
   {
     VAPI_DBG ("Move construct Msg<%s> from msg@%p to msg@%p, shm_data@%p",
@@ -553,6 +761,7 @@ private:
     msg.shm_data = nullptr;
   }
 
+private:
   Msg<M> &operator= (Msg<M> &&msg)
   {
     VAPI_DBG ("Move assign Msg<%s> from msg@%p to msg@%p, shm_data@%p",
@@ -653,10 +862,9 @@ public:
 
   virtual ~Request ()
   {
-    if (RESPONSE_NOT_READY == get_response_state ())
-      {
-        con.unregister_request (this);
-      }
+    /* waits for the rx thread, should it be assigning the response;
+     * so it must not be destroyed from its own callback */
+    con.unregister_request (this);
   }
 
   vapi_error_e execute ()
@@ -795,6 +1003,9 @@ public:
 
   virtual ~Dump ()
   {
+    /* waits for the rx thread, should it be assigning a response;
+     * so it must not be destroyed from its own callback */
+    con.unregister_request (this);
   }
 
   virtual std::tuple<vapi_error_e, bool> assign_response (vapi_msg_id_t id,
@@ -811,6 +1022,16 @@ public:
           }
         return std::make_pair (VAPI_OK, true);
       }
+    else if (nullptr != record_callback)
+      {
+        if (id != Msg<resp_type>::get_msg_id ())
+          {
+            throw Unexpected_msg_id_exception ();
+          }
+        vapi_swap_to_host<resp_type> (static_cast<resp_type *> (shm_data));
+        Msg<resp_type> record{con, shm_data};
+        return std::make_pair (record_callback (record), false);
+      }
     else
       {
         result_set.assign_response (id, shm_data);
@@ -835,10 +1056,28 @@ public:
     return result_set;
   }
 
+  /**
+   * @brief stream the responses instead of collecting them in the result set
+   *
+   * Each response is converted to host byte order in place and passed to
+   * the callback as soon as it is received - the result set stays empty.
+   * The message is freed when the callback returns, unless the callback
+   * moves it out, so the memory held by the dump no longer grows with the
+   * number of responses. Must be set before calling execute ().
+   *
+   * @param record_callback callback invoked for each response
+   */
+  void set_record_callback (
+      std::function<vapi_error_e (Msg<resp_type> &)> record_callback)
+  {
+    this->record_callback = record_callback;
+  }
+
 private:
   Msg<Req> request;
   Result_set<resp_type> result_set;
   std::function<vapi_error_e (Dump<Req, Resp, Args...> &)> callback;
+  std::function<vapi_error_e (Msg<resp_type> &)> record_callback;
 
   friend class Connection;
 };
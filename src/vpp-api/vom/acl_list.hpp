@@ -16,6 +16,7 @@
 #ifndef __VOM_ACL_LIST_H__
 #define __VOM_ACL_LIST_H__
 
+#include <mutex>
 #include <set>
 
 #include "vom/acl_l2_rule.hpp"
@@ -134,6 +135,8 @@ public:
 
   static std::shared_ptr<list> find(const handle_t& handle)
   {
+    std::lock_guard<std::mutex> lg(m_hdl_db_lock);
+
     return (m_hdl_db[handle].lock());
   }
 
@@ -147,12 +150,16 @@ public:
     std::shared_ptr<list> sp = find(key);
 
     if (sp && item) {
+      std::lock_guard<std::mutex> lg(m_hdl_db_lock);
+
       m_hdl_db[item.data()] = sp;
     }
   }
 
   static void remove(const HW::item<handle_t>& item)
   {
+    std::lock_guard<std::mutex> lg(m_hdl_db_lock);
+
     m_hdl_db.erase(item.data());
   }
 
@@ -258,6 +265,12 @@ private:
    */
   static std::map<handle_t, std::weak_ptr<list>> m_hdl_db;
 
+  /**
+   * Lock protecting the handle DB. ACLs may be created from several
+   * threads when the command Q is pipelined.
+   */
+  static std::mutex m_hdl_db_lock;
+
   /**
    * The Key is a user defined identifer for this ACL
    */
@@ -291,6 +304,9 @@ singular_db<typename ACL::list<RULE>::key_t, ACL::list<RULE>> list<RULE>::m_db;
 template <typename RULE>
 std::map<handle_t, std::weak_ptr<ACL::list<RULE>>> list<RULE>::m_hdl_db;
 
+template <typename RULE>
+std::mutex list<RULE>::m_hdl_db_lock;
+
 template <typename RULE>
 typename ACL::list<RULE>::event_handler list<RULE>::m_evh;
 };
@@ -57,6 +57,18 @@ public:
    */
   virtual void succeeded() = 0;
 
+  /**
+   * The handle this command will obtain from VPP, if any. Used by a
+   * pipelined command Q to order commands across objects.
+   */
+  virtual const handle_t* provides() const { return (nullptr); }
+
+  /**
+   * The handle, obtained by another object's command, that must be
+   * known before this command can be issued, if any.
+   */
+  virtual const handle_t* needs() const { return (nullptr); }
+
   /**
    * convert to string format for debug purposes
    */
@@ -18,6 +18,8 @@
 #include "vom/connection.hpp"
 
 namespace VOM {
+const unsigned int connection::max_outstanding = 128;
+
 connection::connection()
   : m_vapi_conn(new vapi::Connection())
   , m_app_name("VOM")
@@ -41,7 +43,7 @@ connection::connect()
 
   rv = m_vapi_conn->connect(m_app_name.c_str(),
                             NULL, // m_api_prefix.c_str(),
-                            128, 128);
+                            max_outstanding, 128);
   return rv;
 }
 
@@ -58,6 +58,11 @@ public:
    */
   vapi::Connection& ctx();
 
+  /**
+   * The maximum number of requests that can be outstanding to VPP
+   */
+  static const unsigned int max_outstanding;
+
 private:
   /**
    * The VAPI connection context
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2017 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vom/dump_cmd.hpp"
+
+namespace VOM {
+std::mutex dump_stream::m_lock;
+std::set<dump_stream*> dump_stream::m_streams;
+std::atomic<unsigned int> dump_stream::m_waiters(0);
+
+dump_stream::waiter::waiter(dump_stream* self)
+{
+  std::lock_guard<std::mutex> lg(m_lock);
+
+  /*
+   * count the waiter before waking the readers so they see it
+   */
+  m_waiters++;
+
+  for (auto s : m_streams) {
+    if (s != self)
+      s->wake();
+  }
+}
+
+dump_stream::waiter::~waiter()
+{
+  m_waiters--;
+}
+
+void
+dump_stream::open(dump_stream* s)
+{
+  std::lock_guard<std::mutex> lg(m_lock);
+
+  m_streams.insert(s);
+}
+
+void
+dump_stream::close(dump_stream* s)
+{
+  std::lock_guard<std::mutex> lg(m_lock);
+
+  m_streams.erase(s);
+}
+
+bool
+dump_stream::waiting()
+{
+  return (0 != m_waiters);
+}
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "mozilla")
+ * End:
+ */
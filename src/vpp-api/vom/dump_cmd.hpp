@@ -16,7 +16,11 @@
 #ifndef __VOM_DUMP_CMD_H__
 #define __VOM_DUMP_CMD_H__
 
-#include <future>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
 
 #include "vom/cmd.hpp"
 #include "vom/hw.hpp"
@@ -29,43 +33,212 @@ namespace VOM {
  */
 typedef unsigned int (*get_msg_size_t)(void*);
 
+/**
+ * The flow control shared by all dump commands whose records are being
+ * streamed.
+ * The records of a dump are handed from the thread reading from VPP to
+ * the client as they arrive. When the client falls behind, the reader
+ * blocks until it catches up, so the memory held does not grow with the
+ * size of the table. But the reader also serves every other command; a
+ * client that, mid-way through one dump, waits for the reply to another
+ * command (e.g. dumping the addresses of each interface as it is read)
+ * would then wait forever. So whilst any thread waits for a reply the
+ * reader is never blocked; the dump's records queue instead.
+ */
+class dump_stream
+{
+public:
+  /**
+   * Marks the calling thread as waiting for a reply from VPP for as long
+   * as the object lives
+   */
+  class waiter
+  {
+  public:
+    /**
+     * Constructor. A stream the thread waits on itself need not be woken.
+     */
+    waiter(dump_stream* self = nullptr);
+
+    /**
+     * Destructor
+     */
+    ~waiter();
+  };
+
+protected:
+  /**
+   * Destructor
+   */
+  virtual ~dump_stream() = default;
+
+  /**
+   * Add a stream to the set whose reader is woken when a thread waits
+   */
+  static void open(dump_stream* s);
+
+  /**
+   * Remove a stream from the set
+   */
+  static void close(dump_stream* s);
+
+  /**
+   * Is any thread waiting for a reply
+   */
+  static bool waiting();
+
+  /**
+   * Wake the reader if it is blocked on this stream
+   */
+  virtual void wake() = 0;
+
+private:
+  /**
+   * Lock protecting the set of open streams
+   */
+  static std::mutex m_lock;
+
+  /**
+   * The open streams
+   */
+  static std::set<dump_stream*> m_streams;
+
+  /**
+   * The number of threads waiting for a reply
+   */
+  static std::atomic<unsigned int> m_waiters;
+};
+
 /**
  * A base class for VPP dump commands.
  * Dump commands are one of the sub-set of command types to VPP. Here the
- * client
- * makes a read request on the resource and VPP responds with all the
- * records.
- * This command is executed synchronously. Once complete the client can
- * 'pop'
- * the records from the command object
+ * client makes a read request on the resource and VPP responds with all
+ * the records.
+ * The records are streamed; issuing the command does not wait for them.
+ * The client reads each record once, in order, by iterating over the
+ * command object. Each record is released as the iteration moves past it.
  */
 template <typename MSG>
-class dump_cmd : public cmd
+class dump_cmd : public cmd, public dump_stream
 {
 public:
-  typedef MSG msg_t;
   typedef typename MSG::resp_type record_t;
 
-  typedef typename vapi::Result_set<typename MSG::resp_type>::const_iterator
-    const_iterator;
+  /**
+   * A record in shared memory
+   */
+  typedef vapi::Msg<record_t> record_msg_t;
+
+  /**
+   * The VAPI dump message, which passes its records to the command
+   */
+  class msg_t : public MSG
+  {
+  public:
+    /**
+     * Constructor taking the command to which the records are passed
+     */
+    template <typename CMD>
+    msg_t(vapi::Connection& con, std::reference_wrapper<CMD> cmd)
+      : MSG(con, cmd)
+    {
+      dump_cmd& d = cmd.get();
+
+      this->set_record_callback(
+        [&d](record_msg_t& rec) { return (d.push(rec)); });
+      dump_stream::open(&d);
+    }
+  };
+
+  /**
+   * Input iterator over the records as they arrive
+   */
+  class const_iterator
+  {
+  public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef record_msg_t value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const record_msg_t* pointer;
+    typedef const record_msg_t& reference;
+
+    /**
+     * Constructor; the end iterator when no command is given
+     */
+    const_iterator(dump_cmd* d = nullptr)
+      : m_cmd(d)
+    {
+      if (m_cmd && !m_cmd->next(false))
+        m_cmd = nullptr;
+    }
+
+    reference operator*() const { return (m_cmd->m_records.front()); }
+
+    pointer operator->() const { return (&m_cmd->m_records.front()); }
+
+    /**
+     * Release the current record and move to the next
+     */
+    const_iterator& operator++()
+    {
+      if (!m_cmd->next(true))
+        m_cmd = nullptr;
+      return (*this);
+    }
+
+    bool operator==(const const_iterator& i) const
+    {
+      return (m_cmd == i.m_cmd);
+    }
+
+    bool operator!=(const const_iterator& i) const
+    {
+      return (m_cmd != i.m_cmd);
+    }
+
+  private:
+    /**
+     * The command whose records are iterated; null at the end
+     */
+    dump_cmd* m_cmd;
+  };
 
   /**
    * Default Constructor
    */
   dump_cmd()
     : cmd()
+    , m_complete(false)
+    , m_abandoned(false)
   {
   }
 
   /**
    * Destructor
    */
-  virtual ~dump_cmd() {}
+  virtual ~dump_cmd()
+  {
+    if (m_dump) {
+      std::unique_lock<std::mutex> lock(m_records_lock);
+
+      /*
+       * drop the records the client did not read and let the dump run to
+       * completion, so VAPI no longer refers to it
+       */
+      m_abandoned = true;
+      m_records.clear();
+      m_cond.notify_all();
+      m_cond.wait_for(lock, std::chrono::seconds(5),
+                      [this] { return (m_complete); });
+    }
+    dump_stream::close(this);
+  }
 
   dump_cmd(const dump_cmd& d) = default;
 
   /**
-   * Constant iterator to the start of the records retunred during the dump
+   * Constant iterator to the first record not yet read.
+   * This waits for the record to arrive.
    */
   const_iterator begin()
   {
@@ -74,43 +247,30 @@ public:
      */
     if (!m_dump)
       return const_iterator();
-    return (m_dump->get_result_set().begin());
+    return (const_iterator(this));
   }
 
   /**
-   * Constant iterator to the end of the records retunred during the dump
+   * Constant iterator to the end of the records returned during the dump
    */
-  const_iterator end()
-  {
-    if (!m_dump)
-      return const_iterator();
-    return (m_dump->get_result_set().end());
-  }
+  const_iterator end() { return const_iterator(); }
 
   /**
-   * Wait for the issue of the command to complete
+   * Wait for the issue of the command to complete.
+   * The records are streamed to the iterator, which applies the timeout
+   * between records, so there is nothing to wait for here.
    */
-  rc_t wait()
-  {
-    std::future_status status;
-    std::future<rc_t> result;
-
-    result = m_promise.get_future();
-    status = result.wait_for(std::chrono::seconds(5));
-
-    if (status != std::future_status::ready) {
-      return (rc_t::TIMEOUT);
-    }
-
-    return (result.get());
-  }
+  rc_t wait() { return (rc_t::OK); }
 
   /**
    * Call operator called when the dump is complete
    */
   vapi_error_e operator()(MSG& d)
   {
-    m_promise.set_value(rc_t::OK);
+    std::lock_guard<std::mutex> lg(m_records_lock);
+
+    m_complete = true;
+    m_cond.notify_all();
 
     return (VAPI_OK);
   }
@@ -121,12 +281,6 @@ public:
   virtual void retire(connection& con) {}
 
 protected:
-  /**
-   * The underlying promise that implements the synchornous nature
-   * of the command issue
-   */
-  std::promise<rc_t> m_promise;
-
   /**
    * Dump commands should not be issued whilst the HW is disabled
    */
@@ -141,6 +295,96 @@ protected:
    * The VAPI event registration
    */
   std::unique_ptr<MSG> m_dump;
+
+private:
+  /**
+   * The number of unread records at which the reader is blocked
+   */
+  static const size_t max_records = 1024;
+
+  /**
+   * Called by the reader thread with each record received
+   */
+  vapi_error_e push(record_msg_t& rec)
+  {
+    std::unique_lock<std::mutex> lock(m_records_lock);
+
+    m_cond.wait(lock, [this] {
+      return (m_abandoned || m_records.size() < max_records ||
+              dump_stream::waiting());
+    });
+    if (!m_abandoned)
+      m_records.emplace_back(std::move(rec));
+    m_cond.notify_all();
+
+    return (VAPI_OK);
+  }
+
+  /**
+   * Wait for the next record, optionally releasing the current one first.
+   * Returns false when there are no more records.
+   */
+  bool next(bool release)
+  {
+    std::unique_lock<std::mutex> lock(m_records_lock);
+
+    if (release) {
+      m_records.pop_front();
+      m_cond.notify_all();
+    }
+    if (m_records.empty() && !m_complete) {
+      /*
+       * the waiter wakes the other streams under their own locks, so it
+       * is made without holding this one's; a thread waiting on another
+       * stream does the same the other way round
+       */
+      lock.unlock();
+      dump_stream::waiter w(this);
+      lock.lock();
+
+      m_cond.wait_for(lock, std::chrono::seconds(5), [this] {
+        return (!m_records.empty() || m_complete);
+      });
+    }
+
+    return (!m_records.empty());
+  }
+
+  /**
+   * Wake the reader if it is blocked on this stream
+   */
+  void wake()
+  {
+    std::lock_guard<std::mutex> lg(m_records_lock);
+
+    m_cond.notify_all();
+  }
+
+  /**
+   * The records received and not yet read. The front is the record the
+   * iterator refers to
+   */
+  std::deque<record_msg_t> m_records;
+
+  /**
+   * Lock protecting the records and completion state
+   */
+  std::mutex m_records_lock;
+
+  /**
+   * Signalled as records are added, read, or the dump completes
+   */
+  std::condition_variable m_cond;
+
+  /**
+   * Has VPP sent all the records
+   */
+  bool m_complete;
+
+  /**
+   * Has the client stopped reading
+   */
+  bool m_abandoned;
 };
 };
 
@@ -13,16 +13,32 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <vector>
+
 #include "vom/hw.hpp"
 #include "vom/hw_cmds.hpp"
 #include "vom/logger.hpp"
 
 namespace VOM {
 HW::cmd_q::cmd_q()
-  : m_enabled(true)
+  : m_window(1)
+  , m_enabled(true)
+  , m_connected(false)
+  , m_conn()
+{
+}
+
+HW::cmd_q::cmd_q(unsigned int window)
+  : m_window(1)
+  , m_enabled(true)
   , m_connected(false)
   , m_conn()
 {
+  this->window(window);
 }
 
 HW::cmd_q::~cmd_q()
@@ -51,13 +67,16 @@ HW::cmd_q::enqueue(cmd* c)
 {
   std::shared_ptr<cmd> sp(c);
 
-  m_queue.push_back(sp);
+  enqueue(sp);
 }
 
 void
 HW::cmd_q::enqueue(std::shared_ptr<cmd> c)
 {
-  m_queue.push_back(c);
+  if (m_queue.empty())
+    m_queue.emplace_back();
+
+  m_queue.back().push_back(c);
 }
 
 void
@@ -66,11 +85,29 @@ HW::cmd_q::enqueue(std::queue<cmd*>& cmds)
   while (cmds.size()) {
     std::shared_ptr<cmd> sp(cmds.front());
 
-    m_queue.push_back(sp);
+    enqueue(sp);
     cmds.pop();
   }
 }
 
+void
+HW::cmd_q::sequence()
+{
+  if (m_queue.empty() || !m_queue.back().empty())
+    m_queue.emplace_back();
+}
+
+void
+HW::cmd_q::window(unsigned int n)
+{
+  /*
+   * each in-flight sequence has at most one request outstanding,
+   * so the window is bounded by the number of outstanding requests
+   * the connection allows
+   */
+  m_window = std::max(1u, std::min(n, connection::max_outstanding));
+}
+
 bool
 HW::cmd_q::connect()
 {
@@ -119,51 +156,133 @@ HW::cmd_q::write()
 {
   rc_t rc = rc_t::OK;
 
+  if (!m_enabled) {
+    /*
+     * The HW is disabled, so set each command as succeeded
+     */
+    for (auto& seq : m_queue) {
+      for (auto& c : seq) {
+        VOM_LOG(log_level_t::DEBUG) << *c;
+        c->succeeded();
+      }
+    }
+  } else if (1 == m_window || m_queue.size() < 2) {
+    rc = write_serial();
+  } else {
+    rc = write_pipelined();
+  }
+
   /*
-   * The queue is enabled, Execute each command in the queue.
-   * If one execution fails, abort the rest
+   * erase all objects in the queue
    */
-  auto it = m_queue.begin();
+  m_queue.clear();
+
+  return (rc);
+}
 
-  while (it != m_queue.end()) {
-    std::shared_ptr<cmd> c = *it;
+rc_t
+HW::cmd_q::write_serial()
+{
+  rc_t rc = rc_t::OK;
 
-    VOM_LOG(log_level_t::DEBUG) << *c;
+  /*
+   * Execute each command in the queue.
+   * If one execution fails, abort the rest
+   */
+  for (auto& seq : m_queue) {
+    for (auto& c : seq) {
+      VOM_LOG(log_level_t::DEBUG) << *c;
 
-    if (m_enabled) {
-      /*
-       * before we issue the command we must move it to the pending
-       * store
-       * ince a async event can be recieved before the command
-       * completes
-       */
       rc = c->issue(m_conn);
 
-      if (rc_t::OK == rc) {
-        /*
-         * move to the next
-         */
-      } else {
+      if (rc_t::OK != rc) {
         /*
          * barf out without issuing the rest
          */
         VOM_LOG(log_level_t::ERROR) << "Failed to execute: " << c->to_string();
-        break;
+        return (rc);
       }
-    } else {
-      /*
-       * The HW is disabled, so set each command as succeeded
-       */
-      c->succeeded();
     }
-
-    ++it;
   }
 
+  return (rc);
+}
+
+rc_t
+HW::cmd_q::write_pipelined()
+{
+  std::mutex lock;
+  std::condition_variable cond;
+  rc_t rc = rc_t::OK;
+
   /*
-   * erase all objects in the queue
+   * The handles that commands in sequences already taken for issue
+   * have yet to obtain from VPP. A command that needs one of these
+   * must wait until it is known.
    */
-  m_queue.erase(m_queue.begin(), m_queue.end());
+  std::multiset<const handle_t*> pending;
+  auto next = m_queue.begin();
+
+  auto issuer = [&]() {
+    std::unique_lock<std::mutex> ul(lock);
+
+    while (next != m_queue.end()) {
+      sequence_t& seq = *next++;
+
+      for (auto& c : seq) {
+        if (c->provides())
+          pending.insert(c->provides());
+      }
+
+      for (auto it = seq.begin(); it != seq.end(); ++it) {
+        std::shared_ptr<cmd> c = *it;
+
+        cond.wait(ul, [&]() {
+          return (!c->needs() || !pending.count(c->needs()));
+        });
+
+        VOM_LOG(log_level_t::DEBUG) << *c;
+
+        ul.unlock();
+        rc_t crc = c->issue(m_conn);
+        ul.lock();
+
+        if (c->provides()) {
+          pending.erase(pending.find(c->provides()));
+          cond.notify_all();
+        }
+
+        if (rc_t::OK != crc) {
+          /*
+           * the rest of this sequence depends on this command, so
+           * abandon it; other sequences are unaffected.
+           */
+          VOM_LOG(log_level_t::ERROR) << "Failed to execute: "
+                                      << c->to_string();
+          if (rc_t::OK == rc)
+            rc = crc;
+
+          while (++it != seq.end()) {
+            if ((*it)->provides()) {
+              pending.erase(pending.find((*it)->provides()));
+            }
+          }
+          cond.notify_all();
+          break;
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> issuers;
+
+  for (unsigned int ii = 0; ii < std::min<size_t>(m_window, m_queue.size());
+       ii++) {
+    issuers.emplace_back(issuer);
+  }
+  for (auto& t : issuers) {
+    t.join();
+  }
 
   return (rc);
 }
@@ -192,6 +311,15 @@ HW::init()
   m_cmdQ = new cmd_q();
 }
 
+/**
+ * Initialse the connection to VPP with a pipelined command Q
+ */
+void
+HW::init(unsigned int window)
+{
+  m_cmdQ = new cmd_q(window);
+}
+
 void
 HW::enqueue(cmd* cmd)
 {
@@ -210,6 +338,12 @@ HW::enqueue(std::queue<cmd*>& cmds)
   m_cmdQ->enqueue(cmds);
 }
 
+void
+HW::sequence()
+{
+  m_cmdQ->sequence();
+}
+
 bool
 HW::connect()
 {
@@ -190,6 +190,13 @@ public:
      * Constructor
      */
     cmd_q();
+
+    /**
+     * Constructor taking the number of command sequences that can be
+     * in flight to VPP at once
+     */
+    cmd_q(unsigned int window);
+
     /**
      * Destructor
      */
@@ -214,11 +221,24 @@ public:
      */
     virtual void enqueue(std::queue<cmd*>& c);
 
+    /**
+     * Start a new sequence of commands. The commands within a sequence
+     * are issued in the order they were enqueued. When the window is
+     * greater than one, separate sequences are issued concurrently.
+     */
+    virtual void sequence();
+
     /**
      * Write all the commands to HW
      */
     virtual rc_t write();
 
+    /**
+     * Set the number of command sequences that can be in flight to VPP
+     * at once. A window of 1, the default, issues each command in turn.
+     */
+    void window(unsigned int n);
+
     /**
      * Blocking Connect to VPP - call once at bootup
      */
@@ -243,9 +263,30 @@ public:
 
   private:
     /**
-     * A queue of enqueued commands, ready to be written
+     * A sequence of commands that must be issued in order
+     */
+    typedef std::deque<std::shared_ptr<cmd>> sequence_t;
+
+    /**
+     * Issue each command in turn, stopping at the first failure
+     */
+    rc_t write_serial();
+
+    /**
+     * Issue up to window sequences concurrently. A failure stops
+     * only the sequence in which it occurs.
+     */
+    rc_t write_pipelined();
+
+    /**
+     * A queue of enqueued command sequences, ready to be written
+     */
+    std::deque<sequence_t> m_queue;
+
+    /**
+     * The number of command sequences that can be in flight at once
      */
-    std::deque<std::shared_ptr<cmd>> m_queue;
+    unsigned int m_window;
 
     /**
      * A map of issued, but uncompleted, commands.
@@ -291,6 +332,11 @@ public:
    */
   static void init();
 
+  /**
+   * Initialise the HW with a pipelined command Q
+   */
+  static void init(unsigned int window);
+
   /**
    * Enqueue A command for execution
    */
@@ -306,6 +352,11 @@ public:
    */
   static void enqueue(std::queue<cmd*>& c);
 
+  /**
+   * Start a new sequence of commands; see cmd_q::sequence()
+   */
+  static void sequence();
+
   /**
    * Write/Execute all commands hitherto enqueued.
    */
@@ -30,6 +30,7 @@ singular_db<interface::key_t, interface> interface::m_db;
  * A DB of all the interfaces, key on VPP's handle
  */
 std::map<handle_t, std::weak_ptr<interface>> interface::m_hdl_db;
+std::mutex interface::m_hdl_db_lock;
 
 interface::event_handler interface::m_evh;
 
@@ -436,6 +437,8 @@ interface::find(const key_t& k)
 std::shared_ptr<interface>
 interface::find(const handle_t& handle)
 {
+  std::lock_guard<std::mutex> lg(m_hdl_db_lock);
+
   return (m_hdl_db[handle].lock());
 }
 
@@ -445,6 +448,8 @@ interface::add(const key_t& key, const HW::item<handle_t>& item)
   std::shared_ptr<interface> sp = find(key);
 
   if (sp && item) {
+    std::lock_guard<std::mutex> lg(m_hdl_db_lock);
+
     m_hdl_db[item.data()] = sp;
   }
 }
@@ -452,6 +457,8 @@ interface::add(const key_t& key, const HW::item<handle_t>& item)
 void
 interface::remove(const HW::item<handle_t>& item)
 {
+  std::lock_guard<std::mutex> lg(m_hdl_db_lock);
+
   m_hdl_db.erase(item.data());
 }
 
@@ -16,6 +16,8 @@
 #ifndef __VOM_INTERFACE_H__
 #define __VOM_INTERFACE_H__
 
+#include <mutex>
+
 #include "vom/enum_base.hpp"
 #include "vom/hw.hpp"
 #include "vom/inspect.hpp"
@@ -283,6 +285,11 @@ public:
       interface::add(m_name, this->item());
     }
 
+    /**
+     * The handle of the created interface
+     */
+    const handle_t* provides() const { return (&this->item().data()); }
+
     /**
      * add the created interface to the DB
      */
@@ -609,6 +616,12 @@ private:
    */
   static std::map<handle_t, std::weak_ptr<interface>> m_hdl_db;
 
+  /**
+   * Lock protecting the handle DB. Interfaces may be created from
+   * several threads when the command Q is pipelined.
+   */
+  static std::mutex m_hdl_db_lock;
+
   /**
    * replay the object to create it in hardware
    */
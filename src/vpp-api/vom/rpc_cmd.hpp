@@ -19,6 +19,7 @@
 #include <future>
 
 #include "vom/cmd.hpp"
+#include "vom/dump_cmd.hpp"
 #include "vom/logger.hpp"
 
 namespace VOM {
@@ -88,6 +89,7 @@ public:
    */
   DATA wait()
   {
+    dump_stream::waiter w;
     std::future_status status;
     std::future<DATA> result;
 
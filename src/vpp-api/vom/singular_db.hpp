@@ -19,6 +19,7 @@
 #include <memory>
 #include <ostream>
 
+#include "vom/hw.hpp"
 #include "vom/logger.hpp"
 
 namespace VOM {
@@ -130,11 +131,14 @@ public:
   }
 
   /**
-   * Populate VPP from current state, on VPP restart
+   * Populate VPP from current state, on VPP restart.
+   * Each object's commands form their own sequence, so a pipelined
+   * command Q may replay several objects at once.
    */
   void replay()
   {
     for (auto entry : m_map) {
+      HW::sequence();
       entry.second.lock()->replay();
     }
   }
@@ -58,6 +58,12 @@ create_cmd::issue(connection& con)
   return rc_t::OK;
 }
 
+const handle_t*
+create_cmd::needs() const
+{
+  return (&m_parent);
+}
+
 std::string
 create_cmd::to_string() const
 {
@@ -45,6 +45,11 @@ public:
    */
   rc_t issue(connection& con);
 
+  /**
+   * The sub-interface cannot be created before its parent
+   */
+  const handle_t* needs() const;
+
   /**
    * convert to string format for debug purposes
    */
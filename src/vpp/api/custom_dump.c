@@ -585,6 +585,10 @@ static void *vl_api_tap_create_v2_t_print
     s = format (s, "tx-ring-size %d ", mp->tx_ring_sz);
   if (mp->rx_ring_sz)
     s = format (s, "rx-ring-size %d ", mp->rx_ring_sz);
+  if (mp->num_rx_queues)
+    s = format (s, "num-rx-queues %d ", ntohs (mp->num_rx_queues));
+  if (mp->enable_gso)
+    s = format (s, "gso ");
   FINISH;
 }
 
@@ -2062,6 +2066,8 @@ static void *vl_api_af_packet_create_t_print
     s = format (s, "hw_addr random ");
   else
     s = format (s, "hw_addr %U ", format_ethernet_address, mp->hw_addr);
+  if (mp->num_rx_queues)
+    s = format (s, "num_rx_queues %u ", ntohs (mp->num_rx_queues));
 
   FINISH;
 }
@@ -0,0 +1,220 @@
+/*
+ *------------------------------------------------------------------
+ * vpp_get_stats.c
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#include <unistd.h>
+#include <vppinfra/format.h>
+#include <vpp-api/client/stat_client.h>
+
+static void
+stat_poll_loop (u8 ** patterns)
+{
+  struct timespec ts, tsrem;
+  stat_segment_data_t *res;
+  vlib_counter_t c;
+  u32 *stats;
+  f64 heartbeat, prev_heartbeat = 0;
+  int i, j;
+
+  stats = stat_segment_ls (patterns);
+  if (!stats)
+    return;
+
+  while (1)
+    {
+      /* a stalled heartbeat means vpp is gone */
+      heartbeat = stat_segment_heartbeat ();
+      if (heartbeat > prev_heartbeat)
+	prev_heartbeat = heartbeat;
+      else
+	fformat (stderr, "vpp heartbeat stopped at %.2f\n", heartbeat);
+
+      res = stat_segment_dump (stats);
+      for (i = 0; i < vec_len (res); i++)
+	{
+	  switch (res[i].type)
+	    {
+	    case STAT_DIR_TYPE_SCALAR_POINTER:
+	      fformat (stdout, "%.2f %s\n", res[i].scalar_value, res[i].name);
+	      break;
+
+	    case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
+	      if (!vec_len (res[i].simple_counter_vec))
+		break;
+	      for (j = 0; j < vec_len (res[i].simple_counter_vec[0]); j++)
+		fformat (stdout, "[%d]: %lld packets %s\n", j,
+			 stat_segment_simple_counter_sum
+			 (res[i].simple_counter_vec, j), res[i].name);
+	      break;
+
+	    case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
+	      if (!vec_len (res[i].combined_counter_vec))
+		break;
+	      for (j = 0; j < vec_len (res[i].combined_counter_vec[0]); j++)
+		{
+		  stat_segment_combined_counter_sum
+		    (res[i].combined_counter_vec, j, &c);
+		  fformat (stdout, "[%d]: %lld packets, %lld bytes %s\n", j,
+			   c.packets, c.bytes, res[i].name);
+		}
+	      break;
+
+	    default:
+	      break;
+	    }
+	}
+      stat_segment_data_free (res);
+
+      ts.tv_sec = 1;
+      ts.tv_nsec = 0;
+      while (nanosleep (&ts, &tsrem) < 0)
+	ts = tsrem;
+    }
+}
+
+typedef enum
+{
+  STAT_CLIENT_CMD_UNKNOWN,
+  STAT_CLIENT_CMD_LS,
+  STAT_CLIENT_CMD_POLL,
+  STAT_CLIENT_CMD_DUMP,
+} stat_client_cmd_t;
+
+int
+main (int argc, char **argv)
+{
+  unformat_input_t _argv, *a = &_argv;
+  u8 *stat_segment_name, *pattern = 0, **patterns = 0;
+  stat_client_cmd_t cmd = STAT_CLIENT_CMD_UNKNOWN;
+  stat_segment_data_t *res;
+  u32 *stats;
+  int i, j, rv;
+
+  stat_segment_name = (u8 *) STAT_SEGMENT_SOCKET_FILE;
+
+  unformat_init_command_line (a, argv);
+
+  while (unformat_check_input (a) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (a, "socket-name %s", &stat_segment_name))
+	vec_add1 (stat_segment_name, 0);
+      else if (unformat (a, "ls"))
+	cmd = STAT_CLIENT_CMD_LS;
+      else if (unformat (a, "dump"))
+	cmd = STAT_CLIENT_CMD_DUMP;
+      else if (unformat (a, "poll"))
+	cmd = STAT_CLIENT_CMD_POLL;
+      else if (unformat (a, "%s", &pattern))
+	{
+	  vec_add1 (pattern, 0);
+	  vec_add1 (patterns, pattern);
+	}
+      else
+	{
+	  fformat (stderr,
+		   "%s: usage [socket-name <name>] [ls|dump|poll] <patterns> ...\n",
+		   argv[0]);
+	  exit (1);
+	}
+    }
+
+  rv = stat_segment_connect ((char *) stat_segment_name);
+  if (rv)
+    {
+      fformat (stderr, "Couldn't connect to vpp, does %s exist?\n",
+	       stat_segment_name);
+      exit (1);
+    }
+
+  switch (cmd)
+    {
+    case STAT_CLIENT_CMD_LS:
+      stats = stat_segment_ls (patterns);
+      res = stat_segment_dump (stats);
+      for (i = 0; i < vec_len (res); i++)
+	fformat (stdout, "%s\n", res[i].name);
+      stat_segment_data_free (res);
+      vec_free (stats);
+      break;
+
+    case STAT_CLIENT_CMD_DUMP:
+      stats = stat_segment_ls (patterns);
+      res = stat_segment_dump (stats);
+      for (i = 0; i < vec_len (res); i++)
+	{
+	  switch (res[i].type)
+	    {
+	    case STAT_DIR_TYPE_SCALAR_POINTER:
+	      fformat (stdout, "%.2f %s\n", res[i].scalar_value, res[i].name);
+	      break;
+
+	    case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
+	      for (j = 0; j < vec_len (res[i].simple_counter_vec); j++)
+		{
+		  counter_t *c;
+
+		  fformat (stdout, "[%d]:", j);
+		  vec_foreach (c, res[i].simple_counter_vec[j])
+		    fformat (stdout, " %lld", c[0]);
+		  fformat (stdout, " %s\n", res[i].name);
+		}
+	      break;
+
+	    case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
+	      for (j = 0; j < vec_len (res[i].combined_counter_vec); j++)
+		{
+		  vlib_counter_t *c;
+
+		  fformat (stdout, "[%d]:", j);
+		  vec_foreach (c, res[i].combined_counter_vec[j])
+		    fformat (stdout, " %lld/%lld", c->packets, c->bytes);
+		  fformat (stdout, " %s\n", res[i].name);
+		}
+	      break;
+
+	    default:
+	      break;
+	    }
+	}
+      stat_segment_data_free (res);
+      vec_free (stats);
+      break;
+
+    case STAT_CLIENT_CMD_POLL:
+      stat_poll_loop (patterns);
+      /* We can only exit via a signal */
+      break;
+
+    default:
+      fformat (stderr,
+	       "%s: usage [socket-name <name>] [ls|dump|poll] <patterns> ...\n",
+	       argv[0]);
+    }
+
+  stat_segment_disconnect ();
+
+  exit (0);
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
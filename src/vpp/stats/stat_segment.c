@@ -0,0 +1,418 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vlib/vlib.h>
+#include <vlib/unix/unix.h>
+#include <vppinfra/lock.h>
+#include <vppinfra/socket.h>
+#include <vpp/stats/stat_segment.h>
+
+typedef struct
+{
+  /** The memfd segment */
+  ssvm_private_t memfd_segment;
+  void *heap;
+  stat_segment_shared_header_t *shared_header;
+
+  /** Directory index by name, on the process heap */
+  uword *directory_index_by_name;
+
+  /** Held from vlib_stats_push_heap to vlib_stats_pop_heap */
+  clib_spinlock_t lock;
+
+  /** Scalars maintained by the collector process */
+  u32 vector_rate_index;
+  u32 last_update_index;
+  f64 update_interval;
+
+  /** The socket the segment's fd is handed out on */
+  clib_socket_t socket;
+  u32 socket_file_index;
+
+  /* Config */
+  uword memory_size;
+  u8 *socket_name;
+} stat_segment_main_t;
+
+stat_segment_main_t stat_segment_main;
+
+/*
+ * Find or add the directory entry for name.
+ * Called on the stat segment heap with the update in progress.
+ */
+static u32
+stat_segment_lookup_or_add (char *name, stat_directory_type_t type,
+			    void *oldheap)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+  stat_segment_shared_header_t *shared_header = sm->shared_header;
+  stat_segment_directory_entry_t *e;
+  uword *p;
+  u32 index;
+
+  p = hash_get_mem (sm->directory_index_by_name, name);
+  if (p)
+    return p[0];
+
+  index = vec_len (shared_header->directory_vector);
+  vec_add2 (shared_header->directory_vector, e, 1);
+  memset (e, 0, sizeof (*e));
+  e->type = type;
+  strncpy (e->name, name, STAT_SEGMENT_NAME_LEN - 1);
+
+  /* the index hash lives on the process heap */
+  clib_mem_set_heap (oldheap);
+  hash_set_mem (sm->directory_index_by_name, name, index);
+  clib_mem_set_heap (sm->heap);
+
+  return index;
+}
+
+void *
+vlib_stats_push_heap (char *name)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+
+  if (!name || !sm->shared_header)
+    return 0;
+
+  clib_spinlock_lock (&sm->lock);
+  sm->shared_header->in_progress = 1;
+  CLIB_MEMORY_BARRIER ();
+
+  return clib_mem_set_heap (sm->heap);
+}
+
+void
+vlib_stats_pop_heap (void *cm_arg, void *oldheap,
+		     stat_directory_type_t type)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+  stat_segment_shared_header_t *shared_header = sm->shared_header;
+  char *name;
+  void *data;
+  u32 index;
+
+  if (!oldheap)
+    return;
+
+  if (STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE == type)
+    {
+      vlib_simple_counter_main_t *cm = cm_arg;
+      name = cm->stat_segment_name;
+      data = cm->counters;
+    }
+  else
+    {
+      vlib_combined_counter_main_t *cm = cm_arg;
+      name = cm->stat_segment_name;
+      data = cm->counters;
+    }
+
+  index = stat_segment_lookup_or_add (name, type, oldheap);
+  shared_header->directory_vector[index].data = data;
+
+  CLIB_MEMORY_BARRIER ();
+  shared_header->epoch++;
+  shared_header->in_progress = 0;
+
+  clib_mem_set_heap (oldheap);
+  clib_spinlock_unlock (&sm->lock);
+}
+
+static u32
+stat_segment_add_scalar (char *name)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+  void *oldheap;
+  u32 index;
+
+  oldheap = clib_mem_set_heap (sm->heap);
+  sm->shared_header->in_progress = 1;
+  CLIB_MEMORY_BARRIER ();
+
+  index = stat_segment_lookup_or_add (name, STAT_DIR_TYPE_SCALAR_POINTER,
+				      oldheap);
+
+  CLIB_MEMORY_BARRIER ();
+  sm->shared_header->epoch++;
+  sm->shared_header->in_progress = 0;
+  clib_mem_set_heap (oldheap);
+
+  return index;
+}
+
+clib_error_t *
+vlib_map_stat_segment_init (void)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+  ssvm_private_t *memfd = &sm->memfd_segment;
+  stat_segment_shared_header_t *shared_header;
+  void *oldheap;
+  int rv;
+
+  memfd->ssvm_size = sm->memory_size ? sm->memory_size :
+    STAT_SEGMENT_DEFAULT_SIZE;
+  memfd->name = format (0, "%s%c", "stats", 0);
+  memfd->requested_va = 0;
+
+  if ((rv = ssvm_master_init (memfd, SSVM_SEGMENT_MEMFD)))
+    return clib_error_return (0, "stat segment create failed: %d", rv);
+
+  sm->heap = memfd->sh->heap;
+  clib_spinlock_init (&sm->lock);
+  sm->directory_index_by_name = hash_create_string (0, sizeof (uword));
+
+  oldheap = ssvm_push_heap (memfd->sh);
+  shared_header = clib_mem_alloc (sizeof (*shared_header));
+  memset (shared_header, 0, sizeof (*shared_header));
+  shared_header->version = STAT_SEGMENT_VERSION;
+  memfd->sh->opaque[STAT_SEGMENT_OPAQUE_HEADER] = shared_header;
+  ssvm_pop_heap (oldheap);
+
+  sm->shared_header = shared_header;
+  sm->vector_rate_index = stat_segment_add_scalar ("/sys/vector_rate");
+  sm->last_update_index = stat_segment_add_scalar ("/sys/last_update");
+
+  memfd->sh->ready = 1;
+
+  return 0;
+}
+
+static clib_error_t *
+stat_segment_accept_ready (clib_file_t * uf)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+  clib_socket_t client;
+  clib_error_t *error;
+  u64 size = sm->memfd_segment.ssvm_size;
+
+  error = clib_socket_accept (&sm->socket, &client);
+  if (error)
+    return error;
+
+  /* hand the segment's fd to the client and be done with it */
+  error = clib_socket_sendmsg (&client, &size, sizeof (size),
+			       &sm->memfd_segment.fd, 1);
+  clib_socket_close (&client);
+
+  return error;
+}
+
+static clib_error_t *
+stat_segment_socket_init (vlib_main_t * vm)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+  clib_socket_t *s = &sm->socket;
+  clib_file_t template = { 0 };
+  clib_error_t *error;
+
+  if (!sm->shared_header)
+    return 0;
+
+  if (!sm->socket_name)
+    sm->socket_name = format (0, "%s%c", STAT_SEGMENT_SOCKET_FILE, 0);
+
+  /* mkdir of file socket, only under /run  */
+  if (strncmp ((char *) sm->socket_name, "/run", 4) == 0)
+    {
+      u8 *tmp = format (0, "%s", sm->socket_name);
+      int i = vec_len (tmp);
+      while (i && tmp[--i] != '/')
+	;
+
+      tmp[i] = 0;
+
+      if (i)
+	vlib_unix_recursive_mkdir ((char *) tmp);
+      vec_free (tmp);
+    }
+
+  s->config = (char *) sm->socket_name;
+  s->flags = CLIB_SOCKET_F_IS_SERVER | CLIB_SOCKET_F_SEQPACKET |
+    CLIB_SOCKET_F_ALLOW_GROUP_WRITE;
+  if ((error = clib_socket_init (s)))
+    return error;
+
+  template.read_function = stat_segment_accept_ready;
+  template.file_descriptor = s->fd;
+  template.description = format (0, "stats segment listener %s",
+				 sm->socket_name);
+  sm->socket_file_index = clib_file_add (&file_main, &template);
+
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (stat_segment_socket_init);
+
+static clib_error_t *
+stat_segment_socket_exit (vlib_main_t * vm)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+
+  if (sm->socket.fd > 0)
+    {
+      clib_file_del_by_index (&file_main, sm->socket_file_index);
+      unlink ((char *) sm->socket_name);
+    }
+
+  return 0;
+}
+
+VLIB_MAIN_LOOP_EXIT_FUNCTION (stat_segment_socket_exit);
+
+/*
+ * Keep the scalars up to date. The counters need no help: they are
+ * incremented in place in the segment.
+ */
+static uword
+stat_segment_collector_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
+				vlib_frame_t * f)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+  stat_segment_directory_entry_t *dir;
+  f64 vector_rate;
+  int i;
+
+  if (!sm->shared_header)
+    return 0;
+
+  if (sm->update_interval <= 0.0)
+    sm->update_interval = 1.0;
+
+  while (1)
+    {
+      vlib_process_suspend (vm, sm->update_interval);
+
+      vector_rate = 0.0;
+      for (i = 0; i < vec_len (vlib_mains); i++)
+	vector_rate += vlib_last_vectors_per_main_loop_as_f64 (vlib_mains[i]);
+      vector_rate /= vec_len (vlib_mains);
+
+      dir = sm->shared_header->directory_vector;
+      dir[sm->vector_rate_index].scalar_value = vector_rate;
+      dir[sm->last_update_index].scalar_value = vlib_time_now (vm);
+    }
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (stat_segment_collector, static) =
+{
+  .function = stat_segment_collector_process,
+  .name = "statseg-collector-process",
+  .type = VLIB_NODE_TYPE_PROCESS,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+statseg_config (vlib_main_t * vm, unformat_input_t * input)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "size %U", unformat_memory_size,
+		    &sm->memory_size))
+	;
+      else if (unformat (input, "socket-name %s", &sm->socket_name))
+	vec_add1 (sm->socket_name, 0);
+      else if (unformat (input, "update-interval %f", &sm->update_interval))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+  return 0;
+}
+
+VLIB_EARLY_CONFIG_FUNCTION (statseg_config, "statseg");
+
+static u8 *
+format_stat_dir_type (u8 * s, va_list * args)
+{
+  stat_directory_type_t type = va_arg (*args, stat_directory_type_t);
+
+  switch (type)
+    {
+    case STAT_DIR_TYPE_SCALAR_POINTER:
+      return format (s, "scalar");
+    case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
+      return format (s, "simple counters");
+    case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
+      return format (s, "combined counters");
+    default:
+      return format (s, "illegal");
+    }
+}
+
+static clib_error_t *
+show_stat_segment_command_fn (vlib_main_t * vm,
+			      unformat_input_t * input,
+			      vlib_cli_command_t * cmd)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+  stat_segment_directory_entry_t *dir, *e;
+  int verbose = 0;
+
+  if (!sm->shared_header)
+    return clib_error_return (0, "stat segment not mapped");
+
+  if (unformat (input, "verbose"))
+    verbose = 1;
+
+  vlib_cli_output (vm, "socket %s, size %U, epoch %lld",
+		   sm->socket_name, format_memory_size,
+		   sm->memfd_segment.ssvm_size, sm->shared_header->epoch);
+
+  dir = sm->shared_header->directory_vector;
+  vlib_cli_output (vm, "%-50s %s", "Name", "Type");
+  vec_foreach (e, dir)
+    vlib_cli_output (vm, "%-50s %U", e->name, format_stat_dir_type, e->type);
+
+  if (verbose)
+    vlib_cli_output (vm, "%U", format_mheap, sm->heap, 0 /* verbose */ );
+
+  return 0;
+}
+
+/*?
+ * Show the directory of the stats shared memory segment
+ *
+ * @cliexpar
+ * @cliexstart{show statistics segment}
+ * socket /run/vpp/stats.sock, size 32M, epoch 24
+ * Name                                               Type
+ * /sys/vector_rate                                   scalar
+ * /sys/last_update                                   scalar
+ * /if/drops                                          simple counters
+ * @cliexend
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_stat_segment_command, static) =
+{
+  .path = "show statistics segment",
+  .short_help = "show statistics segment [verbose]",
+  .function = show_stat_segment_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** \file
+
+    Layout of the stats shared memory segment.
+
+    vpp maps a memfd segment and allocates the per-thread vectors of
+    every counter collection with a stat_segment_name in it, so that
+    counters are incremented in place in shared memory. A directory of
+    named entries points at those vectors and at scalar values. The fd
+    of the segment is handed out on a unix socket; readers map it
+    read-only at the same address, so pointers are valid as-is.
+
+    The directory and the vectors it points at only change on the vpp
+    side under in_progress, after which the epoch is bumped. A reader
+    brackets each access with stat_segment_access_start() and
+    stat_segment_access_end(), and retries if the latter fails.
+*/
+
+#ifndef included_stat_segment_h
+#define included_stat_segment_h
+
+#include <vppinfra/types.h>
+#include <vppinfra/vec.h>
+#include <vppinfra/error.h>
+#include <vppinfra/serialize.h>
+#include <vlib/counter.h>
+#include <svm/ssvm.h>
+
+#define STAT_SEGMENT_SOCKET_FILE "/run/vpp/stats.sock"
+
+#define STAT_SEGMENT_DEFAULT_SIZE (32 << 20)
+
+/** Index of the shared header in the ssvm header's opaque array */
+#define STAT_SEGMENT_OPAQUE_HEADER 0
+
+#define STAT_SEGMENT_VERSION 1
+
+#define STAT_SEGMENT_NAME_LEN 128
+
+typedef struct
+{
+  stat_directory_type_t type;
+  union
+  {
+    /** STAT_DIR_TYPE_SCALAR_POINTER */
+    f64 scalar_value;
+    /** STAT_DIR_TYPE_COUNTER_VECTOR_*: the collection's counters */
+    void *data;
+  };
+  char name[STAT_SEGMENT_NAME_LEN];
+} stat_segment_directory_entry_t;
+
+typedef struct
+{
+  u64 version;
+  /** Bumped after every change of the directory or counter vectors */
+  volatile u64 epoch;
+  /** Non-zero whilst a change is in progress */
+  volatile u64 in_progress;
+  /** Vector of directory entries */
+  stat_segment_directory_entry_t *directory_vector;
+} stat_segment_shared_header_t;
+
+typedef struct
+{
+  u64 epoch;
+} stat_segment_access_t;
+
+static inline void
+stat_segment_access_start (stat_segment_access_t * sa,
+			   stat_segment_shared_header_t * shared_header)
+{
+  sa->epoch = shared_header->epoch;
+  while (shared_header->in_progress != 0)
+    ;
+  CLIB_MEMORY_BARRIER ();
+}
+
+/** @returns 1 if nothing changed since stat_segment_access_start */
+static inline int
+stat_segment_access_end (stat_segment_access_t * sa,
+			 stat_segment_shared_header_t * shared_header)
+{
+  CLIB_MEMORY_BARRIER ();
+  if (shared_header->epoch != sa->epoch || shared_header->in_progress)
+    return 0;
+  return 1;
+}
+
+#endif /* included_stat_segment_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -15,6 +15,7 @@
 #include <vpp/stats/stats.h>
 #include <signal.h>
 #include <vnet/fib/ip4_fib.h>
+#include <vnet/fib/ip6_fib.h>
 #include <vnet/fib/fib_entry.h>
 #include <vnet/mfib/mfib_entry.h>
 #include <vnet/dpo/load_balance.h>
@@ -1910,6 +1911,13 @@ add_routes_in_fib (BVT (clib_bihash_kv) * kvp, void *arg)
       ip6_address_t *addr;
       ip6_route_t *r;
       addr = (ip6_address_t *) kvp;
+
+      /* skip the lookup's markers; they are not routes */
+      if (FIB_NODE_INDEX_INVALID ==
+	  ip6_fib_table_lookup_exact_match (ap->fib_index, addr,
+					    kvp->key[2] & 0xFF))
+	return;
+
       vec_add2 (*ap->routep, r, 1);
       r->address = addr[0];
       r->address_length = kvp->key[2] & 0xFF;
@@ -0,0 +1,110 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2017 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+/*
+ * Measure request/response throughput of the C++ API as the number of
+ * threads issuing requests grows. Responses are dispatched by the
+ * connection's rx thread.
+ *
+ *   vapi_cpp_bench <app name> <api prefix> [requests per thread]
+ */
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+#include <vapi/vapi.hpp>
+#include <vapi/vpe.api.vapi.hpp>
+
+DEFINE_VAPI_MSG_IDS_VPE_API_JSON;
+
+using namespace vapi;
+
+static const int max_outstanding_requests = 128;
+static const int response_queue_size = 128;
+
+static void
+run (Connection &con, int num_threads, int num_requests)
+{
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now ();
+  for (int i = 0; i < num_threads; ++i)
+    {
+      threads.emplace_back ([&con, num_requests]() {
+        for (int j = 0; j < num_requests; ++j)
+          {
+            Control_ping ping (con);
+            if (VAPI_OK != ping.execute ())
+              {
+                abort ();
+              }
+            ping.get_future ().wait ();
+          }
+      });
+    }
+  for (auto &t : threads)
+    {
+      t.join ();
+    }
+  std::chrono::duration<double> d = std::chrono::steady_clock::now () - start;
+  printf ("%2d threads: %d requests in %.3fs, %.0f msgs/s\n", num_threads,
+          num_threads * num_requests, d.count (),
+          num_threads * num_requests / d.count ());
+}
+
+int main (int argc, char *argv[])
+{
+  int num_requests = 100000;
+  if (argc < 3)
+    {
+      printf ("usage: %s <app name> <api prefix> [requests per thread]\n",
+              argv[0]);
+      return EXIT_FAILURE;
+    }
+  if (argc > 3)
+    {
+      num_requests = atoi (argv[3]);
+    }
+
+  Connection con;
+  vapi_error_e rv = con.connect (argv[1], argv[2], max_outstanding_requests,
+                                 response_queue_size);
+  if (VAPI_OK != rv)
+    {
+      printf ("connect failed: %d\n", rv);
+      return EXIT_FAILURE;
+    }
+  con.start_rx_thread ();
+
+  for (int num_threads = 1; num_threads <= 16; num_threads *= 2)
+    {
+      run (con, num_threads, num_requests / num_threads);
+    }
+
+  con.stop_rx_thread ();
+  con.disconnect ();
+  return EXIT_SUCCESS;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
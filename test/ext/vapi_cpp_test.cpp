@@ -16,6 +16,8 @@
  */
 
 #include <memory>
+#include <thread>
+#include <vector>
 #include <stdio.h>
 #include <unistd.h>
 #include <assert.h>
@@ -504,6 +506,71 @@ START_TEST (test_stats_4)
 
 END_TEST;
 
+START_TEST (test_rx_thread)
+{
+  printf ("--- Show version from several threads using the rx thread ---\n");
+  const auto num_threads = 4;
+  const auto num_requests = 25;
+  std::atomic<int> called{0};
+  vapi_error_e rv = con.start_rx_thread ();
+  ck_assert_int_eq (VAPI_OK, rv);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; ++i)
+    {
+      threads.emplace_back ([&called]() {
+        for (int j = 0; j < num_requests; ++j)
+          {
+            Show_version sv (con);
+            vapi_error_e rv = sv.execute ();
+            ck_assert_int_eq (VAPI_OK, rv);
+            rv = sv.get_future ().get ();
+            ck_assert_int_eq (VAPI_OK, rv);
+            ck_assert_int_eq (RESPONSE_READY, sv.get_response_state ());
+            verify_show_version_reply (sv.get_response ());
+            ++called;
+          }
+      });
+    }
+  for (auto &t : threads)
+    {
+      t.join ();
+    }
+  con.stop_rx_thread ();
+  ck_assert_int_eq (num_threads * num_requests, called);
+}
+
+END_TEST;
+
+START_TEST (test_streaming_dump)
+{
+  printf ("--- Stream interface dump records to a callback ---\n");
+  Sw_interface_dump d (con);
+  auto &p = d.get_request ().get_payload ();
+  p.name_filter_valid = 0;
+  memset (p.name_filter, 0, sizeof (p.name_filter));
+  int records = 0;
+  bool seen_local0 = false;
+  d.set_record_callback ([&](Msg<vapi_msg_sw_interface_details> &r) {
+    auto &rp = r.get_payload ();
+    if (0 == rp.sw_if_index)
+      {
+        seen_local0 = true;
+      }
+    ++records;
+    return VAPI_OK;
+  });
+  auto rv = d.execute ();
+  ck_assert_int_eq (VAPI_OK, rv);
+  WAIT_FOR_RESPONSE (d, rv);
+  ck_assert_int_eq (VAPI_OK, rv);
+  ck_assert_int_ne (0, records);
+  ck_assert_int_eq (1, seen_local0);
+  ck_assert_int_eq (0, d.get_result_set ().size ());
+  ck_assert_int_eq (1, d.get_result_set ().is_complete ());
+}
+
+END_TEST;
+
 START_TEST (test_unsupported)
 {
   printf ("--- Unsupported messages ---\n");
@@ -560,6 +627,8 @@ Suite *test_suite (void)
   tcase_add_test (tc_cpp_api, test_stats_2);
   tcase_add_test (tc_cpp_api, test_stats_3);
   tcase_add_test (tc_cpp_api, test_stats_4);
+  tcase_add_test (tc_cpp_api, test_rx_thread);
+  tcase_add_test (tc_cpp_api, test_streaming_dump);
   tcase_add_test (tc_cpp_api, test_unsupported);
   suite_add_tcase (s, tc_cpp_api);
 
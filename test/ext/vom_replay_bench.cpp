@@ -0,0 +1,142 @@
+/*
+ * Benchmark of VOM's replay of its object model to VPP
+ *
+ * Copyright (c) 2017 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Populates the OM with N loopback interfaces, N routes and N ACLs,
+ * writes them to a running VPP, then measures the time taken to replay
+ * the whole OM, as VOM does when VPP restarts, for each of the given
+ * command Q windows.
+ *
+ * Run against a scratch VPP instance with the ACL plugin loaded; each
+ * replay re-creates the loopbacks.
+ *
+ *   vom_replay_bench [-n <objects>] [-w <window>]...
+ */
+
+#include <unistd.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "vom/acl_l3_rule.hpp"
+#include "vom/acl_list.hpp"
+#include "vom/hw.hpp"
+#include "vom/interface.hpp"
+#include "vom/om.hpp"
+#include "vom/route.hpp"
+
+using namespace VOM;
+
+static void
+populate(unsigned int n, const std::string& key)
+{
+    interface itf("loop-bench-0",
+                  interface::type_t::LOOPBACK,
+                  interface::admin_state_t::UP);
+    OM::write(key, itf);
+
+    for (unsigned int ii = 1; ii < n; ii++)
+    {
+        interface l("loop-bench-" + std::to_string(ii),
+                    interface::type_t::LOOPBACK,
+                    interface::admin_state_t::UP);
+        OM::write(key, l);
+    }
+
+    for (unsigned int ii = 0; ii < n; ii++)
+    {
+        boost::asio::ip::address_v4 a(0x0a000000 + (ii << 8));
+        route::prefix_t pfx(a, 24);
+        route::path p(itf, nh_proto_t::IPV4);
+        route::ip_route r(pfx, p);
+
+        OM::write(key, r);
+    }
+
+    for (unsigned int ii = 0; ii < n; ii++)
+    {
+        boost::asio::ip::address_v4 a(0x0b000000 + ii);
+        ACL::l3_rule r1(10, ACL::action_t::PERMIT,
+                        route::prefix_t(a, 32), route::prefix_t::ZERO);
+        ACL::l3_rule r2(20, ACL::action_t::DENY,
+                        route::prefix_t::ZERO, route::prefix_t::ZERO);
+        ACL::l3_list acl("acl-bench-" + std::to_string(ii));
+
+        acl.insert(r1);
+        acl.insert(r2);
+        OM::write(key, acl);
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    std::vector<unsigned int> windows;
+    unsigned int n = 1000;
+    HW::cmd_q *q;
+    int c;
+
+    while (-1 != (c = getopt(argc, argv, "n:w:")))
+    {
+        switch (c)
+        {
+        case 'n':
+            n = std::stoul(optarg);
+            break;
+        case 'w':
+            windows.push_back(std::stoul(optarg));
+            break;
+        default:
+            std::cerr << "usage: " << argv[0]
+                      << " [-n <objects>] [-w <window>]..." << std::endl;
+            return (1);
+        }
+    }
+    if (windows.empty())
+        windows = { 1, 8, 32, 64 };
+
+    q = new HW::cmd_q();
+    HW::init(q);
+    OM::init();
+
+    while (!HW::connect())
+        ;
+
+    populate(n, "vom-bench");
+
+    for (auto w : windows)
+    {
+        q->window(w);
+
+        auto start = std::chrono::steady_clock::now();
+        OM::replay();
+        auto end = std::chrono::steady_clock::now();
+
+        std::chrono::duration<double> d = end - start;
+
+        std::cout << "window " << w << ": replayed " << n
+                  << " interfaces, routes and ACLs in " << d.count()
+                  << "s" << std::endl;
+    }
+
+    OM::remove("vom-bench");
+    HW::disconnect();
+
+    return (0);
+}
@@ -4,6 +4,8 @@
 
 import unittest
 import random
+import re
+import struct
 
 from scapy.packet import Raw
 from scapy.layers.l2 import Ether
@@ -1393,5 +1395,53 @@ class TestACLplugin(VppTestCase):
 
         self.logger.info("ACLP_TEST_FINISH_0305")
 
+    def create_classbench_rules(self, count, seed=42):
+        """ Random rules, with the prefix lengths and port classes
+        distributed roughly like in the ClassBench seed filter sets """
+        rng = random.Random(seed)
+        prefix_lens = [0] * 2 + [8, 16] + [24] * 3 + [28, 30] + [32] * 5
+        port_ranges = [(0, 65535)] * 4 + [(0, 1023), (1024, 65535)] + \
+            [(p, p) for p in (22, 25, 53, 80, 123, 443, 8080)]
+        rules = []
+        for i in range(count):
+            s_prefix = rng.choice(prefix_lens)
+            d_prefix = rng.choice(prefix_lens)
+            proto = rng.choice([0, 6, 6, 6, 17, 17])
+            sport = rng.choice(port_ranges) if proto else (0, 65535)
+            dport = rng.choice(port_ranges) if proto else (0, 65535)
+            rules.append({'is_permit': rng.randint(0, 1), 'is_ipv6': 0,
+                          'proto': proto,
+                          'srcport_or_icmptype_first': sport[0],
+                          'srcport_or_icmptype_last': sport[1],
+                          'src_ip_prefix_len': s_prefix,
+                          'src_ip_addr': struct.pack(
+                              '!I', rng.getrandbits(32)),
+                          'dstport_or_icmpcode_first': dport[0],
+                          'dstport_or_icmpcode_last': dport[1],
+                          'dst_ip_prefix_len': d_prefix,
+                          'dst_ip_addr': struct.pack(
+                              '!I', rng.getrandbits(32))})
+        return rules
+
+    def test_0400_classbench_lookup(self):
+        """ hash lookups agree with the linear ones, with tuple merge
+        """
+        self.logger.info("ACLP_TEST_START_0400")
+        rules = self.create_classbench_rules(500)
+        for tuple_merge in [0, 1]:
+            self.vapi.cli("set acl-plugin use-tuple-merge %d" % tuple_merge)
+            self.apply_rules(rules, "classbench tm %d" % tuple_merge)
+            reply = self.vapi.cli("test acl-plugin lookup sw_if_index %d "
+                                  "input count 20000" %
+                                  self.pg0.sw_if_index)
+            self.logger.info(reply)
+            mismatches = re.search(r"(\d+) mismatches", reply)
+            self.assertIsNotNone(mismatches)
+            self.assertEqual(int(mismatches.group(1)), 0)
+            self.assertIn("tuple merge %s" % ("on" if tuple_merge else "off"),
+                          reply)
+
+        self.logger.info("ACLP_TEST_FINISH_0400")
+
 if __name__ == '__main__':
     unittest.main(testRunner=VppTestRunner)
@@ -26,5 +26,21 @@ class TestFIB(VppTestCase):
             self.logger.critical(error)
         self.assertEqual(error.find("Failed"), -1)
 
+    def test_mtrie(self):
+        """ IPv4 mtrie Unit Tests """
+        error = self.vapi.cli("test mtrie")
+
+        if error:
+            self.logger.critical(error)
+        self.assertEqual(error.find("Failed"), -1)
+
+    def test_ip6_lpm(self):
+        """ IPv6 LPM Unit Tests """
+        error = self.vapi.cli("test ip6 lpm routes 2000")
+
+        if error:
+            self.logger.critical(error)
+        self.assertEqual(error.find("Failed"), -1)
+
 if __name__ == '__main__':
     unittest.main(testRunner=VppTestRunner)
@@ -0,0 +1,180 @@
+#!/usr/bin/env python
+import re
+import unittest
+
+from framework import VppTestCase, VppTestRunner
+
+from scapy.packet import Raw
+from scapy.layers.l2 import Ether
+from scapy.layers.inet import IP, UDP
+from util import ppp
+
+test_packet_count = 1000
+
+
+class TestWorkerHandoff(VppTestCase):
+    """ Worker handoff """
+
+    @classmethod
+    def setUpConstants(cls):
+        super(TestWorkerHandoff, cls).setUpConstants()
+        cls.vpp_cmdline.extend(["cpu", "{", "workers", "2", "}"])
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestWorkerHandoff, cls).setUpClass()
+
+        cls.create_pg_interfaces(range(2))
+        for i in cls.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+        cls.vapi.cli("set interface handoff pg0 workers 0-1 "
+                     "hash 5-tuple reta-size 8")
+
+    def setUp(self):
+        super(TestWorkerHandoff, self).setUp()
+        self.vapi.cli("clear frame-queue stats")
+        self.vapi.cli("set frame-queue policy wait")
+
+    def tearDown(self):
+        super(TestWorkerHandoff, self).tearDown()
+        if not self.vpp_dead:
+            self.logger.info(self.vapi.ppcli("show frame-queue stats"))
+
+    def create_stream(self, count=test_packet_count):
+        """ UDP flows from pg0 to pg1, spread over the workers """
+        pkts = []
+        for i in range(count):
+            info = self.create_packet_info(self.pg0, self.pg1)
+            payload = self.info_to_payload(info)
+            p = (Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac) /
+                 IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4) /
+                 UDP(sport=1024 + i, dport=1234) /
+                 Raw(payload))
+            info.data = p.copy()
+            pkts.append(p)
+        return pkts
+
+    def verify_capture(self, capture):
+        """ Every packet sent arrives, whatever worker forwarded it """
+        seen = set()
+        for packet in capture:
+            try:
+                info = self.payload_to_info(str(packet[Raw]))
+                self.assertEqual(packet[IP].dst, self.pg1.remote_ip4)
+                self.assertEqual(packet[UDP].sport,
+                                 info.data[UDP].sport)
+                seen.add(info.index)
+            except:
+                self.logger.error(ppp("Unexpected or invalid packet:",
+                                      packet))
+                raise
+        self.assertEqual(len(seen), len(self._packet_infos))
+
+    def handoff_stats(self, consumer=None):
+        """ Buffers handed off, and dropped, by the wait/drop policy """
+        vectors = drops = 0
+        for line in self.vapi.cli("show frame-queue stats").splitlines():
+            fields = line.split()
+            if len(fields) > 6 and fields[0].startswith("vpp_wk"):
+                if consumer and fields[1] != consumer:
+                    continue
+                vectors += int(fields[3])
+                drops += int(fields[6])
+        return vectors, drops
+
+    def set_reta(self, workers):
+        """ Set the worker of each bucket of pg0's indirection table """
+        for bucket, worker in enumerate(workers):
+            self.vapi.cli("set interface handoff reta pg0 bucket %d "
+                          "worker %d" % (bucket, worker))
+
+    def test_handoff(self):
+        """ Packets are handed off to, and forwarded by, both workers """
+        self.pg0.add_stream(self.create_stream())
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+
+        self.verify_capture(self.pg1.get_capture(test_packet_count))
+
+        vectors, drops = self.handoff_stats()
+        self.assertEqual(vectors, test_packet_count)
+        self.assertEqual(drops, 0)
+
+    def test_handoff_reta(self):
+        """ The indirection table picks the worker, and is rebalanced """
+        self.set_reta([1] * 8)
+
+        self.pg0.add_stream(self.create_stream())
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+
+        self.verify_capture(self.pg1.get_capture(test_packet_count))
+        vectors, drops = self.handoff_stats(consumer="vpp_wk_1")
+        self.assertEqual(vectors, test_packet_count)
+
+        # all the load on worker 1, so the busiest buckets move to 0
+        self.vapi.cli("set interface handoff rebalance pg0")
+        reta = self.vapi.cli("show interface handoff pg0 buckets")
+        self.logger.info(reta)
+        self.assertIn("worker 0: ", reta)
+        self.assertNotIn("worker 0: 0 buckets", reta)
+
+        self.set_reta([0, 1] * 4)
+
+    def worker_sleeps(self, sleep):
+        """ Sleeps of each worker, from show worker sleep """
+        return [int(n) for n in re.findall(r"^\S+: (\d+) sleeps", sleep,
+                                           re.MULTILINE)]
+
+    def test_handoff_worker_sleep(self):
+        """ Idle workers sleep, and wake for frames handed off """
+        # longer than the barrier sync would wait for the workers
+        reply = self.vapi.cli("set worker sleep idle-loops 16 "
+                              "max-sleep 2000000")
+        self.assertIn("max-sleep must be", reply)
+
+        self.vapi.cli("clear worker sleep")
+        self.vapi.cli("set worker sleep idle-loops 16 max-sleep 200")
+        self.sleep(.1)
+
+        self.pg0.add_stream(self.create_stream())
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+
+        self.verify_capture(self.pg1.get_capture(test_packet_count))
+        vectors, drops = self.handoff_stats()
+        self.assertEqual(vectors, test_packet_count)
+        self.assertEqual(drops, 0)
+
+        # the CLI takes the barrier, which wakes sleeping workers
+        self.vapi.cli("set worker sleep idle-loops 16 max-sleep 10000")
+        self.sleep(.1)
+        sleep = self.vapi.cli("show worker sleep")
+        self.logger.info(sleep)
+        self.vapi.cli("set worker sleep disable")
+        self.assertIn("after 16 idle loops", sleep)
+        sleeps = self.worker_sleeps(sleep)
+        self.assertEqual(len(sleeps), 2)
+        for n in sleeps:
+            self.assertGreater(n, 0)
+
+    def test_handoff_drop_policy(self):
+        """ With the drop policy, what is not handed off is dropped """
+        self.vapi.cli("set frame-queue policy drop threshold 1")
+
+        self.pg0.add_stream(self.create_stream())
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+        self.sleep(.5)
+
+        capture = self.pg1._get_capture(timeout=1)
+        vectors, drops = self.handoff_stats()
+        self.assertEqual(vectors + drops, test_packet_count)
+        self.assertEqual(len(capture) if capture else 0, vectors)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
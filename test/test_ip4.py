@@ -7,7 +7,7 @@ from framework import VppTestCase, VppTestRunner
 from vpp_sub_interface import VppSubInterface, VppDot1QSubint, VppDot1ADSubint
 from vpp_ip_route import VppIpRoute, VppRoutePath, VppIpMRoute, \
     VppMRoutePath, MRouteItfFlags, MRouteEntryFlags, VppMplsIpBind, \
-    VppMplsTable, VppIpTable
+    VppMplsTable, VppIpTable, find_route
 
 from scapy.packet import Raw
 from scapy.layers.l2 import Ether, Dot1Q, ARP
@@ -1314,5 +1314,78 @@ class TestIPInput(VppTestCase):
         rx = self.send_and_expect(self.pg0, p_mtu * 65, self.pg1)
 
 
+class TestIPRouteBatch(VppTestCase):
+    """ IPv4 route batches """
+
+    def setUp(self):
+        super(TestIPRouteBatch, self).setUp()
+
+        self.create_pg_interfaces(range(2))
+
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+    def tearDown(self):
+        super(TestIPRouteBatch, self).tearDown()
+        for i in self.pg_interfaces:
+            i.unconfig_ip4()
+            i.admin_down()
+
+    def batch_entry(self, dst, dst_len, is_add=1):
+        """ A route via pg1's neighbour """
+        return {'is_add': is_add,
+                'is_ipv6': 0,
+                'is_drop': 0,
+                'is_multipath': 0,
+                'dst_address_length': dst_len,
+                'dst_address': socket.inet_pton(socket.AF_INET, dst),
+                'next_hop_sw_if_index': self.pg1.sw_if_index,
+                'next_hop_weight': 1,
+                'next_hop_preference': 0,
+                'next_hop_address': self.pg1.remote_ip4n}
+
+    def test_ip_route_batch(self):
+        """ IP Route Batch Add/Delete """
+
+        dsts = ["10.10.%d.1" % i for i in range(16)]
+
+        #
+        # one route with an impossible prefix length, in the middle
+        #
+        routes = [self.batch_entry(d, 32) for d in dsts]
+        routes.insert(8, self.batch_entry("10.10.100.1", 33))
+
+        with self.vapi.expect_negative_api_retval():
+            reply = self.vapi.ip_route_add_del_batch(routes)
+        self.assertEqual(reply.n_failed, 1)
+
+        for d in dsts:
+            self.assertTrue(find_route(self, d, 32))
+        self.assertFalse(find_route(self, "10.10.100.1", 33))
+
+        #
+        # the routes forward, once the batch's back-walks have run
+        #
+        pkts = [(Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac) /
+                 IP(src=self.pg0.remote_ip4, dst=d) /
+                 UDP(sport=1234, dport=1234) /
+                 Raw('\xa5' * 100)) for d in dsts]
+        self.send_and_expect(self.pg0, pkts, self.pg1)
+
+        #
+        # delete them all, the invalid one failing again
+        #
+        for r in routes:
+            r['is_add'] = 0
+        with self.vapi.expect_negative_api_retval():
+            reply = self.vapi.ip_route_add_del_batch(routes)
+        self.assertEqual(reply.n_failed, 1)
+
+        for d in dsts:
+            self.assertFalse(find_route(self, d, 32))
+
+
 if __name__ == '__main__':
     unittest.main(testRunner=VppTestRunner)
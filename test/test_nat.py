@@ -5,6 +5,8 @@ import unittest
 import struct
 import StringIO
 import random
+import re
+import time
 
 from framework import VppTestCase, VppTestRunner, running_extended_tests
 from vpp_ip_route import VppIpRoute, VppRoutePath, DpoProto
@@ -2525,6 +2527,53 @@ class TestNAT44(MethodHolder):
                 data = ipfix.decode_data_set(p.getlayer(Set))
                 self.verify_ipfix_nat44_ses(data)
 
+    @unittest.skipUnless(running_extended_tests(), "part of extended tests")
+    def test_ipfix_nat44_sess_throughput(self):
+        """ NAT44 throughput with and without IPFIX logging """
+        n_flows = 2000
+        self.nat44_add_address(self.nat_addr)
+        self.vapi.nat44_interface_add_del_feature(self.pg0.sw_if_index)
+        self.vapi.nat44_interface_add_del_feature(self.pg1.sw_if_index,
+                                                  is_inside=0)
+        self.vapi.set_ipfix_exporter(collector_address=self.pg3.remote_ip4n,
+                                     src_address=self.pg3.local_ip4n,
+                                     path_mtu=1450,
+                                     template_interval=10)
+
+        def run(sport_base):
+            pkts = [(Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac) /
+                     IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4) /
+                     UDP(sport=sport_base + i, dport=20))
+                    for i in range(n_flows)]
+            self.pg0.add_stream(pkts)
+            self.pg_enable_capture(self.pg_interfaces)
+            start = time.time()
+            self.pg_start()
+            self.pg1.get_capture(n_flows)
+            return n_flows / (time.time() - start)
+
+        rate = run(10000)
+        self.vapi.nat_ipfix(domain_id=self.ipfix_domain_id,
+                            src_port=self.ipfix_src_port)
+        rate_logging = run(20000)
+        self.logger.info("NAT44 %d new sessions/s, with IPFIX logging %d" %
+                         (rate, rate_logging))
+
+        # every session created while logging was on is in a record
+        self.vapi.cli("ipfix flush")  # FIXME this should be an API call
+        capture = self.pg3.get_capture()
+        ipfix = IPFIXDecoder()
+        for p in capture:
+            if p.haslayer(Template):
+                ipfix.add_template(p.getlayer(Template))
+        created = 0
+        for p in capture:
+            if p.haslayer(Data):
+                data = ipfix.decode_data_set(p.getlayer(Set))
+                # natEvent, sessions over the per user limit are deleted
+                created += len([r for r in data if ord(r[230]) == 4])
+        self.assertEqual(created, n_flows)
+
     def test_ipfix_addr_exhausted(self):
         """ IPFIX logging NAT addresses exhausted """
         self.vapi.nat44_interface_add_del_feature(self.pg0.sw_if_index)
@@ -3560,6 +3609,94 @@ class TestNAT44(MethodHolder):
         sessions = self.vapi.nat44_user_session_dump(self.pg0.remote_ip4n, 0)
         self.assertEqual(nsessions - len(sessions), 2)
 
+    def test_port_block(self):
+        """ NAT44 port block allocation """
+        self.nat44_add_address(self.nat_addr)
+        self.vapi.nat44_interface_add_del_feature(self.pg0.sw_if_index)
+        self.vapi.nat44_interface_add_del_feature(self.pg1.sw_if_index,
+                                                  is_inside=0)
+        self.vapi.nat44_set_port_block_size(64)
+
+        try:
+            pkts = self.create_stream_in(self.pg0, self.pg1)
+            self.pg0.add_stream(pkts)
+            self.pg_enable_capture(self.pg_interfaces)
+            self.pg_start()
+            capture = self.pg1.get_capture(len(pkts))
+            self.verify_capture_out(capture)
+
+            # one block for all the sessions of the user
+            out = self.vapi.cli("show nat44 sessions detail")
+            blocks = re.findall(r"port block %s:(\d+)-(\d+)" %
+                                self.nat_addr, out)
+            self.assertEqual(len(blocks), 1)
+            start, end = int(blocks[0][0]), int(blocks[0][1])
+            self.assertEqual(end - start + 1, 64)
+            for p in capture:
+                if p.haslayer(TCP):
+                    port = p[TCP].sport
+                elif p.haslayer(UDP):
+                    port = p[UDP].sport
+                else:
+                    port = p[ICMP].id
+                self.assertTrue(start <= port <= end)
+
+            # the block goes back with the last of its sessions
+            sessions = self.vapi.nat44_user_session_dump(
+                self.pg0.remote_ip4n, 0)
+            for s in sessions:
+                self.vapi.nat44_del_session(s.inside_ip_address,
+                                            s.inside_port, s.protocol)
+            out = self.vapi.cli("show nat44 sessions detail")
+            self.assertNotIn("port block", out)
+        finally:
+            self.vapi.nat44_set_port_block_size(0)
+
+    def test_session_timeout(self):
+        """ NAT44 session timeouts, and closed TCP sessions aged fast """
+        self.nat44_add_address(self.nat_addr)
+        self.vapi.nat44_interface_add_del_feature(self.pg0.sw_if_index)
+        self.vapi.nat44_interface_add_del_feature(self.pg1.sw_if_index,
+                                                  is_inside=0)
+        self.vapi.nat_det_set_timeouts(udp=2, tcp_transitory=2, icmp=2)
+
+        try:
+            pkts = self.create_stream_in(self.pg0, self.pg1)
+            self.pg0.add_stream(pkts)
+            self.pg_enable_capture(self.pg_interfaces)
+            self.pg_start()
+            capture = self.pg1.get_capture(len(pkts))
+            self.verify_capture_out(capture)
+
+            # FIN packet in -> out
+            p = (Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac) /
+                 IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4) /
+                 TCP(sport=self.tcp_port_in, dport=20, flags="F"))
+            self.pg0.add_stream(p)
+            self.pg_enable_capture(self.pg_interfaces)
+            self.pg_start()
+            self.pg1.get_capture(1)
+
+            # FIN packet out -> in
+            p = (Ether(src=self.pg1.remote_mac, dst=self.pg1.local_mac) /
+                 IP(src=self.pg1.remote_ip4, dst=self.nat_addr) /
+                 TCP(sport=20, dport=self.tcp_port_out, flags="F"))
+            self.pg1.add_stream(p)
+            self.pg_enable_capture(self.pg_interfaces)
+            self.pg_start()
+            self.pg0.get_capture(1)
+
+            # the established TCP timeout is left long, the session closed
+            self.sleep(5)
+            sessions = self.vapi.nat44_user_session_dump(
+                self.pg0.remote_ip4n, 0)
+            self.assertEqual(len(sessions), 0)
+            out = self.vapi.cli("show nat44 sessions")
+            expired = sum(int(n) for n in re.findall(r"(\d+) expired", out))
+            self.assertGreaterEqual(expired, 3)
+        finally:
+            self.vapi.nat_det_set_timeouts()
+
     def test_set_get_reass(self):
         """ NAT44 set/get virtual fragmentation reassembly """
         reas_cfg1 = self.vapi.nat_get_reass()
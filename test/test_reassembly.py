@@ -357,6 +357,26 @@ class TestIPv4Reassembly(VppTestCase):
         self.verify_capture(packets, dropped_packet_indexes)
         self.pg_if.assert_nothing_captured()
 
+    def test_long_fragment_chain(self):
+        """ long fragment chain """
+
+        dropped_packet_indexes = set(
+            index for (index, frags_400, _, _) in self.pkt_infos
+            if len(frags_400) > 3)
+
+        self.vapi.ip_reassembly_set(timeout_ms=1000, max_reassemblies=1000,
+                                    expire_walk_interval_ms=10000,
+                                    max_reassembly_length=3)
+
+        self.pg_enable_capture()
+        self.pg_if.add_stream(self.fragments_400)
+        self.pg_start()
+
+        packets = self.punt_socket.wait_for_packets(
+            len(self.pkt_infos) - len(dropped_packet_indexes))
+        self.verify_capture(packets, dropped_packet_indexes)
+        self.pg_if.assert_nothing_captured()
+
 
 class TestIPv6Reassembly(VppTestCase):
     """ IPv6 Reassembly """
@@ -702,6 +722,26 @@ class TestIPv6Reassembly(VppTestCase):
         self.verify_capture(packets, dropped_packet_indexes)
         self.pg_if.assert_nothing_captured()
 
+    def test_long_fragment_chain(self):
+        """ long fragment chain """
+
+        dropped_packet_indexes = set(
+            index for (index, frags_400, _) in self.pkt_infos
+            if len(frags_400) > 3)
+
+        self.vapi.ip_reassembly_set(timeout_ms=1000, max_reassemblies=1000,
+                                    expire_walk_interval_ms=10000, is_ip6=1,
+                                    max_reassembly_length=3)
+
+        self.pg_enable_capture()
+        self.pg_if.add_stream(self.fragments_400)
+        self.pg_start()
+
+        packets = self.punt_socket.wait_for_packets(
+            len(self.pkt_infos) - len(dropped_packet_indexes))
+        self.verify_capture(packets, dropped_packet_indexes)
+        self.pg_if.assert_nothing_captured()
+
     def test_missing_upper(self):
         """ missing upper layer """
         p = (Ether(dst=self.pg_if.local_mac, src=self.pg_if.remote_mac) /
@@ -832,6 +832,21 @@ class VppPapiProvider(object):
              'next_hop_via_label': next_hop_via_label,
              'next_hop_out_label_stack': next_hop_out_label_stack})
 
+    def ip_route_add_del_batch(self, routes, table_id=0):
+        """ Add / del a batch of routes in one table
+
+        :param routes: list of dicts, one per route, with the fields of
+            ip_route_batch_entry
+        :param table_id:  (Default value = 0)
+        :returns: the reply, with the number of routes that failed
+
+        """
+        return self.api(
+            self.papi.ip_route_add_del_batch,
+            {'table_id': table_id,
+             'count': len(routes),
+             'routes': routes})
+
     def ip_fib_dump(self):
         return self.api(self.papi.ip_fib_dump, {})
 
@@ -1518,6 +1533,17 @@ class VppPapiProvider(object):
             self.papi.nat44_forwarding_enable_disable,
             {'enable': enable})
 
+    def nat44_set_port_block_size(
+            self,
+            block_size):
+        """Set NAT44 port block allocation
+
+        :param block_size: ports per block, 0 to allocate single ports
+        """
+        return self.api(
+            self.papi.nat44_set_port_block_size,
+            {'block_size': block_size})
+
     def nat_set_reass(
             self,
             timeout=2,
@@ -3172,13 +3198,15 @@ class VppPapiProvider(object):
                          'header_version': header_version})
 
     def ip_reassembly_set(self, timeout_ms, max_reassemblies,
-                          expire_walk_interval_ms, is_ip6=0):
+                          expire_walk_interval_ms, is_ip6=0,
+                          max_reassembly_length=0):
         """ Set IP reassembly parameters """
         return self.api(self.papi.ip_reassembly_set,
                         {'is_ip6': is_ip6,
                          'timeout_ms': timeout_ms,
                          'expire_walk_interval_ms': expire_walk_interval_ms,
-                         'max_reassemblies': max_reassemblies})
+                         'max_reassemblies': max_reassemblies,
+                         'max_reassembly_length': max_reassembly_length})
 
     def ip_reassembly_get(self, is_ip6=0):
         """ Get IP reassembly parameters """